@@ -9,6 +9,7 @@
 #include "ag71xx.h"
 #include <ether.h>
 #include <ethernet.h>
+#include <interrupt.h>
 #include <network.h>
 
 /* Implementation of etherControl() for the ag71xx; see the documentation for
@@ -20,6 +21,10 @@ devcall etherControl(device *devptr, int func, long arg1, long arg2)
     struct netaddr *addr;
     uchar *macptr;
     ulong temp = 0;
+    struct packet **pkts;
+    struct netif *netif;
+    irqmask im;
+    int i;
 
     ethptr = &ethertab[devptr->minor];
     if (NULL == ethptr->csr)
@@ -164,6 +169,68 @@ devcall etherControl(device *devptr, int func, long arg1, long arg2)
         addr->addr[5] = 0xFF;
         break;
 
+/* Steer received packets to the receive threads of an interface, or stop */
+    case NET_SET_STEER:
+        im = disable();
+        ethptr->netif = (struct netif *)arg1;
+        if (NULL == ethptr->netif)
+        {
+            ethptr->poll = FALSE;
+            nicptr->interruptMask = ethptr->interruptMask;
+        }
+        restore(im);
+        break;
+
+/* Leave received packets to be polled for, or take them on interrupt */
+    case NET_SET_POLL:
+        im = disable();
+        if (NULL == ethptr->netif)
+        {
+            restore(im);
+            return SYSERR;
+        }
+        ethptr->poll = arg1;
+        nicptr->interruptMask = ethptr->interruptMask;
+        restore(im);
+        break;
+
+/* Take up to arg1 received packets, and take interrupts again once there
+ * are none left.  The NIC raises the receive interrupt while its count of
+ * received packets is not zero, so one that arrives as it is unmasked
+ * still interrupts. */
+    case NET_POLL:
+        im = disable();
+        if (!ethptr->poll || (arg1 <= 0))
+        {
+            restore(im);
+            return SYSERR;
+        }
+        netif = ethptr->netif;
+        i = rxPacketsSteer(ethptr, arg1);
+        if (i < arg1)
+        {
+            nicptr->interruptMask = ethptr->interruptMask;
+        }
+        restore(im);
+        netRxqWake(netif);
+        return i;
+
+/* Write a burst of packets, gathering their segments */
+    case NET_SEND_PKTS:
+        if (NULL == (void *)arg1)
+        {
+            return OK;
+        }
+        pkts = (struct packet **)arg1;
+        for (i = 0; i < arg2; i++)
+        {
+            if (SYSERR == etherWritePkt(devptr, pkts[i]))
+            {
+                break;
+            }
+        }
+        return i;
+
     default:
         return SYSERR;
     }
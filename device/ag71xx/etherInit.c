@@ -99,13 +99,12 @@ devcall etherInit(device *devptr)
     // Drop short packets, set "don't care" on Rx stats vector bits.
     nicptr->fifoConfig5 = 0x0003FFFF;
 
-    /* NOTE: because device initialization runs early in the system, */
-    /*  we are assured that this stkget() call will return          */
-    /*  page-aligned (and cache-aligned) boundaries.                */
-    ethptr->rxBufs = stkget(PAGE_SIZE);
-    ethptr->txBufs = stkget(PAGE_SIZE);
-    ethptr->rxRing = stkget(PAGE_SIZE);
-    ethptr->txRing = stkget(PAGE_SIZE);
+    /* The DMA rings and buffer pointer arrays must be page-aligned */
+    /*  (and so cache-aligned).                                     */
+    ethptr->rxBufs = memgetalign(PAGE_SIZE, PAGE_SIZE);
+    ethptr->txBufs = memgetalign(PAGE_SIZE, PAGE_SIZE);
+    ethptr->rxRing = memgetalign(PAGE_SIZE, PAGE_SIZE);
+    ethptr->txRing = memgetalign(PAGE_SIZE, PAGE_SIZE);
 
     if ((SYSERR == (int)ethptr->rxBufs)
         || (SYSERR == (int)ethptr->txBufs)
@@ -121,20 +120,16 @@ devcall etherInit(device *devptr)
     /* bump buffer pointers/rings to KSEG1 */
     ethptr->rxBufs =
         (struct ethPktBuffer
-         **)(((ulong)ethptr->rxBufs - PAGE_SIZE +
-              sizeof(int)) | KSEG1_BASE);
+         **)((ulong)ethptr->rxBufs | KSEG1_BASE);
     ethptr->txBufs =
         (struct ethPktBuffer
-         **)(((ulong)ethptr->txBufs - PAGE_SIZE +
-              sizeof(int)) | KSEG1_BASE);
+         **)((ulong)ethptr->txBufs | KSEG1_BASE);
     ethptr->rxRing =
         (struct dmaDescriptor
-         *)(((ulong)ethptr->rxRing - PAGE_SIZE +
-             sizeof(int)) | KSEG1_BASE);
+         *)((ulong)ethptr->rxRing | KSEG1_BASE);
     ethptr->txRing =
         (struct dmaDescriptor
-         *)(((ulong)ethptr->txRing - PAGE_SIZE +
-             sizeof(int)) | KSEG1_BASE);
+         *)((ulong)ethptr->txRing | KSEG1_BASE);
 
     /* Zero out the buffer pointers and rings */
     bzero(ethptr->rxBufs, PAGE_SIZE);
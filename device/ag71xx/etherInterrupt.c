@@ -64,6 +64,64 @@ void rxPackets(struct ether *ethptr, struct ag71xx *nicptr)
     }
 }
 
+/**
+ * @ingroup etherspecific
+ *
+ * Put up to @p budget received frames on the receive queues of the
+ * interface the device steers to, each copied into a buffer from the
+ * interface's pool, handing their descriptors back to the NIC with the
+ * same buffers.  Unlike rxPackets(), this takes every frame waiting, up to
+ * the budget, clearing the NIC's count of received frames for each.  A
+ * frame that finds the pool empty is dropped and counted as an overrun.
+ * Interrupts must be disabled, and the caller calls netRxqWake() after.
+ * @param ethptr ethernet table entry, which steers to an interface
+ * @param budget most frames to take
+ * @return number of frames taken off the receive ring
+ */
+int rxPacketsSteer(struct ether *ethptr, int budget)
+{
+    struct ag71xx *nicptr = ethptr->csr;
+    struct dmaDescriptor *dmaptr;
+    struct ethPktBuffer *epb;
+    struct packet *pkt;
+    uint length;
+    int head, n;
+
+    for (n = 0; n < budget; n++)
+    {
+        head = ethptr->rxHead % ETH_RX_RING_ENTRIES;
+        dmaptr = &ethptr->rxRing[head];
+        if (dmaptr->control & ETH_DESC_CTRL_EMPTY)
+        {
+            break;
+        }
+
+        epb = ethptr->rxBufs[head];
+        length = dmaptr->control & ETH_DESC_CTRL_LEN;
+        pkt = bufgetnb(ethptr->netif->rxpool);
+        if ((SYSERR == (int)pkt) || (length > NET_MAX_PKTLEN))
+        {
+            if (SYSERR != (int)pkt)
+            {
+                netFreebuf(pkt);
+            }
+            ethptr->ovrrun++;
+        }
+        else
+        {
+            memcpy(pkt->data, (uchar *)(((ulong)epb->buf) | KSEG1_BASE),
+                   length);
+            pkt->len = length;
+            netRxqPut(ethptr->netif, pkt);
+        }
+
+        dmaptr->control = ETH_DESC_CTRL_EMPTY;
+        ethptr->rxHead++;
+        nicptr->rxStatus = RX_STAT_RECVD;
+    }
+    return n;
+}
+
 /**
  * @ingroup etherspecific
  *
@@ -154,7 +212,24 @@ interrupt etherInterrupt(void)
     if (status & IRQ_RX_PKTRECV)
     {
         ethptr->rxirq++;
-        rxPackets(ethptr, nicptr);
+        if (ethptr->poll)
+        {
+            /* Leave the frames to be polled for, with no more receive
+             * interrupts until they have all been taken */
+            nicptr->interruptMask =
+                ethptr->interruptMask & ~IRQ_RX_PKTRECV;
+            netPollSchedule(ethptr->netif);
+            netRxqWake(ethptr->netif);
+        }
+        else if (ethptr->netif != NULL)
+        {
+            rxPacketsSteer(ethptr, ETH_RX_RING_ENTRIES);
+            netRxqWake(ethptr->netif);
+        }
+        else
+        {
+            rxPackets(ethptr, nicptr);
+        }
     }
 
     if (status & IRQ_RX_OVERFLOW)
@@ -92,6 +92,8 @@ devcall etherOpen(device *devptr)
     /* start Rx engine */
     nicptr->rxControl = RX_CTRL_RXE;
 
+    ethptr->netif = NULL;
+    ethptr->poll = FALSE;
     ethptr->state = ETH_STATE_UP;
     /* enable interrupts */
     nicptr->interruptMask = ethptr->interruptMask;
@@ -18,6 +18,19 @@
 /* Implementation of etherWrite() for the ag71xx; see the documentation for this
  * function in ether.h.  */
 devcall etherWrite(device *devptr, const void *buf, uint len)
+{
+    struct packet frame;
+
+    frame.len = len;
+    frame.curr = (uchar *)buf;
+    frame.segs = NULL;
+    frame.seglen = 0;
+    return etherWritePkt(devptr, &frame);
+}
+
+/* Implementation of etherWritePkt() for the ag71xx; see the documentation for
+ * this function in ether.h.  */
+devcall etherWritePkt(device *devptr, const struct packet *frame)
 {
     struct ether *ethptr = NULL;
     struct ag71xx *nicptr = NULL;
@@ -25,7 +38,7 @@ devcall etherWrite(device *devptr, const void *buf, uint len)
     struct dmaDescriptor *dmaptr = NULL;
     irqmask im;
     ulong tail = 0;
-    const uchar *buffer = buf;
+    uint len = frame->len;
 /* 	ulong *flushControl = (ulong *)0xB800007C; */
 
     ethptr = &ethertab[devptr->minor];
@@ -64,7 +77,7 @@ devcall etherWrite(device *devptr, const void *buf, uint len)
     pkt = (struct ethPktBuffer *)((int)pkt | KSEG1_BASE);
     pkt->buf = (uchar *)(pkt + 1);
     pkt->data = pkt->buf;
-    memcpy(pkt->data, buffer, len);
+    netGather(pkt->data, frame, 0, len);
 
     /* Place filled buffer in outgoing queue */
     ethptr->txBufs[tail] = pkt;
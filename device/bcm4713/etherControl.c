@@ -22,6 +22,8 @@ devcall etherControl(device *devptr, int func, long arg1, long arg2)
     uchar *macptr;
     ulong temp = 0;
     struct netaddr *addr;
+    struct packet **pkts;
+    int i;
 
     ethptr = &ethertab[devptr->minor];
     if (NULL == ethptr->csr)
@@ -179,6 +181,22 @@ devcall etherControl(device *devptr, int func, long arg1, long arg2)
     case NET_GET_MTU:
         return ETH_MTU;
 
+/* Write a burst of packets, gathering their segments */
+    case NET_SEND_PKTS:
+        if (NULL == (void *)arg1)
+        {
+            return OK;
+        }
+        pkts = (struct packet **)arg1;
+        for (i = 0; i < arg2; i++)
+        {
+            if (SYSERR == etherWritePkt(devptr, pkts[i]))
+            {
+                break;
+            }
+        }
+        return i;
+
     default:
         return SYSERR;
     }
@@ -19,6 +19,19 @@
 /* Implementation of etherWrite() for the bcm4713; see the documentation for
  * this function in ether.h.  */
 devcall etherWrite(device *devptr, const void *buf, uint len)
+{
+    struct packet frame;
+
+    frame.len = len;
+    frame.curr = (uchar *)buf;
+    frame.segs = NULL;
+    frame.seglen = 0;
+    return etherWritePkt(devptr, &frame);
+}
+
+/* Implementation of etherWritePkt() for the bcm4713; see the documentation
+ * for this function in ether.h.  */
+devcall etherWritePkt(device *devptr, const struct packet *frame)
 {
     struct ether *ethptr;
     struct bcm4713 *nicptr;
@@ -27,7 +40,7 @@ devcall etherWrite(device *devptr, const void *buf, uint len)
     struct ether *phyptr;
     irqmask im;
     ulong entry = 0, control = 0;
-    const uchar *buffer = buf;
+    uint len = frame->len;
     uint outlen;
 
     ethptr = &ethertab[devptr->minor];
@@ -70,10 +83,10 @@ devcall etherWrite(device *devptr, const void *buf, uint len)
     lanptr = (struct vlanPkt *)pkt->data;
 
     /* Copy packet to DMA buffer with added vlan tag */
-    memcpy(pkt->data, buffer, 12);
+    netGather(pkt->data, frame, 0, 12);
     lanptr->tpi = hs2net(ETH_TYPE_VLAN);
     lanptr->vlanId = hs2net(devptr->minor);
-    memcpy(pkt->data + 16, buffer + 12, outlen - 12);
+    netGather(pkt->data + 16, frame, 12, outlen - 12);
     outlen += ETH_VLAN_LEN;     /* account for vlan tag addition */
     pkt->length = outlen;
 
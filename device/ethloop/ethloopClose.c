@@ -7,6 +7,7 @@
 #include <device.h>
 #include <ethloop.h>
 #include <interrupt.h>
+#include <network.h>
 #include <semaphore.h>
 
 /**
@@ -20,6 +21,7 @@ devcall ethloopClose(device *devptr)
 {
     struct ethloop *elpptr;
     irqmask im;
+    int i;
 
     elpptr = &elooptab[devptr->minor];
     im = disable();
@@ -35,8 +37,17 @@ devcall ethloopClose(device *devptr)
     semfree(elpptr->sem);
     semfree(elpptr->hsem);
 
-    /* free the buffer pool */
-    bfpfree(elpptr->poolid);
+    /* free the packets still queued or held */
+    for (i = 0; i < elpptr->count; i++)
+    {
+        netFreebuf(elpptr->buffer[(elpptr->index + i) % ELOOP_NBUF]);
+    }
+    elpptr->count = 0;
+    if (elpptr->hold != NULL)
+    {
+        netFreebuf(elpptr->hold);
+        elpptr->hold = NULL;
+    }
 
     /* mark as not open */
     elpptr->dev = NULL;
@@ -30,8 +30,12 @@ devcall ethloopControl(device *devptr, int func, long arg1, long arg2)
     uchar old;
     irqmask im;
     char *buf;
-    char *hold;
+    struct packet *hold;
+    struct packet **pkts;
+    struct netif *netif;
+    bool poll;
     int holdlen;
+    int i, result, nqueued;
 
     elpptr = &elooptab[devptr->minor];
 
@@ -89,20 +93,129 @@ devcall ethloopControl(device *devptr, int func, long arg1, long arg2)
         wait(elpptr->hsem);
         /* Get and clear held packet */
         hold = elpptr->hold;
-        holdlen = elpptr->holdlen;
+        holdlen = hold->len;
         elpptr->hold = NULL;
-        elpptr->holdlen = 0;
         restore(im);
         /* Copy held packet to buffer */
         if (arg2 < holdlen)
         {
             holdlen = arg2;
         }
-        memcpy(buf, hold, holdlen);
+        memcpy(buf, hold->data, holdlen);
         /* Free hold buffer */
-        buffree(hold);
+        netFreebuf(hold);
         return holdlen;
 
+/* Hand the next written packet over without copying it */
+    case NET_RECV_PKT:
+        if (NULL == (void *)arg1)
+        {
+            restore(im);
+            return OK;
+        }
+        hold = ethloopTake(elpptr);
+        restore(im);
+        *((struct packet **)arg1) = hold;
+        return hold->len;
+
+/* Set the pool that written packets are put in */
+    case NET_SET_RXPOOL:
+        if (isbadpool(arg1))
+        {
+            restore(im);
+            return SYSERR;
+        }
+        elpptr->rxpool = arg1;
+        restore(im);
+        return OK;
+
+/* Steer written packets to the receive threads of an interface, or stop */
+    case NET_SET_STEER:
+        elpptr->netif = (struct netif *)arg1;
+        if (NULL == elpptr->netif)
+        {
+            elpptr->poll = FALSE;
+            elpptr->rxmask = FALSE;
+        }
+        restore(im);
+        return OK;
+
+/* Have the interface poll for written packets, or steer them as they are
+ * written again, handing it those that are waiting */
+    case NET_SET_POLL:
+        netif = elpptr->netif;
+        if (NULL == netif)
+        {
+            restore(im);
+            return SYSERR;
+        }
+        elpptr->poll = arg1;
+        elpptr->rxmask = FALSE;
+        nqueued = 0;
+        while (!elpptr->poll && (elpptr->count > 0))
+        {
+            netRxqPut(netif, ethloopTake(elpptr));
+            nqueued++;
+        }
+        restore(im);
+        if (nqueued > 0)
+        {
+            netRxqWake(netif);
+        }
+        return OK;
+
+/* Hand up to arg1 written packets to the interface polling for them */
+    case NET_POLL:
+        netif = elpptr->netif;
+        if (!elpptr->poll || (arg1 <= 0))
+        {
+            restore(im);
+            return SYSERR;
+        }
+        for (i = 0; (i < arg1) && (elpptr->count > 0); i++)
+        {
+            netRxqPut(netif, ethloopTake(elpptr));
+        }
+        if (i < arg1)
+        {
+            elpptr->rxmask = FALSE;
+        }
+        restore(im);
+        netRxqWake(netif);
+        return i;
+
+/* Write a burst of packets, gathering their segments, waking the reader
+ * once */
+    case NET_SEND_PKTS:
+        if (NULL == (void *)arg1)
+        {
+            restore(im);
+            return OK;
+        }
+        pkts = (struct packet **)arg1;
+        nqueued = 0;
+        for (i = 0; i < arg2; i++)
+        {
+            result = ethloopPut(elpptr, pkts[i]);
+            if (SYSERR == result)
+            {
+                break;
+            }
+            nqueued += result;
+        }
+        netif = elpptr->netif;
+        poll = elpptr->poll;
+        restore(im);
+        if ((nqueued > 0) && ((netif == NULL) || poll))
+        {
+            signaln(elpptr->sem, nqueued);
+        }
+        if ((nqueued > 0) && (netif != NULL))
+        {
+            netRxqWake(netif);
+        }
+        return i;
+
 /* Set flags */
     case ELOOP_CTRL_SETFLAG:
         old = elpptr->flags & arg1;
@@ -117,6 +230,20 @@ devcall ethloopControl(device *devptr, int func, long arg1, long arg2)
         restore(im);
         return old;
 
+/* Set rate of random loss, in packets per 1000, and restart the same
+ * sequence of losses */
+    case ELOOP_CTRL_SETLOSS:
+        if ((arg1 < 0) || (arg1 > 1000))
+        {
+            restore(im);
+            return SYSERR;
+        }
+        elpptr->loss = arg1;
+        elpptr->lossrand = 1;
+        elpptr->nlost = 0;
+        restore(im);
+        return OK;
+
     default:
         restore(im);
         return SYSERR;
@@ -34,7 +34,9 @@ devcall ethloopOpen(device *devptr)
 
     /* Clear flags and stats */
     elpptr->flags = 0;
+    elpptr->loss = 0;
     elpptr->nout = 0;
+    elpptr->nlost = 0;
 
     /* Create semaphores */
     elpptr->sem = semcreate(0);
@@ -51,18 +53,13 @@ devcall ethloopOpen(device *devptr)
 
     /* Initialize buffers */
     bzero(elpptr->buffer, sizeof(elpptr->buffer));
-    bzero(elpptr->pktlen, sizeof(elpptr->pktlen));
     elpptr->index = 0;
     elpptr->hold = NULL;
-    elpptr->holdlen = 0;
     elpptr->count = 0;
-
-    /* Allocate a buffer pool  */
-    elpptr->poolid = bfpalloc(ELOOP_BUFSIZE, ELOOP_NBUF);
-    if (SYSERR == elpptr->poolid)
-    {
-        goto out_free_hsem;
-    }
+    elpptr->rxpool = netpool;
+    elpptr->netif = NULL;
+    elpptr->poll = FALSE;
+    elpptr->rxmask = FALSE;
 
     /* Link ethloop record with device table entry and mark ethloop as open */
     elpptr->state = ELOOP_STATE_ALLOC;
@@ -72,8 +69,6 @@ devcall ethloopOpen(device *devptr)
     retval = OK;
     goto out_restore;
 
-out_free_hsem:
-    semfree(elpptr->hsem);
 out_free_sem:
     semfree(elpptr->sem);
 out_restore:
@@ -7,9 +7,37 @@
 #include <device.h>
 #include <ethloop.h>
 #include <interrupt.h>
+#include <network.h>
 #include <stddef.h>
 #include <string.h>
 
+/**
+ * @ingroup ethloop
+ *
+ * Take the oldest written packet off the queue of an Ethernet Loopback device,
+ * waiting for one if there is none.  Interrupts must be disabled.
+ *
+ * @param elpptr
+ *      Pointer to the ethloop control block, which must be open.
+ *
+ * @return
+ *      The packet, a buffer from @c rxpool with @c len set to the length
+ *      of the frame at @c data.  The caller frees it with netFreebuf().
+ */
+struct packet *ethloopTake(struct ethloop *elpptr)
+{
+    struct packet *pkt;
+
+    /* wait until the buffer has a packet */
+    wait(elpptr->sem);
+
+    pkt = elpptr->buffer[elpptr->index];
+    elpptr->buffer[elpptr->index] = NULL;
+    elpptr->count--;
+    elpptr->index = (elpptr->index + 1) % ELOOP_NBUF;
+    return pkt;
+}
+
 /**
  * @ingroup ethloop
  *
@@ -33,8 +61,8 @@ devcall ethloopRead(device *devptr, void *buf, uint len)
 {
     struct ethloop *elpptr;
     irqmask im;
-    char *pkt;
-    int pktlen;
+    struct packet *pkt;
+    uint pktlen;
 
     elpptr = &elooptab[devptr->minor];
 
@@ -45,24 +73,17 @@ devcall ethloopRead(device *devptr, void *buf, uint len)
         return SYSERR;
     }
 
-    /* wait until the buffer has a packet */
-    wait(elpptr->sem);
-
-    pkt = elpptr->buffer[elpptr->index];
-    pktlen = elpptr->pktlen[elpptr->index];
-    elpptr->buffer[elpptr->index] = NULL;
-    elpptr->pktlen[elpptr->index] = 0;
-    elpptr->count--;
-    elpptr->index = (elpptr->index + 1) % ELOOP_NBUF;
+    pkt = ethloopTake(elpptr);
     restore(im);
 
+    pktlen = pkt->len;
     if (len < pktlen)
     {
         pktlen = len;
     }
 
-    memcpy(buf, pkt, pktlen);
-    buffree(pkt);
+    memcpy(buf, pkt->data, pktlen);
+    netFreebuf(pkt);
 
     return pktlen;
 }
@@ -7,36 +7,36 @@
 #include <device.h>
 #include <ethloop.h>
 #include <interrupt.h>
+#include <network.h>
 #include <stddef.h>
 #include <string.h>
 
 /**
  * @ingroup ethloop
  *
- * Write data to an Ethernet Loopback device.  On success, the data will be
- * available to be read by a subsequent call to ethloopRead().
+ * Put a frame written to an Ethernet Loopback device on its queue, or drop
+ * or hold it as the device's flags say.  Interrupts must be disabled.
  *
- * @param devptr
- *      Pointer to the device table entry for the ethloop.
+ * @param elpptr
+ *      Pointer to the ethloop control block, which must be open.
  *
- * @param buf
- *      Buffer of data to write.
- *
- * @param len
- *      Length of data to write, in bytes.
+ * @param frame
+ *      Packet whose frame to write, at @c curr followed by any segments it
+ *      has, which are gathered into the frame queued.
  *
  * @return
- *      On success, returns the number of bytes written, which will be exactly
- *      @p len.  On failure, returns SYSERR.
+ *      1 if the frame was queued, in which case the caller signals
+ *      @c elpptr->sem, or calls netRxqWake() if the frames are steered to
+ *      an interface, once the frames it writes are queued; 0 if it was
+ *      dropped or held; SYSERR if it could not be queued.  If the device
+ *      is polled, the frame is queued for ::NET_POLL, and the caller
+ *      signals @c elpptr->sem, then calls netRxqWake().
  */
-devcall ethloopWrite(device *devptr, const void *buf, uint len)
+int ethloopPut(struct ethloop *elpptr, const struct packet *frame)
 {
-    struct ethloop *elpptr;
-    irqmask im;
     int index;
-    char *pkt;
-
-    elpptr = &elooptab[devptr->minor];
+    struct packet *pkt;
+    uint len = frame->len;
 
     /* Make sure the packet isn't too small or too large  */
     if ((len < ELOOP_LINKHDRSIZE) || (len > ELOOP_BUFSIZE))
@@ -44,34 +44,46 @@ devcall ethloopWrite(device *devptr, const void *buf, uint len)
         return SYSERR;
     }
 
-    im = disable();
+    /* Drop packet if drop flags(s) are set */
+    if (elpptr->flags & (ELOOP_FLAG_DROPNXT | ELOOP_FLAG_DROPALL))
+    {
+        elpptr->flags &= ~ELOOP_FLAG_DROPNXT;
+        return 0;
+    }
 
-    /* Make sure the ethloop is actually open  */
-    if (ELOOP_STATE_ALLOC != elpptr->state)
+    /* Drop packet at random if a loss rate is set */
+    if (elpptr->loss > 0)
     {
-        restore(im);
-        return SYSERR;
+        elpptr->lossrand = elpptr->lossrand * 1103515245 + 12345;
+        if ((elpptr->lossrand >> 16) % 1000 < elpptr->loss)
+        {
+            elpptr->nlost++;
+            return 0;
+        }
     }
 
-    /* Drop packet if drop flags(s) are set */
-    if (elpptr->flags & (ELOOP_FLAG_DROPNXT | ELOOP_FLAG_DROPALL))
+    /* Ensure there is room to queue the packet.  While the device is
+     * polled, one that does not fit is dropped, as by a NIC whose receive
+     * ring is full. */
+    if (!(elpptr->flags & ELOOP_FLAG_HOLDNXT)
+        && ((elpptr->netif == NULL) || elpptr->poll)
+        && (elpptr->count >= ELOOP_NBUF))
     {
-        elpptr->flags &= ~ELOOP_FLAG_DROPNXT;
-        restore(im);
-        return len;
+        return elpptr->poll ? 0 : SYSERR;
     }
 
-    /* Allocate buffer space.  This is blocking, so it can only fail if the pool
-     * ID was corrupted.  */
-    pkt = (char *)bufget(elpptr->poolid);
+    /* Allocate a network packet buffer, so that the reader can take the
+     * packet as it is.  Interrupts are disabled, so this cannot wait; the
+     * packet is dropped, and counted against the pool, if there is none. */
+    pkt = bufgetnb(elpptr->rxpool);
     if (SYSERR == (int)pkt)
     {
-        restore(im);
-        return SYSERR;
+        return 0;
     }
 
-    /* Copy supplied buffer into allocated buffer */
-    memcpy(pkt, buf, len);
+    /* Copy supplied frame into allocated buffer */
+    netGather(pkt->data, frame, 0, len);
+    pkt->len = len;
 
     /* Hold next packet if the appropriate flag is set */
     if (elpptr->flags & ELOOP_FLAG_HOLDNXT)
@@ -79,36 +91,103 @@ devcall ethloopWrite(device *devptr, const void *buf, uint len)
         elpptr->flags &= ~ELOOP_FLAG_HOLDNXT;
         if (elpptr->hold != NULL)
         {
-            buffree(elpptr->hold);
+            netFreebuf(elpptr->hold);
         }
         elpptr->hold = pkt;
-        elpptr->holdlen = len;
-        restore(im);
         signal(elpptr->hsem);
-        return len;
+        return 0;
     }
 
-    /* Ensure there is enough buffer space (there always should be)  */
-    if (elpptr->count >= ELOOP_NBUF)
+    /* Steer to the receive thread of the interface, if one is running and
+     * does not poll for packets */
+    if ((elpptr->netif != NULL) && !elpptr->poll)
     {
-        buffree(pkt);
-        restore(im);
-        return SYSERR;
+        elpptr->nout++;
+        return (SYSERR == netRxqPut(elpptr->netif, pkt)) ? 0 : 1;
     }
 
     index = (elpptr->count + elpptr->index) % ELOOP_NBUF;
 
     /* Add to buffer */
     elpptr->buffer[index] = pkt;
-    elpptr->pktlen[index] = len;
     elpptr->count++;
 
     /* Increment count of packets written */
     elpptr->nout++;
 
+    /* Have the interface poll for it, unless it is to already */
+    if (elpptr->poll && !elpptr->rxmask)
+    {
+        elpptr->rxmask = TRUE;
+        netPollSchedule(elpptr->netif);
+    }
+
+    return 1;
+}
+
+/**
+ * @ingroup ethloop
+ *
+ * Write data to an Ethernet Loopback device.  On success, the data will be
+ * available to be read by a subsequent call to ethloopRead().
+ *
+ * @param devptr
+ *      Pointer to the device table entry for the ethloop.
+ *
+ * @param buf
+ *      Buffer of data to write.
+ *
+ * @param len
+ *      Length of data to write, in bytes.
+ *
+ * @return
+ *      On success, returns the number of bytes written, which will be exactly
+ *      @p len.  On failure, returns SYSERR.
+ */
+devcall ethloopWrite(device *devptr, const void *buf, uint len)
+{
+    struct ethloop *elpptr;
+    struct packet frame;
+    struct netif *netif;
+    bool poll;
+    irqmask im;
+    int result;
+
+    elpptr = &elooptab[devptr->minor];
+
+    /* Describe the buffer as a frame with no segments */
+    frame.len = len;
+    frame.curr = (uchar *)buf;
+    frame.segs = NULL;
+    frame.seglen = 0;
+
+    im = disable();
+
+    /* Make sure the ethloop is actually open  */
+    if (ELOOP_STATE_ALLOC != elpptr->state)
+    {
+        restore(im);
+        return SYSERR;
+    }
+
+    result = ethloopPut(elpptr, &frame);
+    netif = elpptr->netif;
+    poll = elpptr->poll;
+
     restore(im);
 
-    signal(elpptr->sem);
+    if (SYSERR == result)
+    {
+        return SYSERR;
+    }
+    if ((result > 0) && ((netif == NULL) || poll))
+    {
+        signal(elpptr->sem);
+    }
+    if ((result > 0) && (netif != NULL))
+    {
+        netRxqWake(netif);
+    }
 
     return len;
 }
@@ -281,8 +281,9 @@ devcall nvramUnset(char *name)
     length = strnlen(tuple->pair, NVRAM_STRMAX) + 1;
     nvram_header->length -= length;
 
-    /* free memory node */
-    if (SYSERR == memfree((void *)tuple, length))
+    /* free memory node, allocated with room for the whole pair */
+    if (SYSERR == memfree((void *)tuple,
+                          sizeof(struct nvram_tuple) + length - 1))
     {
         return SYSERR;
     }
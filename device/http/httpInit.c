@@ -13,6 +13,7 @@
 struct http httptab[NHTTP];
 semaphore maxhttp = -1;
 semaphore activeXWeb = -1;
+int httplistener = SYSERR;
 
 /* Shell command and its length */
 const struct httpcmd httpcmdtab[] = {
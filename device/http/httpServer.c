@@ -15,10 +15,11 @@
 
 
 thread killHttpServer(uint, tid_typ, uint);
-thread httpServer(int, int);
+thread httpServer(int);
 
 /**
- * HTTP server kick start thread
+ * HTTP server kick start thread.  Opens a listener on the HTTP port and
+ * starts the first server thread, which accepts connections from it.
  * @return OK or SYSERR
  */
 thread httpServerKickStart(int netDescrp)
@@ -27,6 +28,7 @@ thread httpServerKickStart(int netDescrp)
     char thrname[TNMLEN];
     int tid;
     int cursem;
+    struct netif *nif;
 
     cursem = activeXWeb;
     /* Only one active web server at a time */
@@ -37,6 +39,16 @@ thread httpServerKickStart(int netDescrp)
         return SYSERR;
     }
 
+    /* Look up the network descriptor */
+    nif = netLookup(netDescrp);
+    if (NULL == nif)
+    {
+        fprintf(stderr, "%s is not associated with an active network",
+                devtab[netDescrp].name);
+        fprintf(stderr, " interface.\n");
+        return SYSERR;
+    }
+
     /* Allocate TCP device */
     tcpdev = tcpAlloc();
     if (isbadtcp(tcpdev))
@@ -45,30 +57,54 @@ thread httpServerKickStart(int netDescrp)
         return SYSERR;
     }
 
+    /* Listen for connections to the web server */
+    if (SYSERR == (long)open(tcpdev, &(nif->ip), NULL, HTTP_LOCAL_PORT,
+                             NULL, TCP_LISTENER))
+    {
+        fprintf(stderr, "tcpOpen SYSERR, devnum: %d\n", tcpdev);
+        close(tcpdev);
+        return SYSERR;
+    }
+    httplistener = tcpdev;
+
     sprintf(thrname, "XWeb_%d", (devtab[tcpdev].minor));
     tid = create((void *)httpServer, INITSTK, INITPRIO, thrname,
-                 2, netDescrp, tcpdev);
+                 1, tcpdev);
     ready(tid, RESCHED_NO);
 
     return tid;
 }
 
 /**
- * HTTP server thread
- * @param host IP address of interface on which to listen
- * @param gentcpdev the allocated tcp device for general listening
+ * HTTP server thread.  Accepts a connection, starts the next server
+ * thread to accept the one after it, and serves this one.
+ * @param listener the TCP device listening on the HTTP port
  * @return OK or SYSERR
  */
-thread httpServer(int netDescrp, int gentcpdev)
+thread httpServer(int listener)
 {
     tid_typ shelltid, killtid;
     int tcpdev, httpdev;
     char thrname[TNMLEN];
-    struct netaddr *host;
-    struct netif *nif;
 
     wait(maxhttp);              /* Make sure max HTTP threads not reached */
 
+    /* Wait for a connection */
+    tcpdev = control(listener, TCP_CTRL_ACCEPT, 0, 0);
+    if (isbadtcp(tcpdev))
+    {
+        signal(maxhttp);
+        return SYSERR;
+    }
+
+    /* Spawn the server for the next connection */
+    if (semcount(activeXWeb) <= 0)
+    {
+        sprintf(thrname, "XWeb_%d", (devtab[tcpdev].minor));
+        ready(create((void *)httpServer, INITSTK, INITPRIO,
+                     thrname, 1, listener), RESCHED_NO);
+    }
+
     /* Allocate HTTP device */
     httpdev = httpAlloc();
 
@@ -76,24 +112,11 @@ thread httpServer(int netDescrp, int gentcpdev)
     if (isbadhttp(httpdev))
     {
         printf("failed to allocate proper HTTP device\n");
+        close(tcpdev);
         signal(maxhttp);
         return SYSERR;
     }
 
-    /* Back up the general tcpdev number */
-    tcpdev = gentcpdev;
-
-    /* Look up the network descriptor */
-    nif = netLookup(netDescrp);
-    if (SYSERR == (int)nif)
-    {
-        fprintf(stderr, "%s is not associated with an active network",
-                devtab[netDescrp].name);
-        fprintf(stderr, " interface.\n");
-        return SYSERR;
-    }
-    host = &(nif->ip);
-
     /* Open HTTP device */
     if (SYSERR == (long)open(httpdev, tcpdev))
     {
@@ -124,59 +147,6 @@ thread httpServer(int netDescrp, int gentcpdev)
     ready(shelltid, RESCHED_NO);
     ready(killtid, RESCHED_NO);
 
-    /* Open TCP device */
-    if (SYSERR ==
-        (long)open(tcpdev, host, NULL, HTTP_LOCAL_PORT, NULL,
-                   TCP_PASSIVE))
-    {
-        int temp;
-        sleep(TCP_TWOMSL + 500);
-        if (SYSERR ==
-            (temp = (long)open(tcpdev, host, NULL, HTTP_LOCAL_PORT, NULL,
-                               TCP_PASSIVE)))
-        {
-            fprintf(CONSOLE, "open returns: %d\n", temp);
-            fprintf(stderr, "tcpOpen SYSERR, devnum: %d\n", tcpdev);
-            kill(shelltid);
-            close(tcpdev);
-            close(httpdev);
-            return SYSERR;
-        }
-        fprintf(CONSOLE, "open returns: %d\n", temp);
-    }
-
-    /* Allocate TCP device */
-    gentcpdev = tcpAlloc();
-    if (isbadtcp(gentcpdev))
-    {
-        /* Wait for a free http device */
-        wait(maxhttp);
-
-        /* Acquire a TCP device through allocation */
-        while ((ushort)SYSERR == (gentcpdev = tcpAlloc()))
-        {
-            /* Do nothing, yield processor */
-            yield();
-        }
-
-        /* Everything acquired, spawn general http device listener */
-        if (semcount(activeXWeb) <= 0)
-        {
-            sprintf(thrname, "XWeb_%d", (devtab[gentcpdev].minor));
-            ready(create((void *)httpServer, INITSTK, INITPRIO,
-                         thrname, 2, netDescrp, gentcpdev), RESCHED_NO);
-        }
-
-        /* Did not consume http device, just waited for availability */
-        signal(maxhttp);
-    }
-    else
-    {
-        sprintf(thrname, "XWeb_%d", (devtab[gentcpdev].minor));
-        ready(create((void *)httpServer, INITSTK, INITPRIO,
-                     thrname, 2, netDescrp, gentcpdev), RESCHED_NO);
-    }
-
     return OK;
 }
 
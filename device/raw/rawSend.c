@@ -17,7 +17,9 @@
  * @param rawptr pointer to the raw socket control block
  * @param buf buffer to semd
  * @param len size of the buffer
- * @return OK if packet was sent succesfully, otherwise SYSERR
+ * @return OK if packet was sent succesfully or is held until the next hop's
+ * address is resolved, NET_DROPPED if it could not be held, otherwise
+ * SYSERR
  */
 syscall rawSend(struct raw *rawptr, void *buf, uint len)
 {
@@ -93,8 +95,8 @@ syscall rawSend(struct raw *rawptr, void *buf, uint len)
         {
         case NETADDR_IPv4:
             RAW_TRACE("Send via IPv4");
-            result = ipv4Send(pkt, &rawptr->localip, &rawptr->remoteip,
-                              rawptr->proto);
+            result = ipv4SendDst(pkt, &rawptr->localip, &rawptr->remoteip,
+                                 rawptr->proto, &rawptr->dst);
             break;
         default:
             result = SYSERR;
@@ -105,5 +107,11 @@ syscall rawSend(struct raw *rawptr, void *buf, uint len)
     {
         return SYSERR;
     }
+
+    /* A packet held until the next hop's address is resolved is sent then */
+    if (NET_QUEUED == result)
+    {
+        return OK;
+    }
     return result;
 }
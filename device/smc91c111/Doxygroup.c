@@ -0,0 +1,17 @@
+/**
+ * @defgroup etherdriver Ethernet
+ * @brief Ethernet driver for SMSC LAN91C111 devices
+ * @ingroup devices
+ *
+ * @defgroup ether Ethernet Standard Functions
+ * @ingroup etherdriver
+ * @brief The functions in this category are also implemented in Xinu's other
+ * Ethernet drivers; some, such as etherRead() and etherWrite(), are compliant
+ * with Xinu's main device model and therefore can be accessed through functions
+ * like read() and write().
+ *
+ * @defgroup etherspecific Ethernet Device-Specific Functions
+ * @ingroup etherdriver
+ * @brief The functions in this category are specific to the SMSC LAN91C111 and
+ * not intended to be used outside of the driver itself.
+ */
@@ -0,0 +1,52 @@
+/**
+ * @file etherClose.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include "smc91c111.h"
+#include <ether.h>
+#include <interrupt.h>
+#include <network.h>
+#include <semaphore.h>
+
+/* Implementation of etherClose() for the smc91c111; see the documentation for
+ * this function in ether.h.  */
+devcall etherClose(device *devptr)
+{
+    struct ether *ethptr;
+    void *csr;
+    irqmask im;
+
+    im = disable();
+
+    ethptr = &ethertab[devptr->minor];
+    if (ethptr->state != ETH_STATE_UP)
+    {
+        restore(im);
+        return SYSERR;
+    }
+    csr = ethptr->csr;
+
+    /* Turn off interrupts, receive and transmit.  */
+    SMC_BANK(csr, 2);
+    SMC_REG8(csr, SMC_INT_MASK) = 0;
+    SMC_BANK(csr, 0);
+    SMC_REG16(csr, SMC_RCR) = 0;
+    SMC_REG16(csr, SMC_TCR) = 0;
+
+    /* Free the received packets nobody has read.  */
+    while (ethptr->icount > 0)
+    {
+        netFreebuf(ethptr->in[ethptr->istart]);
+        ethptr->istart = (ethptr->istart + 1) % ETH_IBLEN;
+        ethptr->icount--;
+    }
+    semfree(ethptr->isema);
+    ethptr->isema = semcreate(0);
+
+    ethptr->netif = NULL;
+    ethptr->poll = FALSE;
+    ethptr->state = ETH_STATE_DOWN;
+    restore(im);
+    return OK;
+}
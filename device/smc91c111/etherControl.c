@@ -0,0 +1,187 @@
+/**
+ * @file etherControl.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <bufpool.h>
+#include <ether.h>
+#include <interrupt.h>
+#include <network.h>
+#include <string.h>
+#include "smc91c111.h"
+
+/* Implementation of etherControl() for the smc91c111; see the documentation
+ * for this function in ether.h.  */
+devcall etherControl(device *devptr, int req, long arg1, long arg2)
+{
+    struct netaddr *addr;
+    struct ether *ethptr;
+    struct netif *netif;
+    struct packet *pkt;
+    struct packet **pkts;
+    void *csr;
+    irqmask im;
+    int i;
+
+    ethptr = &ethertab[devptr->minor];
+    csr = ethptr->csr;
+    if (csr == NULL)
+    {
+        return SYSERR;
+    }
+
+    switch (req)
+    {
+    /* Program MAC address into device. */
+    case ETH_CTRL_SET_MAC:
+        im = disable();
+        SMC_BANK(csr, 1);
+        for (i = 0; i < ETH_ADDR_LEN; i++)
+        {
+            SMC_REG8(csr, SMC_IA + i) = ((const uchar *)arg1)[i];
+        }
+        memcpy(ethptr->devAddress, (const uchar *)arg1, ETH_ADDR_LEN);
+        restore(im);
+        break;
+
+    /* Get MAC address from device. */
+    case ETH_CTRL_GET_MAC:
+        memcpy((uchar *)arg1, ethptr->devAddress, ETH_ADDR_LEN);
+        break;
+
+    /* Enable or disable loopback mode.  */
+    case ETH_CTRL_SET_LOOPBK:
+        im = disable();
+        SMC_BANK(csr, 0);
+        if ((bool)arg1 == TRUE)
+        {
+            SMC_REG16(csr, SMC_TCR) |= SMC_TCR_LOOP;
+        }
+        else
+        {
+            SMC_REG16(csr, SMC_TCR) &= ~SMC_TCR_LOOP;
+        }
+        restore(im);
+        break;
+
+    /* Get link header length. */
+    case NET_GET_LINKHDRLEN:
+        return ETH_HDR_LEN;
+
+    /* Get MTU. */
+    case NET_GET_MTU:
+        return ETH_MTU;
+
+    /* Get hardware address.  */
+    case NET_GET_HWADDR:
+        addr = (struct netaddr *)arg1;
+        addr->type = NETADDR_ETHERNET;
+        addr->len = ETH_ADDR_LEN;
+        return etherControl(devptr, ETH_CTRL_GET_MAC, (long)addr->addr, 0);
+
+    /* Get broadcast hardware address. */
+    case NET_GET_HWBRC:
+        addr = (struct netaddr *)arg1;
+        addr->type = NETADDR_ETHERNET;
+        addr->len = ETH_ADDR_LEN;
+        memset(addr->addr, 0xFF, ETH_ADDR_LEN);
+        break;
+
+    /* Hand the next received packet over without copying it.  */
+    case NET_RECV_PKT:
+        if (NULL == (void *)arg1)
+        {
+            return OK;
+        }
+        im = disable();
+        if (ethptr->state != ETH_STATE_UP)
+        {
+            restore(im);
+            return SYSERR;
+        }
+        pkt = smc91c111_recv_packet(ethptr);
+        restore(im);
+        *((struct packet **)arg1) = pkt;
+        return pkt->len;
+
+    /* Set the pool received packets are put in.  */
+    case NET_SET_RXPOOL:
+        if (isbadpool(arg1))
+        {
+            return SYSERR;
+        }
+        ethptr->inPool = arg1;
+        break;
+
+    /* Steer received packets to the receive threads of an interface, or
+     * stop.  */
+    case NET_SET_STEER:
+        im = disable();
+        ethptr->netif = (struct netif *)arg1;
+        if (NULL == ethptr->netif)
+        {
+            ethptr->poll = FALSE;
+            SMC_BANK(csr, 2);
+            SMC_REG8(csr, SMC_INT_MASK) |= SMC_INT_RCV;
+        }
+        restore(im);
+        break;
+
+    /* Leave received packets to be polled for, or take them on interrupt.
+     * Any waiting are taken on the interrupt raised as it is unmasked.  */
+    case NET_SET_POLL:
+        im = disable();
+        if (NULL == ethptr->netif)
+        {
+            restore(im);
+            return SYSERR;
+        }
+        ethptr->poll = arg1;
+        SMC_BANK(csr, 2);
+        SMC_REG8(csr, SMC_INT_MASK) |= SMC_INT_RCV;
+        restore(im);
+        break;
+
+    /* Take up to arg1 received packets, and take interrupts again once there
+     * are none left.  The receive interrupt is raised while any received
+     * packet is in the controller's memory, so one that arrives as it is
+     * unmasked still interrupts.  */
+    case NET_POLL:
+        im = disable();
+        if (!ethptr->poll || (arg1 <= 0))
+        {
+            restore(im);
+            return SYSERR;
+        }
+        netif = ethptr->netif;
+        i = smc91c111_rx(ethptr, arg1);
+        if (i < arg1)
+        {
+            SMC_REG8(csr, SMC_INT_MASK) |= SMC_INT_RCV;
+        }
+        restore(im);
+        netRxqWake(netif);
+        return i;
+
+    /* Write a burst of packets, gathering their segments.  */
+    case NET_SEND_PKTS:
+        if (NULL == (void *)arg1)
+        {
+            return OK;
+        }
+        pkts = (struct packet **)arg1;
+        for (i = 0; i < arg2; i++)
+        {
+            if (SYSERR == etherWritePkt(devptr, pkts[i]))
+            {
+                break;
+            }
+        }
+        return i;
+
+    default:
+        return SYSERR;
+    }
+
+    return OK;
+}
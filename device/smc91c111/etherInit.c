@@ -0,0 +1,70 @@
+/**
+ * @file etherInit.c
+ *
+ * Initialization for the SMSC LAN91C111 Ethernet controller.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include "smc91c111.h"
+#include <ether.h>
+#include <interrupt.h>
+#include <semaphore.h>
+#include <stdlib.h>
+
+/* Global table of Ethernet devices.  */
+struct ether ethertab[NETHER];
+
+/* Implementation of etherInit() for the smc91c111; see the documentation for
+ * this function in ether.h.  */
+/**
+ * @details
+ *
+ * SMSC LAN91C111-specific notes:  the hardware address is the one the
+ * controller loaded from its EEPROM at reset, or that QEMU was given with its
+ * <code>-nic ...,mac=</code> option.  The controller is reset with transmit
+ * and receive off, which etherOpen() turns on.
+ */
+devcall etherInit(device *devptr)
+{
+    struct ether *ethptr;
+    void *csr;
+    uint i;
+
+    /* Initialize the static `struct ether' for this device.  */
+    ethptr = &ethertab[devptr->minor];
+    bzero(ethptr, sizeof(struct ether));
+    ethptr->dev = devptr;
+    ethptr->csr = devptr->csr;
+    ethptr->state = ETH_STATE_DOWN;
+    ethptr->mtu = ETH_MTU;
+    ethptr->addressLength = ETH_ADDR_LEN;
+    ethptr->isema = semcreate(0);
+    if (isbadsem(ethptr->isema))
+    {
+        return SYSERR;
+    }
+    csr = ethptr->csr;
+
+    /* Reset the controller, leaving it with transmit, receive and all its
+     * interrupts off.  */
+    SMC_BANK(csr, 0);
+    SMC_REG16(csr, SMC_RCR) = SMC_RCR_SOFT_RST;
+    SMC_REG16(csr, SMC_RCR) = 0;
+    SMC_REG16(csr, SMC_TCR) = 0;
+    SMC_BANK(csr, 2);
+    SMC_REG8(csr, SMC_INT_MASK) = 0;
+
+    /* Get the hardware address.  */
+    SMC_BANK(csr, 1);
+    for (i = 0; i < ETH_ADDR_LEN; i++)
+    {
+        ethptr->devAddress[i] = SMC_REG8(csr, SMC_IA + i);
+    }
+
+    /* Route the controller's interrupt line to the VIC, and install the
+     * interrupt handler.  */
+    SMC_SIC_PICENSET = 1U << devptr->irq;
+    interruptVector[devptr->irq] = devptr->intr;
+    enable_irq(devptr->irq);
+    return OK;
+}
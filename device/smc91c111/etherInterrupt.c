@@ -0,0 +1,174 @@
+/**
+ * @file etherInterrupt.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include "smc91c111.h"
+#include <bufpool.h>
+#include <ether.h>
+#include <interrupt.h>
+#include <network.h>
+#include <semaphore.h>
+#include <thread.h>
+
+extern int resdefer;
+
+/**
+ * @ingroup etherspecific
+ *
+ * Take up to @p budget received frames out of the controller's memory, with
+ * interrupts disabled.  Each is copied into a buffer from @c inPool and put
+ * on a receive queue of the interface steered to, or on the ethptr->in
+ * queue for etherRead() if there is none; the caller wakes the receive
+ * threads.  Bank 2 is left selected.
+ *
+ * @param ethptr
+ *      Ethernet device, which must be up.
+ * @param budget
+ *      Most frames to take.
+ *
+ * @return
+ *      Number of frames taken, whether they were kept or dropped.  If it is
+ *      less than @p budget, none are left.
+ */
+int smc91c111_rx(struct ether *ethptr, int budget)
+{
+    void *csr = ethptr->csr;
+    struct packet *pkt;
+    ushort *data;
+    uint status, count, len, word, i;
+    int n;
+
+    SMC_BANK(csr, 2);
+    for (n = 0; n < budget; n++)
+    {
+        if (SMC_REG16(csr, SMC_FIFO) & SMC_FIFO_RXEMPTY)
+        {
+            break;
+        }
+
+        /* Read the status word and byte count at the start of the oldest
+         * received packet.  */
+        SMC_REG16(csr, SMC_PTR) =
+            SMC_PTR_RCV | SMC_PTR_AUTO_INCR | SMC_PTR_READ;
+        word = SMC_REG32(csr, SMC_DATA);
+        status = word & 0xFFFF;
+        count = (word >> 16) & SMC_PKT_COUNT_MASK;
+        len = count - SMC_PKT_OVERHEAD;
+        if (status & SMC_RS_ODDFRM)
+        {
+            len++;
+        }
+
+        if ((status & SMC_RS_ERRORS) || (count < SMC_PKT_OVERHEAD) ||
+            (len < ETH_HDR_LEN) || (len > ETH_MAX_PKT_LEN))
+        {
+            ethptr->errors++;
+        }
+        else if (((ethptr->netif == NULL) &&
+                  (ethptr->icount == ETH_IBLEN)) ||
+                 (SYSERR == (int)(pkt = bufgetnb(ethptr->inPool))))
+        {
+            /* No space to buffer another received packet.  */
+            ethptr->ovrrun++;
+        }
+        else
+        {
+            /* Copy the frame, and the control word after it, a word at a
+             * time.  The frame starts 2 octets into a word of the packet
+             * buffer, so each word is stored as two halves.  */
+            data = (ushort *)pkt->data;
+            for (i = 0; i < (count - 4 + 3) / 4; i++)
+            {
+                word = SMC_REG32(csr, SMC_DATA);
+                *data++ = word & 0xFFFF;
+                *data++ = word >> 16;
+            }
+            pkt->len = len;
+
+            if (ethptr->netif != NULL)
+            {
+                netRxqPut(ethptr->netif, pkt);
+            }
+            else
+            {
+                ethptr->in[(ethptr->istart + ethptr->icount) % ETH_IBLEN] =
+                    pkt;
+                ethptr->icount++;
+
+                /* This may wake up a thread in etherRead().  */
+                signal(ethptr->isema);
+            }
+        }
+
+        /* Free the packet in the controller's memory.  */
+        SMC_REG16(csr, SMC_MMU_CMD) = SMC_MMU_REMOVE_RELEASE;
+        while (SMC_REG16(csr, SMC_MMU_CMD) & SMC_MMU_BUSY)
+            ;
+    }
+    return n;
+}
+
+/**
+ * @ingroup etherspecific
+ *
+ * Decode and handle hardware interrupt request from ethernet device.
+ */
+interrupt etherInterrupt(void)
+{
+    struct ether *ethptr;
+    void *csr;
+    uint status, bank;
+
+    ethptr = &ethertab[0];
+    csr = ethptr->csr;
+    if (ethptr->state != ETH_STATE_UP)
+    {
+        return;
+    }
+
+    /* The bank selected by the code interrupted is put back at the end.  */
+    bank = SMC_REG16(csr, SMC_BANK_SELECT) & 0x3;
+    SMC_BANK(csr, 2);
+    status = SMC_REG8(csr, SMC_INT_STAT) & SMC_REG8(csr, SMC_INT_MASK);
+    ethptr->interruptStatus = status;
+
+    resdefer = 1;               /* defer rescheduling */
+
+    /* The receive interrupt is raised while any received packet is still
+     * in the controller's memory, so it needs no acknowledgement.  */
+    if (status & SMC_INT_RCV)
+    {
+        ethptr->rxirq++;
+        if (ethptr->poll)
+        {
+            /* Leave the frames to be polled for, with no more receive
+             * interrupts until they have all been taken.  */
+            SMC_REG8(csr, SMC_INT_MASK) &= ~SMC_INT_RCV;
+            netPollSchedule(ethptr->netif);
+            netRxqWake(ethptr->netif);
+        }
+        else
+        {
+            smc91c111_rx(ethptr, ETH_IBLEN);
+            if (ethptr->netif != NULL)
+            {
+                netRxqWake(ethptr->netif);
+            }
+        }
+    }
+
+    if (status & SMC_INT_RX_OVRN)
+    {
+        SMC_REG8(csr, SMC_INT_STAT) = SMC_INT_RX_OVRN;
+        ethptr->ovrrun++;
+    }
+
+    SMC_BANK(csr, bank);
+
+    if (--resdefer > 0)
+    {
+        resdefer = 0;
+        resched();
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * @file etherOpen.c
+ *
+ * Code for opening a SMSC LAN91C111 Ethernet controller device.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include "smc91c111.h"
+#include <bufpool.h>
+#include <ether.h>
+#include <interrupt.h>
+
+/* Implementation of etherOpen() for the smc91c111; see the documentation for
+ * this function in ether.h.  */
+devcall etherOpen(device *devptr)
+{
+    struct ether *ethptr;
+    void *csr;
+    irqmask im;
+
+    im = disable();
+
+    /* Fail if device is not down.  */
+    ethptr = &ethertab[devptr->minor];
+    if (ethptr->state != ETH_STATE_DOWN)
+    {
+        restore(im);
+        return SYSERR;
+    }
+    csr = ethptr->csr;
+
+    /* Rx packets are copied out of the controller's memory straight into
+     * network packet buffers, and Tx packets are copied into it, so the
+     * driver has no pools of its own.  Received packets go in netpool until
+     * netUp() hands over the interface's own pool with NET_SET_RXPOOL.  */
+    ethptr->inPool = netpool;
+    ethptr->netif = NULL;
+    ethptr->poll = FALSE;
+    ethptr->istart = 0;
+    ethptr->icount = 0;
+
+    /* Free all packets in the controller's memory, and have it free each
+     * packet sent once it has been sent.  */
+    SMC_BANK(csr, 2);
+    SMC_REG16(csr, SMC_MMU_CMD) = SMC_MMU_RESET;
+    SMC_BANK(csr, 1);
+    SMC_REG16(csr, SMC_CONTROL) |= SMC_CONTROL_AUTO_RELEASE;
+
+    /* Enable transmit, padding short frames, and receive, leaving the CRC
+     * off received frames.  */
+    SMC_BANK(csr, 0);
+    SMC_REG16(csr, SMC_TCR) = SMC_TCR_TXENA | SMC_TCR_PAD_EN;
+    SMC_REG16(csr, SMC_RCR) = SMC_RCR_RXEN | SMC_RCR_STRIP_CRC;
+
+    /* Interrupt when frames are received, or lost.  After restoring
+     * interrupts, etherInterrupt() can run at any time.  */
+    SMC_BANK(csr, 2);
+    SMC_REG8(csr, SMC_INT_MASK) = SMC_INT_RCV | SMC_INT_RX_OVRN;
+
+    ethptr->state = ETH_STATE_UP;
+    restore(im);
+    return OK;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file etherRead.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include "smc91c111.h"
+#include <ether.h>
+#include <interrupt.h>
+#include <network.h>
+#include <string.h>
+
+/**
+ * @ingroup etherspecific
+ *
+ * Take the oldest received packet off the ethptr->in circular queue, waiting
+ * for one if there is none.  Interrupts must be disabled.
+ *
+ * @param ethptr
+ *      Ethernet device, which must be up.
+ *
+ * @return
+ *      The packet, a buffer from @c inPool with @c len set to the length
+ *      of the frame at @c data.  The caller frees it with netFreebuf().
+ */
+struct packet *smc91c111_recv_packet(struct ether *ethptr)
+{
+    struct packet *pkt;
+
+    wait(ethptr->isema);
+
+    pkt = ethptr->in[ethptr->istart];
+    ethptr->istart = (ethptr->istart + 1) % ETH_IBLEN;
+    ethptr->icount--;
+    return pkt;
+}
+
+/* Implementation of etherRead() for the smc91c111; see the documentation for
+ * this function in ether.h.  */
+devcall etherRead(device *devptr, void *buf, uint len)
+{
+    irqmask im;
+    struct ether *ethptr;
+    struct packet *pkt;
+
+    im = disable();
+
+    /* Make sure device is actually up.  */
+    ethptr = &ethertab[devptr->minor];
+    if (ethptr->state != ETH_STATE_UP)
+    {
+        restore(im);
+        return SYSERR;
+    }
+
+    pkt = smc91c111_recv_packet(ethptr);
+    restore(im);
+
+    /* Copy the data from the packet buffer, being careful to copy at most the
+     * number of bytes requested. */
+    if (pkt->len < len)
+    {
+        len = pkt->len;
+    }
+    memcpy(buf, pkt->data, len);
+
+    netFreebuf(pkt);
+    return len;
+}
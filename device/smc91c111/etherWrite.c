@@ -0,0 +1,100 @@
+/**
+ * @file etherWrite.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include "smc91c111.h"
+#include <ether.h>
+#include <interrupt.h>
+#include <network.h>
+
+/* Image of the packet being written into the controller's memory: status
+ * word, byte count, frame and control word, padded to a whole word.  */
+static uint txbuf[(SMC_PKT_OVERHEAD + ETH_MAX_PKT_LEN + 1 + 3) / 4];
+
+/* Implementation of etherWrite() for the smc91c111; see the documentation for
+ * this function in ether.h.  */
+devcall etherWrite(device *devptr, const void *buf, uint len)
+{
+    struct packet frame;
+
+    frame.len = len;
+    frame.curr = (uchar *)buf;
+    frame.segs = NULL;
+    frame.seglen = 0;
+    return etherWritePkt(devptr, &frame);
+}
+
+/* Implementation of etherWritePkt() for the smc91c111; see the documentation
+ * for this function in ether.h.  */
+devcall etherWritePkt(device *devptr, const struct packet *frame)
+{
+    struct ether *ethptr;
+    void *csr;
+    uchar *image;
+    uint len = frame->len;
+    uint count, tries, i;
+    irqmask im;
+
+    ethptr = &ethertab[devptr->minor];
+    if (ethptr->state != ETH_STATE_UP ||
+        len < ETH_HEADER_LEN || len > ETH_HDR_LEN + ETH_MTU)
+    {
+        return SYSERR;
+    }
+    csr = ethptr->csr;
+
+    /* The controller and txbuf are shared with the interrupt handler and
+     * other writers.  */
+    im = disable();
+
+    /* Allocate a packet in the controller's memory.  Packets sent are freed
+     * by the controller itself, so this waits only until the frames ahead
+     * of this one have gone.  */
+    SMC_BANK(csr, 2);
+    SMC_REG16(csr, SMC_MMU_CMD) = SMC_MMU_ALLOC;
+    for (tries = 0; SMC_REG8(csr, SMC_ARR) & SMC_ARR_FAILED; tries++)
+    {
+        if (tries >= SMC_ALLOC_TRIES)
+        {
+            restore(im);
+            return SYSERR;
+        }
+    }
+    SMC_REG8(csr, SMC_PNR) = SMC_REG8(csr, SMC_ARR) & SMC_PNR_MASK;
+    SMC_REG16(csr, SMC_PTR) = SMC_PTR_AUTO_INCR;
+
+    /* Build the packet: a status word the controller fills in, the even
+     * byte count, the frame, gathered from its segments, and the control
+     * word, which holds the last octet of a frame of odd length.  */
+    count = (len & ~1) + SMC_PKT_OVERHEAD;
+    image = (uchar *)txbuf;
+    image[0] = 0;
+    image[1] = 0;
+    image[2] = count & 0xFF;
+    image[3] = count >> 8;
+    netGather(image + 4, frame, 0, len);
+    if (len & 1)
+    {
+        image[count - 1] = SMC_CTL_ODD;
+    }
+    else
+    {
+        image[count - 2] = 0;
+        image[count - 1] = 0;
+    }
+
+    /* Copy it into the controller a word at a time, and send it.  */
+    for (i = 0; i < count / 4; i++)
+    {
+        SMC_REG32(csr, SMC_DATA) = txbuf[i];
+    }
+    if (count & 2)
+    {
+        SMC_REG16(csr, SMC_DATA) = ((ushort *)txbuf)[2 * i];
+    }
+    SMC_REG16(csr, SMC_MMU_CMD) = SMC_MMU_ENQUEUE;
+
+    restore(im);
+    return len;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file smc91c111.h
+ *
+ * This header provides definitions of the registers of the SMSC LAN91C111
+ * Ethernet controller, as found on the ARM Versatile Platform Baseboard and
+ * emulated by QEMU (hw/net/smc91c111.c).  They were taken from SMSC's data
+ * sheet for the LAN91C111.
+ *
+ * The controller has four banks of registers in a 16-byte window, one bank
+ * visible at a time; the Bank Select register at offset 14 is in every bank.
+ * Frames are not moved by DMA.  Instead, each frame sent or received is held
+ * in a "packet" in the controller's own memory, which is read and written
+ * through the Data register at an offset set in the Pointer register.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#ifndef _SMC91C111_H_
+#define _SMC91C111_H_
+
+#include <stddef.h>
+
+struct ether;
+
+/* Register access.  Each register is named by its offset in its bank, and
+ * the bank must be selected with SMC_BANK() first.  */
+#define SMC_REG8(csr, off)   (*(volatile uchar *)((ulong)(csr) + (off)))
+#define SMC_REG16(csr, off)  (*(volatile ushort *)((ulong)(csr) + (off)))
+#define SMC_REG32(csr, off)  (*(volatile uint *)((ulong)(csr) + (off)))
+#define SMC_BANK(csr, bank)  (SMC_REG16(csr, SMC_BANK_SELECT) = (bank))
+
+#define SMC_BANK_SELECT     0x0E    /**< Bank Select register, every bank */
+
+/* Bank 0 registers */
+#define SMC_TCR             0x00    /**< Transmit Control register        */
+#define SMC_TCR_TXENA       0x0001  /**< Enable transmitter               */
+#define SMC_TCR_LOOP        0x0002  /**< Internal loopback                */
+#define SMC_TCR_PAD_EN      0x0080  /**< Pad short frames to 64 octets    */
+#define SMC_RCR             0x04    /**< Receive Control register         */
+#define SMC_RCR_RXEN        0x0100  /**< Enable receiver                  */
+#define SMC_RCR_STRIP_CRC   0x0200  /**< Leave CRC off received frames    */
+#define SMC_RCR_SOFT_RST    0x8000  /**< Reset the controller             */
+
+/* Bank 1 registers */
+#define SMC_IA              0x04    /**< Individual Address, 6 octets     */
+#define SMC_CONTROL         0x0C    /**< Control register                 */
+#define SMC_CONTROL_AUTO_RELEASE 0x0800 /**< Free packets once sent       */
+
+/* Bank 2 registers */
+#define SMC_MMU_CMD         0x00    /**< MMU Command register             */
+#define SMC_MMU_BUSY        0x0001  /**< Command still in progress (read) */
+#define SMC_MMU_ALLOC       0x0020  /**< Allocate a packet to send        */
+#define SMC_MMU_RESET       0x0040  /**< Free all packets                 */
+#define SMC_MMU_REMOVE_RELEASE 0x0080 /**< Free oldest received packet   */
+#define SMC_MMU_ENQUEUE     0x00C0  /**< Send the packet in PNR           */
+#define SMC_PNR             0x02    /**< Packet Number register (8-bit)   */
+#define SMC_ARR             0x03    /**< Allocation Result reg (8-bit)    */
+#define SMC_ARR_FAILED      0x80    /**< Allocation not (yet) made        */
+#define SMC_PNR_MASK        0x3F    /**< Packet number                    */
+#define SMC_FIFO            0x04    /**< FIFO Ports register              */
+#define SMC_FIFO_RXEMPTY    0x8000  /**< No received packets waiting      */
+#define SMC_PTR             0x06    /**< Pointer register                 */
+#define SMC_PTR_RCV         0x8000  /**< Point into oldest received pkt   */
+#define SMC_PTR_AUTO_INCR   0x4000  /**< Advance with each Data access    */
+#define SMC_PTR_READ        0x2000  /**< Data is to be read               */
+#define SMC_DATA            0x08    /**< Data register, 32 bits wide      */
+#define SMC_INT_STAT        0x0C    /**< Interrupt Status, write to ack   */
+#define SMC_INT_MASK        0x0D    /**< Interrupt Mask register (8-bit)  */
+#define SMC_INT_RCV         0x01    /**< Received packets waiting         */
+#define SMC_INT_RX_OVRN     0x10    /**< Frame lost, no room to receive   */
+
+/* Words at the start and end of each packet in controller memory.  A
+ * packet holds a status word, a byte count, the frame, and a control word
+ * whose low octet is the last octet of a frame of odd length.  The byte
+ * count covers all of them, and is always even.  */
+#define SMC_PKT_OVERHEAD    6       /**< Octets of packet that are not frame */
+#define SMC_PKT_COUNT_MASK  0x07FE  /**< Byte count in second word        */
+#define SMC_CTL_ODD         0x20    /**< Control octet: odd length frame  */
+#define SMC_RS_ALGNERR      0x8000  /**< Rx status: alignment error       */
+#define SMC_RS_BADCRC       0x2000  /**< Rx status: bad CRC               */
+#define SMC_RS_ODDFRM       0x1000  /**< Rx status: odd length frame      */
+#define SMC_RS_TOOLONG      0x0800  /**< Rx status: frame too long        */
+#define SMC_RS_TOOSHORT     0x0400  /**< Rx status: frame too short       */
+#define SMC_RS_ERRORS       (SMC_RS_ALGNERR | SMC_RS_BADCRC | \
+                             SMC_RS_TOOLONG | SMC_RS_TOOSHORT)
+
+/** Times the Allocation Result register is read waiting for a packet */
+#define SMC_ALLOC_TRIES     100000
+
+/**
+ * Set Enable register of the Versatile's secondary interrupt controller
+ * that passes its lines 21 to 30 straight to the same lines of the VIC.
+ * The LAN91C111 is wired to its line 25.
+ */
+#define SMC_SIC_PICENSET    (*(volatile uint *)0x10003020)
+
+int smc91c111_rx(struct ether *, int);
+struct packet *smc91c111_recv_packet(struct ether *);
+
+#endif                          /* _SMC91C111_H_ */
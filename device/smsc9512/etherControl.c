@@ -3,7 +3,9 @@
  */
 /* Embedded Xinu, Copyright (C) 2008, 2013.  All rights reserved. */
 
+#include <bufpool.h>
 #include <ether.h>
+#include <interrupt.h>
 #include <network.h>
 #include <string.h>
 #include "smsc9512.h"
@@ -16,6 +18,10 @@ devcall etherControl(device *devptr, int req, long arg1, long arg2)
     usb_status_t status;
     struct netaddr *addr;
     struct ether *ethptr;
+    struct packet *pkt;
+    struct packet **pkts;
+    irqmask im;
+    int i;
 
     ethptr = &ethertab[devptr->minor];
     udev = ethptr->csr;
@@ -59,6 +65,55 @@ devcall etherControl(device *devptr, int req, long arg1, long arg2)
         addr->len = ETH_ADDR_LEN;
         return etherControl(devptr, ETH_CTRL_GET_MAC, (long)addr->addr, 0);
 
+    /* Hand the next received packet over without copying it.  */
+    case NET_RECV_PKT:
+        if (NULL == (void *)arg1)
+        {
+            return OK;
+        }
+        im = disable();
+        if (ethptr->state != ETH_STATE_UP)
+        {
+            restore(im);
+            return SYSERR;
+        }
+        pkt = smsc9512_recv_packet(ethptr);
+        restore(im);
+        *((struct packet **)arg1) = pkt;
+        return pkt->len;
+    /* Set the pool received packets are put in.  */
+    case NET_SET_RXPOOL:
+        if (isbadpool(arg1))
+        {
+            return SYSERR;
+        }
+        ethptr->inPool = arg1;
+        break;
+
+    /* Steer received packets to the receive threads of an interface, or
+     * stop.  */
+    case NET_SET_STEER:
+        im = disable();
+        ethptr->netif = (struct netif *)arg1;
+        restore(im);
+        break;
+
+    /* Write a burst of packets, gathering their segments.  */
+    case NET_SEND_PKTS:
+        if (NULL == (void *)arg1)
+        {
+            return OK;
+        }
+        pkts = (struct packet **)arg1;
+        for (i = 0; i < arg2; i++)
+        {
+            if (SYSERR == etherWritePkt(devptr, pkts[i]))
+            {
+                break;
+            }
+        }
+        return i;
+
     /* Get broadcast hardware address. */
     case NET_GET_HWBRC:
         addr = (struct netaddr *)arg1;
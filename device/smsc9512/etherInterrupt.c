@@ -17,6 +17,8 @@
 #include "smsc9512.h"
 #include <bufpool.h>
 #include <ether.h>
+#include <network.h>
+#include <semaphore.h>
 #include <string.h>
 #include <usb_core_driver.h>
 
@@ -53,8 +55,8 @@ void smsc9512_tx_complete(struct usb_xfer_request *req)
  *
  * This function is responsible for breaking up the raw USB transfer data into
  * the constituent Ethernet packet(s), then pushing them onto the incoming
- * packets queue (which may wake up threads in etherRead() that are waiting for
- * new packets).  It then must re-submit the USB bulk transfer request so that
+ * packets queue (which may wake up threads in etherRead() or netRecv() that
+ * are waiting for new packets).  It then must re-submit the USB bulk transfer request so that
  * packets can continue to be received.
  *
  * @param req
@@ -70,6 +72,7 @@ void smsc9512_rx_complete(struct usb_xfer_request *req)
         const uint8_t *data, *edata;
         uint32_t recv_status;
         uint32_t frame_length;
+        struct packet *pkt;
 
         /* For each Ethernet frame in the received USB data... */
         for (data = req->recvbuf, edata = req->recvbuf + req->actual_size;
@@ -98,33 +101,46 @@ void smsc9512_rx_complete(struct usb_xfer_request *req)
                               recv_status, frame_length);
                 ethptr->errors++;
             }
-            else if (ethptr->icount == ETH_IBLEN)
+            else if (((ethptr->netif == NULL) &&
+                      (ethptr->icount == ETH_IBLEN)) ||
+                     (SYSERR == (int)(pkt = bufgetnb(ethptr->inPool))))
             {
-                /* No space to buffer another received packet.  */
+                /* No space to buffer another received packet.  (bufget()
+                 * must not wait here, so bufgetnb() is used, which counts
+                 * the drop against the pool.)  */
                 usb_dev_debug(req->dev, "SMSC9512: Tallying overrun\n");
                 ethptr->ovrrun++;
             }
             else
             {
-                /* Buffer the received packet.  */
+                /* Copy the frame out of the USB transfer straight into a
+                 * network packet buffer, which netRecv() takes as it is.  */
+                pkt->len = frame_length - ETH_CRC_LEN;
+                memcpy(pkt->data, data + SMSC9512_RX_OVERHEAD, pkt->len);
 
-                struct ethPktBuffer *pkt;
+                /* Steer it to a receive thread of the interface, which are
+                 * woken once the whole transfer is handled.  */
+                if (ethptr->netif != NULL)
+                {
+                    netRxqPut(ethptr->netif, pkt);
+                    continue;
+                }
 
-                pkt = bufget(ethptr->inPool);
-                pkt->buf = pkt->data = (uint8_t*)(pkt + 1);
-                pkt->length = frame_length - ETH_CRC_LEN;
-                memcpy(pkt->buf, data + SMSC9512_RX_OVERHEAD, pkt->length);
                 ethptr->in[(ethptr->istart + ethptr->icount) % ETH_IBLEN] = pkt;
                 ethptr->icount++;
 
                 usb_dev_debug(req->dev, "SMSC9512: Receiving "
                               "packet (length=%u, icount=%u)\n",
-                              pkt->length, ethptr->icount);
+                              pkt->len, ethptr->icount);
 
                 /* This may wake up a thread in etherRead().  */
                 signal(ethptr->isema);
             }
         }
+        if (ethptr->netif != NULL)
+        {
+            netRxqWake(ethptr->netif);
+        }
     }
     else
     {
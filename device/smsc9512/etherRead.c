@@ -3,18 +3,47 @@
  */
 /* Embedded Xinu, Copyright (C) 2013.  All rights reserved. */
 
-#include <bufpool.h>
+#include "smsc9512.h"
 #include <ether.h>
 #include <interrupt.h>
+#include <network.h>
 #include <string.h>
 
+/**
+ * @ingroup etherspecific
+ *
+ * Take the oldest received packet off the ethptr->in circular queue, waiting
+ * for one if there is none.  Interrupts must be disabled.
+ *
+ * @param ethptr
+ *      Ethernet device, which must be up.
+ *
+ * @return
+ *      The packet, a buffer from @c inPool with @c len set to the length
+ *      of the frame at @c data.  The caller frees it with netFreebuf().
+ */
+struct packet *smsc9512_recv_packet(struct ether *ethptr)
+{
+    struct packet *pkt;
+
+    /* Wait for received packet to be available in the ethptr->in circular
+     * queue.  */
+    wait(ethptr->isema);
+
+    /* Remove the received packet from the circular queue.  */
+    pkt = ethptr->in[ethptr->istart];
+    ethptr->istart = (ethptr->istart + 1) % ETH_IBLEN;
+    ethptr->icount--;
+    return pkt;
+}
+
 /* Implementation of etherRead() for the smsc9512; see the documentation for
  * this function in ether.h.  */
 devcall etherRead(device *devptr, void *buf, uint len)
 {
     irqmask im;
     struct ether *ethptr;
-    struct ethPktBuffer *pkt;
+    struct packet *pkt;
 
     im = disable();
 
@@ -26,32 +55,19 @@ devcall etherRead(device *devptr, void *buf, uint len)
         return SYSERR;
     }
 
-    /* Wait for received packet to be available in the ethptr->in circular
-     * queue.  */
-    wait(ethptr->isema);
-
-    /* Remove the received packet from the circular queue.  */
-    pkt = ethptr->in[ethptr->istart];
-    ethptr->istart = (ethptr->istart + 1) % ETH_IBLEN;
-    ethptr->icount--;
-
-    /* TODO: we'd like to restore interrupts here (before the memcpy()), but
-     * this doesn't work yet because smsc9512_rx_complete() expects a buffer to
-     * be available if icount < ETH_IBLEN; therefore, since we decremented
-     * icount, we can't restore interrupts until we actually release the
-     * corresponding buffer.  */
+    pkt = smsc9512_recv_packet(ethptr);
+    restore(im);
 
     /* Copy the data from the packet buffer, being careful to copy at most the
      * number of bytes requested. */
-    if (pkt->length < len)
+    if (pkt->len < len)
     {
-        len = pkt->length;
+        len = pkt->len;
     }
-    memcpy(buf, pkt->buf, len);
+    memcpy(buf, pkt->data, len);
 
     /* Return the packet buffer to the pool, then return the length of the
      * packet received.  */
-    buffree(pkt);
-    restore(im);
+    netFreebuf(pkt);
     return len;
 }
@@ -7,17 +7,32 @@
 #include <bufpool.h>
 #include <ether.h>
 #include <interrupt.h>
+#include <network.h>
 #include <string.h>
 #include <usb_core_driver.h>
 
 /* Implementation of etherWrite() for the SMSC LAN9512; see the documentation
  * for this function in ether.h.  */
 devcall etherWrite(device *devptr, const void *buf, uint len)
+{
+    struct packet frame;
+
+    frame.len = len;
+    frame.curr = (uchar *)buf;
+    frame.segs = NULL;
+    frame.seglen = 0;
+    return etherWritePkt(devptr, &frame);
+}
+
+/* Implementation of etherWritePkt() for the SMSC LAN9512; see the
+ * documentation for this function in ether.h.  */
+devcall etherWritePkt(device *devptr, const struct packet *frame)
 {
     struct ether *ethptr;
     struct usb_xfer_request *req;
     uint8_t *sendbuf;
     uint32_t tx_cmd_a, tx_cmd_b;
+    uint len = frame->len;
 
     ethptr = &ethertab[devptr->minor];
     if (ethptr->state != ETH_STATE_UP ||
@@ -45,7 +60,7 @@ devcall etherWrite(device *devptr, const void *buf, uint len)
     sendbuf[6] = (tx_cmd_b >> 16) & 0xff;
     sendbuf[7] = (tx_cmd_b >> 24) & 0xff;
     STATIC_ASSERT(SMSC9512_TX_OVERHEAD == 8);
-    memcpy(sendbuf + SMSC9512_TX_OVERHEAD, buf, len);
+    netGather(sendbuf + SMSC9512_TX_OVERHEAD, frame, 0, len);
 
     /* Set total size of the data to send over the USB.  */
     req->size = len + SMSC9512_TX_OVERHEAD;
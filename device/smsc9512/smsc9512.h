@@ -61,6 +61,11 @@ struct usb_xfer_request;
 void smsc9512_rx_complete(struct usb_xfer_request *req);
 void smsc9512_tx_complete(struct usb_xfer_request *req);
 
+struct ether;
+struct packet;
+
+struct packet *smsc9512_recv_packet(struct ether *ethptr);
+
 
 static inline void
 __smsc9512_dump_reg(struct usb_device *udev, uint32_t index, const char *name)
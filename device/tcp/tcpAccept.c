@@ -0,0 +1,57 @@
+/**
+ * @file tcpAccept.c
+ *
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <interrupt.h>
+#include <semaphore.h>
+#include <tcp.h>
+
+/**
+ * @ingroup tcp
+ *
+ * Wait for a connection to a listener to be established and take it off
+ * the listener's accept queue.
+ * @param tcbptr pointer to transmission control block of listener
+ * @return device number of the connection, SYSERR if the device is not a
+ *         listener or is closed while waiting
+ * @pre-condition TCB mutex is not held
+ */
+devcall tcpAccept(struct tcb *tcbptr)
+{
+    struct tcb *child;
+    irqmask im;
+
+    im = disable();
+    while ((TCP_LISTEN == tcbptr->state)
+           && (TCP_LISTENER == tcbptr->opentype))
+    {
+        /* Signalled once for each connection queued */
+        wait(tcbptr->openclose);
+        if (TCP_LISTEN != tcbptr->state)
+        {
+            break;
+        }
+
+        /* A queued connection may have been reset since */
+        child = tcbptr->acchead;
+        if (child != NULL)
+        {
+            tcbptr->acchead = child->accnext;
+            if (NULL == tcbptr->acchead)
+            {
+                tcbptr->acctail = NULL;
+            }
+            child->accnext = NULL;
+            child->parent = NULL;
+            tcbptr->nchild--;
+            restore(im);
+            TCP_TRACE("Accepted TCB %d", child->dev);
+            return child->dev;
+        }
+    }
+    restore(im);
+    return SYSERR;
+}
@@ -7,33 +7,46 @@
 #include <stddef.h>
 #include <ipv4.h>
 #include <network.h>
+#include <string.h>
 #include <tcp.h>
 
 /**
  * @ingroup tcp
+ *
+ * Calculate the checksum of a TCP segment.
+ * @param pkt packet whose curr points to the TCP header
+ * @param len length of the TCP header and data
+ * @param src source IP address
+ * @param dst destination IP address
+ * @return checksum of the segment, 0 if it carries a correct checksum
  */
 ushort tcpChksum(struct packet *pkt, ushort len, struct netaddr *src,
                  struct netaddr *dst)
 {
-    struct tcpPseudo *pseu;
-    uchar buf[TCP_PSEUDO_LEN];
-    ushort sum;
-
-    /* Store current data before TCP header in temporary buffer */
-    pseu = (struct tcpPseudo *)(pkt->curr - TCP_PSEUDO_LEN);
-    memcpy(buf, pseu, TCP_PSEUDO_LEN);
-
-    /* Generate TCP psuedo header */
-    memcpy(pseu->srcIp, src->addr, IPv4_ADDR_LEN);
-    memcpy(pseu->dstIp, dst->addr, IPv4_ADDR_LEN);
-    pseu->zero = 0;
-    pseu->proto = IPv4_PROTO_TCP;
-    pseu->len = hs2net(len);
+    return netChksumFinish(netChksumAdd(tcpChksumPseudo(src, dst, len),
+                                        pkt->curr, len));
+}
 
-    sum = netChksum(pseu, len + TCP_PSEUDO_LEN);
+/**
+ * @ingroup tcp
+ *
+ * Sum of the pseudo header that the TCP checksum covers, to be added to
+ * the sum of the segment with netChksumAdd().
+ * @param src source IP address
+ * @param dst destination IP address
+ * @param len length of the TCP header and data
+ * @return partial sum of the pseudo header
+ */
+uint tcpChksumPseudo(const struct netaddr *src, const struct netaddr *dst,
+                     ushort len)
+{
+    struct tcpPseudo pseu;
 
-    /* Restore data before TCP header from temporary buffer */
-    memcpy(pseu, buf, TCP_PSEUDO_LEN);
+    memcpy(pseu.srcIp, src->addr, IPv4_ADDR_LEN);
+    memcpy(pseu.dstIp, dst->addr, IPv4_ADDR_LEN);
+    pseu.zero = 0;
+    pseu.proto = IPv4_PROTO_TCP;
+    pseu.len = hs2net(len);
 
-    return sum;
+    return netChksumAdd(0, &pseu, TCP_PSEUDO_LEN);
 }
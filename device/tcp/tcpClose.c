@@ -5,14 +5,18 @@
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <device.h>
+#include <interrupt.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <tcp.h>
 
+static void tcpCloseChildren(struct tcb *);
+
 /**
  * @ingroup tcp
  *
- * Close a TCP device.
+ * Close a TCP device.  Closing a listener resets the connections made to
+ * it that have not been accepted.
  * @param devptr TCP device table entry
  * @return OK if TCP is closed properly, otherwise SYSERR
  */
@@ -43,8 +47,13 @@ devcall tcpClose(device *devptr)
         {
             signaln(tcbptr->readers, semcount(tcbptr->readers) * -1);
         }
+        if (TCP_LISTENER == tcbptr->opentype)
+        {
+            tcpCloseChildren(tcbptr);
+        }
+        /* Freeing the TCB returns any waiting opens and accepts */
         tcpFree(tcbptr);
-        break;
+        return OK;
     case TCP_SYNRECV:
         tcbptr->sndfin = seqadd(tcbptr->snduna, tcbptr->ocount);
         tcbptr->sndflg |= TCP_FLG_FIN;
@@ -87,3 +96,42 @@ devcall tcpClose(device *devptr)
 
     return OK;
 }
+
+/*
+ * Resets each connection made to a listener and not accepted yet.
+ * @pre-condition listener's mutex is already held
+ */
+static void tcpCloseChildren(struct tcb *tcbptr)
+{
+    struct tcb *child;
+    bool mine;
+    int i;
+    irqmask im;
+
+    for (i = 0; i < NTCP; i++)
+    {
+        child = &tcptab[i];
+        if (child->parent != tcbptr)
+        {
+            continue;
+        }
+        wait(child->mutex);
+        im = disable();
+        mine = (child->parent == tcbptr);
+        if (mine)
+        {
+            child->parent = NULL;
+        }
+        restore(im);
+        if (mine)
+        {
+            tcpSend(child, TCP_CTRL_RST | TCP_CTRL_ACK, child->sndnxt,
+                    child->rcvnxt, 0, 0);
+            tcpFree(child);
+        }
+        else
+        {
+            signal(child->mutex);
+        }
+    }
+}
@@ -18,6 +18,7 @@ devcall tcpControl(device *devptr, int func, long arg1, long arg2)
 {
     struct tcb *tcbptr;
     uint bytes;
+    uchar opt;
 
     tcbptr = &tcptab[devptr->minor];
 
@@ -36,6 +37,98 @@ devcall tcpControl(device *devptr, int func, long arg1, long arg2)
         signal(tcbptr->mutex);
         return bytes;
 
+        /* Set size of input or output buffer for the next connection */
+    case TCP_CTRL_SETRCVBUF:
+    case TCP_CTRL_SETSNDBUF:
+        if ((tcbptr->state != TCP_CLOSED)
+            || ((arg1 != 0)
+                && ((arg1 < TCP_BUFMIN) || (arg1 > TCP_BUFMAX))))
+        {
+            signal(tcbptr->mutex);
+            return SYSERR;
+        }
+        if (TCP_CTRL_SETRCVBUF == func)
+        {
+            tcbptr->rcvbuf = arg1;
+        }
+        else
+        {
+            tcbptr->sndbuf = arg1;
+        }
+        signal(tcbptr->mutex);
+        return OK;
+
+        /* Get size of input buffer, which grows if it autotunes */
+    case TCP_CTRL_GETRCVBUF:
+        if (tcbptr->in != NULL)
+        {
+            bytes = tcbptr->ibsize;
+        }
+        else
+        {
+            bytes = (0 == tcbptr->rcvbuf) ? TCP_IBLEN : tcbptr->rcvbuf;
+        }
+        signal(tcbptr->mutex);
+        return bytes;
+
+        /* Get size of output buffer */
+    case TCP_CTRL_GETSNDBUF:
+        if (tcbptr->out != NULL)
+        {
+            bytes = tcbptr->obsize;
+        }
+        else
+        {
+            bytes = (0 == tcbptr->sndbuf) ? TCP_OBLEN : tcbptr->sndbuf;
+        }
+        signal(tcbptr->mutex);
+        return bytes;
+
+        /* Turn Nagle's algorithm or delayed ACKs off or on */
+    case TCP_CTRL_NODELAY:
+    case TCP_CTRL_QUICKACK:
+        opt = (TCP_CTRL_NODELAY == func) ? TCP_SOCK_NODELAY
+            : TCP_SOCK_QUICKACK;
+        if (arg1)
+        {
+            tcbptr->sockopt |= opt;
+        }
+        else
+        {
+            tcbptr->sockopt &= ~opt;
+        }
+        /* Send what either was holding back */
+        if (TCP_CTRL_NODELAY == func)
+        {
+            if (arg1 && ((TCP_ESTAB == tcbptr->state)
+                         || (TCP_CLOSEWT == tcbptr->state)))
+            {
+                tcpSendData(tcbptr);
+            }
+        }
+        else if (arg1 && (tcbptr->sndflg & TCP_FLG_DELACK))
+        {
+            tcpSendAck(tcbptr);
+        }
+        signal(tcbptr->mutex);
+        return OK;
+
+        /* Set the most connections a listener holds until accepted */
+    case TCP_CTRL_BACKLOG:
+        if (arg1 < 0)
+        {
+            signal(tcbptr->mutex);
+            return SYSERR;
+        }
+        tcbptr->backlog = arg1;
+        signal(tcbptr->mutex);
+        return OK;
+
+        /* Wait for the next connection to a listener */
+    case TCP_CTRL_ACCEPT:
+        signal(tcbptr->mutex);
+        return tcpAccept(tcbptr);
+
         /* Unrecongnized control function */
     default:
         signal(tcbptr->mutex);
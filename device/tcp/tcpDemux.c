@@ -1,12 +1,38 @@
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
+#include <interrupt.h>
 #include <tcp.h>
 
+/* The TCB in use with exactly these ports and remote address (none if
+ * remoteip is NULL) that is bound to the local address dstip. */
+static struct tcb *tcpLookup(ushort localpt, ushort remotept,
+                             struct netaddr *dstip, struct netaddr *remoteip)
+{
+    struct tcb *tcbptr;
+
+    for (tcbptr = tcphash[tcpHashSlot(localpt, remotept, remoteip)];
+         tcbptr != NULL; tcbptr = tcbptr->hnext)
+    {
+        if ((tcbptr->state != TCP_CLOSED)
+            && (tcbptr->localpt == localpt)
+            && (tcbptr->remotept == remotept)
+            && (netaddrequal(&tcbptr->localip, dstip))
+            && ((NULL == remoteip) ? (NULL == tcbptr->remoteip.type)
+                : netaddrequal(&tcbptr->remoteip, remoteip)))
+        {
+            return tcbptr;
+        }
+    }
+    return NULL;
+}
+
 /**
  * @ingroup tcp
  *
- * Locate the TCP socket for a TCP packet
+ * Locate the TCP socket for a TCP packet.  Looks in at most three buckets
+ * of the TCB hash table and takes no TCB mutex; the caller must wait on the
+ * mutex of the TCB returned and check that it is still open.
  * @param dstpt destination port of the TCP packet
  * @param srcpt source port of the TCP packet
  * @param dstip destination IP of the TCP packet
@@ -16,54 +42,29 @@
 struct tcb *tcpDemux(ushort dstpt, ushort srcpt, struct netaddr *dstip,
                      struct netaddr *srcip)
 {
-    struct tcb *tcbptr = NULL;
-    uint i;
-    uint level = 0;
+    struct tcb *tcbptr;
+    irqmask im;
 
-    /* Cycle through all tcp devices to find the best match */
-    for (i = 0; i < NTCP; i++)
-    {
-        wait(tcptab[i].mutex);
-        if (tcptab[i].state != TCP_CLOSED)
-        {
-            /* Full match is the best */
-            if (level < 3
-                && (tcptab[i].localpt == dstpt)
-                && (tcptab[i].remotept == srcpt)
-                && (netaddrequal(&tcptab[i].localip, dstip))
-                && (netaddrequal(&tcptab[i].remoteip, srcip)))
-            {
-                tcbptr = &tcptab[i];
-                level = 3;
-                TCP_TRACE("Level 3 match, socket %d", i);
-            }
+    im = disable();
 
-            /* Src and dst ports match */
-            if (level < 2
-                && (tcptab[i].localpt == dstpt)
-                && (tcptab[i].remotept == srcpt)
-                && (netaddrequal(&tcptab[i].localip, dstip))
-                && (tcptab[i].remoteip.type == NULL))
-            {
-                tcbptr = &tcptab[i];
-                level = 2;
-                TCP_TRACE("Level 2 match, socket %d", i);
-            }
+    /* Full match is the best */
+    tcbptr = tcpLookup(dstpt, srcpt, dstip, srcip);
 
-            /* Dst ports match is last */
-            if (level < 1
-                && (tcptab[i].localpt == dstpt)
-                && (tcptab[i].remotept == NULL)
-                && (netaddrequal(&tcptab[i].localip, dstip))
-                && (tcptab[i].remoteip.type == NULL))
-            {
-                tcbptr = &tcptab[i];
-                level = 1;
-                TCP_TRACE("Level 1 match, socket %d", i);
-            }
-        }
-        signal(tcptab[i].mutex);
+    /* Src and dst ports match */
+    if (NULL == tcbptr)
+    {
+        tcbptr = tcpLookup(dstpt, srcpt, dstip, NULL);
     }
 
+    /* Dst ports match is last */
+    if (NULL == tcbptr)
+    {
+        tcbptr = tcpLookup(dstpt, 0, dstip, NULL);
+    }
+
+    restore(im);
+
+    TCP_TRACE("Demux match, socket %d", (NULL == tcbptr) ? -1 :
+              (int)(tcbptr - tcptab));
     return tcbptr;
 }
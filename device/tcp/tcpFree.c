@@ -10,7 +10,9 @@
 /**
  * @ingroup tcp
  *
- * Delete a TCB.
+ * Delete a TCB.  The buffer sizes, options and backlog set with
+ * tcpControl() are kept for the next connection.  A connection to a
+ * listener that was not accepted yet is taken off the listener.
  * @param tcbptr pointer to transmission control block for connection
  * @precondition TCB mutex is already held
  */
@@ -18,20 +20,59 @@ devcall tcpFree(struct tcb *tcbptr)
 {
     irqmask im;
     semaphore temp;
+    uint rcvbuf, sndbuf, backlog;
+    uchar sockopt;
+    struct tcb *parent, *prev, *child;
+
+    im = disable();
+
+    /* Stop delivering segments to it */
+    tcpHashRemove(tcbptr);
+    tcpRingFree(tcbptr);
 
     /* Verify TCB is not already free */
     if (TCP_CLOSED == tcbptr->state)
     {
+        restore(im);
         signal(tcbptr->mutex);
         return SYSERR;
     }
 
     TCP_TRACE("Free TCB");
 
-    im = disable();
+    parent = tcbptr->parent;
+    if (parent != NULL)
+    {
+        prev = NULL;
+        for (child = parent->acchead; (child != NULL) && (child != tcbptr);
+             child = child->accnext)
+        {
+            prev = child;
+        }
+        if (child != NULL)
+        {
+            if (NULL == prev)
+            {
+                parent->acchead = child->accnext;
+            }
+            else
+            {
+                prev->accnext = child->accnext;
+            }
+            if (parent->acctail == child)
+            {
+                parent->acctail = prev;
+            }
+        }
+        parent->nchild--;
+    }
 
     /* Free TCB */
     temp = tcbptr->mutex;
+    rcvbuf = tcbptr->rcvbuf;
+    sndbuf = tcbptr->sndbuf;
+    sockopt = tcbptr->sockopt;
+    backlog = tcbptr->backlog;
     semfree(tcbptr->openclose);
     semfree(tcbptr->readers);
     semfree(tcbptr->writers);
@@ -40,6 +81,10 @@ devcall tcpFree(struct tcb *tcbptr)
     tcbptr->state = TCP_CLOSED;
     tcbptr->devstate = TCP_FREE;
     tcbptr->mutex = temp;
+    tcbptr->rcvbuf = rcvbuf;
+    tcbptr->sndbuf = sndbuf;
+    tcbptr->sockopt = sockopt;
+    tcbptr->backlog = backlog;
     restore(im);
     signal(tcbptr->mutex);
     return OK;
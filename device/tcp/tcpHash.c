@@ -0,0 +1,75 @@
+/**
+ * @file tcpHash.c
+ *
+ * Hash table of TCBs in use, keyed on local port, remote port and remote
+ * IP address.  A listening TCB whose remote port or address is not yet known
+ * is hashed with that part of the key zero, so tcpDemux() only has to look
+ * in three buckets to find the best match for a segment.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <tcp.h>
+
+/** @ingroup tcp
+ * Buckets of the TCB hash table.  */
+struct tcb *tcphash[TCP_NHASH];
+
+/**
+ * @ingroup tcp
+ *
+ * Bucket that holds TCBs with the given ports and remote address.
+ * @param localpt local port
+ * @param remotept remote port, or 0
+ * @param remoteip remote IP address, or @c NULL
+ * @return index into ::tcphash
+ */
+uint tcpHashSlot(ushort localpt, ushort remotept,
+                 const struct netaddr *remoteip)
+{
+    return netHashPorts(localpt, remotept, remoteip) & (TCP_NHASH - 1);
+}
+
+/**
+ * @ingroup tcp
+ *
+ * Add a TCB to the hash table under its current ports and remote address.
+ * Interrupts must be disabled.
+ * @param tcbptr pointer to transmission control block, not already in table
+ */
+void tcpHashInsert(struct tcb *tcbptr)
+{
+    tcbptr->hslot = tcpHashSlot(tcbptr->localpt, tcbptr->remotept,
+                                &tcbptr->remoteip);
+    tcbptr->hnext = tcphash[tcbptr->hslot];
+    tcphash[tcbptr->hslot] = tcbptr;
+    tcbptr->hashed = TRUE;
+}
+
+/**
+ * @ingroup tcp
+ *
+ * Take a TCB out of the hash table, if it is in it.  Must be done before
+ * changing any of its ports or addresses.  Interrupts must be disabled.
+ * @param tcbptr pointer to transmission control block
+ */
+void tcpHashRemove(struct tcb *tcbptr)
+{
+    struct tcb **prev;
+
+    if (!tcbptr->hashed)
+    {
+        return;
+    }
+    for (prev = &tcphash[tcbptr->hslot]; *prev != NULL;
+         prev = &(*prev)->hnext)
+    {
+        if (*prev == tcbptr)
+        {
+            *prev = tcbptr->hnext;
+            break;
+        }
+    }
+    tcbptr->hnext = NULL;
+    tcbptr->hashed = FALSE;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file tcpInterval.c
+ *
+ * Sorted lists of runs of sequence numbers, used for the data a receiver
+ * holds beyond rcvnxt and for the data a sender knows was selectively
+ * acknowledged.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <tcp.h>
+
+/**
+ * @ingroup tcp
+ *
+ * Add a run of sequence numbers to a sorted list of intervals, merging it
+ * with every interval it overlaps or touches.  If the list is full, the
+ * interval furthest ahead is forgotten.
+ * @param list intervals, in order
+ * @param count number of intervals in the list
+ * @param max largest number of intervals the list holds
+ * @param start first sequence number of the run
+ * @param end sequence number after the run
+ */
+void tcpIntervalAdd(struct tcpInterval *list, uint *count, uint max,
+                    tcpseq start, tcpseq end)
+{
+    uint i, j, k;
+
+    if (!seqlt(start, end))
+    {
+        return;
+    }
+
+    /* Find the first interval that does not end before this one starts */
+    for (i = 0; (i < *count) && seqlt(list[i].end, start); i++)
+    {
+    }
+
+    /* Merge with every interval this one overlaps or touches */
+    for (j = i; (j < *count) && seqlte(list[j].start, end); j++)
+    {
+        if (seqlt(list[j].start, start))
+        {
+            start = list[j].start;
+        }
+        if (seqlt(end, list[j].end))
+        {
+            end = list[j].end;
+        }
+    }
+
+    if (i == j)
+    {
+        /* Make room at i for a new interval */
+        if (max == *count)
+        {
+            if (max == i)
+            {
+                return;
+            }
+            (*count)--;
+        }
+        for (k = *count; k > i; k--)
+        {
+            list[k] = list[k - 1];
+        }
+        (*count)++;
+    }
+    else if (j > i + 1)
+    {
+        /* Close up the intervals merged into i */
+        for (k = j; k < *count; k++)
+        {
+            list[k - (j - i - 1)] = list[k];
+        }
+        *count -= j - i - 1;
+    }
+    list[i].start = start;
+    list[i].end = end;
+}
+
+/**
+ * @ingroup tcp
+ *
+ * Remove the sequence numbers before a given one from a sorted list of
+ * intervals.
+ * @param list intervals, in order
+ * @param count number of intervals in the list
+ * @param seq first sequence number to keep
+ */
+void tcpIntervalTrim(struct tcpInterval *list, uint *count, tcpseq seq)
+{
+    uint i, k;
+
+    for (i = 0; (i < *count) && seqlte(list[i].end, seq); i++)
+    {
+    }
+    if (i > 0)
+    {
+        for (k = i; k < *count; k++)
+        {
+            list[k - i] = list[k];
+        }
+        *count -= i;
+    }
+    if ((*count > 0) && seqlt(list[0].start, seq))
+    {
+        list[0].start = seq;
+    }
+}
@@ -23,8 +23,14 @@ static ushort allocPort(void);
  *           3rd argument is the remote IP address
  *           4th argument is the local port (auto-assigned if zero)
  *           5th argument is the remote port (ignored if zero)
- *           6th argument is the mode (TCP_ACTIVE or TCP_PASSIVE)
+ *           6th argument is the mode (TCP_ACTIVE, TCP_PASSIVE or
+ *           TCP_LISTENER)
  * @return OK if TCP is opened properly, otherwise SYSERR
+ *
+ * A passive open waits for one connection on the device itself.  A
+ * listener returns at once and keeps listening; each connection made to
+ * it gets a TCP device of its own, which tcpControl() with
+ * ::TCP_CTRL_ACCEPT returns once the connection is established.
  */
 devcall tcpOpen(device *devptr, va_list ap)
 {
@@ -34,6 +40,7 @@ devcall tcpOpen(device *devptr, va_list ap)
     struct netaddr *localip;
     ushort remotept;
     struct netaddr *remoteip;
+    irqmask im;
 
     /* Setup pointer to tcp */
     tcbptr = &tcptab[devptr->minor];
@@ -44,7 +51,9 @@ devcall tcpOpen(device *devptr, va_list ap)
     tcbptr->devstate = TCP_ALLOC;
 
     /* Verify device is not already open */
-    if ((tcbptr->state != TCP_CLOSED) && (tcbptr->state != TCP_LISTEN))
+    if ((tcbptr->state != TCP_CLOSED)
+        && ((tcbptr->state != TCP_LISTEN)
+            || (TCP_LISTENER == tcbptr->opentype)))
     {
         signal(tcbptr->mutex);
         TCP_TRACE("Already open");
@@ -76,7 +85,9 @@ devcall tcpOpen(device *devptr, va_list ap)
     /* Mutually link tcp record with device table entry */
     tcbptr->dev = devptr->num;
 
-    /* Initialize port and ip fields */
+    /* Initialize port and ip fields, rehashing a listening TCB */
+    im = disable();
+    tcpHashRemove(tcbptr);
     tcbptr->localpt = localpt;
     netaddrcpy(&tcbptr->localip, localip);
     tcbptr->remotept = remotept;
@@ -88,6 +99,8 @@ devcall tcpOpen(device *devptr, va_list ap)
     {
         netaddrcpy(&tcbptr->remoteip, remoteip);
     }
+    tcpHashInsert(tcbptr);
+    restore(im);
     tcbptr->opentype = mode;
 
     /* Setup transmission control block */
@@ -104,6 +117,11 @@ devcall tcpOpen(device *devptr, va_list ap)
     case TCP_PASSIVE:
         tcbptr->state = TCP_LISTEN;
         break;
+    case TCP_LISTENER:
+        tcbptr->state = TCP_LISTEN;
+        signal(tcbptr->mutex);
+        TCP_TRACE("Listening");
+        return OK;
     case TCP_ACTIVE:
         if (SYSERR == tcpOpenActive(tcbptr))
         {
@@ -22,6 +22,7 @@ static int stateCheck(struct tcb *);
 devcall tcpRead(device *devptr, void *buf, uint len)
 {
     int count = 0;
+    uint n;
     struct tcb *tcbptr;
     int check;
     char *buffer = buf;
@@ -55,16 +56,18 @@ devcall tcpRead(device *devptr, void *buf, uint len)
 //            return check; 
         }
 
-        /* Read as much as possible from the input buffer 
-         * Preserve the circular buffer  */
-        while ((tcbptr->icount > 0) && (count < len))
+        /* Read as much as possible from the input buffer */
+        n = len - count;
+        if (n > tcbptr->icount)
         {
-            *buffer++ = tcbptr->in[tcbptr->istart];
-            tcbptr->imark[tcbptr->istart] = FALSE;
-            tcbptr->istart = (tcbptr->istart + 1) % TCP_IBLEN;
-            tcbptr->icount--;
-            count++;
+            n = tcbptr->icount;
         }
+        tcpRingGet(tcbptr->in, tcbptr->ibsize, tcbptr->istart,
+                   (uchar *)buffer, n);
+        buffer += n;
+        tcbptr->istart = (tcbptr->istart + n) % tcbptr->ibsize;
+        tcbptr->icount -= n;
+        count += n;
 
 #ifdef TCP_GRACIOUSACK
         /* Send gracious acknowledgement if window has increaed */
@@ -97,6 +100,14 @@ static int stateCheck(struct tcb *tcbptr)
         /* No connection exists */
         signal(tcbptr->mutex);
         return TCP_ERR_NOCONN;
+    case TCP_LISTEN:
+        /* A listener never has a connection of its own */
+        if (TCP_LISTENER == tcbptr->opentype)
+        {
+            signal(tcbptr->mutex);
+            return TCP_ERR_NOCONN;
+        }
+        break;
     case TCP_CLOSEWT:
         /* No more data will come, but satisfy with already recvd data */
         if (tcbptr->icount > 0)
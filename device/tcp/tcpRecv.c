@@ -96,6 +96,7 @@ int tcpRecv(struct packet *pkt, struct netaddr *src, struct netaddr *dst)
     /* Send a reset if necessary */
     if (tcbptr->sndflg & TCP_FLG_SNDRST)
     {
+        tcbptr->sndflg &= ~TCP_FLG_SNDRST;
         tcpSendRst(pkt, src, dst);
     }
 
@@ -11,7 +11,9 @@
  * @ingroup tcp
  *
  * Process an ackowledgement of data in an incoming TCP segment for a
- * connection which has been fully established.
+ * connection which has been fully established.  Duplicate ACKs start fast
+ * retransmit and fast recovery as in NewReno (RFC 6582); during recovery
+ * each ACK lets the next hole, as reported by SACK, be retransmitted.
  * @param pkt incoming packet
  * @param tcbptr pointer to transmission control block for connection
  * @precondition TCB mutex is already held 
@@ -20,11 +22,16 @@
 int tcpRecvAck(struct packet *pkt, struct tcb *tcbptr)
 {
     uint amt = 0;
+    uint window;
+    uint flight;
+    ushort seglen;
     tcpseq oldend, newend;
     struct tcpPkt *tcp;
 
     /* Setup packet pointers */
     tcp = (struct tcpPkt *)pkt->curr;
+    seglen = tcpSeglen(tcp, pkt->len - (pkt->curr - pkt->linkhdr));
+    window = (uint)tcp->window << tcbptr->sndwscale;
 
     if (seqlt(tcbptr->snduna, tcp->acknum)
         && seqlte(tcp->acknum, tcbptr->sndnxt))
@@ -47,27 +54,96 @@ int tcpRecvAck(struct packet *pkt, struct tcb *tcbptr)
         }
 
         /* Adjust send buffer */
-        tcbptr->ostart = (tcbptr->ostart + amt) % TCP_OBLEN;
+        tcbptr->ostart = (tcbptr->ostart + amt) % tcbptr->obsize;
         tcbptr->ocount -= amt;
         tcbptr->obytes += amt;
-        if (tcbptr->ocount < TCP_OBLEN)
+        if (tcbptr->ocount < tcbptr->obsize)
         {
             signal(tcbptr->writers);
         }
 
         tcbptr->snduna = tcp->acknum;
+        tcpIntervalTrim(tcbptr->sacked, &tcbptr->nsacked, tcbptr->snduna);
+        tcbptr->dupacks = 0;
 
         /* Remove any segments from retransmission queue which are ACKed */
         tcbptr->rxtcount = 0;
-        tcpRecvRtt(tcbptr);
+        if (tcbptr->sndflg & TCP_FLG_RECOVER)
+        {
+            tcpTimerPurge(tcbptr, TCP_EVT_RXT);
+            if (seqlt(tcbptr->snduna, tcbptr->recover))
+            {
+                /* Partial ACK: the next hole was lost too.  Deflate the
+                 * congestion window by the data that left the network. */
+                if (amt < tcbptr->sndcwn)
+                {
+                    tcbptr->sndcwn -= amt;
+                }
+                else
+                {
+                    tcbptr->sndcwn = 0;
+                }
+                tcbptr->sndcwn += tcbptr->sndmss;
+                tcpSendHole(tcbptr);
+            }
+            else
+            {
+                /* Full ACK ends fast recovery */
+                tcbptr->sndcwn = tcbptr->sndsst;
+                tcbptr->sndflg &= ~TCP_FLG_RECOVER;
+            }
+        }
+        else
+        {
+            tcpRecvRtt(tcbptr);
+            /* After a timeout, resend the holes in what was sent before */
+            if (seqlt(tcbptr->snduna, tcbptr->recover))
+            {
+                tcpSendHole(tcbptr);
+            }
+        }
         /* If unacknowledged data remains, reschedule retransmit timer */
-        if (seqlt(tcbptr->snduna, tcbptr->sndnxt))
+        if (seqlt(tcbptr->snduna, tcbptr->sndnxt)
+            && (tcpTimerRemain(tcbptr, TCP_EVT_RXT) <= 0))
         {
             tcpTimerSched(tcbptr->rxttime, tcbptr, TCP_EVT_RXT);
         }
 
         tcbptr->sndflg |= TCP_FLG_SNDDATA;
     }
+    /* A duplicate ACK acknowledges nothing new, carries no data and leaves
+     * the window alone while data is outstanding */
+    else if ((tcp->acknum == tcbptr->snduna) && (0 == seglen)
+             && !(tcp->control & (TCP_CTRL_SYN | TCP_CTRL_FIN))
+             && (window == tcbptr->sndwnd)
+             && seqlt(tcbptr->snduna, tcbptr->sndnxt))
+    {
+        tcbptr->dupacks++;
+        if (tcbptr->sndflg & TCP_FLG_RECOVER)
+        {
+            /* Each duplicate ACK means a segment left the network */
+            tcbptr->sndcwn += tcbptr->sndmss;
+            tcpSendHole(tcbptr);
+            tcbptr->sndflg |= TCP_FLG_SNDDATA;
+        }
+        else if ((TCP_DUPACKS == tcbptr->dupacks)
+                 && !seqlt(tcbptr->snduna, tcbptr->recover))
+        {
+            /* Fast retransmit, then recover with half the data in flight */
+            flight = tcpSeqdiff(tcbptr->sndnxt, tcbptr->snduna);
+            tcbptr->sndsst = flight / 2;
+            if (tcbptr->sndsst < 2 * tcbptr->sndmss)
+            {
+                tcbptr->sndsst = 2 * tcbptr->sndmss;
+            }
+            tcbptr->recover = tcbptr->sndnxt;
+            tcbptr->sndhole = tcbptr->snduna;
+            tcbptr->sndflg |= TCP_FLG_RECOVER;
+            tcpSendHole(tcbptr);
+            tcbptr->sndcwn = tcbptr->sndsst + TCP_DUPACKS * tcbptr->sndmss;
+            TCP_TRACE("Fast retransmit %u", tcbptr->snduna);
+        }
+    }
 
     /* Update send window (if packet is not out of order) */
     if (seqlt(tcbptr->sndwl1, tcp->seqnum)
@@ -76,9 +152,9 @@ int tcpRecvAck(struct packet *pkt, struct tcb *tcbptr)
     {
         /* Calculate sequence number for end of old and new send window */
         oldend = seqadd(tcbptr->sndwl2, tcbptr->sndwnd);
-        newend = seqadd(tcp->acknum, tcp->window);
+        newend = seqadd(tcp->acknum, window);
 
-        tcbptr->sndwnd = tcp->window;
+        tcbptr->sndwnd = window;
         tcbptr->sndwl1 = tcp->seqnum;
         tcbptr->sndwl2 = tcp->acknum;
 
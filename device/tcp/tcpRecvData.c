@@ -8,6 +8,10 @@
 #include <network.h>
 #include <tcp.h>
 
+static void tcpRecvHold(struct tcb *, tcpseq, uint);
+static void tcpRecvAdvance(struct tcb *, uint);
+static void tcpRecvTune(struct tcb *);
+
 /**
  * @ingroup tcp
  *
@@ -24,12 +28,11 @@ int tcpRecvData(struct packet *pkt, struct tcb *tcbptr)
     ushort tcplen;
     ushort seglen;
 
-    uint start;
-    uint i;
-    uint index;
+    tcpseq seq;
     tcpseq offset;
     uchar *data;
     uint window;
+    uint i;
 
     /* Setup packet pointers */
     tcp = (struct tcpPkt *)pkt->curr;
@@ -50,19 +53,16 @@ int tcpRecvData(struct packet *pkt, struct tcb *tcbptr)
             /* Initialize pointer to data within TCP packet */
             data = (uchar *)tcp + offset2octets(tcp->offset);
 
-            /* Calculate where to start in segment and buffer */
-            if (seqlt(tcp->seqnum, tcbptr->rcvnxt))
+            /* Skip data already received */
+            seq = tcp->seqnum;
+            if (seqlt(seq, tcbptr->rcvnxt))
             {
-                offset = tcpSeqdiff(tcbptr->rcvnxt, tcp->seqnum);
+                offset = tcpSeqdiff(tcbptr->rcvnxt, seq);
                 data += offset;
                 seglen -= offset;
-                start = tcbptr->inxt;
-            }
-            else
-            {
-                offset = tcpSeqdiff(tcp->seqnum, tcbptr->rcvnxt);
-                start = (tcbptr->inxt + offset) % TCP_IBLEN;
+                seq = tcbptr->rcvnxt;
             }
+            offset = tcpSeqdiff(seq, tcbptr->rcvnxt);
 
             /* Copy only part of data if not enough buffer space */
             window = tcpSeqdiff(tcbptr->rcvwnd, tcbptr->rcvnxt);
@@ -74,49 +74,62 @@ int tcpRecvData(struct packet *pkt, struct tcb *tcbptr)
             }
 
             /* Copy data into buffer */
-            for (i = 0; i < seglen; i++)
+            tcpRingPut(tcbptr->in, tcbptr->ibsize,
+                       (tcbptr->inxt + offset) % tcbptr->ibsize, data, seglen);
+
+            /* Data beyond rcvnxt waits for the gap before it to fill; send
+             * a duplicate ACK at once so the sender learns of the gap */
+            if (offset != 0)
+            {
+                tcpRecvHold(tcbptr, seq, seglen);
+                tcbptr->sndflg |= TCP_FLG_SNDACK;
+                break;
+            }
+
+            /* ACK at once if this fills a gap, otherwise every second
+             * segment; a lone segment waits for the delayed ACK timer */
+            tcbptr->rcvsegs++;
+            if ((tcbptr->nooo > 0) || (tcbptr->sockopt & TCP_SOCK_QUICKACK)
+                || (tcbptr->rcvsegs >= TCP_DELACK_SEGS))
+            {
+                tcbptr->sndflg |= TCP_FLG_SNDACK;
+            }
+            else if (!(tcbptr->sndflg & TCP_FLG_DELACK))
             {
-                index = (start + i) % TCP_IBLEN;
-                tcbptr->in[index] = data[i];
-                tcbptr->imark[index] = TRUE;
+                tcbptr->sndflg |= TCP_FLG_DELACK;
+                tcpTimerSched(TCP_DELACK_TIME, tcbptr, TCP_EVT_DELACK);
             }
 
-            /* If started at begnning of window, we can ACK */
-            if (start == tcbptr->inxt)
+            /* ACK at least current data, and any held data it reaches */
+            tcpRecvAdvance(tcbptr, seglen);
+            while ((tcbptr->nooo > 0)
+                   && seqlte(tcbptr->ooo[0].start, tcbptr->rcvnxt))
             {
-                /* ACK at least current data */
-                tcbptr->icount += seglen;
-                tcbptr->ibytes += seglen;
-                tcbptr->inxt = (tcbptr->inxt + seglen) % TCP_IBLEN;
-                tcbptr->rcvnxt = seqadd(tcbptr->rcvnxt, seglen);
-
-                /* Keep going until data is missing */
-                while ((tcbptr->icount < TCP_IBLEN)
-                       && (tcbptr->imark[tcbptr->inxt]))
+                if (seqlt(tcbptr->rcvnxt, tcbptr->ooo[0].end))
                 {
-                    tcbptr->icount++;
-                    tcbptr->ibytes++;
-                    tcbptr->inxt = (tcbptr->inxt + 1) % TCP_IBLEN;
-                    tcbptr->rcvnxt = seqadd(tcbptr->rcvnxt, 1);
-
-                    /* If FIN has been seen, stop when we reach it */
-                    if ((tcbptr->rcvflg & TCP_FLG_FIN)
-                        && (tcbptr->rcvnxt == tcbptr->rcvfin))
-                    {
-                        tcp->control |= TCP_CTRL_FIN;
-                        break;
-                    }
+                    tcpRecvAdvance(tcbptr, tcpSeqdiff(tcbptr->ooo[0].end,
+                                                      tcbptr->rcvnxt));
                 }
-
-                /* Signal readers */
-                if (semcount(tcbptr->readers) < 1)
+                tcbptr->nooo--;
+                for (i = 0; i < tcbptr->nooo; i++)
                 {
-                    signal(tcbptr->readers);
+                    tcbptr->ooo[i] = tcbptr->ooo[i + 1];
                 }
+            }
+            tcpRecvTune(tcbptr);
 
-                tcbptr->sndflg |= TCP_FLG_SNDACK;
+            /* If FIN has been seen, process it if the data reached it */
+            if ((tcbptr->rcvflg & TCP_FLG_FIN)
+                && (tcbptr->rcvnxt == tcbptr->rcvfin))
+            {
+                tcp->control |= TCP_CTRL_FIN;
             }
 
+            /* Signal readers */
+            if (semcount(tcbptr->readers) < 1)
+            {
+                signal(tcbptr->readers);
+            }
             break;
 
             /* Data should not be recevied in CLOSEWT, CLOSING, LASTACK, and TIMEWT
@@ -156,8 +169,8 @@ int tcpRecvData(struct packet *pkt, struct tcb *tcbptr)
                 tcbptr->rcvnxt = seqadd(tcbptr->rcvnxt, 1);
                 if (seqlt(tcbptr->sndfin, tcbptr->snduna))
                 {
-                    tcpTimerSched(TCP_TWOMSL, tcbptr, TCP_EVT_TIMEWT);
                     tcpTimerPurge(tcbptr, NULL);
+                    tcpTimerSched(TCP_TWOMSL, tcbptr, TCP_EVT_TIMEWT);
                     tcbptr->state = TCP_TIMEWT;
                 }
                 else
@@ -200,3 +213,90 @@ int tcpRecvData(struct packet *pkt, struct tcb *tcbptr)
 
     return OK;
 }
+
+/*
+ * Moves rcvnxt forward over data that is in the input buffer.
+ * @param tcbptr TCB for connection
+ * @param len number of octets
+ */
+static void tcpRecvAdvance(struct tcb *tcbptr, uint len)
+{
+    tcbptr->icount += len;
+    tcbptr->ibytes += len;
+    tcbptr->inxt = (tcbptr->inxt + len) % tcbptr->ibsize;
+    tcbptr->rcvnxt = seqadd(tcbptr->rcvnxt, len);
+}
+
+/*
+ * Grows an input buffer that autotunes when the other side sends more than
+ * half of it in one round trip, so that the window keeps up with the
+ * bandwidth-delay product of the path.  Waits for a round trip time to be
+ * measured, and never grows the buffer beyond what the window scale agreed
+ * can advertise.
+ * @param tcbptr TCB for connection
+ */
+static void tcpRecvTune(struct tcb *tcbptr)
+{
+    ulong now;
+    uint rtt, size;
+
+    if ((tcbptr->ibsize >= tcbptr->ibmax) || (0 == tcbptr->sndrtt))
+    {
+        return;
+    }
+    now = tcpTimerNow();
+    if (0 == tcbptr->tunetime)
+    {
+        tcbptr->tuneseq = tcbptr->rcvnxt;
+        tcbptr->tunetime = now;
+        return;
+    }
+
+    /* Look at what arrived once a round trip has passed */
+    rtt = tcbptr->sndrtt >> 3;
+    if (rtt < TCP_TUNE_MINTIME)
+    {
+        rtt = TCP_TUNE_MINTIME;
+    }
+    if (now - tcbptr->tunetime < rtt)
+    {
+        return;
+    }
+    if (tcpSeqdiff(tcbptr->rcvnxt, tcbptr->tuneseq) > tcbptr->ibsize / 2)
+    {
+        size = tcbptr->ibsize * 2;
+        if (size > tcbptr->ibmax)
+        {
+            size = tcbptr->ibmax;
+        }
+        if (size > ((uint)TCP_MAX_WND << tcbptr->rcvwscale))
+        {
+            size = (uint)TCP_MAX_WND << tcbptr->rcvwscale;
+        }
+        if (size > tcbptr->ibsize)
+        {
+            tcpRingGrow(tcbptr, size);
+        }
+        TCP_TRACE("Input buffer %u", tcbptr->ibsize);
+    }
+    tcbptr->tuneseq = tcbptr->rcvnxt;
+    tcbptr->tunetime = now;
+}
+
+/*
+ * Records that the octets from seq on are in the input buffer, beyond a gap
+ * after rcvnxt.  If all intervals are in use, the one furthest from rcvnxt
+ * is forgotten; its data is simply received again.
+ * @param tcbptr TCB for connection
+ * @param seq sequence number of the first octet, after rcvnxt
+ * @param len number of octets
+ */
+static void tcpRecvHold(struct tcb *tcbptr, tcpseq seq, uint len)
+{
+    tcpIntervalAdd(tcbptr->ooo, &tcbptr->nooo, TCP_NOOO, seq,
+                   seqadd(seq, len));
+    if (len > 0)
+    {
+        tcbptr->ooolast = seq;
+    }
+}
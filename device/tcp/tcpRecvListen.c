@@ -5,13 +5,18 @@
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
+#include <interrupt.h>
 #include <network.h>
+#include <semaphore.h>
 #include <tcp.h>
 
+static int tcpRecvChild(struct packet *, struct tcb *, struct netaddr *);
+
 /**
  * @ingroup tcp
  *
  * Processes an incoming packet for a TCP connection in the LISTEN state.
+ * A SYN to a listener is handed to a TCB of its own.
  * @param pkt incoming packet
  * @param tcbptr pointer to transmission control block for connection
  * @param src source IP address
@@ -22,6 +27,7 @@ int tcpRecvListen(struct packet *pkt, struct tcb *tcbptr,
                   struct netaddr *src)
 {
     struct tcpPkt *tcp;
+    irqmask im;
 
     /* Setup packet pointers */
     tcp = (struct tcpPkt *)pkt->curr;
@@ -42,6 +48,11 @@ int tcpRecvListen(struct packet *pkt, struct tcb *tcbptr,
     /* Should receive a SYN */
     if (tcp->control & TCP_CTRL_SYN)
     {
+        if (TCP_LISTENER == tcbptr->opentype)
+        {
+            return tcpRecvChild(pkt, tcbptr, src);
+        }
+
         /* Update receive information */
         tcbptr->rcvnxt = seqadd(tcp->seqnum, 1);
         tcbptr->rcvwnd = seqadd(tcp->seqnum, TCP_INIT_WND);
@@ -49,6 +60,8 @@ int tcpRecvListen(struct packet *pkt, struct tcb *tcbptr,
         tcbptr->sndflg |= TCP_FLG_SNDACK;
 
         /* Finish specifying connection, if not already set */
+        im = disable();
+        tcpHashRemove(tcbptr);
         if (NULL == tcbptr->remotept)
         {
             tcbptr->remotept = tcp->srcpt;
@@ -57,6 +70,8 @@ int tcpRecvListen(struct packet *pkt, struct tcb *tcbptr,
         {
             netaddrcpy(&tcbptr->remoteip, src);
         }
+        tcpHashInsert(tcbptr);
+        restore(im);
 
         /* Update send information */
         tcbptr->sndwnd = tcp->window;
@@ -81,3 +96,86 @@ int tcpRecvListen(struct packet *pkt, struct tcb *tcbptr,
     /* Should not get here, but if so drop segment and return */
     return OK;
 }
+
+/*
+ * Starts a connection to a listener on a free TCB, which goes through
+ * the SYN processing of a passive open.  The SYN is dropped, and sent
+ * again by the other side later, if the listener's backlog is full or no
+ * TCB is free.
+ * @pre-condition listener's mutex is already held
+ */
+static int tcpRecvChild(struct packet *pkt, struct tcb *tcbptr,
+                        struct netaddr *src)
+{
+    struct tcpPkt *tcp;
+    struct tcb *child;
+    uint backlog;
+    int i;
+    irqmask im;
+
+    tcp = (struct tcpPkt *)pkt->curr;
+
+    backlog = (0 == tcbptr->backlog) ? TCP_BACKLOG : tcbptr->backlog;
+    if (tcbptr->nchild >= backlog)
+    {
+        TCP_TRACE("Backlog full, drop SYN");
+        return OK;
+    }
+
+    /* Allocate a TCB as tcpAlloc() does, holding on to its mutex */
+    child = NULL;
+    for (i = 0; i < NTCP; i++)
+    {
+        if (&tcptab[i] == tcbptr)
+        {
+            continue;
+        }
+        wait(tcptab[i].mutex);
+        if (TCP_FREE == tcptab[i].devstate)
+        {
+            child = &tcptab[i];
+            child->devstate = TCP_ALLOC;
+            break;
+        }
+        signal(tcptab[i].mutex);
+    }
+    if (NULL == child)
+    {
+        TCP_TRACE("No free TCB, drop SYN");
+        return OK;
+    }
+
+    /* Specify the connection, with the listener's buffers and options */
+    child->dev = i + TCP0;
+    child->opentype = TCP_PASSIVE;
+    child->state = TCP_LISTEN;
+    child->localpt = tcbptr->localpt;
+    netaddrcpy(&child->localip, &tcbptr->localip);
+    child->remotept = tcp->srcpt;
+    netaddrcpy(&child->remoteip, src);
+    child->rcvbuf = tcbptr->rcvbuf;
+    child->sndbuf = tcbptr->sndbuf;
+    child->sockopt = tcbptr->sockopt;
+    if (SYSERR == tcpSetup(child))
+    {
+        tcpFree(child);
+        return OK;
+    }
+
+    im = disable();
+    child->parent = tcbptr;
+    tcbptr->nchild++;
+    tcpHashInsert(child);
+    restore(im);
+
+    tcpRecvOpts(pkt, child);
+    if (TCP_ERR_RESET == tcpRecvListen(pkt, child, src))
+    {
+        tcpFree(child);
+    }
+    else
+    {
+        signal(child->mutex);
+    }
+    return OK;
+}
@@ -11,7 +11,11 @@
 /**
  * @ingroup tcp
  *
- * Processes the options in an incoming packet for a TCP connection.
+ * Processes the options in an incoming packet for a TCP connection.  The
+ * window scale and SACK permitted options are only taken from a SYN; if
+ * the SYN has none, the connection does not use window scaling in either
+ * direction.  Blocks of a SACK option that lie between snduna and sndnxt
+ * are added to the send scoreboard.
  * @param pkt incoming packet
  * @param tcbptr pointer to transmission control block for connection
  * @return OK
@@ -23,43 +27,105 @@ int tcpRecvOpts(struct packet *pkt, struct tcb *tcbptr)
     uchar *options;
     uchar *endopt;
     struct tcpPkt *tcp;
+    bool syn;
+    ushort mss;
+    tcpseq start, end;
+    uchar *block;
 
     tcp = (struct tcpPkt *)pkt->curr;
 
-    /* Check if the header contains options */
-    if (offset2octets(tcp->offset) == TCP_HDR_LEN)
+    /* Only the SYN that synchronizes the connection sets the window scale */
+    syn = (tcp->control & TCP_CTRL_SYN)
+        && ((TCP_LISTEN == tcbptr->state) || (TCP_SYNSENT == tcbptr->state));
+    if (syn)
     {
-        /* No options */
-        return OK;
+        tcbptr->rcvflg &= ~(TCP_FLG_WSCALE | TCP_FLG_SACK);
     }
 
     options = tcp->data;
     endopt = options + (offset2octets(tcp->offset) - TCP_HDR_LEN);
 
     /* Keep handling options until end of otpion list is encountered */
-    while ((*options != TCP_OPT_END) && (options < endopt))
+    while ((options < endopt) && (*options != TCP_OPT_END))
     {
+        if (TCP_OPT_NOP == *options)
+        {
+            options++;
+            continue;
+        }
+
+        /* Every other option has a length, which must fit in the header */
+        if ((options + 1 >= endopt) || (options[1] < 2)
+            || (options + options[1] > endopt))
+        {
+            break;
+        }
+
+        /* The options may not be word aligned, so read them an octet at a
+         * time */
         switch (*options)
         {
             /* Maximum segment size */
         case TCP_OPT_MSS:
-            options += 2;
-            /*
-             * BUG: The options may not be word aligned to deference as
-             * a short.  Discovered by RB on 7/2.
-             * FIXED by AG on 8/10.
-             * TODO: add test case with non-word aligned opts
-             */
-            tcbptr->sndmss = *options++;
-            tcbptr->sndmss += *options++ << 8;
-            tcbptr->sndmss -= TCP_HDR_LEN;
+            mss = (options[2] << 8) | options[3];
+            if ((TCP_OPT_MSS_LEN == options[1]) && (mss > TCP_HDR_LEN))
+            {
+                tcbptr->sndmss = mss - TCP_HDR_LEN;
+            }
             break;
-            /* Skip over NOP and unknown options */
-        case TCP_OPT_NOP:
+            /* Window scale */
+        case TCP_OPT_WSCALE:
+            if (syn && (TCP_OPT_WSCALE_LEN == options[1]))
+            {
+                tcbptr->sndwscale = options[2];
+                if (tcbptr->sndwscale > TCP_MAX_WSCALE)
+                {
+                    tcbptr->sndwscale = TCP_MAX_WSCALE;
+                }
+                tcbptr->rcvflg |= TCP_FLG_WSCALE;
+            }
+            break;
+            /* Selective acknowledgement permitted */
+        case TCP_OPT_SACKOK:
+            if (syn)
+            {
+                tcbptr->rcvflg |= TCP_FLG_SACK;
+            }
+            break;
+            /* Selective acknowledgement */
+        case TCP_OPT_SACK:
+            if (syn || !(tcbptr->rcvflg & TCP_FLG_SACK)
+                || !(tcp->control & TCP_CTRL_ACK))
+            {
+                break;
+            }
+            for (block = options + 2; block + 8 <= options + options[1];
+                 block += 8)
+            {
+                start = (block[0] << 24) | (block[1] << 16)
+                    | (block[2] << 8) | block[3];
+                end = (block[4] << 24) | (block[5] << 16)
+                    | (block[6] << 8) | block[7];
+                if (seqlt(tcbptr->snduna, start) && seqlt(start, end)
+                    && seqlte(end, tcbptr->sndnxt))
+                {
+                    tcpIntervalAdd(tcbptr->sacked, &tcbptr->nsacked,
+                                   TCP_NSACKED, start, end);
+                }
+            }
+            break;
+            /* Skip over unknown options */
         default:
-            options++;
             break;
         }
+        options += options[1];
+    }
+
+    /* Window scaling is only used if both sides offer it */
+    if (syn && !(tcbptr->rcvflg & TCP_FLG_WSCALE))
+    {
+        tcbptr->sndwscale = 0;
+        tcbptr->rcvwscale = 0;
     }
 
     return OK;
@@ -5,7 +5,9 @@
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
+#include <interrupt.h>
 #include <network.h>
+#include <semaphore.h>
 #include <tcp.h>
 
 /**
@@ -23,6 +25,8 @@ int tcpRecvOther(struct packet *pkt, struct tcb *tcbptr)
 {
     bool segAccept = FALSE;
     struct tcpPkt *tcp;
+    struct tcb *parent;
+    irqmask im;
 
     /* Setup packet pointers */
     tcp = (struct tcpPkt *)pkt->curr;
@@ -52,7 +56,8 @@ int tcpRecvOther(struct packet *pkt, struct tcb *tcbptr)
         case TCP_SYNRECV:
             tcbptr->rxtcount = 0;
             tcpTimerPurge(tcbptr, TCP_EVT_RXT);
-            if (TCP_PASSIVE == tcbptr->opentype)
+            if ((TCP_PASSIVE == tcbptr->opentype)
+                && (NULL == tcbptr->parent))
             {
                 tcbptr->state = TCP_LISTEN;
                 return OK;
@@ -94,7 +99,27 @@ int tcpRecvOther(struct packet *pkt, struct tcb *tcbptr)
             && seqlte(tcp->acknum, tcbptr->sndnxt))
         {
             tcbptr->state = TCP_ESTAB;
-            signal(tcbptr->openclose);  /* Signal connection open */
+            im = disable();
+            parent = tcbptr->parent;
+            if (NULL == parent)
+            {
+                signal(tcbptr->openclose);  /* Signal connection open */
+            }
+            else
+            {
+                /* Queue for tcpAccept() on the listener */
+                if (NULL == parent->acctail)
+                {
+                    parent->acchead = tcbptr;
+                }
+                else
+                {
+                    parent->acctail->accnext = tcbptr;
+                }
+                parent->acctail = tcbptr;
+                signal(parent->openclose);
+            }
+            restore(im);
         }
         else
         {
@@ -78,9 +78,17 @@ int tcpRecvSynsent(struct packet *pkt, struct tcb *tcbptr)
             tcbptr->sndwl2 = tcp->acknum;
         }
 
-        /* Remove any segments from retransmission queue which are ACKed */
+        /* Remove any segments from retransmission queue which are ACKed,
+         * taking the first round trip time from the SYN */
         tcbptr->rxtcount = 0;
-        tcpTimerPurge(tcbptr, TCP_EVT_RXT);
+        if (ackAccept)
+        {
+            tcpRecvRtt(tcbptr);
+        }
+        else
+        {
+            tcpTimerPurge(tcbptr, TCP_EVT_RXT);
+        }
         /* If unacknowledged data remains, reschedule retransmit timer */
         if (seqlt(tcbptr->snduna, tcbptr->sndnxt))
         {
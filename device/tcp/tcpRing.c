@@ -0,0 +1,210 @@
+/**
+ * @file tcpRing.c
+ *
+ * Copies in and out of the circular input and output buffers of a TCB.  A
+ * run of octets that wraps past the end of a buffer is copied in two parts.
+ * The buffers are allocated when a TCB is set up, at the sizes set with
+ * tcpControl(), and the input buffer may be grown while data is in it.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <memory.h>
+#include <network.h>
+#include <string.h>
+#include <tcp.h>
+
+/**
+ * @ingroup tcp
+ *
+ * Copy octets into a circular buffer.
+ * @param ring circular buffer
+ * @param size size of the buffer
+ * @param start index in the buffer of the first octet to write
+ * @param src octets to copy
+ * @param len number of octets, at most @p size
+ */
+void tcpRingPut(uchar *ring, uint size, uint start, const uchar *src,
+                uint len)
+{
+    uint first;
+
+    first = size - start;
+    if (len <= first)
+    {
+        memcpy(ring + start, src, len);
+    }
+    else
+    {
+        memcpy(ring + start, src, first);
+        memcpy(ring, src + first, len - first);
+    }
+}
+
+/**
+ * @ingroup tcp
+ *
+ * Copy octets out of a circular buffer.
+ * @param ring circular buffer
+ * @param size size of the buffer
+ * @param start index in the buffer of the first octet to read
+ * @param dst buffer to copy into
+ * @param len number of octets, at most @p size
+ */
+void tcpRingGet(const uchar *ring, uint size, uint start, uchar *dst,
+                uint len)
+{
+    uint first;
+
+    first = size - start;
+    if (len <= first)
+    {
+        memcpy(dst, ring + start, len);
+    }
+    else
+    {
+        memcpy(dst, ring + start, first);
+        memcpy(dst + first, ring, len - first);
+    }
+}
+
+/**
+ * @ingroup tcp
+ *
+ * Copy octets out of a circular buffer and add them to a partial Internet
+ * checksum in the same pass.
+ * @param ring circular buffer
+ * @param size size of the buffer
+ * @param start index in the buffer of the first octet to read
+ * @param dst buffer to copy into
+ * @param len number of octets, at most @p size
+ * @param sum partial sum of the data before, which must be of even length
+ * @return partial sum, as netChksumCopy() returns
+ */
+uint tcpRingGetSum(const uchar *ring, uint size, uint start, uchar *dst,
+                   uint len, uint sum)
+{
+    uint first, rest;
+
+    first = size - start;
+    if (len <= first)
+    {
+        return netChksumCopy(sum, dst, ring + start, len);
+    }
+
+    sum = netChksumCopy(sum, dst, ring + start, first);
+    if (0 == (first & 1))
+    {
+        return netChksumCopy(sum, dst + first, ring, len - first);
+    }
+
+    /* After an odd first part the octets of each word are swapped, and so
+     * is their sum */
+    rest = netChksumCopy(0, dst + first, ring, len - first);
+    sum += ((rest << 8) | (rest >> 8)) & 0xFFFF;
+    return (sum >> 16) + (sum & 0xFFFF);
+}
+
+/**
+ * @ingroup tcp
+ *
+ * Allocate the input and output buffers of a TCB, freeing any it has.
+ * @param tcbptr pointer to transmission control block for connection
+ * @return OK if the buffers were allocated, otherwise SYSERR
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+int tcpRingAlloc(struct tcb *tcbptr)
+{
+    tcpRingFree(tcbptr);
+
+    /* With no size set the input buffer starts small and autotunes */
+    if (0 == tcbptr->rcvbuf)
+    {
+        tcbptr->ibsize = TCP_IBLEN;
+        tcbptr->ibmax = TCP_IBMAX;
+    }
+    else
+    {
+        tcbptr->ibsize = tcbptr->rcvbuf;
+        tcbptr->ibmax = tcbptr->rcvbuf;
+    }
+    tcbptr->obsize = (0 == tcbptr->sndbuf) ? TCP_OBLEN : tcbptr->sndbuf;
+
+    tcbptr->in = memget(tcbptr->ibsize);
+    if (SYSERR == (int)tcbptr->in)
+    {
+        tcbptr->in = NULL;
+        return SYSERR;
+    }
+    tcbptr->out = memget(tcbptr->obsize);
+    if (SYSERR == (int)tcbptr->out)
+    {
+        tcbptr->out = NULL;
+        tcpRingFree(tcbptr);
+        return SYSERR;
+    }
+    return OK;
+}
+
+/**
+ * @ingroup tcp
+ *
+ * Free the input and output buffers of a TCB, if it has them.
+ * @param tcbptr pointer to transmission control block for connection
+ */
+void tcpRingFree(struct tcb *tcbptr)
+{
+    if (tcbptr->in != NULL)
+    {
+        memfree(tcbptr->in, tcbptr->ibsize);
+        tcbptr->in = NULL;
+    }
+    if (tcbptr->out != NULL)
+    {
+        memfree(tcbptr->out, tcbptr->obsize);
+        tcbptr->out = NULL;
+    }
+}
+
+/**
+ * @ingroup tcp
+ *
+ * Move the input buffer of a TCB into a larger one.  The octets ready for
+ * the user and any held beyond rcvnxt are copied to the start of the new
+ * buffer, in order.
+ * @param tcbptr pointer to transmission control block for connection
+ * @param size new size of the input buffer
+ * @return OK if the buffer was grown, otherwise SYSERR
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+int tcpRingGrow(struct tcb *tcbptr, uint size)
+{
+    uchar *ring;
+    uint len;
+
+    if (size <= tcbptr->ibsize)
+    {
+        return SYSERR;
+    }
+    ring = memget(size);
+    if (SYSERR == (int)ring)
+    {
+        return SYSERR;
+    }
+
+    len = tcbptr->icount;
+    if (tcbptr->nooo > 0)
+    {
+        len += tcpSeqdiff(tcbptr->ooo[tcbptr->nooo - 1].end, tcbptr->rcvnxt);
+    }
+    tcpRingGet(tcbptr->in, tcbptr->ibsize, tcbptr->istart, ring, len);
+    memfree(tcbptr->in, tcbptr->ibsize);
+
+    tcbptr->in = ring;
+    tcbptr->ibsize = size;
+    tcbptr->istart = 0;
+    tcbptr->inxt = tcbptr->icount;
+    return OK;
+}
@@ -6,6 +6,7 @@
 
 #include <stddef.h>
 #include <memory.h>
+#include <network.h>
 #include <stdlib.h>
 #include <string.h>
 #include <tcp.h>
@@ -20,6 +21,8 @@
  * @param acknum acknowledgement number for the packet
  * @param data data to be included in the packet, NULL if no data
  * @param datalen length of the data, 0 if no data
+ * @return OK if the segment was sent or is held until the next hop's
+ * address is resolved, otherwise what ipv4SendDst() returned
  * @pre-condition TCB mutex is already held
  * @post-condition TCB mutex is still held
  */
@@ -30,17 +33,34 @@ int tcpSend(struct tcb *tcbptr, uchar ctrl, uint seqnum,
     struct tcpPkt *tcp = NULL;
     int result;
     uchar *data;
-    uint i = 0;
-    ushort window = 0;
-    ushort msslen = 0;
+    uint window = 0;
+    ushort optlen = 0;
+    bool wscale = FALSE;
+    bool sackok = FALSE;
+    uint nsack = 0;
+    uint first, i;
     ushort tcplen;
+    uint sum;
 
     /* If SYN is set, then don't include in datalen, but include MSS */
     if (ctrl & TCP_CTRL_SYN)
     {
         datalen--;
-        msslen = ((3 + TCP_OPT_MSS_SIZE) & ~0x03);
+        optlen = TCP_OPT_MSS_LEN;
         TCP_TRACE("No SYN in datalen, include MSS");
+
+        /* Offer window scaling, or agree to it if the other side did */
+        if (!(ctrl & TCP_CTRL_ACK) || (tcbptr->rcvflg & TCP_FLG_WSCALE))
+        {
+            wscale = TRUE;
+            optlen += 1 + TCP_OPT_WSCALE_LEN;
+        }
+        /* Likewise for selective acknowledgements */
+        if (!(ctrl & TCP_CTRL_ACK) || (tcbptr->rcvflg & TCP_FLG_SACK))
+        {
+            sackok = TRUE;
+            optlen += 2 + TCP_OPT_SACKOK_LEN;
+        }
     }
     /* If FIN is set, then don't include in datalen */
     if (ctrl & TCP_CTRL_FIN)
@@ -49,8 +69,21 @@ int tcpSend(struct tcb *tcbptr, uchar ctrl, uint seqnum,
         TCP_TRACE("No FIN in datalen");
     }
 
+    /* If SACK is in use, report data held beyond rcvnxt in segments that
+     * carry no data, so that full segments still fit the path */
+    if (!(ctrl & TCP_CTRL_SYN) && (0 == datalen)
+        && (tcbptr->rcvflg & TCP_FLG_SACK) && (tcbptr->nooo > 0))
+    {
+        nsack = tcbptr->nooo;
+        if (nsack > TCP_OPT_SACK_MAXBLK)
+        {
+            nsack = TCP_OPT_SACK_MAXBLK;
+        }
+        optlen = 4 + nsack * 2 * sizeof(tcpseq);
+    }
+
     /* Get space to construct packet */
-    tcplen = TCP_HDR_LEN + datalen + msslen;
+    tcplen = TCP_HDR_LEN + datalen + optlen;
     if (tcplen > NET_MAX_PKTLEN)
     {
         TCP_TRACE("Packet too large");
@@ -73,34 +106,87 @@ int tcpSend(struct tcb *tcbptr, uchar ctrl, uint seqnum,
     tcp->dstpt = tcbptr->remotept;
     tcp->seqnum = seqnum;
     tcp->acknum = acknum;
-    tcp->offset = octets2offset(TCP_HDR_LEN + msslen);
+    tcp->offset = octets2offset(TCP_HDR_LEN + optlen);
     tcp->control = ctrl;
-    tcp->window = tcpSendWindow(tcbptr);
-    window = tcp->window;
+    /* The window in a SYN is never scaled */
+    window = tcpSendWindow(tcbptr);
+    if (ctrl & TCP_CTRL_SYN)
+    {
+        tcp->window = window;
+    }
+    else
+    {
+        tcp->window = window >> tcbptr->rcvwscale;
+    }
     data = tcp->data;
 
     /* Add options */
-    if (msslen)
+    if (ctrl & TCP_CTRL_SYN)
     {
         *data++ = TCP_OPT_MSS;
         *data++ = TCP_OPT_MSS_LEN;
         *((ushort *)data) = hs2net((tcbptr->rcvmss + TCP_HDR_LEN));
-        data += TCP_OPT_MSS_LEN;
-        for (i = (TCP_OPT_MSS_LEN % 4); i > 1; i--)
+        data += TCP_OPT_MSS_LEN - 2;
+        TCP_TRACE("Added MSS");
+        if (wscale)
         {
             *data++ = TCP_OPT_NOP;
+            *data++ = TCP_OPT_WSCALE;
+            *data++ = TCP_OPT_WSCALE_LEN;
+            *data++ = tcbptr->rcvwscale;
+            TCP_TRACE("Added window scale %d", tcbptr->rcvwscale);
+        }
+        if (sackok)
+        {
+            *data++ = TCP_OPT_NOP;
+            *data++ = TCP_OPT_NOP;
+            *data++ = TCP_OPT_SACKOK;
+            *data++ = TCP_OPT_SACKOK_LEN;
+            TCP_TRACE("Added SACK permitted");
         }
-        *data++ = TCP_OPT_END;
-        TCP_TRACE("Added MSS");
     }
-
-    /* Copy data into packet */
-    if (datalen > 0)
+    else if (nsack > 0)
     {
-        for (i = 0; i < datalen; i++)
+        *data++ = TCP_OPT_NOP;
+        *data++ = TCP_OPT_NOP;
+        *data++ = TCP_OPT_SACK;
+        *data++ = 2 + nsack * 2 * sizeof(tcpseq);
+
+        /* The block holding the latest segment received comes first, then
+         * the others from rcvnxt on */
+        first = 0;
+        for (i = 0; i < tcbptr->nooo; i++)
+        {
+            if (seqlte(tcbptr->ooo[i].start, tcbptr->ooolast)
+                && seqlt(tcbptr->ooolast, tcbptr->ooo[i].end))
+            {
+                first = i;
+            }
+        }
+        *((tcpseq *)data) = hl2net(tcbptr->ooo[first].start);
+        data += sizeof(tcpseq);
+        *((tcpseq *)data) = hl2net(tcbptr->ooo[first].end);
+        data += sizeof(tcpseq);
+        for (i = 0; (i < tcbptr->nooo) && (nsack > 1); i++)
         {
-            *data++ = tcbptr->out[(datastart + i) % TCP_OBLEN];
+            if (i != first)
+            {
+                *((tcpseq *)data) = hl2net(tcbptr->ooo[i].start);
+                data += sizeof(tcpseq);
+                *((tcpseq *)data) = hl2net(tcbptr->ooo[i].end);
+                data += sizeof(tcpseq);
+                nsack--;
+            }
         }
+        TCP_TRACE("Added SACK");
+    }
+
+    /* Copy data into packet, summing it for the checksum as it goes */
+    sum = tcpChksumPseudo(&tcbptr->localip, &tcbptr->remoteip, tcplen);
+    if (datalen > 0)
+    {
+        sum = tcpRingGetSum(tcbptr->out, tcbptr->obsize,
+                            datastart % tcbptr->obsize, data, datalen, sum);
     }
 
     /* Convert TCP header fields to net order */
@@ -111,20 +197,38 @@ int tcpSend(struct tcb *tcbptr, uchar ctrl, uint seqnum,
     tcp->window = hs2net(tcp->window);
     tcp->urgent = hs2net(tcp->urgent);
 
-    /* Calculate TCP checksum */
-    tcp->chksum = tcpChksum(pkt, tcplen, &tcbptr->localip,
-                            &tcbptr->remoteip);
+    /* Calculate TCP checksum, adding the header and options to the sum */
+    tcp->chksum = netChksumFinish(netChksumAdd(sum, tcp, tcplen - datalen));
+
+    /* Whatever ACK was delayed goes out with this segment */
+    if (ctrl & TCP_CTRL_ACK)
+    {
+        tcbptr->rcvsegs = 0;
+        if (tcbptr->sndflg & TCP_FLG_DELACK)
+        {
+            tcbptr->sndflg &= ~TCP_FLG_DELACK;
+            tcpTimerPurge(tcbptr, TCP_EVT_DELACK);
+        }
+    }
 
     /* Send TCP packet */
-    result = ipv4Send(pkt, &tcbptr->localip, &tcbptr->remoteip,
-                      IPv4_PROTO_TCP);
+    result = ipv4SendDst(pkt, &tcbptr->localip, &tcbptr->remoteip,
+                         IPv4_PROTO_TCP, &tcbptr->dst);
 
     if (SYSERR == netFreebuf(pkt))
     {
         return SYSERR;
     }
 
-    if (result == OK)
+    /* A segment held until the next hop's address is resolved is sent
+     * then, so it counts as sent */
+    if (result == NET_QUEUED)
+    {
+        TCP_TRACE("QUEUED <C=0x%02X><S=%u><A=%u><dl=%u><w=%u>",
+                  ctrl, seqnum, acknum, datalen, window);
+        result = OK;
+    }
+    else if (result == OK)
     {
         TCP_TRACE("SENT <C=0x%02X><S=%u><A=%u><dl=%u><w=%u>",
                       ctrl, seqnum, acknum, datalen, window)
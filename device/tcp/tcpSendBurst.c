@@ -0,0 +1,174 @@
+/**
+ * @file tcpSendBurst.c
+ *
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <bufpool.h>
+#include <network.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tcp.h>
+
+static void tcpTmplBuild(struct tcb *);
+
+/**
+ * @ingroup tcp
+ *
+ * Sends a run of full size data segments for a TCP connection.  Each
+ * segment's headers are copied from the connection's template, and only
+ * its sequence number, window, lengths and checksums are filled in; the
+ * segments go to the network interface ::TCP_BURST at a time, with the
+ * link-level header from the connection's destination cache.
+ * @param tcbptr pointer to the transmission control block for connection
+ * @param seqnum sequence number for the first segment
+ * @param datastart index in the output buffer of the first segment's data
+ * @param nseg number of segments of sndmss octets to send
+ * @return number of segments sent, SYSERR if they must be sent with
+ * 	tcpSend() instead because the destination is not cached or they
+ * 	would need to be fragmented
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+int tcpSendBurst(struct tcb *tcbptr, uint seqnum, uint datastart, uint nseg)
+{
+    struct packet *pkts[TCP_BURST];
+    struct packet *pkt;
+    struct ipv4Pkt *ip;
+    struct tcpPkt *tcp;
+    ushort tcplen, window;
+    tcpseq acknum;
+    ushort id;
+    uint sent, n, i, sum;
+    int result;
+
+    /* Segments that need fragmenting or address resolution go one at a
+     * time */
+    if (OK != netDstLookup(&tcbptr->dst, &tcbptr->remoteip))
+    {
+        return SYSERR;
+    }
+    tcplen = TCP_HDR_LEN + tcbptr->sndmss;
+    if (IPv4_HDR_LEN + tcplen > tcbptr->dst.nif->mtu)
+    {
+        return SYSERR;
+    }
+
+    if (!tcbptr->tmplok)
+    {
+        tcpTmplBuild(tcbptr);
+    }
+    window = hs2net(tcpSendWindow(tcbptr) >> tcbptr->rcvwscale);
+    acknum = hl2net(tcbptr->rcvnxt);
+
+    sent = 0;
+    while (sent < nseg)
+    {
+        /* Get buffers for a burst; only the first of them may wait */
+        pkt = bufget(netpool);
+        if (SYSERR == (int)pkt)
+        {
+            TCP_TRACE("Failed to get buffer");
+            break;
+        }
+        pkts[0] = pkt;
+        n = (nseg - sent < TCP_BURST) ? nseg - sent : TCP_BURST;
+        n = 1 + bufgetn(netpool, (void **)&pkts[1], n - 1);
+        id = ipv4IdTake(n);
+
+        /* Build each segment at the end of its buffer, as tcpSend() and
+         * ipv4Send() would, from the template */
+        for (i = 0; i < n; i++)
+        {
+            pkt = pkts[i];
+            pkt->nif = tcbptr->dst.nif;
+            pkt->linkhdr = NULL;
+            pkt->nethdr = NULL;
+            pkt->segs = NULL;
+            pkt->seglen = 0;
+            pkt->len = IPv4_HDR_LEN + tcplen;
+            pkt->curr = pkt->data + NET_MAX_PKTLEN
+                - ((tcplen + 0x7) & ~0x7) - IPv4_HDR_LEN;
+            memcpy(pkt->curr, tcbptr->tmpl, IPv4_HDR_LEN + TCP_HDR_LEN);
+
+            /* Each segment is its own datagram, with an identification
+             * from the counter ipv4Send() uses, in case it is fragmented
+             * on the way */
+            ip = (struct ipv4Pkt *)pkt->curr;
+            ip->len = hs2net(pkt->len);
+            ip->id = hs2net(id);
+            id++;
+            ip->chksum = netChksumFinish(tcbptr->tmplipsum + ip->len + ip->id);
+
+            tcp = (struct tcpPkt *)(pkt->curr + IPv4_HDR_LEN);
+            tcp->seqnum = hl2net(seqnum);
+            tcp->acknum = acknum;
+            tcp->window = window;
+            sum = tcpRingGetSum(tcbptr->out, tcbptr->obsize, datastart,
+                                tcp->data, tcbptr->sndmss,
+                                tcbptr->tmplsum + hs2net(tcplen));
+            tcp->chksum = netChksumFinish(netChksumAdd(sum, tcp,
+                                                       TCP_HDR_LEN));
+
+            seqnum = seqadd(seqnum, tcbptr->sndmss);
+            datastart = (datastart + tcbptr->sndmss) % tcbptr->obsize;
+        }
+
+        /* Send the burst */
+        result = netSendPkts(pkts, n, &tcbptr->dst);
+        buffreen((void **)pkts, n);
+        TCP_TRACE("%s %u segments", (OK == result) ? "SENT" : "FAILED to send",
+                  n);
+        sent += n;
+        if (SYSERR == result)
+        {
+            break;
+        }
+    }
+
+    /* Whatever ACK was delayed went out with these segments */
+    if (sent > 0)
+    {
+        tcbptr->rcvsegs = 0;
+        if (tcbptr->sndflg & TCP_FLG_DELACK)
+        {
+            tcbptr->sndflg &= ~TCP_FLG_DELACK;
+            tcpTimerPurge(tcbptr, TCP_EVT_DELACK);
+        }
+    }
+
+    return sent;
+}
+
+/*
+ * Builds the IPv4 and TCP headers shared by a connection's full size data
+ * segments, with their lengths, identifications, sequence numbers, window
+ * and checksums zero, and the sums of the headers that do not change.
+ */
+static void tcpTmplBuild(struct tcb *tcbptr)
+{
+    struct ipv4Pkt *ip;
+    struct tcpPkt *tcp;
+
+    bzero(tcbptr->tmpl, sizeof(tcbptr->tmpl));
+
+    ip = (struct ipv4Pkt *)tcbptr->tmpl;
+    ip->ver_ihl = (uchar)(IPv4_VERSION << 4) + IPv4_HDR_LEN / 4;
+    ip->tos = IPv4_TOS_ROUTINE;
+    ip->ttl = IPv4_TTL;
+    ip->proto = IPv4_PROTO_TCP;
+    memcpy(ip->src, tcbptr->localip.addr, IPv4_ADDR_LEN);
+    memcpy(ip->dst, tcbptr->remoteip.addr, IPv4_ADDR_LEN);
+    tcbptr->tmplipsum = netChksumAdd(0, ip, IPv4_HDR_LEN);
+
+    tcp = (struct tcpPkt *)(tcbptr->tmpl + IPv4_HDR_LEN);
+    tcp->srcpt = hs2net(tcbptr->localpt);
+    tcp->dstpt = hs2net(tcbptr->remotept);
+    tcp->offset = octets2offset(TCP_HDR_LEN);
+    tcp->control = TCP_CTRL_ACK;
+    tcbptr->tmplsum = tcpChksumPseudo(&tcbptr->localip, &tcbptr->remoteip,
+                                      0);
+
+    tcbptr->tmplok = TRUE;
+}
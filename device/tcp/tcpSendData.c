@@ -21,8 +21,10 @@ int tcpSendData(struct tcb *tcbptr)
 {
     uint wndused;      /**< amount of window filled with data pending ACK */
     uint pending;      /**< amount of data pending ACK or transmission */
+    uint window;       /**< smaller of send and congestion windows */
     uint tosend;
     uint sent;
+    int nseg;
     uchar ctrl;
 
     /* Verify sender MSS is greater than 0 */
@@ -54,8 +56,13 @@ int tcpSendData(struct tcb *tcbptr)
     }
 
     /* Check if new transmssion is allowed */
-    /* If (SNDNXT >= SNDUNA + SNDWND), then can't send data */
-    if (seqlte(seqadd(tcbptr->snduna, tcbptr->sndwnd), tcbptr->sndnxt))
+    /* If (SNDNXT >= SNDUNA + min(SNDWND, SNDCWN)), then can't send data */
+    window = tcbptr->sndwnd;
+    if (tcbptr->sndcwn < window)
+    {
+        window = tcbptr->sndcwn;
+    }
+    if (seqlte(seqadd(tcbptr->snduna, window), tcbptr->sndnxt))
     {
         return 0;
     }
@@ -80,9 +87,9 @@ int tcpSendData(struct tcb *tcbptr)
     /* There is data to send and space in the window to send it */
     ctrl = TCP_CTRL_ACK;
     /* Determine how much data to send */
-    if (pending > tcbptr->sndwnd)
+    if (pending > window)
     {
-        tosend = tcbptr->sndwnd - wndused;
+        tosend = window - wndused;
     }
     else
     {
@@ -93,24 +100,45 @@ int tcpSendData(struct tcb *tcbptr)
         }
     }
 
-    /* Send as many maximum size segments as possible */
+    /* Send as many maximum size segments as possible, in bursts where
+     * the path allows, and one at a time otherwise */
     sent = 0;
+    if (tosend > tcbptr->sndmss)
+    {
+        nseg = tcpSendBurst(tcbptr, tcbptr->sndnxt,
+                            (tcbptr->ostart + wndused) % tcbptr->obsize,
+                            (tosend - 1) / tcbptr->sndmss);
+        if (nseg > 0)
+        {
+            tosend -= nseg * tcbptr->sndmss;
+            sent += nseg * tcbptr->sndmss;
+            wndused += nseg * tcbptr->sndmss;
+            tcbptr->sndnxt = seqadd(tcbptr->sndnxt, nseg * tcbptr->sndmss);
+        }
+    }
     while (tosend > tcbptr->sndmss)
     {
         tcpSend(tcbptr, TCP_CTRL_ACK, tcbptr->sndnxt, tcbptr->rcvnxt,
-                (tcbptr->ostart + wndused) % TCP_OBLEN, tcbptr->sndmss);
+                (tcbptr->ostart + wndused) % tcbptr->obsize, tcbptr->sndmss);
         tosend -= tcbptr->sndmss;
         sent += tcbptr->sndmss;
         wndused += tcbptr->sndmss;
         tcbptr->sndnxt = seqadd(tcbptr->sndnxt, tcbptr->sndmss);
     }
 
-    /* Send the remainder of the sendable data */
-    tcpSend(tcbptr, ctrl, tcbptr->sndnxt, tcbptr->rcvnxt,
-            (tcbptr->ostart + wndused) % TCP_OBLEN, tosend);
-    sent += tosend;
-    wndused += tosend;
-    tcbptr->sndnxt = seqadd(tcbptr->sndnxt, tosend);
+    /* Send the remainder of the sendable data, unless it is a partial
+     * segment and data is pending ACK (Nagle, RFC 896); it goes out when
+     * the ACK arrives or more data fills the segment */
+    if ((tosend == tcbptr->sndmss) || (ctrl & TCP_CTRL_FIN)
+        || (tcbptr->sockopt & TCP_SOCK_NODELAY)
+        || (tcbptr->snduna == tcbptr->sndnxt))
+    {
+        tcpSend(tcbptr, ctrl, tcbptr->sndnxt, tcbptr->rcvnxt,
+                (tcbptr->ostart + wndused) % tcbptr->obsize, tosend);
+        sent += tosend;
+        wndused += tosend;
+        tcbptr->sndnxt = seqadd(tcbptr->sndnxt, tosend);
+    }
 
     /* If one does not already exist, schedule a retransmission event */
     if (tcpTimerRemain(tcbptr, TCP_EVT_RXT) <= 0)
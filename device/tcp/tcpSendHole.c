@@ -0,0 +1,81 @@
+/**
+ * @file tcpSendHole.c
+ *
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <tcp.h>
+
+/**
+ * @ingroup tcp
+ *
+ * Retransmits the next hole in the data pending ACK during loss recovery.
+ * The hole starts at snduna, or after the last hole retransmitted, and
+ * skips whatever the receiver reported with SACK.  Without SACK blocks
+ * beyond it, only the segment at snduna is known to be missing, as in
+ * NewReno.
+ * @param tcbptr pointer to the transmission control block for connection
+ * @return number of sequence numbers retransmitted, counting the FIN
+ * @pre-condition TCB mutex is already held
+ * @post-condition TCB mutex is still held
+ */
+int tcpSendHole(struct tcb *tcbptr)
+{
+    tcpseq seq, end;
+    uint tosend, datalen, i;
+    uchar ctrl;
+
+    seq = tcbptr->snduna;
+    if (seqlt(seq, tcbptr->sndhole))
+    {
+        seq = tcbptr->sndhole;
+    }
+
+    /* Skip over data the receiver already has, and find where the hole
+     * ends */
+    end = tcbptr->sndnxt;
+    for (i = 0; i < tcbptr->nsacked; i++)
+    {
+        if (seqlt(seq, tcbptr->sacked[i].start))
+        {
+            end = tcbptr->sacked[i].start;
+            break;
+        }
+        if (seqlt(seq, tcbptr->sacked[i].end))
+        {
+            seq = tcbptr->sacked[i].end;
+        }
+    }
+    if (!seqlt(seq, end)
+        || ((i == tcbptr->nsacked) && (seq != tcbptr->snduna)))
+    {
+        return 0;
+    }
+
+    /* Send at most a segment, with the FIN if it is in the hole.  The FIN
+     * takes the last sequence number of the hole, not an octet of data */
+    ctrl = TCP_CTRL_ACK;
+    tosend = tcpSeqdiff(end, seq);
+    if (tosend > tcbptr->sndmss)
+    {
+        tosend = tcbptr->sndmss;
+    }
+    datalen = tosend;
+    if ((tcbptr->sndflg & TCP_FLG_FIN)
+        && seqlt(tcbptr->sndfin, seqadd(seq, tosend)))
+    {
+        ctrl |= TCP_CTRL_FIN;
+        datalen--;
+    }
+    tcpSend(tcbptr, ctrl, seq, tcbptr->rcvnxt,
+            (tcbptr->ostart + tcpSeqdiff(seq, tcbptr->snduna))
+            % tcbptr->obsize, datalen);
+    tcbptr->sndhole = seqadd(seq, tosend);
+
+    /* Give the retransmission a full timeout before falling back on the
+     * retransmission timer */
+    tcpTimerPurge(tcbptr, TCP_EVT_RXT);
+    tcpTimerSched(tcbptr->rxttime, tcbptr, TCP_EVT_RXT);
+    return tosend;
+}
@@ -96,6 +96,13 @@ int tcpSendRxt(struct tcb *tcbptr)
     tcpSend(tcbptr, control, tcbptr->snduna, tcbptr->rcvnxt,
             tcbptr->ostart, tosend);
 
+    /* A timeout ends fast recovery; the holes in what was sent so far are
+     * resent as ACKs for this segment arrive */
+    tcbptr->sndflg &= ~TCP_FLG_RECOVER;
+    tcbptr->dupacks = 0;
+    tcbptr->recover = tcbptr->sndnxt;
+    tcbptr->sndhole = seqadd(tcbptr->snduna, tosend);
+
     /* Adjust sender congestion window */
     if (first)
     {
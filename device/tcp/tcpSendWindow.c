@@ -10,18 +10,22 @@
 /**
  * @ingroup tcp
  *
- * Calculates the window size to advertise in an outgoing TCP packet.
+ * Calculates the window size to advertise in an outgoing TCP packet.  Once
+ * the connection is synchronized a new window is a whole number of units of
+ * the window scale, so the end of window recorded in rcvwnd is the one the
+ * other side is told.
  * @param tcbptr pointer to transmission control block for connection
+ * @return window in octets, before it is scaled
  * @pre-condition TCB mutex is already held
  * @post-condition TCB mutex is still held
  */
-ushort tcpSendWindow(struct tcb *tcbptr)
+uint tcpSendWindow(struct tcb *tcbptr)
 {
-    ushort unused = 0;
-    ushort window = 0;
+    uint unused = 0;
+    uint window = 0;
 
     /* Set proposed window to maximum possible */
-    window = TCP_IBLEN - tcbptr->icount;        // Correct?
+    window = tcbptr->ibsize - tcbptr->icount;
 
     switch (tcbptr->state)
     {
@@ -31,14 +35,26 @@ ushort tcpSendWindow(struct tcb *tcbptr)
     case TCP_LISTEN:
     case TCP_SYNSENT:
     case TCP_SYNRECV:
-        /* Don't do receiver-side silly window syndrome avoidance */
+        /* Don't do receiver-side silly window syndrome avoidance, and
+         * don't rely on window scaling before it is agreed */
+        if (window > TCP_MAX_WND)
+        {
+            window = TCP_MAX_WND;
+        }
         tcbptr->rcvwnd = seqadd(tcbptr->rcvnxt, window);
         return window;
     }
 
+    /* Fit the window in the window field once it is scaled */
+    if (window > ((uint)TCP_MAX_WND << tcbptr->rcvwscale))
+    {
+        window = (uint)TCP_MAX_WND << tcbptr->rcvwscale;
+    }
+    window &= ~((1 << tcbptr->rcvwscale) - 1);
+
     /* Receiver-side silly window syndrome avoidance */
     /* Calculate unsued portion of currently advertised window */
-    unused = (ushort)tcpSeqdiff(tcbptr->rcvwnd, tcbptr->rcvnxt);
+    unused = tcpSeqdiff(tcbptr->rcvwnd, tcbptr->rcvnxt);
 #ifdef TCP_FAKEACK
     if (seqlt(tcbptr->rcvwnd, tcbptr->rcvnxt))
     {
@@ -46,7 +62,7 @@ ushort tcpSendWindow(struct tcb *tcbptr)
     }
 #endif
     /* Use 0 if proposed window less than 1/4 buffer or less than 1 MSS */
-    if (((window * 4) < TCP_IBLEN) || (window < tcbptr->rcvmss))
+    if (((window * 4) < tcbptr->ibsize) || (window < tcbptr->rcvmss))
     {
         window = 0;
     }
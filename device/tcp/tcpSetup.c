@@ -36,6 +36,7 @@ int tcpSetup(struct tcb *tcbptr)
     tcbptr->istart = 0;
     tcbptr->inxt = 0;
     tcbptr->icount = 0;
+    tcbptr->nooo = 0;
     tcbptr->ibytes = 0;
     tcbptr->readers = semcreate(0);
 
@@ -53,10 +54,15 @@ int tcpSetup(struct tcb *tcbptr)
     tcbptr->sndmss = TCP_INIT_MSS;
     tcbptr->sndflg = NULL;
     tcbptr->sndcwn = tcbptr->sndmss;
-    tcbptr->sndsst = TCP_MAX_WND;
+    tcbptr->sndsst = (uint)TCP_MAX_WND << TCP_MAX_WSCALE;  /* no limit */
     tcbptr->rxttime = TCP_RXT_INITTIME;
     tcbptr->rxtcount = 0;
     tcbptr->psttime = TCP_PST_INITTIME;
+    tcbptr->dupacks = 0;
+    tcbptr->recover = tcbptr->iss;
+    tcbptr->sndhole = tcbptr->iss;
+    tcbptr->nsacked = 0;
+    tcbptr->tmplok = FALSE;
 
     /* Initialize receive fields */
     tcbptr->rcvmss = TCP_INIT_MSS - TCP_HDR_LEN;
@@ -70,6 +76,23 @@ int tcpSetup(struct tcb *tcbptr)
         return SYSERR;
     }
 
+    /* Allocate input and output buffers, which a listener never uses */
+    if ((tcbptr->opentype != TCP_LISTENER)
+        && (SYSERR == tcpRingAlloc(tcbptr)))
+    {
+        return SYSERR;
+    }
+    tcbptr->tunetime = 0;
+
+    /* Offer a window scale large enough for the input buffer to grow */
+    tcbptr->sndwscale = 0;
+    tcbptr->rcvwscale = 0;
+    while ((tcbptr->rcvwscale < TCP_MAX_WSCALE)
+           && ((TCP_MAX_WND << tcbptr->rcvwscale) < tcbptr->ibmax))
+    {
+        tcbptr->rcvwscale++;
+    }
+
     return OK;
 }
 
@@ -25,8 +25,8 @@ void tcpStat(struct tcb *tcbptr)
     tcpseq rcvnxt, rcvwnd;
     tcpseq snduna, sndnxt;
     uint sndwnd;
-    uint istart, icount, ibytes;
-    uint ostart, ocount, obytes;
+    uint istart, icount, ibytes, ibsize;
+    uint ostart, ocount, obytes, obsize;
     char strA[20];
     char strB[20];
 
@@ -57,9 +57,11 @@ void tcpStat(struct tcb *tcbptr)
     istart = tcbptr->istart;
     icount = tcbptr->icount;
     ibytes = tcbptr->ibytes;
+    ibsize = tcbptr->ibsize;
     ostart = tcbptr->ostart;
     ocount = tcbptr->ocount;
     obytes = tcbptr->obytes;
+    obsize = tcbptr->obsize;
 
     signal(tcbptr->mutex);
 
@@ -120,6 +122,9 @@ void tcpStat(struct tcb *tcbptr)
     case TCP_ACTIVE:
         sprintf(strB, "Active");
         break;
+    case TCP_LISTENER:
+        sprintf(strB, "Listener");
+        break;
     default:
         sprintf(strB, "Unknown");
         break;
@@ -144,11 +149,11 @@ void tcpStat(struct tcb *tcbptr)
 
     /* Buffers */
     printf("           ");
-    printf("In  Start: %-10u Count: %-10u Read %-10u\n",
-           istart, icount, ibytes);
+    printf("In  Start: %-10u Count: %-10u Read %-10u Size %-10u\n",
+           istart, icount, ibytes, ibsize);
     printf("           ");
-    printf("Out Start: %-10u Count: %-10u Read %-10u\n",
-           ostart, ocount, obytes);
+    printf("Out Start: %-10u Count: %-10u Read %-10u Size %-10u\n",
+           ostart, ocount, obytes, obsize);
     printf("\n");
 
     return;
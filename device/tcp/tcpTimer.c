@@ -1,21 +1,52 @@
 /**
  * @file tcpTimer.c
  *
+ * TCP timer wheel.  Each TCB has one event of each type; while it is
+ * scheduled it sits in the slot of ::tcpwheel for the tick it is due,
+ * modulo ::TCP_WHEELSLOTS, so scheduling and cancelling are O(1).  An event
+ * more than one turn of the wheel away stays in its slot until the turn
+ * in which it is due.  The timer thread sleeps until the next event is
+ * due, or until woken when nothing is scheduled, and tcpTimerSched() wakes
+ * it early if an event is scheduled before that.
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <clock.h>
 #include <interrupt.h>
-#include <semaphore.h>
 #include <stddef.h>
-#include <stdlib.h>
 #include <tcp.h>
 #include <thread.h>
 
-struct tcpEvent tcptimertab[TCP_NEVENTS];
-semaphore tcpmutex;
+#define TCP_WHEELMASK (TCP_WHEELSLOTS - 1)
 
-static int calcElapsed(int, int);
+/** @ingroup tcp
+ * Slots of the TCP timer wheel, one per tick.  */
+struct tcpEvent *tcpwheel[TCP_WHEELSLOTS];
+
+/** @ingroup tcp
+ * Bitmap of the non-empty slots of ::tcpwheel.  */
+uint tcpwheelmap[TCP_WHEELSLOTS / 32];
+
+/** @ingroup tcp
+ * Thread ID of the TCP timer thread.  */
+tid_typ tcptimerid = BADTID;
+
+/** @ingroup tcp
+ * TRUE while the TCP timer thread sleeps until ::tcptimerwake.  */
+bool tcptimerasleep;
+
+/** @ingroup tcp
+ * Tick at which the TCP timer thread is next due to wake.  */
+ulong tcptimerwake;
+
+/** @ingroup tcp
+ * Number of times the TCP timer thread has woken up.  */
+ulong tcptimerwakes;
+
+static ulong tcpwheelnow;       /* last tick whose slot was processed */
+
+static struct tcpEvent *tcpTimerDue(uint, ulong);
+static ulong tcpTimerNext(ulong);
 
 /**
  * @ingroup tcp
@@ -24,108 +55,135 @@ static int calcElapsed(int, int);
  */
 thread tcpTimer(void)
 {
-    struct tcpEvent *first = NULL;
-    struct tcpEvent *head = NULL;
-    ulong lastticks;
-    ulong lasttime;
-    ulong elapse;
-    irqmask ps;
+    struct tcpEvent *evtptr;
+    struct tcb *tcbptr;
+    ulong now, ticks, next, i;
     uchar type;
-    struct tcb *tcbptr = NULL;
-
-    /* Setup timer event delta queue */
-    bzero(tcptimertab, sizeof(struct tcpEvent) * TCP_NEVENTS);
-    tcpmutex = semcreate(1);
-    head = &tcptimertab[TCP_EVT_HEAD];
-    head->used = TRUE;
-    head->next = NULL;
+    irqmask im;
 
     TCP_TRACE("Timer init complete");
-    /* Initialize timer accounting information */
-    ps = disable();
-    lastticks = clkticks;
-    lasttime = clktime;
-    elapse = 0;
-    restore(ps);
-    sleep(TCP_FREQ);
+    im = disable();
+    tcptimerid = gettid();
+    tcpwheelnow = tcpTimerNow();
+    restore(im);
 
     while (TRUE)
     {
-//              TCP_TRACE("Tick");
-        wait(tcpmutex);
-        while ((head->next != NULL) && (elapse > 0))
-        {
-            first = head->next;
-            if (first->remain > elapse)
-            {
-                first->remain -= elapse;
-                break;
-            }
+        im = disable();
+        tcptimerasleep = FALSE;
+        now = tcpTimerNow();
 
-            elapse -= first->remain;
-            first->remain = 0;
-            while ((first != NULL) && (first->remain <= 0))
+        /* Trigger the events due in every tick since the last pass */
+        ticks = now - tcpwheelnow;
+        if (ticks > TCP_WHEELSLOTS)
+        {
+            ticks = TCP_WHEELSLOTS;
+        }
+        for (i = 1; i <= ticks; i++)
+        {
+            while (NULL != (evtptr = tcpTimerDue(tcpwheelnow + i, now)))
             {
-                /* Save event information and update pointers */
-                type = first->type;
-                tcbptr = first->tcbptr;
-                first->used = FALSE;
-                head->next = first->next;
-
-                /* Release mutex in case triggered event needs it */
-                signal(tcpmutex);
-
-                /* Trigger event */
+                type = evtptr->type;
+                tcbptr = evtptr->tcbptr;
+                tcpTimerPurge(tcbptr, type);
+                restore(im);
                 tcpTimerTrigger(type, tcbptr);
-
-                /* Reclaim mutex */
-                wait(tcpmutex);
-
-                /* Obtain first event (which may have changed while 
-                 * mutex was released) */
-                first = head->next;
+                im = disable();
             }
         }
-        signal(tcpmutex);
-
-        ps = disable();
-        elapse = calcElapsed(lastticks, lasttime);
-        restore(ps);
+        tcpwheelnow = now;
 
-//        sleep(TCP_FREQ - elapse);
-        sleep(TCP_FREQ);
+        /* Sleep until the next event is due */
+        next = tcpTimerNext(now);
+        tcptimerasleep = TRUE;
+        tcptimerwake = now + ((~0UL == next) ? (~0UL >> 1) : next);
+        restore(im);
 
-        ps = disable();
-        elapse = calcElapsed(lastticks, lasttime);
-        lastticks = clkticks;
-        lasttime = clktime;
-        restore(ps);
+        if (~0UL == next)
+        {
+            receive();
+        }
+        else
+        {
+            recvtime(next);
+        }
+        tcptimerwakes++;
     }
     return OK;
 }
 
 /**
- * Calulates the number of milliseconds elapsed.
- * @param lastticks last value of clock ticks
- * @param lasttime last value of clock time
- * @return number of milliseconds elapsed between the time provided and now 
- * @precondition interrupts are disabled
- * @postcondition interrupts are still disabled
+ * @ingroup tcp
+ *
+ * Current time for TCP timers.
+ * @return ticks of the clock since boot, which are milliseconds
  */
-static int calcElapsed(int lastticks, int lasttime)
+ulong tcpTimerNow(void)
 {
-    int ticks = 0;
+    ulong now;
+    irqmask im;
+
+    im = disable();
+#if TICKLESS
+    clkcatchup();
+#endif
+    now = tmrnow;
+    restore(im);
+    return now;
+}
 
-    if (lasttime == clktime)
+/*
+ * First event in the slot of a tick that is due by now, NULL if none.
+ * Interrupts must be disabled.
+ */
+static struct tcpEvent *tcpTimerDue(uint tick, ulong now)
+{
+    struct tcpEvent *evtptr;
+
+    for (evtptr = tcpwheel[tick & TCP_WHEELMASK]; evtptr != NULL;
+         evtptr = evtptr->next)
     {
-        ticks = clkticks - lastticks;
+        if ((long)(evtptr->expires - now) <= 0)
+        {
+            return evtptr;
+        }
     }
-    else
+    return NULL;
+}
+
+/*
+ * Ticks from now until the first scheduled event is due, ~0 if none.  The
+ * slots are visited in the order their ticks come round, so the search
+ * ends at the first slot holding an event due within one turn; events
+ * further away are only compared as they are passed.  Interrupts must be
+ * disabled.
+ */
+static ulong tcpTimerNext(ulong now)
+{
+    struct tcpEvent *evtptr;
+    ulong best, delta, i;
+    uint slot, word;
+
+    best = ~0UL;
+    for (i = 1; (i <= TCP_WHEELSLOTS) && (i < best); i++)
     {
-        ticks = CLKTICKS_PER_SEC - lastticks;
-        ticks += (clktime - lasttime - 1) * CLKTICKS_PER_SEC;
-        ticks += clkticks;
+        slot = (now + i) & TCP_WHEELMASK;
+        word = tcpwheelmap[slot >> 5] >> (slot & 0x1f);
+        if (0 == word)
+        {
+            i += 31 - (slot & 0x1f);
+            continue;
+        }
+        i += __builtin_ctz(word);
+        slot = (now + i) & TCP_WHEELMASK;
+        for (evtptr = tcpwheel[slot]; evtptr != NULL; evtptr = evtptr->next)
+        {
+            delta = evtptr->expires - now;
+            if (delta < best)
+            {
+                best = delta;
+            }
+        }
     }
-
-    return (ticks * (CLKTICKS_PER_SEC / 1000));
+    return best;
 }
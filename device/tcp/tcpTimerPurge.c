@@ -4,7 +4,7 @@
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
-#include <semaphore.h>
+#include <interrupt.h>
 #include <stddef.h>
 #include <tcp.h>
 
@@ -19,33 +19,39 @@
  */
 devcall tcpTimerPurge(struct tcb *tcbptr, uchar type)
 {
-    struct tcpEvent *prev = NULL;
-    struct tcpEvent *cur = NULL;
+    struct tcpEvent *evtptr;
     int result = SYSERR;
+    uint slot;
+    int i;
+    irqmask im;
 
-    wait(tcpmutex);
-    prev = &tcptimertab[TCP_EVT_HEAD];
-    cur = prev->next;
-    while (cur != NULL)
+    im = disable();
+    for (i = 0; i < TCP_NTIMERS; i++)
     {
-        if ((cur->tcbptr == tcbptr)
-            && ((NULL == type) || (cur->type == type)))
+        evtptr = &tcbptr->timers[i];
+        if ((NULL == evtptr->prev) || ((NULL != type) && (type != i + 1)))
         {
-            if (SYSERR == result)
-            {
-                result = cur->time - cur->remain;
-            }
-            if (cur->next != NULL)
-            {
-                cur->next->remain += cur->remain;
-            }
-            prev->next = cur->next;
-            cur->used = FALSE;
+            continue;
+        }
+        if (SYSERR == result)
+        {
+            result = tcpTimerNow() - evtptr->start;
+        }
+
+        /* Unlink the event, and mark its slot empty if it was the last */
+        *evtptr->prev = evtptr->next;
+        if (evtptr->next != NULL)
+        {
+            evtptr->next->prev = evtptr->prev;
+        }
+        evtptr->prev = NULL;
+        slot = evtptr->expires & (TCP_WHEELSLOTS - 1);
+        if (NULL == tcpwheel[slot])
+        {
+            tcpwheelmap[slot >> 5] &= ~(1 << (slot & 0x1f));
         }
-        prev = cur;
-        cur = cur->next;
     }
-    signal(tcpmutex);
+    restore(im);
 
     return result;
 }
@@ -4,7 +4,7 @@
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
-#include <semaphore.h>
+#include <interrupt.h>
 #include <stddef.h>
 #include <tcp.h>
 
@@ -18,22 +18,27 @@
  */
 int tcpTimerRemain(struct tcb *tcbptr, uchar type)
 {
-    struct tcpEvent *cur = NULL;
+    struct tcpEvent *evtptr;
     int time = 0;
+    irqmask im;
 
-    wait(tcpmutex);
-    cur = tcptimertab[TCP_EVT_HEAD].next;
-    while (cur != NULL)
+    if ((type < 1) || (type > TCP_NTIMERS))
     {
-        time += cur->remain;
-        if ((cur->tcbptr == tcbptr) && (cur->type == type))
+        return 0;
+    }
+
+    im = disable();
+    evtptr = &tcbptr->timers[type - 1];
+    if (evtptr->prev != NULL)
+    {
+        /* An event that is due but not yet triggered has 1 left */
+        time = evtptr->expires - tcpTimerNow();
+        if (time < 1)
         {
-            signal(tcpmutex);
-            return time;
+            time = 1;
         }
-        cur = cur->next;
     }
-    signal(tcpmutex);
+    restore(im);
 
-    return 0;
+    return time;
 }
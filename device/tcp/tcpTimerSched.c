@@ -4,16 +4,16 @@
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
-#include <semaphore.h>
+#include <interrupt.h>
 #include <stddef.h>
 #include <tcp.h>
-
-static int allocEvent(void);
+#include <thread.h>
 
 /**
  * @ingroup tcp
  *
- * Schedule TCP timer events.
+ * Schedule TCP timer events.  A TCB has at most one event of each type; an
+ * event of the type already scheduled is moved to the new time.
  * @param time milliseconds before timer triggers
  * @param tcbptr TCB with which event is associated
  * @param type type of timer event
@@ -21,77 +21,45 @@ static int allocEvent(void);
  */
 devcall tcpTimerSched(int time, struct tcb *tcbptr, uchar type)
 {
-    int evt = 0;
-    struct tcpEvent *evtptr = NULL;
-    struct tcpEvent *prev = NULL;
-    struct tcpEvent *next = NULL;
+    struct tcpEvent *evtptr;
+    uint slot;
+    irqmask im;
 
     /* Verify parameters */
-    if ((time < 0) || (NULL == tcbptr))
+    if ((time < 0) || (NULL == tcbptr) || (type < 1)
+        || (type > TCP_NTIMERS))
     {
         return SYSERR;
     }
 
-    wait(tcpmutex);
-    /* Setup timer event */
-    evt = allocEvent();
-    if (SYSERR == evt)
-    {
-        signal(tcpmutex);
-        return SYSERR;
-    }
-    evtptr = &tcptimertab[evt];
-    evtptr->time = time;
+    im = disable();
+    tcpTimerPurge(tcbptr, type);
+
+    /* Setup timer event, due no sooner than the next tick */
+    evtptr = &tcbptr->timers[type - 1];
+    evtptr->start = tcpTimerNow();
+    evtptr->expires = evtptr->start + ((time > 0) ? time : 1);
     evtptr->type = type;
     evtptr->tcbptr = tcbptr;
 
-    /* Insert event into delta queue */
-    prev = &tcptimertab[TCP_EVT_HEAD];
-    next = prev->next;
-    while ((next != NULL) && (next->remain <= time))
-    {
-        time -= next->remain;
-        prev = next;
-        next = next->next;
-    }
-    evtptr->next = next;
-    prev->next = evtptr;
-    evtptr->remain = time;
-    if (next != NULL)
+    /* Insert event into the slot for its tick */
+    slot = evtptr->expires & (TCP_WHEELSLOTS - 1);
+    evtptr->next = tcpwheel[slot];
+    if (evtptr->next != NULL)
     {
-        next->remain -= time;
+        evtptr->next->prev = &evtptr->next;
     }
-    signal(tcpmutex);
+    evtptr->prev = &tcpwheel[slot];
+    tcpwheel[slot] = evtptr;
+    tcpwheelmap[slot >> 5] |= 1 << (slot & 0x1f);
 
-    return OK;
-}
-
-/**
- * Allocate an unused timer event block
- * @return index to used block, or SYSERR if none exist
- * @precondition TCP Timer mutex is already held
- * @postcondition TCP Timer mutex is still held
- */
-static int allocEvent(void)
-{
-    int evt;
-    static int nextevt = 0;
-
-    /* Check all TCP timer event slots (except the head) */
-    for (evt = 0; evt < TCP_NEVENTS; evt++)
+    /* Wake the timer thread if it would sleep past this event */
+    if (tcptimerasleep && ((long)(evtptr->expires - tcptimerwake) < 0))
     {
-        nextevt = (nextevt + 1) % TCP_NEVENTS;
-        /* Ignore head */
-        if (TCP_EVT_HEAD == nextevt)
-        {
-            continue;
-        }
-        if (FALSE == tcptimertab[nextevt].used)
-        {
-            tcptimertab[nextevt].used = TRUE;
-            return nextevt;
-        }
+        tcptimerasleep = FALSE;
+        send(tcptimerid, OK);
     }
-    return SYSERR;
+    restore(im);
 
+    return OK;
 }
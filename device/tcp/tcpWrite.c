@@ -22,7 +22,7 @@ static int stateCheck(struct tcb *);
 devcall tcpWrite(device *devptr, void *buf, uint len)
 {
     uint count = 0;
-    uchar ch;
+    uint n;
     struct tcb *tcbptr;
     uchar *buffer = buf;
     int check;
@@ -55,16 +55,19 @@ devcall tcpWrite(device *devptr, void *buf, uint len)
             return check;
         }
 
-        while ((tcbptr->ocount < TCP_OBLEN) && (count < len))
+        n = len - count;
+        if (n > tcbptr->obsize - tcbptr->ocount)
         {
-            ch = *buffer++;
-            tcbptr->out[((tcbptr->ostart + tcbptr->ocount) % TCP_OBLEN)] =
-                ch;
-            tcbptr->ocount++;
-            count++;
+            n = tcbptr->obsize - tcbptr->ocount;
         }
+        tcpRingPut(tcbptr->out, tcbptr->obsize,
+                   (tcbptr->ostart + tcbptr->ocount) % tcbptr->obsize,
+                   buffer, n);
+        buffer += n;
+        tcbptr->ocount += n;
+        count += n;
         /* If space remains, another writer can write */
-        if (tcbptr->ocount < TCP_OBLEN)
+        if (tcbptr->ocount < tcbptr->obsize)
         {
             signal(tcbptr->writers);
         }
@@ -10,6 +10,7 @@
 #include <stdlib.h>
 
 struct telnet telnettab[NTELNET];
+int telnetlistener = SYSERR;
 
 /**
  * @ingroup telnet
@@ -23,24 +23,30 @@
 ushort udpChksum(struct packet *pkt, ushort len, const struct netaddr *src,
                  const struct netaddr *dst)
 {
+    return netChksumFinish(netChksumAdd(udpChksumPseudo(src, dst, len),
+                                        pkt->curr, len));
+}
 
-    struct udpPseudoHdr *pseu;
-    struct udpPseudoHdr temp;
-    ushort sum;
-
-    pseu = ((struct udpPseudoHdr *)(pkt->curr)) - 1;
-    memcpy(&temp, pseu, sizeof(struct udpPseudoHdr));
-
-    /* Generate UDP pseudo header */
-    memcpy(pseu->srcIp, src->addr, IPv4_ADDR_LEN);
-    memcpy(pseu->dstIp, dst->addr, IPv4_ADDR_LEN);
-    pseu->zero = 0;
-    pseu->proto = IPv4_PROTO_UDP;
-    pseu->len = hs2net(len);
-
-    sum = netChksum(pseu, len + sizeof(struct udpPseudoHdr));
+/**
+ * @ingroup udpinternal
+ *
+ * Calculate the partial checksum of the UDP pseudo-header, to be added to
+ * the sum of the UDP packet with netChksumAdd() or netChksumCopy().
+ * @param src Source IP Address
+ * @param dst Destination IP Address
+ * @param len Length of UDP packet
+ * @return The partial sum of the pseudo-header
+ */
+uint udpChksumPseudo(const struct netaddr *src, const struct netaddr *dst,
+                     ushort len)
+{
+    struct udpPseudoHdr pseu;
 
-    memcpy(pseu, &temp, sizeof(struct udpPseudoHdr));
+    memcpy(pseu.srcIp, src->addr, IPv4_ADDR_LEN);
+    memcpy(pseu.dstIp, dst->addr, IPv4_ADDR_LEN);
+    pseu.zero = 0;
+    pseu.proto = IPv4_PROTO_UDP;
+    pseu.len = hs2net(len);
 
-    return sum;
+    return netChksumAdd(0, &pseu, sizeof(struct udpPseudoHdr));
 }
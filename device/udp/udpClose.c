@@ -30,7 +30,9 @@
 devcall udpClose(device *devptr)
 {
     struct udp *udpptr;
+    struct udpPseudoHdr *pseudo;
     irqmask im;
+    int i;
 
     /* Get pointer to the UDP structure  */
     udpptr = &udptab[devptr->minor];
@@ -44,7 +46,18 @@ devcall udpClose(device *devptr)
         return SYSERR;
     }
 
-    /* Free the in buffer pool */
+    /* Stop delivering packets to it */
+    udpHashRemove(udpptr);
+
+    /* Free the packets not read, some of which may be from the heap, and
+     * the in buffer pool */
+    for (i = 0; i < udpptr->icount; i++)
+    {
+        pseudo = (struct udpPseudoHdr *)
+            udpptr->in[(udpptr->istart + i) % UDP_MAX_PKTS];
+        udpFreebuf((struct udpPkt *)pseudo,
+                   sizeof(struct udpPseudoHdr) + pseudo->len);
+    }
     bfpfree(udpptr->inPool);
 
     /* Free the in semaphore */
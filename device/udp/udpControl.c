@@ -7,6 +7,7 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <device.h>
+#include <interrupt.h>
 #include <network.h>
 #include <udp.h>
 
@@ -24,6 +25,7 @@ devcall udpControl(device *devptr, int func, long arg1, long arg2)
 {
     struct udp *udpptr;
     uchar old;
+    irqmask im;
 
     udpptr = &udptab[devptr->minor];
 
@@ -31,18 +33,23 @@ devcall udpControl(device *devptr, int func, long arg1, long arg2)
     {
     case UDP_CTRL_ACCEPT:
         /* arg1 is port and arg2 is pointer to netaddr */
+        im = disable();
+        udpHashRemove(udpptr);
         udpptr->localpt = arg1;
-        if (NULL == arg2)
+        if (NULL != arg2)
         {
-            return SYSERR;
+            netaddrcpy(&(udpptr->localip), (struct netaddr *)arg2);
         }
-        else
+        if (UDP_OPEN == udpptr->state)
         {
-            netaddrcpy(&(udpptr->localip), (struct netaddr *)arg2);
+            udpHashInsert(udpptr);
         }
-        return OK;
+        restore(im);
+        return (NULL == arg2) ? SYSERR : OK;
     case UDP_CTRL_BIND:
         /* arg1 is port and arg2 is pointer to netaddr */
+        im = disable();
+        udpHashRemove(udpptr);
         udpptr->remotept = arg1;
         if (NULL == arg2)
         {
@@ -52,6 +59,11 @@ devcall udpControl(device *devptr, int func, long arg1, long arg2)
         {
             netaddrcpy(&(udpptr->remoteip), (struct netaddr *)arg2);
         }
+        if (UDP_OPEN == udpptr->state)
+        {
+            udpHashInsert(udpptr);
+        }
+        restore(im);
         return OK;
     case UDP_CTRL_CLRFLAG:
         /* arg1 is the flag we are clearing */
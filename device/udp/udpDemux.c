@@ -7,15 +7,34 @@
 #include <stddef.h>
 #include <udp.h>
 
-#define NO_MATCH      0
-#define DEST_MATCH    1
-#define PARTIAL_MATCH 2
-#define FULL_MATCH    3
+/* The open socket with exactly these ports and remote address (none if
+ * remoteip is NULL) that is bound to the local address dstip. */
+static struct udp *udpLookup(ushort localpt, ushort remotept,
+                             const struct netaddr *dstip,
+                             const struct netaddr *remoteip)
+{
+    struct udp *udpptr;
+
+    for (udpptr = udphash[udpHashSlot(localpt, remotept, remoteip)];
+         udpptr != NULL; udpptr = udpptr->hnext)
+    {
+        if ((udpptr->localpt == localpt)
+            && (udpptr->remotept == remotept)
+            && (netaddrequal(&udpptr->localip, dstip))
+            && ((NULL == remoteip) ? (NULL == udpptr->remoteip.type)
+                : netaddrequal(&udpptr->remoteip, remoteip)))
+        {
+            return udpptr;
+        }
+    }
+    return NULL;
+}
 
 /**
  * @ingroup udpinternal
  *
- * Locate the UDP socket for a UDP packet
+ * Locate the UDP socket for a UDP packet.  Looks in at most three buckets
+ * of the socket hash table, however many sockets are open.
  * @param dstpt destination port of the UDP packet
  * @param srcpt source port of the UDP packet
  * @param dstip destination IP of the UDP packet
@@ -27,55 +46,21 @@
 struct udp *udpDemux(ushort dstpt, ushort srcpt, const struct netaddr *dstip,
                      const struct netaddr *srcip)
 {
-    struct udp *udpptr = NULL;
-    uint i;
-    uint match = NO_MATCH;
-
-    /* Cycle through all udp devices to find the best match */
-    for (i = 0; i < NUDP; i++)
-    {
-        if (udptab[i].state == UDP_FREE)
-        {
-            /* skip this entry */
-            continue;
-        }
-        if (!netaddrequal(&udptab[i].localip, dstip))
-        {
-            /* entry is not bound to the destination */
-            continue;
-        }
+    struct udp *udpptr;
 
-        /* Full match is the best */
-        if (match < FULL_MATCH
-            && (udptab[i].localpt == dstpt)
-            && (udptab[i].remotept == srcpt)
-            && (netaddrequal(&udptab[i].remoteip, srcip)))
-        {
-            udpptr = &udptab[i];
-            match = FULL_MATCH;
-            /* you can't beat a full match */
-            break;
-        }
+    /* Full match is the best */
+    udpptr = udpLookup(dstpt, srcpt, dstip, srcip);
 
-        /* Src and dst ports match is second */
-        if (match < PARTIAL_MATCH
-            && (udptab[i].localpt == dstpt)
-            && (udptab[i].remotept == srcpt)
-            && (udptab[i].remoteip.type == NULL))
-        {
-            udpptr = &udptab[i];
-            match = PARTIAL_MATCH;
-        }
+    /* Src and dst ports match is second */
+    if (NULL == udpptr)
+    {
+        udpptr = udpLookup(dstpt, srcpt, dstip, NULL);
+    }
 
-        /* Dst ports match is last */
-        if (match < DEST_MATCH
-            && (udptab[i].localpt == dstpt)
-            && (udptab[i].remotept == NULL)
-            && (udptab[i].remoteip.type == NULL))
-        {
-            udpptr = &udptab[i];
-            match = DEST_MATCH;
-        }
+    /* Dst ports match is last */
+    if (NULL == udpptr)
+    {
+        udpptr = udpLookup(dstpt, 0, dstip, NULL);
     }
 
     return udpptr;
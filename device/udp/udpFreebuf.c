@@ -6,13 +6,23 @@
 
 #include <stddef.h>
 #include <bufpool.h>
+#include <memory.h>
 #include <network.h>
 #include <udp.h>
 
 /**
  * @ingroup udpinternal
+ *
+ * Free a buffer from udpGetbuf().
+ * @param udppkt the buffer
+ * @param len length it was got for
+ * @return OK if the buffer was freed, otherwise SYSERR
  */
-syscall udpFreebuf(struct udpPkt *udppkt)
+syscall udpFreebuf(struct udpPkt *udppkt, uint len)
 {
+    if (len > NET_MAX_PKTLEN)
+    {
+        return memfree(udppkt, len);
+    }
     return buffree(udppkt);
 }
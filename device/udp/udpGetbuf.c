@@ -6,17 +6,29 @@
 
 #include <stddef.h>
 #include <bufpool.h>
+#include <memory.h>
 #include <network.h>
 #include <stdlib.h>
 #include <udp.h>
 
 /**
  * @ingroup udpinternal
+ *
+ * Get a buffer to store a received UDP packet in, from the device's pool
+ * if it fits, otherwise from the heap.  Free it with udpFreebuf().
+ * @param udpptr UDP device the packet is for
+ * @param len length of the UDP pseudo-header, header and data
+ * @return the buffer, or SYSERR if there is none
  */
-struct udpPkt *udpGetbuf(struct udp *udpptr)
+struct udpPkt *udpGetbuf(struct udp *udpptr, uint len)
 {
     struct udpPkt *udppkt = NULL;
 
+    if (len > NET_MAX_PKTLEN)
+    {
+        return memget(len);
+    }
+
     udppkt = bufget(udpptr->inPool);
     if (SYSERR == (int)udppkt)
     {
@@ -0,0 +1,76 @@
+/**
+ * @file udpHash.c
+ *
+ * Hash table of open UDP sockets, keyed on local port, remote port and
+ * remote IP address.  A socket whose remote IP address or remote port is
+ * not set is hashed with that part of the key zero, so that udpDemux() finds
+ * sockets bound to a port, to a port pair, or to a full connection by
+ * looking in one bucket each.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <udp.h>
+
+/** @ingroup udpinternal
+ * Buckets of the UDP socket hash table.  */
+struct udp *udphash[UDP_NHASH];
+
+/**
+ * @ingroup udpinternal
+ *
+ * Bucket that holds sockets with the given ports and remote address.
+ * @param localpt local port
+ * @param remotept remote port, or 0
+ * @param remoteip remote IP address, or @c NULL
+ * @return index into ::udphash
+ */
+uint udpHashSlot(ushort localpt, ushort remotept,
+                 const struct netaddr *remoteip)
+{
+    return netHashPorts(localpt, remotept, remoteip) & (UDP_NHASH - 1);
+}
+
+/**
+ * @ingroup udpinternal
+ *
+ * Add an open socket to the hash table under its current ports and remote
+ * address.  Interrupts must be disabled.
+ * @param udpptr UDP socket, not already in the table
+ */
+void udpHashInsert(struct udp *udpptr)
+{
+    udpptr->hslot = udpHashSlot(udpptr->localpt, udpptr->remotept,
+                                &udpptr->remoteip);
+    udpptr->hnext = udphash[udpptr->hslot];
+    udphash[udpptr->hslot] = udpptr;
+    udpptr->hashed = TRUE;
+}
+
+/**
+ * @ingroup udpinternal
+ *
+ * Take a socket out of the hash table, if it is in it.  Must be done before
+ * changing any of its ports or addresses.  Interrupts must be disabled.
+ * @param udpptr UDP socket
+ */
+void udpHashRemove(struct udp *udpptr)
+{
+    struct udp **prev;
+
+    if (!udpptr->hashed)
+    {
+        return;
+    }
+    for (prev = &udphash[udpptr->hslot]; *prev != NULL;
+         prev = &(*prev)->hnext)
+    {
+        if (*prev == udpptr)
+        {
+            *prev = udpptr->hnext;
+            break;
+        }
+    }
+    udpptr->hnext = NULL;
+    udpptr->hashed = FALSE;
+}
@@ -118,6 +118,9 @@ devcall udpOpen(device *devptr, va_list ap)
 
     udpptr->flags = 0;
 
+    /* Make the socket visible to udpDemux() */
+    udpHashInsert(udpptr);
+
     retval = OK;
     goto out_restore;
 
@@ -106,7 +106,8 @@ devcall udpRead(device *devptr, void *buf, uint len)
 
     /* Free the packet buffer, restore interrupts, and return the number of
      * bytes read.  */
-    udpFreebuf((struct udpPkt *)pseudo);
+    udpFreebuf((struct udpPkt *)pseudo,
+               sizeof(struct udpPseudoHdr) + udppkt->len);
     restore(im);
     return count;
 }
@@ -37,7 +37,8 @@ syscall udpRecv(struct packet *pkt, const struct netaddr *src,
     /* Point to the start of the UDP header */
     udppkt = (struct udpPkt *)pkt->curr;
 
-    if (NULL == udppkt)
+    if ((NULL == udppkt) || (net2hs(udppkt->len) < UDP_HDR_LEN)
+        || (net2hs(udppkt->len) > pkt->len - (pkt->curr - pkt->linkhdr)))
     {
         UDP_TRACE("Invalid UDP packet.");
         netFreebuf(pkt);
@@ -97,14 +98,16 @@ syscall udpRecv(struct packet *pkt, const struct netaddr *src,
      * and clear the flag */
     if (UDP_FLAG_BINDFIRST & udpptr->flags)
     {
+        udpHashRemove(udpptr);
         udpptr->remotept = udppkt->srcPort;
         netaddrcpy(&(udpptr->localip), dst);
         netaddrcpy(&(udpptr->remoteip), src);
+        udpHashInsert(udpptr);
         udpptr->flags &= ~UDP_FLAG_BINDFIRST;
     }
 
     /* Get some buffer space to store the packet */
-    tpkt = udpGetbuf(udpptr);
+    tpkt = udpGetbuf(udpptr, sizeof(struct udpPseudoHdr) + udppkt->len);
 
     if (SYSERR == (int)tpkt)
     {
@@ -46,9 +46,27 @@ syscall udpSend(struct udp *udpptr, ushort datalen, const void *buf)
     struct packet *pkt;
     struct udpPkt *udppkt;
     struct netaddr localip, remoteip;
+    struct netSeg seg;
+    uint sum;
+    bool gather;
     int result;
 
-    pkt = netGetbuf();
+    /* The data of a datagram too large for a pool buffer is sent from the
+     * caller's buffer, as a segment after the headers; a passive device's
+     * datagram has its header in the data, so is copied to the heap.
+     * Leave room for the headers in front either way. */
+    gather = !(udpptr->flags & UDP_FLAG_PASSIVE)
+        && (ETH_HDR_LEN + IPv4_HDR_LEN + UDP_HDR_LEN + datalen + 3
+            > NET_MAX_PKTLEN);
+    if (gather)
+    {
+        pkt = netGetbuf();
+    }
+    else
+    {
+        pkt = netGetbufLen(ETH_HDR_LEN + IPv4_HDR_LEN + UDP_HDR_LEN
+                           + datalen + 3);
+    }
     if (SYSERR == (int)pkt)
     {
         UDP_TRACE("Failed to allocate buffer");
@@ -89,6 +107,9 @@ syscall udpSend(struct udp *udpptr, ushort datalen, const void *buf)
             netFreebuf(pkt);
             return SYSERR;
         }
+
+        /* Calculate UDP checksum (which happens to be the same as TCP's) */
+        udppkt->chksum = udpChksum(pkt, datalen, &localip, &remoteip);
     }
     else
     {
@@ -97,7 +118,14 @@ syscall udpSend(struct udp *udpptr, ushort datalen, const void *buf)
          * length */
         pkt->len = datalen;
         /* Round the datalength to maintain word alignment */
-        pkt->curr -= (3 + (ulong)(pkt->len)) & ~0x03;
+        if (gather)
+        {
+            pkt->curr -= UDP_HDR_LEN;
+        }
+        else
+        {
+            pkt->curr -= (3 + (ulong)(pkt->len)) & ~0x03;
+        }
 
         /* Set UDP header fields and fill the packet with the data */
         udppkt = (struct udpPkt *)(pkt->curr);
@@ -106,14 +134,38 @@ syscall udpSend(struct udp *udpptr, ushort datalen, const void *buf)
         udppkt->len = hs2net(pkt->len);
         udppkt->chksum = 0;
 
-        memcpy(udppkt->data, buf, datalen - UDP_HDR_LEN);
+        /* Sum the data as it is copied, or where it lies, then add the
+         * header to it */
+        sum = udpChksumPseudo(&localip, &remoteip, datalen);
+        if (gather)
+        {
+            seg.data = buf;
+            seg.len = datalen - UDP_HDR_LEN;
+            seg.next = NULL;
+            pkt->segs = &seg;
+            pkt->seglen = seg.len;
+            sum = netChksumAdd(sum, buf, seg.len);
+        }
+        else
+        {
+            sum = netChksumCopy(sum, udppkt->data, buf,
+                                datalen - UDP_HDR_LEN);
+        }
+        udppkt->chksum = netChksumFinish(netChksumAdd(sum, udppkt,
+                                                      UDP_HDR_LEN));
     }
 
-    /* Calculate UDP checksum (which happens to be the same as TCP's) */
-    udppkt->chksum = udpChksum(pkt, datalen, &localip, &remoteip);
-
-    /* Send the UDP packet through IP */
-    result = ipv4Send(pkt, &localip, &remoteip, IPv4_PROTO_UDP);
+    /* Send the UDP packet through IP; a passive socket's packets may each
+     * go somewhere else, so only a connected one keeps its destination */
+    if (udpptr->flags & UDP_FLAG_PASSIVE)
+    {
+        result = ipv4Send(pkt, &localip, &remoteip, IPv4_PROTO_UDP);
+    }
+    else
+    {
+        result = ipv4SendDst(pkt, &localip, &remoteip, IPv4_PROTO_UDP,
+                             &udpptr->dst);
+    }
 
     if (SYSERR == netFreebuf(pkt))
     {
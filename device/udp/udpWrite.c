@@ -38,7 +38,8 @@
  *      data successfully sent, which may be less than @p len in the case of an
  *      error.  If the UDP device is not in passive mode and @p len was 0, no
  *      packets will be sent and 0 will be returned.  Otherwise, returns
- *      ::SYSERR.
+ *      ::SYSERR.  Packets held until the next hop's hardware address is
+ *      resolved count as sent.
  */
 devcall udpWrite(device *devptr, const void *buf, uint len)
 {
@@ -57,7 +58,7 @@ devcall udpWrite(device *devptr, const void *buf, uint len)
             return SYSERR;
         }
         result = udpSend(udpptr, len, buf);
-        if (OK == result)
+        if ((OK == result) || (NET_QUEUED == result))
         {
             return len;
         }
@@ -93,7 +94,7 @@ devcall udpWrite(device *devptr, const void *buf, uint len)
             }
 
             result = udpSend(udpptr, pktsize, (const uchar*)buf + count);
-            if (OK != result)
+            if ((OK != result) && (NET_QUEUED != result))
             {
                 if (0 == count)
                 {
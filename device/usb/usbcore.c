@@ -124,7 +124,7 @@ usb_alloc_xfer_request(uint bufsize)
 {
     struct usb_xfer_request *req;
 
-    req = memget(sizeof(struct usb_xfer_request) + bufsize);
+    req = slabget(sizeof(struct usb_xfer_request) + bufsize);
     if (req == (void*)SYSERR)
     {
         return NULL;
@@ -151,7 +151,7 @@ void usb_free_xfer_request(struct usb_xfer_request *req)
         /* TODO: HCD-specific variables need to be handled better.  */
         kill(req->deferer_thread_tid);
         semfree(req->deferer_thread_sema);
-        memfree(req, sizeof(struct usb_xfer_request) + req->size);
+        slabfree(req, sizeof(struct usb_xfer_request) + req->size);
     }
 }
 
@@ -44,15 +44,13 @@
 #define ARP_UNRESOLVED     1       /**< Entry is used but unresolved    */
 /* ARP entry is resolved if it is USED and RESOLVED (0b11) */
 #define ARP_RESOLVED        3      /**< Entry is used and resolved      */
-#define ARP_NTHRWAIT        10     /**< Num threads that can wait       */
-
-/* ARP Lookup */
-#define ARP_MAX_LOOKUP      5     /**< Num ARP lookup attempts per pkt  */
-#define ARP_MSG_RESOLVED    1     /**< Message shows arp resolution     */
+#define ARP_NHASH          16      /**< Buckets in hash of entries, 2^n */
+#define ARP_NPENDING        3      /**< Pkts held per unresolved entry  */
 
 /* Timing info */
 #define ARP_TTL_UNRESOLVED  5    /**< TTL in secs for unresolv entry  */
 #define ARP_TTL_RESOLVED    300   /**< TTL in secs for resolved entry  */
+#define ARP_RQST_INTERVAL   1     /**< Min secs between requests sent  */
 
 /* ARP thread constants */
 #define ARP_THR_PRIO        NET_THR_PRIO   /**< ARP thread priority     */
@@ -103,12 +101,28 @@ struct arpEntry
     struct netaddr hwaddr;               /**< Hardware address              */
     struct netaddr praddr;               /**< Protocol address              */
     uint expires;                    /**< clktime when entry expires    */
-    tid_typ waiting[ARP_NTHRWAIT];   /**< Threads waiting for entry     */
-    int count;                       /**< Count of threads waiting      */
+    uint rqsttime;                   /**< clktime last request was sent */
+    struct packet *pending[ARP_NPENDING]; /**< Pkts awaiting resolution */
+    int npending;                    /**< Count of pending packets      */
+    struct arpEntry *hnext;          /**< Next entry in hash bucket     */
+};
+
+/* ARP statistics */
+struct arpStats
+{
+    uint queued;                /**< Pkts held awaiting resolution   */
+    uint sent;                  /**< Held pkts sent once resolved    */
+    uint dropped;               /**< Pkts dropped awaiting resolution */
 };
 
 /* ARP table */
 extern struct arpEntry arptab[ARP_NENTRY];
+extern struct arpEntry *arphash[ARP_NHASH];
+extern struct arpStats arpstats;
+
+/* Incremented whenever a resolved hardware address is dropped or changes,
+ * so that destination caches filled from the table are refilled */
+extern volatile uint arpgen;
 
 /* ARP packet queue for packets requiring reply */
 extern mailbox arpqueue;
@@ -118,9 +132,12 @@ struct arpEntry *arpAlloc(void);
 thread arpDaemon(void);
 struct arpEntry *arpGetEntry(const struct netaddr *);
 syscall arpFree(struct arpEntry *);
+uint arpHashSlot(const struct netaddr *);
+void arpHashInsert(struct arpEntry *);
+void arpHashRemove(struct arpEntry *);
 syscall arpInit(void);
-syscall arpLookup(struct netif *, const struct netaddr *, struct netaddr *);
-syscall arpNotify(struct arpEntry *, message);
+syscall arpLookup(struct netif *, const struct netaddr *, struct netaddr *,
+                  struct packet *);
 syscall arpRecv(struct packet *);
 syscall arpSendRqst(struct arpEntry *);
 syscall arpSendReply(struct packet *);
@@ -35,6 +35,11 @@ struct bfpentry
     void *head;
     struct poolbuf *next;
     semaphore freebuf;
+    uint reserve;               /**< buffers non-blocking gets leave free */
+    uint nused;                 /**< buffers in use                       */
+    uint hiwat;                 /**< most buffers ever in use at once     */
+    uint nwait;                 /**< bufget() calls that had to wait      */
+    uint ndrop;                 /**< bufgetnb() calls that found none     */
 };
 
 /**
@@ -52,9 +57,13 @@ extern struct bfpentry bfptab[];
 
 /* function prototypes */
 void *bufget(int);
+void *bufgetnb(int);
+uint bufgetn(int, void **, uint);
 syscall buffree(void *);
+syscall buffreen(void **, uint);
 int bfpalloc(uint, uint);
 syscall bfpfree(int);
+syscall bfpreserve(int, uint);
 
 #ifndef NPOOL
 #  define NPOOL 0
@@ -19,9 +19,38 @@
  */
 #define CLKTICKS_PER_SEC  1000
 
+/**
+ * @ingroup timer
+ *
+ * Dynamic tick mode.  When TRUE, the timer interrupt is programmed as a
+ * one-shot deadline for the next timed wait to expire whenever at most one
+ * thread can run, rather than firing every tick.  Requires clkset() and a
+ * free-running clkcount() from the platform.  Enabled in xinu.conf.
+ */
+#ifndef TICKLESS
+#define TICKLESS          FALSE
+#endif
+
+/**
+ * @ingroup timer
+ *
+ * Longest interval, in ticks, between two timer interrupts in dynamic tick
+ * mode.  This bounds how stale ::clktime can get while a single thread
+ * runs without sleeping, and keeps the deadline within a 32-bit counter.
+ */
+#define CLKTICKS_MAXIDLE  CLKTICKS_PER_SEC
+
 extern volatile ulong clkticks;
 extern volatile ulong clktime;
-extern qid_typ sleepq;
+extern ulong tmrnow;
+extern qid_typ tmrwheel;
+extern qid_typ tmrwakeq;
+extern ulong clkintrs;
+extern ulong clkidlewakes;
+#if TICKLESS
+extern bool clkoneshot;
+extern ulong clklast;
+#endif
 
 /* Clock function prototypes.  Note:  clkupdate() and clkcount() are documented
  * here because their implementations are platform-dependent.  */
@@ -41,6 +70,20 @@ void clkinit(void);
  */
 void clkupdate(ulong cycles);
 
+/**
+ * @ingroup timer
+ *
+ * Sets up a timer interrupt to trigger a certain number of clock cycles from
+ * now, replacing any interrupt that is already scheduled.  Unlike
+ * clkupdate(), the interval is never measured from the previous deadline.
+ * Only needed on platforms that enable ::TICKLESS.
+ *
+ * @param cycles
+ *     Number of cycles from now after which the timer interrupt is to be
+ *     triggered.
+ */
+void clkset(ulong cycles);
+
 /**
  * @ingroup timer
  *
@@ -55,6 +98,15 @@ void clkupdate(ulong cycles);
 ulong clkcount(void);
 
 interrupt clkhandler(void);
+void tmrinit(void);
+int tmrinsert(tid_typ, int);
+void tmrremove(tid_typ);
+void tmradvance(ulong);
+ulong tmrnext(void);
+#if TICKLESS
+void clkcatchup(void);
+void clkdeadline(void);
+#endif
 void udelay(ulong);
 void mdelay(ulong);
 
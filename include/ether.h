@@ -9,6 +9,7 @@
 
 #include <device.h>
 #include <ethernet.h>
+#include <network.h>
 #include <stdarg.h>
 #include <stddef.h>
 #include <semaphore.h>
@@ -111,10 +112,13 @@ struct ether
     ushort istart;              /**< Index of first byte                */
     ushort icount;              /**< Packets in buffer                  */
 
-    struct ethPktBuffer *in[ETH_IBLEN]; /**< Input buffer               */
+    void *in[ETH_IBLEN];        /**< Input buffer (ethPktBuffer or packet,
+                                     depending on the driver)           */
 
     int inPool;                 /**< buffer pool id for input           */
     int outPool;                /**< buffer pool id for output          */
+    struct netif *netif;        /**< interface steered to, or NULL      */
+    bool poll;                  /**< receive by NET_POLL, not interrupt */
 };
 
 /**
@@ -218,6 +222,29 @@ devcall etherRead(device *devptr, void *buf, uint len);
  */
 devcall etherWrite(device *devptr, const void *buf, uint len);
 
+/**
+ * \ingroup ether
+ *
+ * Write the frame of a network packet to an Ethernet device, gathering the
+ * segments it has after the octets at @c curr.  This is called by
+ * etherControl() for ::NET_SEND_PKTS, and by etherWrite() for a frame in
+ * one buffer.  As with etherWrite(), the frame is only buffered to be sent
+ * at some later time, but the packet and its segments are no longer needed
+ * once this function returns.
+ *
+ * @param devptr
+ *      Pointer to the entry in Xinu's device table for the Ethernet device.
+ * @param pkt
+ *      Packet whose frame to send, of @c len bytes.  It must start with the
+ *      MAC destination address and end with the payload.
+ *
+ * @return
+ *      ::SYSERR if packet is too small, too large, or the Ethernet device is
+ *      not currently up; otherwise the length of the frame, the number of
+ *      bytes submitted to be written at some later time.
+ */
+devcall etherWritePkt(device *devptr, const struct packet *pkt);
+
 /**
  * \ingroup ether
  *
@@ -266,6 +293,7 @@ interrupt etherInterrupt(void);
  */
 int colon2mac(char *, uchar *);
 int allocRxBuffer(struct ether *, int);
+int rxPacketsSteer(struct ether *, int);
 int waitOnBit(volatile uint *, uint, const int, int);
 
 #endif                          /* _ETHER_H_ */
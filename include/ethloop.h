@@ -10,6 +10,7 @@
 #include <stddef.h>
 #include <device.h>
 #include <ethernet.h>
+#include <network.h>
 #include <semaphore.h>
 
 #define ELOOP_MTU          1500
@@ -21,6 +22,7 @@
 #define ELOOP_CTRL_GETHOLD	1
 #define ELOOP_CTRL_SETFLAG  2
 #define ELOOP_CTRL_CLRFLAG	3
+#define ELOOP_CTRL_SETLOSS  4   /**< drop written pkts at random, per 1000 */
 
 #define ELOOP_FLAG_HOLDNXT	0x01  /**< place next written pkt in hold  */
 #define ELOOP_FLAG_DROPNXT	0x04  /**< drop next written pkt           */
@@ -36,23 +38,28 @@ struct ethloop
 {
     int state;                      /**< device state                       */
     device *dev;                    /**< device table entry                 */
-    int poolid;                     /**< poolid for the buffer pool         */
     uchar flags;                    /**< flags                              */
+    uint loss;                      /**< written pkts dropped per 1000      */
+    uint lossrand;                  /**< state of loss random numbers       */
 
     /* Packet queue */
     int index;                  /**< index of first packet in buffer    */
     semaphore sem;              /**< number of packets in buffer        */
     int count;                      /**< number of packets in buffer        */
-    char *buffer[ELOOP_NBUF];   /**< input buffer                       */
-    int pktlen[ELOOP_NBUF];         /**< length of packet in buffer         */
+    struct packet *buffer[ELOOP_NBUF]; /**< written packets, from rxpool */
+    int rxpool;                     /**< pool of packets written            */
+    struct netif *netif;            /**< interface steered to, or NULL      */
+    bool poll;                      /**< packets are taken by NET_POLL      */
+    bool rxmask;                    /**< poll scheduled, as if the receive
+                                         interrupt of a NIC were masked     */
 
     /* Hold packet */
     semaphore hsem;                 /**< number of held packets             */
-    char *hold;                 /**< hold buffer                        */
-    int holdlen;                    /**< length of packet in hold buffer    */
+    struct packet *hold;            /**< held packet                        */
 
     /* Statistics */
     uint nout;                      /**< number of packets written          */
+    uint nlost;                     /**< number of packets dropped at random */
 };
 
 extern struct ethloop elooptab[];
@@ -64,5 +71,7 @@ devcall ethloopClose(device *);
 devcall ethloopRead(device *, void *, uint);
 devcall ethloopWrite(device *, const void *, uint);
 devcall ethloopControl(device *, int, long, long);
+struct packet *ethloopTake(struct ethloop *);
+int ethloopPut(struct ethloop *, const struct packet *);
 
 #endif                          /* _ETHLOOP_H_ */
@@ -102,13 +102,67 @@ struct ipv4Pkt             /**< IPv4 Packet Variables                   */
     uint8_t   opts[1];            /**< Options and padding is variable       */
 };
 
+/* Fragmentation */
+#define IPv4_FRAG_NSEG      4       /**< Pieces a fragment sent refers to  */
+
+/* Fragment reassembly */
+#define IPv4_MAX_LEN        0xFFFF  /**< Largest datagram, with header     */
+#define IPv4_REASM_NENTRY   4       /**< Datagrams reassembled at once     */
+#define IPv4_REASM_NFRAG    64      /**< Fragments held of one datagram    */
+#define IPv4_REASM_NBUF     96      /**< Fragments held of all datagrams   */
+#define IPv4_REASM_TIME     30      /**< Seconds to wait for the rest      */
+#define IPv4_REASM_TICK     1000    /**< ms between checks for timeouts    */
+
+/* Reassembly table entry states */
+#define IPv4_REASM_FREE     0
+#define IPv4_REASM_USED     1
+#define IPv4_REASM_BUSY     2       /**< Being completed or dropped        */
+
+/**
+ * A fragment held for reassembly.  Its packet's curr points to the first
+ * octet of its data not already held in another fragment.
+ */
+struct ipv4Frag
+{
+    struct packet *pkt;         /**< Packet holding the fragment         */
+    ushort start;               /**< Offset of the data in the datagram  */
+    ushort end;                 /**< Offset of the end of the data       */
+};
+
+/**
+ * A datagram being reassembled, keyed by source, destination, protocol
+ * and identification.  Its fragments are kept in order of offset, with
+ * no data in more than one of them.
+ */
+struct ipv4Reasm
+{
+    uchar state;                        /**< IPv4_REASM_* state          */
+    uchar proto;                        /**< Protocol of the datagram    */
+    ushort id;                          /**< Identification, net order   */
+    uchar src[IPv4_ADDR_LEN];           /**< Source address              */
+    uchar dst[IPv4_ADDR_LEN];           /**< Destination address         */
+    ulong expires;                      /**< clktime it is dropped at    */
+    uint total;                         /**< Data length, 0 until known  */
+    uint nfrag;                         /**< Number of fragments held    */
+    struct ipv4Frag frag[IPv4_REASM_NFRAG];     /**< Fragments held      */
+};
+
+extern struct ipv4Reasm ipv4reasmtab[];
+extern uint ipv4reasmnbuf;
+
 /* Function prototypes */
 syscall dot2ipv4(const char *, struct netaddr *);
+ushort ipv4IdTake(uint);
+struct packet *ipv4Reasm(struct packet *);
+void ipv4ReasmExpire(void);
+thread ipv4ReasmTimer(void);
 syscall ipv4Recv(struct packet *);
 bool ipv4RecvValid(struct ipv4Pkt *);
 bool ipv4RecvDemux(struct netaddr *);
 syscall ipv4Send(struct packet *, struct netaddr *, struct netaddr *,
                  uchar);
+syscall ipv4SendDst(struct packet *, struct netaddr *, struct netaddr *,
+                    uchar, struct netDst *);
 syscall ipv4SendFrag(struct packet *, struct netaddr *);
 
 #endif                          /* _IPv4_H_ */
@@ -41,7 +41,98 @@ struct memblock
     uint length;                    /**< size of memory block (with struct) */
 };
 
-extern struct memblock memlist;     /**< head of free memory list           */
+extern struct memblock memlist;     /**< heap accounting (length only)      */
+
+/* The kernel heap is a two-level segregated fit (TLSF) allocator.  Free */
+/* blocks are kept on MEM_NFL x MEM_NSL lists indexed by size, with one */
+/* bitmap over the first level and one per first-level entry over the   */
+/* second, so memget() and memfree() take constant time.                */
+#define MEM_SLBITS    4                     /**< log2 of MEM_NSL            */
+#define MEM_NSL       (1 << MEM_SLBITS)     /**< second-level lists         */
+#define MEM_FLSHIFT   (MEM_SLBITS + 3)      /**< sizes below 128 are linear */
+#define MEM_NFL       (32 - MEM_FLSHIFT + 1)    /**< first-level lists      */
+
+#define MEM_FREE      0x1       /**< block is free                      */
+#define MEM_PREVFREE  0x2       /**< physically preceding block is free */
+#define MEM_SLACK     0x4       /**< block has 8 bytes more than asked  */
+#define MEM_FLAGS     0x7
+
+#define MEMHDRSIZE    8         /**< bytes of header before allocation  */
+#define MEMMINBLK     16        /**< smallest block, with header        */
+
+/**
+ * Boundary tag at the start of every block of the kernel heap.  Blocks
+ * tile the heap, so the next block is found from the size and the
+ * previous one from @c prevphys.  The free list links overlay the first
+ * bytes handed out by memget() and are only valid while the block is free.
+ */
+struct memhdr
+{
+    struct memhdr *prevphys;        /**< physically preceding block         */
+    uint size;                      /**< size with header, ORed with flags  */
+    struct memhdr *nextfree;        /**< next block on the same free list   */
+    struct memhdr *prevfree;        /**< previous block on same free list   */
+};
+
+/** size of a heap block, including its header */
+#define memsize(b)  ((b)->size & ~MEM_FLAGS)
+/** block physically following a heap block */
+#define memnext(b)  ((struct memhdr *)((ulong)(b) + memsize(b)))
+/** TRUE if nothing follows a heap block below the top of the heap */
+#define memislast(b)  ((ulong)memnext(b) >= memctl.top)
+
+/**
+ * Free list heads and bitmaps of the kernel heap.
+ */
+struct memctl
+{
+    uint flmap;                     /**< first levels with a free block     */
+    uint slmap[MEM_NFL];            /**< second levels with a free block    */
+    struct memhdr *free[MEM_NFL][MEM_NSL];  /**< free list heads           */
+    ulong top;                      /**< address just above the heap        */
+    struct memhdr *last;            /**< block at the top of the heap       */
+};
+
+extern struct memctl memctl;
+
+/* Slab allocator: requests up to SLAB_MAXOBJ bytes are served from    */
+/* per-size-class slabs carved out of the heap with memget().           */
+#define SLAB_MINOBJ   16        /**< size of the smallest size class    */
+#define SLAB_MAXOBJ   4096      /**< size of the largest size class     */
+#define NSLABCLASS    9         /**< number of size classes             */
+#define SLAB_MINSIZE  4096      /**< smallest slab, in bytes            */
+
+/**
+ * Header at the start of every slab.  A slab is aligned to its own size,
+ * so the header of any object is found by masking the object's address.
+ */
+struct slab
+{
+    struct slab *next;              /**< next slab with free objects        */
+    struct slab *prev;              /**< previous slab with free objects    */
+    void *free;                     /**< list of free objects in this slab  */
+    uint inuse;                     /**< number of objects handed out       */
+};
+
+/**
+ * Per-size-class bookkeeping and statistics.
+ */
+struct slabclass
+{
+    uint size;                      /**< object size of this class          */
+    uint slabsize;                  /**< bytes per slab, a power of two     */
+    uint nobj;                      /**< objects per slab                   */
+    struct slab *partial;           /**< slabs with at least one free object*/
+    struct slab *spare;             /**< free slab kept in reserve          */
+    uint nslab;                     /**< slabs currently owned              */
+    uint inuse;                     /**< objects currently handed out       */
+    uint reqbytes;                  /**< bytes requested by those objects   */
+    uint hits;                      /**< allocations from an existing slab  */
+    uint misses;                    /**< allocations that needed a new slab */
+    uint frees;                     /**< objects returned                   */
+};
+
+extern struct slabclass slabtab[];
 
 /* Other memory data */
 
@@ -50,8 +141,15 @@ extern void *_etext;            /**< linker provides end of text segment    */
 extern void *memheap;           /**< bottom of heap                         */
 
 /* Memory function prototypes */
+void meminit(void);
+void memlink(struct memhdr *);
+void memunlink(struct memhdr *);
+struct memhdr *memfind(uint);
 void *memget(uint);
+void *memgetalign(uint, uint);
 syscall memfree(void *, uint);
 void *stkget(uint);
+void *slabget(uint);
+syscall slabfree(void *, uint);
 
 #endif                          /* _MEMORY_H_ */
@@ -10,6 +10,7 @@
 #include <stddef.h>
 #include <conf.h>
 #include <ethernet.h>
+#include <semaphore.h>
 #include <string.h>
 
 /** @ingroup network
@@ -81,6 +82,77 @@ int netaddrsprintf(char *, const struct netaddr *);
 #define NET_GET_HWADDR      203
 #define NET_GET_HWBRC       204
 
+/**
+ * @ingroup network
+ * Control function of drivers that receive straight into packet buffers.
+ * With @c arg1 pointing to a <code>struct packet *</code>, waits for the
+ * next frame and stores the packet holding it, with @c len set and the
+ * frame at @c data; returns the frame length.  With @c arg1 NULL, returns
+ * ::OK without waiting, to show the driver supports it.  Drivers that do
+ * not are read() from instead.
+ */
+#define NET_RECV_PKT        205
+
+/**
+ * @ingroup network
+ * Control function of drivers that can write a burst of frames in one
+ * call.  With @c arg1 pointing to an array of @c arg2 packets, each with
+ * its frame at @c curr and @c len set, writes them in order and returns
+ * how many were written.  With @c arg1 NULL, returns ::OK to show the
+ * driver supports it.  Drivers that do not are written to a frame at a
+ * time instead.  A packet may have segments after the octets at @c curr,
+ * which the driver gathers into the frame; drivers that do not support
+ * this control are given packets made contiguous by netLinearize().  The
+ * packets stay the caller's.
+ */
+#define NET_SEND_PKTS       206
+
+/**
+ * @ingroup network
+ * Control function of drivers that support ::NET_RECV_PKT, to set the
+ * buffer pool, @c arg1, that received frames are put in.  Buffers are
+ * taken from it with bufgetnb(), so a frame that finds the pool empty is
+ * dropped and counted against the pool rather than waited for.  Until it
+ * is set, frames go in ::netpool.
+ */
+#define NET_SET_RXPOOL      207
+
+/**
+ * @ingroup network
+ * Control function of drivers that can steer received frames themselves.
+ * With @c arg1 pointing to the <code>struct netif</code> running on the
+ * device, the driver puts each frame it receives, in a packet buffer with
+ * @c len set and the frame at @c data, on one of the interface's receive
+ * queues with netRxqPut(), and wakes the receive threads with netRxqWake()
+ * once it has put the frames it has.  With @c arg1 NULL it stops, and
+ * queues frames for read() and ::NET_RECV_PKT again.  Returns ::OK if the
+ * driver supports it.  For drivers that do not, the first receive thread
+ * reads frames from the device and steers them.
+ */
+#define NET_SET_STEER       208
+
+/**
+ * @ingroup network
+ * Control function of drivers that steer frames and can be polled for
+ * them.  With @c arg1 TRUE, the driver stops handling received frames in
+ * its interrupt handler: on a receive interrupt it masks further ones and
+ * calls netPollSchedule(), and takes frames off the device only when
+ * polled with ::NET_POLL.  With @c arg1 FALSE it steers frames from its
+ * interrupt handler again.  Returns ::OK if the driver supports it; it
+ * must already steer to an interface with ::NET_SET_STEER.
+ */
+#define NET_SET_POLL        209
+
+/**
+ * @ingroup network
+ * Control function of drivers in the mode set by ::NET_SET_POLL.  Puts up
+ * to @c arg1 received frames on the receive queues, as for ::NET_SET_STEER,
+ * and returns how many it put.  If it put fewer, none were left, and the
+ * driver unmasks its receive interrupt; otherwise it leaves it masked and
+ * is polled again.
+ */
+#define NET_POLL            210
+
 /* Network interface structure definitions */
 #ifdef NETHER
 #ifdef NETHLOOP
@@ -92,14 +164,40 @@ int netaddrsprintf(char *, const struct netaddr *);
 
 
 /* Network receive thread constants */
-#define NET_NTHR       5              /**< Num net receive threads      */
+#define NET_NTHR       5              /**< Default num net receive threads */
+#define NET_NTHR_MAX   8              /**< Max num net receive threads  */
+#define NET_RXQ_LEN    64             /**< Pkts each receive queue holds */
+#define NET_POLL_BUDGET 16            /**< Most pkts taken in each poll */
 #define NET_THR_PRIO   30             /**< Net recv thread priority     */
 #define NET_THR_STK    4096           /**< Net recv thread stack size   */
+#define NET_RECV_RETRY 10             /**< ms to wait after a read fails */
 
 /* Network table entry states */
 #define NET_FREE   0                  /**< Netif state free             */
 #define NET_ALLOC  1                  /**< Netif state allocated        */
 
+/* netSend() results besides OK and SYSERR */
+#define NET_QUEUED   2                /**< Held for address resolution  */
+#define NET_DROPPED  (-5)             /**< No room to hold for resolution */
+
+/**
+ * Queue of received packets for one network receive thread.  Frames are
+ * put on the queue that a hash of their IPv4 addresses, protocol and ports
+ * selects, so that each flow is handled by one thread, in order.
+ */
+struct netRxq
+{
+    semaphore sem;                    /**< Packets waiting, to wake thread */
+    uint head;                        /**< Index of oldest packet       */
+    uint count;                       /**< Packets in the queue         */
+    uint nwake;                       /**< Packets put, not yet signaled */
+    uint maxcount;                    /**< Most packets queued at once  */
+    uint npkt;                        /**< Packets the thread handled   */
+    uint ndrop;                       /**< Packets dropped, queue full  */
+    uint nsignal;                     /**< Times the thread was woken   */
+    struct packet *pkt[NET_RXQ_LEN];  /**< Queued packets               */
+};
+
 /** Net interface control block */
 struct netif
 {
@@ -113,22 +211,68 @@ struct netif
     struct netaddr ipbrc;             /**< Broadcast protocol address   */
     struct netaddr hwaddr;            /**< Hardware address             */
     struct netaddr hwbrc;             /**< Hardware broadcast address   */
-    tid_typ recvthr[NET_NTHR];        /**< Recv thread ids              */
+    uint nthr;                        /**< Num recv threads             */
+    tid_typ recvthr[NET_NTHR_MAX];    /**< Recv thread ids              */
+    struct netRxq rxq[NET_NTHR_MAX];  /**< Recv queue of each thread    */
     uint nin;                         /**< Num recv pkts                */
     uint nproc;                       /**< Num recv pkts processed      */
+    bool recvpkt;                     /**< Driver supports NET_RECV_PKT */
+    bool sendpkts;                    /**< Driver supports NET_SEND_PKTS */
+    bool steer;                       /**< Driver supports NET_SET_STEER */
+    bool poll;                        /**< Driver is polled, NET_SET_POLL */
+    bool pollpend;                    /**< Poll waits on first recv queue */
+    uint nrxintr;                     /**< Recv interrupts that polled  */
+    uint npoll;                       /**< Num polls of the driver      */
+    int rxpool;                       /**< Pool of received packets     */
     void *capture;                    /**< Snoop capture structure      */
 };
 
 extern struct netif netiftab[];
 
-/** Network packet buffer pool */
+/** Network packet buffer pool for packets sent */
 extern int netpool;
 
 #define NET_MAX_PKTLEN		1598    /**< Mod 4 of this constant must be 2 */
 /**
- * Poolsize should be >= ARP_NQUEUE + RT_NQUEUE + UDP_IBLEN + RAW_IBLEN 
+ * Poolsize of ::netpool should be >= ARP_NENTRY * ARP_NPENDING plus the
+ * packets being sent at once.  The last NET_TXRESERVE of them are left for
+ * netGetbuf(), which waits for a buffer, by what can drop a packet instead.
+ */
+#define NET_POOLSIZE		256
+#define NET_TXRESERVE		16
+/**
+ * Poolsize of the pool of received packets each interface gets should be
+ *   >= ARP_NQUEUE + RT_NQUEUE + RAW_IBLEN + IPv4_REASM_NBUF
+ */
+#define NET_RXPOOLSIZE		320
+
+/**
+ * Header in front of a packet buffer too large for ::netpool, which
+ * netGetbufLen() takes from the heap.  It is laid out like the header
+ * of a pool buffer, with ::NET_HEAPPOOL where the pool ID would be, so
+ * that netFreebuf() can tell the two apart.
+ */
+struct netHeapbuf
+{
+    uint size;                  /**< Size of the block, with this header */
+    int poolid;                 /**< ::NET_HEAPPOOL                     */
+};
+
+#define NET_HEAPPOOL        (-1)    /**< Pool ID of heap packet buffers */
+
+/**
+ * Segment of an outgoing frame that lies outside its packet buffer, such
+ * as data in the caller's memory or another packet.  The segments of a
+ * packet follow the octets at its @c curr, in order.  They need only stay
+ * valid until netSend() or netSendPkts() returns, since drivers and held
+ * copies take their own copy of the frame.
  */
-#define NET_POOLSIZE		512
+struct netSeg
+{
+    const uchar *data;          /**< Octets of the segment              */
+    uint len;                   /**< Length of the segment              */
+    const struct netSeg *next;  /**< Next segment, NULL if last         */
+};
 
 /** Incoming packet structure       */
 struct packet
@@ -138,22 +282,59 @@ struct packet
     uchar *linkhdr;             /**< Pointer to link layer header       */
     uchar *nethdr;              /**< Pointer to network layer header    */
     uchar *curr;                /**< Pointer to location into packet    */
+    const struct netSeg *segs;  /**< Rest of the frame, NULL if none    */
+    uint seglen;                /**< Octets in segs, counted in len     */
     uchar pad[2];               /**< Padding for word alignment         */
     uchar data[1];              /**< Pointer to incoming packet         */
 };
 
+/**
+ * Destination cache of a connected socket: the interface and next hop
+ * that its packets to one remote address leave by, and the link-level
+ * header they carry.  Filled in by netDstLookup(), and only used while
+ * the route and ARP tables are as they were then.
+ */
+struct netDst
+{
+    struct netif *nif;          /**< Interface, NULL if never filled in */
+    struct netaddr dst;         /**< Remote address                     */
+    struct netaddr nxthop;      /**< Gateway, or the remote address     */
+    uchar linkhdr[ETH_HDR_LEN]; /**< Link-level header of the packets   */
+    uint rtgen;                 /**< Route table generation, ::rtgen    */
+    uint arpgen;                /**< ARP table generation, ::arpgen     */
+    uint expires;               /**< clktime hardware address expires   */
+};
+
 /* Function Prototypes */
 ushort netChksum(void *, uint);
+uint netChksumAdd(uint, const void *, uint);
+ushort netChksumAdjust(ushort, ushort, ushort);
+uint netChksumCopy(uint, void *, const void *, uint);
+ushort netChksumFinish(uint);
 syscall netDown(int);
+syscall netDstLookup(struct netDst *, const struct netaddr *);
 syscall netFreebuf(struct packet *);
+uint netGather(void *, const struct packet *, uint, uint);
 struct packet *netGetbuf(void);
+struct packet *netGetbufLen(uint);
+uint netHashPorts(ushort, ushort, const struct netaddr *);
 syscall netInit(void);
+struct packet *netLinearize(const struct packet *);
 struct netif *netLookup(int);
-thread netRecv(struct netif *);
+void netPoll(struct netif *);
+void netPollSchedule(struct netif *);
+thread netRecv(struct netif *, uint);
+int netRxqPut(struct netif *, struct packet *);
+uint netRxqSelect(const struct netif *, const struct packet *);
+struct packet *netRxqTake(struct netif *, uint);
+void netRxqWake(struct netif *);
 syscall netSend(struct packet *, const struct netaddr *, const struct netaddr *,
                 ushort);
+syscall netSendPkts(struct packet **, uint, const struct netDst *);
 syscall netUp(int, const struct netaddr *, const struct netaddr *,
               const struct netaddr *);
+syscall netUpThreads(int, const struct netaddr *, const struct netaddr *,
+                     const struct netaddr *, uint);
 
 /**  @} */
 
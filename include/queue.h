@@ -26,10 +26,23 @@
 
 #include <kernel.h>
 
+#ifndef NPRIO
+/** number of distinct ready list priority levels (multiple of 32)      */
+#define NPRIO   64
+#endif
+
+/* timing wheel geometry: TMRLEVELS levels of TMRSLOTS queues each     */
+#define TMRSLOTBITS 6
+#define TMRSLOTS    (1 << TMRSLOTBITS)  /**< slots per wheel level      */
+#define TMRLEVELS   4                   /**< levels in the wheel        */
+#define NTMRSLOT    (TMRSLOTS * TMRLEVELS)
+
 #ifndef NQENT
 
-/** NQENT = 1 per thread, 2 per list, 2 per sem */
-#define NQENT   (NTHREAD + 4 + NSEM + NSEM)
+/** NQENT = 1 per thread, 2 per list, 2 per sem, 2 per ready priority,
+ *  2 per timing wheel slot */
+#define NQENT   (NTHREAD + 4 + NSEM + NSEM + NPRIO + NPRIO \
+                 + NTMRSLOT + NTMRSLOT)
 #endif
 
 #define EMPTY (-2)              /**< null pointer for queues            */
@@ -66,6 +79,16 @@ extern qid_typ readylist;
 #define lastkey(q)   (quetab[quetab[quetail(q)].prev].key)
 #define firstid(q)   (quetab[quehead(q)].next)
 
+/* The ready list is NPRIO consecutive FIFO queues, one per priority    */
+/* level, starting at readylist.  A bitmap of non-empty levels lets the */
+/* scheduler find the highest ready priority in constant time.          */
+#define RDYMAPLEN    (NPRIO / 32)
+extern uint rdymap[RDYMAPLEN];
+
+#define rdylevel(p)  ((p) < 0 ? 0 : ((p) >= NPRIO ? NPRIO - 1 : (p)))
+#define rdyqueue(l)  (readylist + 2 * (l))
+#define isrdyqueue(q) ((uint)((q) - readylist) < 2 * NPRIO)
+
 /* Queue function prototypes */
 tid_typ getfirst(qid_typ);
 tid_typ getlast(qid_typ);
@@ -75,5 +98,9 @@ tid_typ dequeue(qid_typ);
 int insert(tid_typ, qid_typ, int);
 int insertd(tid_typ, qid_typ, int);
 qid_typ queinit(void);
+qid_typ rdyinit(void);
+int rdyinsert(tid_typ, int);
+tid_typ rdydequeue(void);
+int rdyhighest(void);
 
 #endif                          /* _QUEUE_H_ */
@@ -57,6 +57,7 @@ struct raw
     ushort proto;                   /**< IP protocol to accept              */
     struct netaddr localip;         /**< Local IP address                   */
     struct netaddr remoteip;        /**< Remote IP address                  */
+    struct netDst dst;              /**< Destination cache                  */
 
     /* Input fields */
     struct packet *in[RAW_IBLEN];        /**< Input buffer                  */
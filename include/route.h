@@ -36,6 +36,10 @@
 /* Route daemon info */
 #define RT_NQUEUE          32      /**< Number of pkts allowed in queue */
 
+/* Route lookup structures */
+#define RT_NNODE  (2 * RT_NENTRY + 1)  /**< Nodes in IPv4 lookup trie    */
+#define RT_NCACHE          16      /**< Route cache entries, power of 2 */
+
 /* Route Packet Structure */
 struct rtEntry
 {
@@ -50,9 +54,42 @@ struct rtEntry
 /* Route table */
 extern struct rtEntry rttab[RT_NENTRY];
 
+/**
+ * Node of the path-compressed binary trie used to look up IPv4 routes.  A
+ * node stands for the first @c len bits of @c prefix; its children extend
+ * it with a 0 or a 1 as bit @c len, skipping any bits that no route in the
+ * subtree differs in.
+ */
+struct rtNode
+{
+    uint prefix;                /**< Prefix, host order, masked to len  */
+    ushort len;                 /**< Prefix length in bits              */
+    ushort child[2];            /**< Index of children, 0 if none       */
+    struct rtEntry *route;      /**< Route for this prefix, or NULL     */
+};
+
+/**
+ * Route cache entry.  Only valid while @c gen equals ::rtgen.
+ */
+struct rtCache
+{
+    uint addr;                  /**< Destination, host order            */
+    uint gen;                   /**< Value of rtgen when cached         */
+    struct rtEntry *route;      /**< Route for destination, or NULL     */
+};
+
+/* IPv4 lookup trie, rebuilt whenever the route table changes */
+extern struct rtNode rttrie[RT_NNODE];
+extern struct rtCache rtcache[RT_NCACHE];
+extern volatile uint rtgen;
+
 /* Route pakcet queue for packets requiring routing */
 extern mailbox rtqueue;
 
+/* Routed packets dropped because the next hop's hardware address was not
+ * resolved and no more packets could be held for it */
+extern uint rtnarpdrop;
+
 /* Function prototypes */
 syscall rtAdd(const struct netaddr *dst, const struct netaddr *gate,
               const struct netaddr *mask, struct netif *nif);
@@ -61,6 +98,8 @@ thread rtDaemon(void);
 syscall rtDefault(const struct netaddr *gate, struct netif *nif);
 syscall rtInit(void);
 struct rtEntry *rtLookup(const struct netaddr *addr);
+void rtTrieBuild(void);
+struct rtEntry *rtTrieLookup(uint addr);
 syscall rtRecv(struct packet *pkt);
 syscall rtRemove(const struct netaddr *dst);
 syscall rtClear(struct netif *nif);
@@ -75,6 +75,13 @@ struct tcpPkt
 #define TCP_OPT_MSS      2 /**< maximum segment size */
 #define TCP_OPT_MSS_SIZE 6 /**< bytes needed for MSS option */
 #define TCP_OPT_MSS_LEN  4 /**< length of MSS option */
+#define TCP_OPT_WSCALE   3 /**< window scale */
+#define TCP_OPT_WSCALE_LEN 3 /**< length of window scale option */
+#define TCP_MAX_WSCALE  14 /**< largest window scale shift, RFC 7323 */
+#define TCP_OPT_SACKOK   4 /**< selective acknowledgement permitted */
+#define TCP_OPT_SACKOK_LEN 2 /**< length of SACK permitted option */
+#define TCP_OPT_SACK     5 /**< selective acknowledgement */
+#define TCP_OPT_SACK_MAXBLK 4 /**< most blocks sent in a SACK option */
 
 /* TCP Checksum Pseudo Header */
 struct tcpPseudo
@@ -89,8 +96,15 @@ struct tcpPseudo
 #define TCP_PSEUDO_LEN  12
 
 /* Buffer lengths */
-#define TCP_IBLEN 16384  /**< Size of input buffer, must be multiple of 8 */
-#define TCP_OBLEN 16384  /**< Size of output buffer */
+#define TCP_IBLEN 16384  /**< Default initial size of input buffer */
+#define TCP_OBLEN 16384  /**< Default size of output buffer */
+#define TCP_IBMAX (256 * 1024)  /**< Input buffer autotuning limit */
+#define TCP_BUFMIN 2048  /**< Smallest buffer size that can be set */
+#define TCP_BUFMAX (1024 * 1024)  /**< Largest buffer size that can be set */
+#define TCP_TUNE_MINTIME 10  /**< Shortest time in ms autotuning looks at */
+#define TCP_NOOO  8      /**< Out-of-order intervals held per TCB */
+#define TCP_NSACKED 8    /**< Selectively acknowledged intervals per TCB */
+#define TCP_BURST 16     /**< Segments handed to the interface at once */
 
 /* Initial sizes */
 #define TCP_INIT_MSS (1440 + TCP_HDR_LEN)
@@ -98,6 +112,41 @@ struct tcpPseudo
 #define TCP_INIT_WND TCP_INIT_MSS
 #define TCP_MAX_WND 65535
 
+/* Socket hash table */
+#define TCP_NHASH 32     /**< Buckets in TCB hash table, power of 2 */
+
+/**
+ * Run of sequence numbers received out of order, from @c start up to but
+ * not including @c end.
+ */
+struct tcpInterval
+{
+    tcpseq start;
+    tcpseq end;
+};
+
+/* TCP Timer Constants; times are in clock ticks, which are milliseconds */
+#define TCP_NTIMERS     4   /**< timer events per TCB */
+#define TCP_EVT_TIMEWT  1   /**< 2MSL time-wait timeout */
+#define TCP_EVT_RXT     2   /**< retransmit event */
+#define TCP_EVT_PERSIST 3   /**< persist event, for zero window */
+#define TCP_EVT_DELACK  4   /**< delayed ACK event */
+#define TCP_WHEELSLOTS  256 /**< one-tick slots in timer wheel, power of 2 */
+
+/**
+ * TCP timer event.  Each TCB has one of each type, which is either in the
+ * slot of the timer wheel for the tick it is due or not scheduled.
+ */
+struct tcpEvent
+{
+    ulong expires;                  /**< Tick at which event is due */
+    ulong start;                    /**< Tick at which event was scheduled */
+    uchar type;                     /**< Type of event */
+    struct tcb *tcbptr;             /**< TCB for event */
+    struct tcpEvent *next;          /**< Next event in the same slot */
+    struct tcpEvent **prev;         /**< Link to this event, NULL if idle */
+};
+
 /**
  * Transmission control block 
  */
@@ -107,6 +156,7 @@ struct tcb
     uchar state;         /**< connection state */
     uchar devstate;      /**< allocation state of the device internally */
     semaphore mutex;     /**< Mutual exclusion semaphore */
+    struct tcpEvent timers[TCP_NTIMERS]; /**< Timer events, by type */
 
     /* Connection details */
     ushort localpt;             /**< Local port number */
@@ -115,6 +165,18 @@ struct tcb
     struct netaddr remoteip;    /**< Remote IP address */
     uchar opentype;             /**< Type of open call */
     semaphore openclose;
+    struct tcb *hnext;          /**< Next TCB in hash bucket */
+    ushort hslot;               /**< Hash bucket of TCB */
+    bool hashed;                /**< TCB is in hash table */
+    struct netDst dst;          /**< Destination cache */
+
+    /* Listening */
+    struct tcb *parent;         /**< Listener, until connection accepted */
+    struct tcb *accnext;        /**< Next TCB in listener's accept queue */
+    struct tcb *acchead;        /**< First established, unaccepted TCB */
+    struct tcb *acctail;        /**< Last established, unaccepted TCB */
+    uint nchild;                /**< TCBs created and not yet accepted */
+    uint backlog;               /**< Most unaccepted TCBs, 0 for default */
 
     /* Receive variables */
     tcpseq rcvnxt;              /**< receive next */
@@ -122,16 +184,26 @@ struct tcb
     tcpseq rcvup;               /**< receive urgent pointer */
     tcpseq rcvfin;              /**< sequence number for received FIN */
     ushort rcvmss;              /**< maximum receive segment size */
-    uchar rcvflg;               /**< receive flags */
+    ushort rcvflg;              /**< receive flags */
+
+    uchar rcvwscale;            /**< shift applied to advertised window */
 
     /* Receive buffer */
     semaphore readers;          /**< Count of readers waiting for data */
     uint istart;                /**< Index of first octet ready for user */
     uint icount;                /**< Count of octets ready for user */
-    uint inxt;
-    uchar in[TCP_IBLEN];        /**< Input buffer */
-    uchar imark[TCP_IBLEN];
+    uint inxt;                  /**< Index of octet for rcvnxt */
+    uchar *in;                  /**< Input buffer */
+    uint ibsize;                /**< Size of input buffer */
+    uint ibmax;                 /**< Size input buffer may grow to */
+    uint rcvbuf;                /**< Input buffer size set, 0 to autotune */
+    tcpseq tuneseq;             /**< rcvnxt when autotuning last looked */
+    ulong tunetime;             /**< Time in ms autotuning last looked */
+    struct tcpInterval ooo[TCP_NOOO]; /**< Data beyond rcvnxt, in order */
+    uint nooo;                  /**< Count of out-of-order intervals */
+    tcpseq ooolast;             /**< Start of last out-of-order segment */
     uint ibytes;                /**< Count of bytes passed to user */
+    uint rcvsegs;               /**< Data segments received since ACK */
 
     /* Send variables */
     tcpseq snduna;                  /**< send unacknowledged */
@@ -145,22 +217,38 @@ struct tcb
     tcpseq iss;                     /**< initial send seq num */
     tcpseq sndfin;                  /**< sequence number for sent FIN */
     ushort sndmss;                  /**< maximum send segment size */
-    uchar sndflg;                   /**< send flags */
+    ushort sndflg;                  /**< send flags */
+    uchar sndwscale;                /**< shift applied to received window */
     int sndrtt;                     /**< smoothed sending round trip time */
     int sndrtd;                     /**< sending round trip deviation */
     int rxttime;                    /**< retransmission timer */
     uint rxtcount;                  /**< number of retransmissions */
     int psttime;                    /**< persist timer */
+    uint dupacks;                   /**< duplicate ACKs in a row */
+    tcpseq recover;                 /**< sndnxt when loss was detected */
+    tcpseq sndhole;                 /**< end of last hole retransmitted */
+    struct tcpInterval sacked[TCP_NSACKED]; /**< SACKed beyond snduna */
+    uint nsacked;                   /**< Count of SACKed intervals */
 
     /* Send buffer */
     semaphore writers;         /**< Count of writers waiting for buffer */
     uint ostart;               /**< Index of first octet */
     uint ocount;               /**< Octets in buffer */
-    uchar out[TCP_OBLEN];      /**< Output buffer */
+    uchar *out;                /**< Output buffer */
+    uint obsize;               /**< Size of output buffer */
+    uint sndbuf;               /**< Output buffer size set, 0 for default */
+    uchar sockopt;             /**< Socket options set */
     uint obytes;               /**< Count of bytes acknowledged by receiver */
+
+    /* Header template for full size data segments */
+    uchar tmpl[IPv4_HDR_LEN + TCP_HDR_LEN]; /**< IPv4 and TCP headers */
+    uint tmplipsum;            /**< Sum of IPv4 header, less its length */
+    uint tmplsum;              /**< Sum of pseudo header, less its length */
+    bool tmplok;               /**< Template is built for this connection */
 };
 
 extern struct tcb tcptab[];
+extern struct tcb *tcphash[];
 
 /* Local port allocation ranges */
 #define TCP_PSTART 10000     /**< start port for allocating */
@@ -169,6 +257,9 @@ extern struct tcb tcptab[];
 /* Open type */
 #define TCP_PASSIVE  0  /**< passive open connection */
 #define TCP_ACTIVE   1  /**< active open connection */
+#define TCP_LISTENER 2  /**< listen for connections to accept */
+
+#define TCP_BACKLOG  8  /**< Default unaccepted connections per listener */
 
 /* Connection states */
 #define TCP_CLOSED   0 /**< closed state */
@@ -190,6 +281,17 @@ extern struct tcb tcptab[];
 #define TCP_FLG_SNDDATA  0x08   /**< Need to send data */
 #define TCP_FLG_SNDRST   0x10   /**< Need to send a RST */
 #define TCP_FLG_PERSIST  0x20   /**< In persist output state */
+#define TCP_FLG_WSCALE   0x40   /**< Window scale option received */
+#define TCP_FLG_SACK     0x80   /**< SACK permitted option received */
+#define TCP_FLG_RECOVER  0x100  /**< In fast recovery */
+#define TCP_FLG_DELACK   0x200  /**< Delayed ACK timer is running */
+
+/* Socket options, kept from one connection to the next */
+#define TCP_SOCK_NODELAY   0x01 /**< Send partial segments at once */
+#define TCP_SOCK_QUICKACK  0x02 /**< ACK every segment at once */
+
+#define TCP_DUPACKS 3   /**< duplicate ACKs that start fast retransmit */
+#define TCP_DELACK_SEGS 2   /**< data segments ACKed together at most */
 
 #define TCP_SEQINCR 904 /**< amount to increment ISS each time */
 
@@ -211,18 +313,11 @@ extern struct tcb tcptab[];
 /* TCP Length Macros */
 #define tcpSeglen(tcppkt, len) (len - offset2octets(tcppkt->offset))
 
-/* TCP Timer Constants */
-#define TCP_NEVENTS     (3*NTCP)+1 /**< max number events (incl dummy head) */
-#define TCP_EVT_HEAD    0   /**< Head entry */
-#define TCP_FREQ        10  /**< milliseconds per timer tick */
-#define TCP_EVT_TIMEWT  1   /**< 2MSL time-wait timeout */
-#define TCP_EVT_RXT     2   /**< retransmit event */
-#define TCP_EVT_PERSIST 3   /**< persist event, for zero window */
-
 /* TCP Timer Durations */
 #define TCP_TWOMSL  (5*1000)
 #define TCP_PST_INITTIME (3*1000)  /**< initial persist time */
 #define TCP_PST_MAXTIME  (64*1000) /**< maximum persist time */
+#define TCP_DELACK_TIME  (200)     /**< longest an ACK is delayed */
 
 /* TCP Retransmit */
 #define TCP_RXT_MAXCOUNT 10         /** maximum number of retransmissions */
@@ -230,23 +325,24 @@ extern struct tcb tcptab[];
 #define TCP_RXT_MINTIME  (100)    /**< minimum retransmission time */
 #define TCP_RXT_MAXTIME  (32*1000) /**< maximum retransmission time */
 
-/* TCP Timer Event */
-struct tcpEvent
-{
-    bool used;                      /**< Is timer event record used? */
-    int time;                       /**< number of TCP timer ticks for event */
-    int remain;                     /**< TCP timer ticks remain */
-    uchar type;                     /**< Type of event */
-    struct tcb *tcbptr;             /**< TCB for event */
-    struct tcpEvent *next;          /**< Next timer event */
-};
-
-extern struct tcpEvent tcptimertab[];
-extern semaphore tcpmutex;
+extern struct tcpEvent *tcpwheel[];
+extern uint tcpwheelmap[];
+extern tid_typ tcptimerid;
+extern bool tcptimerasleep;
+extern ulong tcptimerwake;
+extern ulong tcptimerwakes;
 
 /* TCP Control Functions */
 #define TCP_CTRL_RECVBYTES 2 /**< Get number of bytes recevied */
 #define TCP_CTRL_SENTBYTES 3 /**< Get number of bytes sent */
+#define TCP_CTRL_SETRCVBUF 4 /**< Set input buffer size, 0 to autotune */
+#define TCP_CTRL_SETSNDBUF 5 /**< Set output buffer size, 0 for default */
+#define TCP_CTRL_GETRCVBUF 6 /**< Get input buffer size */
+#define TCP_CTRL_GETSNDBUF 7 /**< Get output buffer size */
+#define TCP_CTRL_NODELAY   8 /**< Turn Nagle's algorithm off (TRUE) or on */
+#define TCP_CTRL_QUICKACK  9 /**< Turn delayed ACKs off (TRUE) or on */
+#define TCP_CTRL_BACKLOG  10 /**< Set listener backlog, 0 for default */
+#define TCP_CTRL_ACCEPT   11 /**< Wait for a connection, get its device */
 
 /* TCP Ports */
 #define TCP_PORT_TELNET    23
@@ -263,14 +359,19 @@ devcall tcpPutc(device *, char);
 devcall tcpControl(device *, int, long, long);
 
 ushort tcpAlloc(void);
+devcall tcpAccept(struct tcb *);
 ushort tcpChksum(struct packet *, ushort, struct netaddr *,
                  struct netaddr *);
+uint tcpChksumPseudo(const struct netaddr *, const struct netaddr *, ushort);
 devcall tcpFree(struct tcb *);
 int tcpOpenActive(struct tcb *);
 void tcpAbort(struct tcb *, int);
 int tcpSetup(struct tcb *);
 
 struct tcb *tcpDemux(ushort, ushort, struct netaddr *, struct netaddr *);
+uint tcpHashSlot(ushort, ushort, const struct netaddr *);
+void tcpHashInsert(struct tcb *);
+void tcpHashRemove(struct tcb *);
 int tcpRecv(struct packet *, struct netaddr *, struct netaddr *);
 int tcpRecvOpts(struct packet *, struct tcb *);
 int tcpRecvListen(struct packet *, struct tcb *, struct netaddr *);
@@ -282,22 +383,33 @@ int tcpRecvAck(struct packet *, struct tcb *);
 int tcpRecvRtt(struct tcb *);
 
 int tcpSend(struct tcb *, uchar, uint, uint, uint, ushort);
-ushort tcpSendWindow(struct tcb *);
+uint tcpSendWindow(struct tcb *);
 int tcpSendAck(struct tcb *);
+int tcpSendBurst(struct tcb *, uint, uint, uint);
 int tcpSendSyn(struct tcb *);
 int tcpSendData(struct tcb *);
 int tcpSendRxt(struct tcb *);
+int tcpSendHole(struct tcb *);
 int tcpSendPersist(struct tcb *);
 int tcpSendRst(struct packet *, struct netaddr *, struct netaddr *);
 
 void tcpStat(struct tcb *);
 
 thread tcpTimer(void);
+ulong tcpTimerNow(void);
 void tcpTimerTrigger(uchar, struct tcb *);
 devcall tcpTimerSched(int, struct tcb *, uchar);
 devcall tcpTimerPurge(struct tcb *, uchar);
 devcall tcpTimerRemain(struct tcb *, uchar);
 
 tcpseq tcpSeqdiff(tcpseq, tcpseq);
+void tcpRingPut(uchar *, uint, uint, const uchar *, uint);
+void tcpRingGet(const uchar *, uint, uint, uchar *, uint);
+uint tcpRingGetSum(const uchar *, uint, uint, uchar *, uint, uint);
+int tcpRingAlloc(struct tcb *);
+void tcpRingFree(struct tcb *);
+int tcpRingGrow(struct tcb *, uint);
+void tcpIntervalAdd(struct tcpInterval *, uint *, uint, tcpseq, tcpseq);
+void tcpIntervalTrim(struct tcpInterval *, uint *, tcpseq);
 
 #endif                          /* _TCP_H_ */
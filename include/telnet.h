@@ -109,6 +109,7 @@ struct telnet
 };
 
 extern struct telnet telnettab[];
+extern int telnetlistener;      /**< TCP device listening, or SYSERR */
 
 /* Driver functions */
 int telnetAlloc(void);
@@ -121,6 +122,6 @@ devcall telnetGetc(device *);
 devcall telnetPutc(device *, char);
 devcall telnetControl(device *, int, long, long);
 devcall telnetFlush(device *);
-thread telnetServer(int, int, ushort, char *);
+thread telnetServer(ushort, ushort, char *);
 
 #endif                          /* _TELNET_H_ */
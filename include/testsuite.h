@@ -8,6 +8,7 @@
 #ifndef _TESTSUITE_H_
 #define _TESTSUITE_H_
 
+#include <network.h>
 #include <thread.h>
 
 thread test_bigargs(bool);
@@ -45,12 +46,35 @@ thread test_raw(bool);
 thread test_ip(bool);
 thread test_umemory(bool);
 thread test_tlb(bool);
+thread test_ctxsw(bool);
+thread test_clock(bool);
+thread test_timerWheel(bool);
+thread test_slab(bool);
+thread test_heap(bool);
+thread test_libStringSpeed(bool);
+thread test_demux(bool);
+thread test_route(bool);
+thread test_tcpBulk(bool);
+thread test_tcpTimer(bool);
+thread test_tcpAccept(bool);
+thread test_chksum(bool);
+thread test_ipReasm(bool);
+thread test_netSeg(bool);
+thread test_netSteer(bool);
+thread test_netPoll(bool);
 
 void testPass(bool, const char *);
 void testFail(bool, const char *);
 void testSkip(bool, const char *);
 void testPrint(bool, const char *);
 
+/* Loopback network shared by the network tests */
+#define TESTNET_WAIT  1000      /**< ms to wait for a datagram to arrive */
+struct netif *testNetUp(struct netaddr *);
+void testNetDown(void);
+ushort testNetUdpOpen(const struct netaddr *, ushort);
+ulong testNetUdpLoop(ushort, uchar *, uchar *, uint, uint);
+
 /**
  * Causes the test to fail if condition is met and display failmsg in that
  * case.  Otherwise, the test will pass.
@@ -31,8 +31,9 @@
 /* UDP definitions */
 #define UDP_HDR_LEN	        8
 #define UDP_MAX_PKTS        100
-#define UDP_MAX_DATALEN     1024
+#define UDP_MAX_DATALEN     (IPv4_MAX_LEN - IPv4_HDR_LEN - UDP_HDR_LEN)
 #define UDP_TTL             64
+#define UDP_NHASH           32  /**< buckets in socket hash, power of 2 */
 
 /** @}
  *  @ingroup udpexternal
@@ -140,9 +141,14 @@ struct udp
 
     uchar state;                        /**< UDP state                      */
     uchar flags;                        /**< UDP flags                      */
+    struct udp *hnext;                  /**< Next socket in hash bucket     */
+    ushort hslot;                       /**< Hash bucket of socket          */
+    bool hashed;                        /**< Socket is in hash table        */
+    struct netDst dst;                  /**< Destination cache              */
 };
 
 extern struct udp udptab[];
+extern struct udp *udphash[];
 
 /** @} */
 
@@ -155,14 +161,18 @@ devcall udpWrite(device *, const void *, uint);
 ushort udpAlloc(void);
 ushort udpChksum(struct packet *, ushort, const struct netaddr *,
                  const struct netaddr *);
+uint udpChksumPseudo(const struct netaddr *, const struct netaddr *, ushort);
 struct udp *udpDemux(ushort, ushort, const struct netaddr *,
                      const struct netaddr *);
+uint udpHashSlot(ushort, ushort, const struct netaddr *);
+void udpHashInsert(struct udp *);
+void udpHashRemove(struct udp *);
 syscall udpRecv(struct packet *, const struct netaddr *,
                 const struct netaddr *);
 syscall udpSend(struct udp *, ushort, const void *);
 devcall udpControl(device *, int, long, long);
-struct udpPkt *udpGetbuf(struct udp *);
-syscall udpFreebuf(struct udpPkt *);
+struct udpPkt *udpGetbuf(struct udp *, uint);
+syscall udpFreebuf(struct udpPkt *, uint);
 
 #endif                          /* __ASSEMBLER__ */
 
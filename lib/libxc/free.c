@@ -27,11 +27,11 @@ void free(void *ptr)
     /* back up to accounting information */
     block--;
 
-    /* don't memfree if we fail basic checks */
+    /* don't slabfree if we fail basic checks */
     if (block->next != block)
     {
         return;
     }
 
-    memfree(block, block->length);
+    slabfree(block, block->length);
 }
@@ -34,7 +34,7 @@ void *malloc(size_t size)
     size += sizeof(struct memblock);
 
     /* acquire memory from kernel */
-    pmem = (struct memblock *)memget(size);
+    pmem = (struct memblock *)slabget(size);
     if (SYSERR == (uint)pmem)
     {
         return NULL;
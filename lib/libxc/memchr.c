@@ -5,6 +5,7 @@
 
 #include <string.h>
 #include <stddef.h>
+#include "word.h"
 
 /** 
  * @ingroup libxc
@@ -27,13 +28,31 @@ void *memchr(const void *s, int c, size_t n)
 {
     const unsigned char *p = s;
     unsigned char byte = c;
-    size_t i;
+    const word_t *wp;
+    word_t pattern;
 
-    for (i = 0; i < n; i++)
+    for (; (n > 0) && !wordaligned(p); n--, p++)
     {
-        if (p[i] == byte)
+        if (*p == byte)
         {
-            return (void*)&p[i]; /* Cast away const */
+            return (void*)p; /* Cast away const */
+        }
+    }
+
+    /* skip whole words that do not contain the byte */
+    pattern = WORDONES * byte;
+    wp = (const word_t *)p;
+    while ((n >= WORDSIZE) && !haszero(*wp ^ pattern))
+    {
+        wp++;
+        n -= WORDSIZE;
+    }
+
+    for (p = (const unsigned char *)wp; n > 0; n--, p++)
+    {
+        if (*p == byte)
+        {
+            return (void*)p; /* Cast away const */
         }
     }
     return NULL;
@@ -5,6 +5,7 @@
 /* Embedded Xinu, Copyright (C) 2009, 2013.  All rights reserved. */
 
 #include <string.h>
+#include "word.h"
 
 /**
  * @ingroup libxc
@@ -26,13 +27,39 @@
 int memcmp(const void *s1, const void *s2, size_t n)
 {
     const unsigned char *p1 = s1, *p2 = s2;
-    size_t i;
+    const word_t *w1, *w2;
 
-    for (i = 0; i < n; i++)
+    /* skip equal words when both sides can be aligned together */
+    if ((n >= WORDMIN)
+        && (((unsigned long)p1 & WORDMASK) == ((unsigned long)p2 & WORDMASK)))
     {
-        if (p1[i] != p2[i])
+        while (!wordaligned(p1))
         {
-            return (int)p1[i] - (int)p2[i];
+            if (*p1 != *p2)
+            {
+                return (int)*p1 - (int)*p2;
+            }
+            p1++;
+            p2++;
+            n--;
+        }
+        w1 = (const word_t *)p1;
+        w2 = (const word_t *)p2;
+        while ((n >= WORDSIZE) && (*w1 == *w2))
+        {
+            w1++;
+            w2++;
+            n -= WORDSIZE;
+        }
+        p1 = (const unsigned char *)w1;
+        p2 = (const unsigned char *)w2;
+    }
+
+    for (; n > 0; n--, p1++, p2++)
+    {
+        if (*p1 != *p2)
+        {
+            return (int)*p1 - (int)*p2;
         }
     }
     return 0;
@@ -4,12 +4,14 @@
 /* Embedded Xinu, Copyright (C) 2009, 2013.  All rights reserved. */
 
 #include <string.h>
+#include "word.h"
 
 /**
  * @ingroup libxc
  *
  * Copy the specified number of bytes of memory to another location.  The memory
- * locations must not overlap.
+ * locations must not overlap.  Longer copies align the destination and then
+ * move four words per iteration.
  *
  * @param dest
  *      Pointer to the destination memory.
@@ -25,11 +27,56 @@ void *memcpy(void *dest, const void *src, size_t n)
 {
     unsigned char *dest_p = dest;
     const unsigned char *src_p = src;
-    size_t i;
+    word_t *dw;
+    const word_t *sw;
+    const struct uword *su;
 
-    for (i = 0; i < n; i++)
+    if (n >= WORDMIN)
     {
-        dest_p[i] = src_p[i];
+        while (!wordaligned(dest_p))
+        {
+            *dest_p++ = *src_p++;
+            n--;
+        }
+        dw = (word_t *)dest_p;
+        if (wordaligned(src_p))
+        {
+            sw = (const word_t *)src_p;
+            while (n >= 4 * WORDSIZE)
+            {
+                dw[0] = sw[0];
+                dw[1] = sw[1];
+                dw[2] = sw[2];
+                dw[3] = sw[3];
+                dw += 4;
+                sw += 4;
+                n -= 4 * WORDSIZE;
+            }
+            while (n >= WORDSIZE)
+            {
+                *dw++ = *sw++;
+                n -= WORDSIZE;
+            }
+            src_p = (const unsigned char *)sw;
+        }
+        else
+        {
+            /* source is not aligned like the destination */
+            su = (const struct uword *)src_p;
+            while (n >= WORDSIZE)
+            {
+                *dw++ = (su++)->w;
+                n -= WORDSIZE;
+            }
+            src_p = (const unsigned char *)su;
+        }
+        dest_p = (unsigned char *)dw;
+    }
+
+    while (n > 0)
+    {
+        *dest_p++ = *src_p++;
+        n--;
     }
 
     return dest;
@@ -4,6 +4,7 @@
 /* Embedded Xinu, Copyright (C) 2009, 2013.  All rights reserved. */
 
 #include <string.h>
+#include "word.h"
 
 /** 
  * @ingroup libxc
@@ -24,11 +25,38 @@ void *memset(void *s, int c, size_t n)
 {
     unsigned char *p = s;
     unsigned char byte = c;
-    size_t i;
+    word_t *wp, w;
 
-    for (i = 0; i < n; i++)
+    if (n >= WORDMIN)
     {
-        p[i] = byte;
+        while (!wordaligned(p))
+        {
+            *p++ = byte;
+            n--;
+        }
+        w = WORDONES * byte;
+        wp = (word_t *)p;
+        while (n >= 4 * WORDSIZE)
+        {
+            wp[0] = w;
+            wp[1] = w;
+            wp[2] = w;
+            wp[3] = w;
+            wp += 4;
+            n -= 4 * WORDSIZE;
+        }
+        while (n >= WORDSIZE)
+        {
+            *wp++ = w;
+            n -= WORDSIZE;
+        }
+        p = (unsigned char *)wp;
+    }
+
+    while (n > 0)
+    {
+        *p++ = byte;
+        n--;
     }
     return s;
 }
@@ -5,6 +5,7 @@
 
 #include <string.h>
 #include <stddef.h>
+#include "word.h"
 
 /** 
  * @ingroup libxc
@@ -23,6 +24,30 @@
 char *strchr(const char *s, int c)
 {
     char ch = c;
+    const word_t *wp;
+    word_t pattern;
+
+    for (; !wordaligned(s); s++)
+    {
+        if (*s == ch)
+        {
+            return (char*)s; /* Cast away const. */
+        }
+        if (*s == '\0')
+        {
+            return NULL;
+        }
+    }
+
+    /* skip whole words that hold neither the character nor the end */
+    pattern = WORDONES * (unsigned char)ch;
+    wp = (const word_t *)s;
+    while (!haszero(*wp) && !haszero(*wp ^ pattern))
+    {
+        wp++;
+    }
+
+    s = (const char *)wp;
     do
     {
         if (*s == ch)
@@ -4,6 +4,7 @@
 /* Embedded Xinu, Copyright (C) 2013.  All rights reserved. */
 
 #include <string.h>
+#include "word.h"
 
 /**
  * @ingroup libxc
@@ -18,11 +19,29 @@
  */
 size_t strlen(const char *s)
 {
-    size_t n = 0;
+    const char *p = s;
+    const word_t *wp;
 
-    while (s[n] != '\0')
+    for (; !wordaligned(p); p++)
     {
-        n++;
+        if (*p == '\0')
+        {
+            return p - s;
+        }
     }
-    return n;
+
+    /* An aligned word never crosses a page, so reading past the
+     * terminator within the last word is harmless. */
+    wp = (const word_t *)p;
+    while (!haszero(*wp))
+    {
+        wp++;
+    }
+
+    p = (const char *)wp;
+    while (*p != '\0')
+    {
+        p++;
+    }
+    return p - s;
 }
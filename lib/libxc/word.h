@@ -0,0 +1,37 @@
+/**
+ * @file word.h
+ *
+ * Helpers shared by the word-at-a-time memory and string functions.  These
+ * move or examine one machine word per step once the pointers are aligned,
+ * and fall back to bytes for short lengths and for the ragged ends.
+ */
+/* Embedded Xinu, Copyright (C) 2013.  All rights reserved. */
+
+#ifndef _LIBXC_WORD_H_
+#define _LIBXC_WORD_H_
+
+typedef unsigned long word_t;
+
+/* A word at any alignment.  The compiler loads it with whatever the
+ * architecture offers for unaligned access (lwl/lwr on MIPS). */
+struct uword
+{
+    word_t w;
+} __attribute__((__packed__));
+
+#define WORDSIZE        sizeof(word_t)
+#define WORDMASK        (WORDSIZE - 1)
+#define wordaligned(p)  (0 == ((unsigned long)(p) & WORDMASK))
+
+/* Lengths below this are not worth aligning for. */
+#define WORDMIN         (4 * WORDSIZE)
+
+/* 0x01 and 0x80 in every byte of a word. */
+#define WORDONES        ((word_t)-1 / 0xff)
+#define WORDHIGHS       (WORDONES * 0x80)
+
+/* Nonzero if any byte of the word is zero.  Which byte it was is found
+ * by looking at the bytes, so this works for either byte order. */
+#define haszero(w)      (((w) - WORDONES) & ~(w) & WORDHIGHS)
+
+#endif                          /* _LIBXC_WORD_H_ */
@@ -39,7 +39,7 @@ syscall mailboxAlloc(uint count)
         if (MAILBOX_FREE == mbxptr->state)
         {
             /* get memory space for the message queue */
-            mbxptr->msgs = memget(sizeof(int) * count);
+            mbxptr->msgs = slabget(sizeof(int) * count);
 
             /* check if memory was allocated correctly */
             if (SYSERR == (int)mbxptr->msgs)
@@ -56,7 +56,7 @@ syscall mailboxAlloc(uint count)
             if ((SYSERR == (int)mbxptr->sender) ||
                 (SYSERR == (int)mbxptr->receiver))
             {
-                memfree(mbxptr->msgs, sizeof(int) * (mbxptr->max));
+                slabfree(mbxptr->msgs, sizeof(int) * (mbxptr->max));
                 semfree(mbxptr->sender);
                 semfree(mbxptr->receiver);
                 break;
@@ -43,7 +43,7 @@ syscall mailboxFree(mailbox box)
         semfree(mbxptr->receiver);
 
         /* free memory that was used for the message queue */
-        memfree(mbxptr->msgs, sizeof(int) * (mbxptr->max));
+        slabfree(mbxptr->msgs, sizeof(int) * (mbxptr->max));
 
         retval = OK;
     }
@@ -6,12 +6,15 @@
 
 #include <stddef.h>
 #include <arp.h>
+#include <clock.h>
 #include <stdlib.h>
 
 /**
  * @ingroup arp
  *
- * Allocates an entry from the ARP table.
+ * Allocates an entry from the ARP table.  Expired entries are freed on the
+ * way, so that packets held by unresolved ones are not kept any longer.
+ * The caller sets the protocol address and adds the entry to the hash.
  * @return entry in ARP table, SYSERR if error occurs
  * @pre-condition interrupts are disabled
  * @post-condition interrupts are still disabled
@@ -25,6 +28,12 @@ struct arpEntry *arpAlloc(void)
 
     for (i = 0; i < ARP_NENTRY; i++)
     {
+        if ((ARP_USED & arptab[i].state) && (arptab[i].expires < clktime))
+        {
+            ARP_TRACE("\tEntry %d expired", i);
+            arpFree(&arptab[i]);
+        }
+
         /* If entry is free, return entry */
         if (ARP_FREE == arptab[i].state)
         {
@@ -50,7 +59,7 @@ struct arpEntry *arpAlloc(void)
     }
 
     /* Return entry with minimum expires */
-    bzero(minexpires, sizeof(struct arpEntry));
+    arpFree(minexpires);
     minexpires->state = ARP_USED;
     return minexpires;
 }
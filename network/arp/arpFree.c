@@ -12,11 +12,15 @@
 /**
  * @ingroup arp
  *
- * Frees an entry from the ARP table.
+ * Frees an entry from the ARP table, dropping any packets still waiting
+ * for it to be resolved.
  * @return SYSERR if error occurs, otherwise OK
  */
 syscall arpFree(struct arpEntry *entry)
 {
+    int i;
+    irqmask im;
+
     ARP_TRACE("Freeing ARP entry");
 
     /* Error check pointers */
@@ -25,16 +29,25 @@ syscall arpFree(struct arpEntry *entry)
         return SYSERR;
     }
 
-    /* Notify threads waiting on resolution */
-    if (ARP_UNRESOLVED == entry->state)
+    im = disable();
+    arpHashRemove(entry);
+    if (ARP_RESOLVED == entry->state)
+    {
+        arpgen++;
+    }
+
+    /* Drop packets waiting on resolution */
+    for (i = 0; i < entry->npending; i++)
     {
-        arpNotify(entry, TIMEOUT);
-        ARP_TRACE("Waiting threads notified");
+        netFreebuf(entry->pending[i]);
+        arpstats.dropped++;
+        ARP_TRACE("Dropped pending packet");
     }
 
     /* Clear ARP table entry */
     bzero(entry, sizeof(struct arpEntry));
     entry->state = ARP_FREE;
+    restore(im);
     ARP_TRACE("Freed entry %d",
               ((int)entry - (int)arptab) / sizeof(struct arpEntry));
     return OK;
@@ -0,0 +1,75 @@
+/**
+ * @file arpHash.c
+ *
+ * Hash table of used ARP table entries, keyed on protocol address, so that
+ * arpGetEntry() looks in one bucket instead of the whole table.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <arp.h>
+
+/** @ingroup arp
+ * Buckets of the ARP entry hash table.  */
+struct arpEntry *arphash[ARP_NHASH];
+
+/**
+ * @ingroup arp
+ *
+ * Bucket that holds the entry for a protocol address.
+ * @param praddr protocol address
+ * @return index into ::arphash
+ */
+uint arpHashSlot(const struct netaddr *praddr)
+{
+    uint hash;
+    int i;
+
+    hash = 0;
+    for (i = 0; i < praddr->len; i++)
+    {
+        hash = hash * 31 + praddr->addr[i];
+    }
+    hash ^= hash >> 16;
+    hash ^= hash >> 8;
+    return hash & (ARP_NHASH - 1);
+}
+
+/**
+ * @ingroup arp
+ *
+ * Add an entry to the hash table under its protocol address.  Interrupts
+ * must be disabled.
+ * @param entry ARP table entry with praddr set, not already in the table
+ */
+void arpHashInsert(struct arpEntry *entry)
+{
+    uint slot;
+
+    slot = arpHashSlot(&entry->praddr);
+    entry->hnext = arphash[slot];
+    arphash[slot] = entry;
+}
+
+/**
+ * @ingroup arp
+ *
+ * Take an entry out of the hash table, if it is in it.  Must be done before
+ * changing its protocol address.  Interrupts must be disabled.
+ * @param entry ARP table entry
+ */
+void arpHashRemove(struct arpEntry *entry)
+{
+    struct arpEntry **prev;
+
+    for (prev = &arphash[arpHashSlot(&entry->praddr)]; *prev != NULL;
+         prev = &(*prev)->hnext)
+    {
+        if (*prev == entry)
+        {
+            *prev = entry->hnext;
+            break;
+        }
+    }
+    entry->hnext = NULL;
+}
@@ -11,6 +11,8 @@
 #include <thread.h>
 
 struct arpEntry arptab[ARP_NENTRY];
+struct arpStats arpstats;
+volatile uint arpgen;
 mailbox arpqueue;
 
 /**
@@ -29,6 +31,8 @@ syscall arpInit(void)
         bzero(&arptab[i], sizeof(struct arpEntry));
         arptab[i].state = ARP_FREE;
     }
+    bzero(arphash, sizeof(arphash));
+    bzero(&arpstats, sizeof(arpstats));
 
     /* Initialize ARP queue */
     arpqueue = mailboxAlloc(ARP_NQUEUE);
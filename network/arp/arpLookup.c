@@ -6,30 +6,38 @@
 
 #include <stddef.h>
 #include <arp.h>
+#include <bufpool.h>
 #include <clock.h>
 #include <interrupt.h>
 #include <string.h>
-#include <thread.h>
 
 /**
  * @ingroup arp
  *
- * Obtains a hardware address from the ARP table given a protocol address.
+ * Obtains a hardware address from the ARP table given a protocol address,
+ * without waiting.  If the address is not resolved yet, a copy of the
+ * packet is held by its ARP table entry until arpRecv() gets the reply, and
+ * an ARP request is sent.
  * @param netptr network interface
  * @param praddr protocol address
  * @param hwaddr buffer into which hardware address should be placed
- * @return OK if hardware address was obtained, otherwise TIMEOUT or SYSERR
+ * @param pkt packet to send, link-level header filled in but for the
+ *  destination
+ * @return OK if hardware address was obtained, NET_QUEUED if a copy of the
+ *  packet is waiting for the address, NET_DROPPED if there was no room to
+ *  hold one, otherwise SYSERR
  */
 syscall arpLookup(struct netif *netptr, const struct netaddr *praddr,
-                  struct netaddr *hwaddr)
+                  struct netaddr *hwaddr, struct packet *pkt)
 {
     struct arpEntry *entry = NULL;  /**< pointer to ARP table entry   */
-    uint lookups = 0;                   /**< num of ARP lookups performed */
-    int ttl;                            /**< TTL for ARP table entry      */
+    struct packet *copy = NULL;         /**< copy of packet held by entry */
+    bool rqst;                          /**< send an ARP request          */
     irqmask im;                         /**< interrupt state              */
 
     /* Error check pointers */
-    if ((NULL == netptr) || (NULL == praddr) || (NULL == hwaddr))
+    if ((NULL == netptr) || (NULL == praddr) || (NULL == hwaddr)
+        || (NULL == pkt))
     {
         ARP_TRACE("Invalid args");
         return SYSERR;
@@ -37,73 +45,76 @@ syscall arpLookup(struct netif *netptr, const struct netaddr *praddr,
 
     ARP_TRACE("Looking up protocol address");
 
-    /* Attempt to obtain destination hardware address from ARP table until:
-     * 1) lookup succeeds; 2) TIMEOUT occurs; 3) SYSERR occurs; or
-     * 4) maximum number of lookup attempts occrus. */
-    while (lookups < ARP_MAX_LOOKUP)
-    {
-        lookups++;
-
-        /* Obtain entry from ARP table */
-        im = disable();
-        entry = arpGetEntry(praddr);
-
-        /* If ARP entry does not exist; create an unresolved entry */
-        if (NULL == entry)
-        {
-            ARP_TRACE("Entry does not exist");
-            entry = arpAlloc();
-            if (SYSERR == (int)entry)
-            {
-                restore(im);
-                return SYSERR;
-            }
-
-            entry->state = ARP_UNRESOLVED;
-            entry->nif = netptr;
-            netaddrcpy(&entry->praddr, praddr);
-            entry->expires = clktime + ARP_TTL_UNRESOLVED;
-            entry->count = 0;
-        }
-
-        /* Place hardware address in buffer if entry is resolved */
-        if (ARP_RESOLVED == entry->state)
-        {
-            netaddrcpy(hwaddr, &entry->hwaddr);
-            ARP_TRACE("Entry exists");
-            return OK;
-        }
+    /* Obtain entry from ARP table */
+    im = disable();
+    entry = arpGetEntry(praddr);
 
-        /* Entry is unresolved; enqueue thread to wait for resolution */
-        if (entry->count >= ARP_NTHRWAIT)
+    /* If ARP entry does not exist; create an unresolved entry */
+    if (NULL == entry)
+    {
+        ARP_TRACE("Entry does not exist");
+        entry = arpAlloc();
+        if (SYSERR == (int)entry)
         {
             restore(im);
-            ARP_TRACE("Queue of waiting threads is full");
             return SYSERR;
         }
-        entry->waiting[entry->count] = gettid();
-        entry->count++;
-        ttl = (entry->expires - clktime) * CLKTICKS_PER_SEC;
+
+        entry->state = ARP_UNRESOLVED;
+        entry->nif = netptr;
+        netaddrcpy(&entry->praddr, praddr);
+        entry->expires = clktime + ARP_TTL_UNRESOLVED;
+        entry->rqsttime = clktime - ARP_RQST_INTERVAL;
+        arpHashInsert(entry);
+    }
+
+    /* Place hardware address in buffer if entry is resolved */
+    if (ARP_RESOLVED == entry->state)
+    {
+        netaddrcpy(hwaddr, &entry->hwaddr);
         restore(im);
+        ARP_TRACE("Entry exists");
+        return OK;
+    }
 
-        /* Send an ARP request and wait for response */
-        if (SYSERR == arpSendRqst(entry))
-        {
-            ARP_TRACE("Failed to send request");
-            return SYSERR;
-        }
-        recvclr();
-        switch (recvtime(ttl))
-        {
-        case TIMEOUT:
-        case SYSERR:
-            return SYSERR;
-        case ARP_MSG_RESOLVED:
-        default:
-            /* Reply received, address resolved, re-attempt lookup */
-            continue;
-        }
+    /* Entry is unresolved; hold a copy of the packet if the entry has room
+     * and a buffer can be had without waiting for one. */
+    if (entry->npending < ARP_NPENDING)
+    {
+        copy = bufgetnb(netpool);
+    }
+    if ((NULL == copy) || (SYSERR == (int)copy))
+    {
+        copy = NULL;
+        arpstats.dropped++;
+        ARP_TRACE("No room to hold packet");
+    }
+    else
+    {
+        copy->nif = pkt->nif;
+        copy->len = pkt->len;
+        copy->curr = copy->data;
+        copy->linkhdr = copy->curr;
+        copy->segs = NULL;
+        copy->seglen = 0;
+        netGather(copy->curr, pkt, 0, pkt->len);
+        entry->pending[entry->npending++] = copy;
+        arpstats.queued++;
+        ARP_TRACE("Holding packet %d", entry->npending);
+    }
+
+    /* Send a request, unless one was sent very recently */
+    rqst = (clktime - entry->rqsttime >= ARP_RQST_INTERVAL);
+    if (rqst)
+    {
+        entry->rqsttime = clktime;
+    }
+    restore(im);
+
+    if (rqst && (SYSERR == arpSendRqst(entry)))
+    {
+        ARP_TRACE("Failed to send request");
     }
 
-    return SYSERR;
+    return (NULL == copy) ? NET_DROPPED : NET_QUEUED;
 }
@@ -7,13 +7,45 @@
 #include <stddef.h>
 #include <arp.h>
 #include <clock.h>
+#include <device.h>
 #include <ethernet.h>
 #include <interrupt.h>
 #include <ipv4.h>
 #include <mailbox.h>
 #include <network.h>
+#include <snoop.h>
 #include <string.h>
 
+/* Send the packets that were waiting for a hardware address, and free
+ * them.  Their link-level headers lack only the destination. */
+static void arpSendPending(struct packet **pending, int npending,
+                           const struct netaddr *hwaddr)
+{
+    struct packet *pkt;
+    struct etherPkt *ether;
+    int i;
+
+    for (i = 0; i < npending; i++)
+    {
+        pkt = pending[i];
+        ether = (struct etherPkt *)pkt->curr;
+        memcpy(ether->dst, hwaddr->addr, hwaddr->len);
+        if (pkt->len == write(pkt->nif->dev, pkt->curr, pkt->len))
+        {
+            if (pkt->nif->capture != NULL)
+            {
+                snoopCapture(pkt->nif->capture, pkt);
+            }
+            arpstats.sent++;
+        }
+        else
+        {
+            arpstats.dropped++;
+        }
+        netFreebuf(pkt);
+    }
+}
+
 /**
  * @ingroup arp
  *
@@ -29,6 +61,8 @@ syscall arpRecv(struct packet *pkt)
     struct netaddr sha;             /**< source hardware address        */
     struct netaddr spa;             /**< source protocol address        */
     struct netaddr dpa;             /**< destination protocol address   */
+    struct packet *pending[ARP_NPENDING];   /**< pkts awaiting sha      */
+    int npending;                   /**< number of pending packets      */
     irqmask im;                     /**< interrupt state                */
 
     /* Error check pointers */
@@ -83,15 +117,25 @@ syscall arpRecv(struct packet *pkt)
     if (entry != NULL)
     {
         ARP_TRACE("Entry already exists");
+        if ((ARP_RESOLVED == entry->state)
+            && !netaddrequal(&entry->hwaddr, &sha))
+        {
+            arpgen++;
+        }
         netaddrcpy(&entry->hwaddr, &sha);
         entry->expires = clktime + ARP_TTL_RESOLVED;
 
-        /* Notify threads waiting on resolution */
+        /* Send packets waiting on resolution */
         if (ARP_UNRESOLVED == entry->state)
         {
             entry->state = ARP_RESOLVED;
-            arpNotify(entry, ARP_MSG_RESOLVED);
-            ARP_TRACE("Notified waiting threads");
+            npending = entry->npending;
+            memcpy(pending, entry->pending, npending * sizeof(pending[0]));
+            entry->npending = 0;
+            restore(im);
+            arpSendPending(pending, npending, &sha);
+            ARP_TRACE("Sent %d waiting packets", npending);
+            im = disable();
         }
     }
 
@@ -119,6 +163,7 @@ syscall arpRecv(struct packet *pkt)
             netaddrcpy(&entry->hwaddr, &sha);
             netaddrcpy(&entry->praddr, &spa);
             entry->expires = clktime + ARP_TTL_RESOLVED;
+            arpHashInsert(entry);
             ARP_TRACE("Added entry %d (state = %d)",
                       ((int)entry -
                        (int)arptab) / sizeof(struct arpEntry),
@@ -0,0 +1,465 @@
+/**
+ * @file ipv4Reasm.c
+ *
+ * Reassembly of fragmented IPv4 datagrams.  The fragments of a datagram
+ * are held, in the packets they arrived in, in an entry of ::ipv4reasmtab
+ * until they cover it, and then copied into one packet large enough for
+ * the whole datagram.  No more than ::IPv4_REASM_NBUF fragments are held
+ * at once; to make room for more the oldest datagram is dropped.  A
+ * datagram that has waited ::IPv4_REASM_TIME seconds is dropped by the
+ * reassembly timer thread, or by the next fragment to arrive.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <clock.h>
+#include <icmp.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <network.h>
+#include <string.h>
+#include <thread.h>
+
+/** @ingroup ipv4
+ * Datagrams being reassembled.  */
+struct ipv4Reasm ipv4reasmtab[IPv4_REASM_NENTRY];
+
+/** @ingroup ipv4
+ * Number of fragments held in ::ipv4reasmtab.  */
+uint ipv4reasmnbuf;
+
+static struct ipv4Reasm *ipv4ReasmFind(const struct ipv4Pkt *);
+static struct ipv4Reasm *ipv4ReasmVictim(bool, bool *);
+static int ipv4ReasmInsert(struct ipv4Reasm *, struct packet *, uint, uint);
+static bool ipv4ReasmDone(const struct ipv4Reasm *);
+static struct packet *ipv4ReasmBuild(struct ipv4Reasm *);
+static void ipv4ReasmFree(struct ipv4Reasm *, bool);
+
+/**
+ * @ingroup ipv4
+ *
+ * Add a fragment to the datagram it belongs to.  Data that overlaps data
+ * already held is dropped, except where the fragment covers the whole of
+ * another, which it then replaces.
+ * @param pkt incoming fragment, whose nethdr points to its IPv4 header and
+ * 	whose length has no link-level padding
+ * @return the reassembled datagram, with nethdr and curr pointing to its
+ * 	IPv4 header, if this fragment completed it; otherwise NULL.  Either
+ * 	way the fragment is no longer the caller's.
+ */
+struct packet *ipv4Reasm(struct packet *pkt)
+{
+    struct ipv4Pkt *ip;
+    struct ipv4Reasm *rsm, *victim;
+    uint ihl, iplen, flags, start, end, i;
+    bool expired;
+    irqmask im;
+
+    ip = (struct ipv4Pkt *)pkt->nethdr;
+    ihl = (ip->ver_ihl & IPv4_IHL) * 4;
+    iplen = net2hs(ip->len);
+
+    /* The header may not claim more than the packet holds */
+    if ((iplen <= ihl) || (iplen > pkt->len - (pkt->nethdr - pkt->linkhdr)))
+    {
+        IPv4_TRACE("Truncated fragment");
+        netFreebuf(pkt);
+        return NULL;
+    }
+    flags = net2hs(ip->flags_froff);
+    start = (flags & IPv4_FROFF) * 8;
+    end = start + iplen - ihl;
+
+    /* Every fragment but the last carries a multiple of 8 octets, and
+     * none may run past the largest datagram */
+    if ((end <= start) || (end + ihl > IPv4_MAX_LEN)
+        || ((flags & IPv4_FLAG_MF) && ((end - start) & 0x7)))
+    {
+        IPv4_TRACE("Invalid fragment");
+        netFreebuf(pkt);
+        return NULL;
+    }
+    pkt->curr = pkt->nethdr + ihl;
+
+    im = disable();
+
+    /* Drop datagrams that have waited too long, then the oldest while the
+     * fragments held are at the limit or no entry is free for a new one */
+    while (TRUE)
+    {
+        rsm = ipv4ReasmFind(ip);
+        victim = ipv4ReasmVictim(NULL == rsm, &expired);
+        if (NULL == victim)
+        {
+            break;
+        }
+        restore(im);
+        ipv4ReasmFree(victim, expired);
+        im = disable();
+    }
+    if (ipv4reasmnbuf >= IPv4_REASM_NBUF)
+    {
+        restore(im);
+        IPv4_TRACE("Too many fragments held");
+        netFreebuf(pkt);
+        return NULL;
+    }
+
+    /* Start a new datagram */
+    if (NULL == rsm)
+    {
+        for (i = 0; i < IPv4_REASM_NENTRY; i++)
+        {
+            if (IPv4_REASM_FREE == ipv4reasmtab[i].state)
+            {
+                rsm = &ipv4reasmtab[i];
+                break;
+            }
+        }
+        if (NULL == rsm)
+        {
+            restore(im);
+            IPv4_TRACE("No reassembly entry free");
+            netFreebuf(pkt);
+            return NULL;
+        }
+        rsm->state = IPv4_REASM_USED;
+        rsm->proto = ip->proto;
+        rsm->id = ip->id;
+        memcpy(rsm->src, ip->src, IPv4_ADDR_LEN);
+        memcpy(rsm->dst, ip->dst, IPv4_ADDR_LEN);
+        rsm->expires = clktime + IPv4_REASM_TIME;
+        rsm->total = 0;
+        rsm->nfrag = 0;
+    }
+
+    /* The last fragment gives the length of the datagram, which no other
+     * fragment may run past */
+    if (!(flags & IPv4_FLAG_MF))
+    {
+        if (((rsm->total != 0) && (rsm->total != end))
+            || ((rsm->nfrag > 0) && (rsm->frag[rsm->nfrag - 1].end > end)))
+        {
+            restore(im);
+            IPv4_TRACE("Inconsistent last fragment");
+            netFreebuf(pkt);
+            return NULL;
+        }
+        rsm->total = end;
+    }
+    else if ((rsm->total != 0) && (end > rsm->total))
+    {
+        restore(im);
+        IPv4_TRACE("Fragment past end of datagram");
+        netFreebuf(pkt);
+        return NULL;
+    }
+
+    if (SYSERR == ipv4ReasmInsert(rsm, pkt, start, end))
+    {
+        restore(im);
+        IPv4_TRACE("Duplicate fragment");
+        netFreebuf(pkt);
+        return NULL;
+    }
+    if (!ipv4ReasmDone(rsm))
+    {
+        restore(im);
+        return NULL;
+    }
+
+    /* Every fragment is here; copy them out without interrupts disabled */
+    rsm->state = IPv4_REASM_BUSY;
+    restore(im);
+    pkt = ipv4ReasmBuild(rsm);
+    ipv4ReasmFree(rsm, FALSE);
+    return pkt;
+}
+
+/**
+ * @ingroup ipv4
+ *
+ * Drop the datagrams that have waited ::IPv4_REASM_TIME seconds, freeing
+ * the fragments they hold and reporting them to their sources.
+ */
+void ipv4ReasmExpire(void)
+{
+    struct ipv4Reasm *rsm;
+    irqmask im;
+    uint i;
+
+    for (i = 0; i < IPv4_REASM_NENTRY; i++)
+    {
+        rsm = &ipv4reasmtab[i];
+        im = disable();
+        if ((IPv4_REASM_USED != rsm->state)
+            || ((long)(clktime - rsm->expires) < 0))
+        {
+            restore(im);
+            continue;
+        }
+        rsm->state = IPv4_REASM_BUSY;
+        restore(im);
+        ipv4ReasmFree(rsm, TRUE);
+    }
+}
+
+/**
+ * @ingroup ipv4
+ *
+ * Reassembly timer thread, which drops datagrams that have timed out even
+ * when no more fragments arrive.
+ */
+thread ipv4ReasmTimer(void)
+{
+    while (TRUE)
+    {
+        sleep(IPv4_REASM_TICK);
+        ipv4ReasmExpire();
+    }
+
+    return OK;
+}
+
+/*
+ * Entry of the datagram a fragment belongs to, NULL if none.  Interrupts
+ * must be disabled.
+ */
+static struct ipv4Reasm *ipv4ReasmFind(const struct ipv4Pkt *ip)
+{
+    struct ipv4Reasm *rsm;
+    uint i;
+
+    for (i = 0; i < IPv4_REASM_NENTRY; i++)
+    {
+        rsm = &ipv4reasmtab[i];
+        if ((IPv4_REASM_USED == rsm->state) && (rsm->id == ip->id)
+            && (rsm->proto == ip->proto)
+            && (0 == memcmp(rsm->src, ip->src, IPv4_ADDR_LEN))
+            && (0 == memcmp(rsm->dst, ip->dst, IPv4_ADDR_LEN)))
+        {
+            return rsm;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Entry of a datagram to drop: one that has waited too long, or else the
+ * oldest if the fragments held are at the limit or a new entry is wanted
+ * and none is free.  The entry returned is marked busy, and expired tells
+ * whether it timed out.  Interrupts must be disabled.
+ */
+static struct ipv4Reasm *ipv4ReasmVictim(bool needentry, bool *expired)
+{
+    struct ipv4Reasm *rsm, *oldest;
+    bool freeentry;
+    uint i;
+
+    oldest = NULL;
+    freeentry = FALSE;
+    for (i = 0; i < IPv4_REASM_NENTRY; i++)
+    {
+        rsm = &ipv4reasmtab[i];
+        if (IPv4_REASM_FREE == rsm->state)
+        {
+            freeentry = TRUE;
+        }
+        if (IPv4_REASM_USED != rsm->state)
+        {
+            continue;
+        }
+        if ((long)(clktime - rsm->expires) >= 0)
+        {
+            rsm->state = IPv4_REASM_BUSY;
+            *expired = TRUE;
+            return rsm;
+        }
+        if ((NULL == oldest) || ((long)(rsm->expires - oldest->expires) < 0))
+        {
+            oldest = rsm;
+        }
+    }
+
+    if ((oldest != NULL) && ((ipv4reasmnbuf >= IPv4_REASM_NBUF)
+                             || (needentry && !freeentry)))
+    {
+        oldest->state = IPv4_REASM_BUSY;
+        *expired = FALSE;
+        return oldest;
+    }
+    return NULL;
+}
+
+/*
+ * Put a fragment in its place among those of a datagram, trimming it to
+ * the data not already held.  Fragments it covers entirely are freed.
+ * Returns SYSERR if it holds nothing new or there is no room for it.
+ * Interrupts must be disabled.
+ */
+static int ipv4ReasmInsert(struct ipv4Reasm *rsm, struct packet *pkt,
+                           uint start, uint end)
+{
+    struct ipv4Frag *frag = rsm->frag;
+    uint i, j, k;
+
+    /* Skip the fragments that end before this one starts */
+    for (i = 0; (i < rsm->nfrag) && (frag[i].end <= start); i++)
+    {
+        ;
+    }
+
+    /* Data already held comes first at the front... */
+    if ((i < rsm->nfrag) && (frag[i].start <= start))
+    {
+        if (frag[i].end >= end)
+        {
+            return SYSERR;
+        }
+        pkt->curr += frag[i].end - start;
+        start = frag[i].end;
+        i++;
+    }
+
+    /* ...fragments covered by this one give way to it... */
+    for (j = i; (j < rsm->nfrag) && (frag[j].end <= end); j++)
+    {
+        ;
+    }
+
+    /* ...and data already held comes first at the back */
+    if ((j < rsm->nfrag) && (frag[j].start < end))
+    {
+        end = frag[j].start;
+    }
+    if (end <= start)
+    {
+        return SYSERR;
+    }
+    if ((i == j) && (IPv4_REASM_NFRAG == rsm->nfrag))
+    {
+        return SYSERR;
+    }
+
+    /* Free fragments i..j-1 and put this one in their place */
+    for (k = i; k < j; k++)
+    {
+        netFreebuf(frag[k].pkt);
+    }
+    ipv4reasmnbuf -= j - i;
+    if (i == j)
+    {
+        for (k = rsm->nfrag; k > i; k--)
+        {
+            frag[k] = frag[k - 1];
+        }
+    }
+    else
+    {
+        for (k = j; k < rsm->nfrag; k++)
+        {
+            frag[k - (j - i - 1)] = frag[k];
+        }
+    }
+    rsm->nfrag = rsm->nfrag + i + 1 - j;
+    frag[i].pkt = pkt;
+    frag[i].start = start;
+    frag[i].end = end;
+    ipv4reasmnbuf++;
+    return OK;
+}
+
+/*
+ * Whether the fragments of a datagram cover it from start to end.
+ * Interrupts must be disabled.
+ */
+static bool ipv4ReasmDone(const struct ipv4Reasm *rsm)
+{
+    uint i, next;
+
+    if (0 == rsm->total)
+    {
+        return FALSE;
+    }
+    next = 0;
+    for (i = 0; i < rsm->nfrag; i++)
+    {
+        if (rsm->frag[i].start != next)
+        {
+            return FALSE;
+        }
+        next = rsm->frag[i].end;
+    }
+    return (next == rsm->total);
+}
+
+/*
+ * Copy the fragments of a complete datagram into one packet, with the
+ * link-level and IPv4 headers of the first.  Returns NULL if there is no
+ * buffer for it.
+ */
+static struct packet *ipv4ReasmBuild(struct ipv4Reasm *rsm)
+{
+    struct packet *first, *pkt;
+    struct ipv4Pkt *ip;
+    uint hdrlen, ihl, i;
+
+    first = rsm->frag[0].pkt;
+    ip = (struct ipv4Pkt *)first->nethdr;
+    ihl = (ip->ver_ihl & IPv4_IHL) * 4;
+    hdrlen = (first->nethdr - first->linkhdr) + ihl;
+
+    pkt = netGetbufLen(hdrlen + rsm->total);
+    if (SYSERR == (int)pkt)
+    {
+        IPv4_TRACE("No buffer for reassembled datagram");
+        return NULL;
+    }
+
+    pkt->nif = first->nif;
+    pkt->len = hdrlen + rsm->total;
+    pkt->linkhdr = pkt->data;
+    pkt->nethdr = pkt->linkhdr + (first->nethdr - first->linkhdr);
+    pkt->curr = pkt->nethdr;
+    memcpy(pkt->linkhdr, first->linkhdr, hdrlen);
+    for (i = 0; i < rsm->nfrag; i++)
+    {
+        memcpy(pkt->nethdr + ihl + rsm->frag[i].start, rsm->frag[i].pkt->curr,
+               rsm->frag[i].end - rsm->frag[i].start);
+    }
+
+    ip = (struct ipv4Pkt *)pkt->nethdr;
+    ip->len = hs2net(ihl + rsm->total);
+    ip->flags_froff = 0;
+    ip->chksum = 0;
+    ip->chksum = netChksum(ip, ihl);
+
+    IPv4_TRACE("Reassembled %d fragments", rsm->nfrag);
+    return pkt;
+}
+
+/*
+ * Free the fragments of a datagram marked busy, and its entry.  A datagram
+ * that timed out with its first fragment is reported to its source.
+ */
+static void ipv4ReasmFree(struct ipv4Reasm *rsm, bool expired)
+{
+    irqmask im;
+    uint i;
+
+    if (expired && (0 == rsm->frag[0].start))
+    {
+        IPv4_TRACE("Reassembly timed out");
+        icmpTimeExceeded(rsm->frag[0].pkt, ICMP_FRA_EXC);
+    }
+    for (i = 0; i < rsm->nfrag; i++)
+    {
+        netFreebuf(rsm->frag[i].pkt);
+    }
+
+    im = disable();
+    ipv4reasmnbuf -= rsm->nfrag;
+    rsm->nfrag = 0;
+    rsm->state = IPv4_REASM_FREE;
+    restore(im);
+}
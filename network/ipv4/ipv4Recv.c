@@ -68,18 +68,6 @@ syscall ipv4Recv(struct packet *pkt)
 #endif
     }
 
-    /* Check if packet is fragmented */
-    if ((IPv4_FLAG_MF & net2hs(ip->flags_froff))
-        || (0 != (net2hs(ip->flags_froff) & IPv4_FROFF)))
-    {
-        // TODO: Handle fragmenting of packet
-        // TODO: Should send icmp time exceeded
-        // return ipRecvSendFrag(pkt, &dst);
-        IPv4_TRACE("Packet fragmented");
-        netFreebuf(pkt);
-        return SYSERR;
-    }
-
     /* The Ethernet driver pads packets less than 60 bytes in length.
      * If the packet length returned from the Ethernet driver (pkt->len)
      * does not agree with the packet headers, adjust the packet length 
@@ -90,6 +78,19 @@ syscall ipv4Recv(struct packet *pkt)
         pkt->len = pkt->nif->linkhdrlen + iplen;
     }
 
+    /* Hold fragments until the whole datagram is here */
+    if ((IPv4_FLAG_MF & net2hs(ip->flags_froff))
+        || (0 != (net2hs(ip->flags_froff) & IPv4_FROFF)))
+    {
+        IPv4_TRACE("Packet fragmented");
+        pkt = ipv4Reasm(pkt);
+        if (NULL == pkt)
+        {
+            return OK;
+        }
+        ip = (struct ipv4Pkt *)pkt->nethdr;
+    }
+
     /* Move current pointer to application level header */
     pkt->curr += ((ip->ver_ihl & IPv4_IHL) << 2);
 
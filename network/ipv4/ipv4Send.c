@@ -5,11 +5,17 @@
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
+#include <interrupt.h>
 #include <ipv4.h>
 #include <network.h>
 #include <string.h>
 #include <route.h>
 
+static void ipv4SendHdr(struct packet *, const struct netaddr *,
+                        const struct netaddr *, uchar);
+
+static ushort ipv4id;           /* identification of the next datagram */
+
 /**
  * @ingroup ipv4
  *
@@ -18,7 +24,8 @@
  * @param src source IP address
  * @param dst destination IP address
  * @param proto the protocol of the ip pkt
- * @return OK if packet was sent, TIMEOUT if ARP request timed out,
+ * @return OK if packet was sent, NET_QUEUED if it is held until the next
+ * hop's hardware address is resolved, NET_DROPPED if it could not be held,
  * IPv4_NO_INTERFACE if interface does not exist, IPv4_NO_HOP if next hop
  * is unknown, SYSERR otherwise.
  */
@@ -26,7 +33,6 @@ syscall ipv4Send(struct packet *pkt, struct netaddr *src,
                  struct netaddr *dst, uchar proto)
 {
     struct rtEntry *rtptr;
-    struct ipv4Pkt *ip;
     struct netaddr *nxthop;
 
     /* Error check pointers */
@@ -62,6 +68,52 @@ syscall ipv4Send(struct packet *pkt, struct netaddr *src,
         nxthop = &rtptr->gateway;
     }
 
+    ipv4SendHdr(pkt, src, dst, proto);
+
+    /* Fragment and send packet */
+    return ipv4SendFrag(pkt, nxthop);
+}
+
+/**
+ * @ingroup ipv4
+ *
+ * Send an outgoing IPv4 packet of a connected socket.  The interface, next
+ * hop and link-level header come from the socket's destination cache,
+ * without a route or ARP lookup, while it holds the destination; otherwise
+ * the packet is sent by ipv4Send().
+ * @param packet packet being sent
+ * @param src source IP address
+ * @param dst destination IP address
+ * @param proto the protocol of the ip pkt
+ * @param dc destination cache of the socket
+ * @return as for ipv4Send()
+ */
+syscall ipv4SendDst(struct packet *pkt, struct netaddr *src,
+                    struct netaddr *dst, uchar proto, struct netDst *dc)
+{
+    /* Packets that need fragmenting or resolution take the long way */
+    if ((NULL == pkt) || (NULL == dst) || (NULL == dc)
+        || (OK != netDstLookup(dc, dst))
+        || (pkt->len + IPv4_HDR_LEN > dc->nif->mtu))
+    {
+        return ipv4Send(pkt, src, dst, proto);
+    }
+
+    IPv4_TRACE("Destination cached");
+    pkt->nif = dc->nif;
+    ipv4SendHdr(pkt, src, dst, proto);
+
+    return netSendPkts(&pkt, 1, dc);
+}
+
+/*
+ * Prepends the IPv4 header to a packet whose interface is set.
+ */
+static void ipv4SendHdr(struct packet *pkt, const struct netaddr *src,
+                        const struct netaddr *dst, uchar proto)
+{
+    struct ipv4Pkt *ip;
+
     /* Set up outgoing packet header */
     pkt->len += IPv4_HDR_LEN;
     pkt->curr -= IPv4_HDR_LEN;
@@ -73,7 +125,9 @@ syscall ipv4Send(struct packet *pkt, struct netaddr *src,
     ip->ver_ihl += IPv4_HDR_LEN / 4;
     ip->tos = IPv4_TOS_ROUTINE;
     ip->len = hs2net(pkt->len);
-    ip->id = 0;
+    /* Each datagram gets its own identification, so that the fragments
+     * of one are not reassembled with those of another */
+    ip->id = hs2net(ipv4IdTake(1));
     ip->flags_froff = 0;
     ip->ttl = IPv4_TTL;
     ip->proto = proto;
@@ -93,7 +147,24 @@ syscall ipv4Send(struct packet *pkt, struct netaddr *src,
     ip->chksum = 0;
     ip->chksum = netChksum((uchar *)ip, IPv4_HDR_LEN);
     IPv4_TRACE("Setup IPv4 header");
+}
 
-    /* Fragment and send packet */
-    return ipv4SendFrag(pkt, nxthop);
+/**
+ * @ingroup ipv4
+ *
+ * Takes identifications for outgoing datagrams from the counter shared by
+ * everything that builds IPv4 headers.
+ * @param n number of consecutive identifications to take
+ * @return the first of them
+ */
+ushort ipv4IdTake(uint n)
+{
+    ushort id;
+    irqmask im;
+
+    im = disable();
+    id = ipv4id;
+    ipv4id += n;
+    restore(im);
+    return id;
 }
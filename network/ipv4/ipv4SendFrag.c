@@ -12,19 +12,36 @@
 #include <string.h>
 #include <ethernet.h>
 
+static uint ipv4FragData(struct netSeg *, uchar *, const struct netSeg **,
+                         uint *, uint);
+
 /**
- * Fragments packet into maximum transmission unit sized chunks.
+ * Fragments packet into maximum transmission unit sized chunks.  Each
+ * fragment is a header followed by segments that refer to its data where
+ * it lies, in the packet's buffer or the packet's own segments, so the
+ * data is not copied unless the driver cannot gather it.  If a fragment
+ * cannot be sent, or held until the next hop's address is resolved, the
+ * rest are not sent, as the datagram can no longer be reassembled.
  * @param pkt the packet to fragment
- * @return OK
+ * @return OK if the fragments were sent, NET_QUEUED if some are held until
+ * the next hop's address is resolved, NET_DROPPED if one could not be
+ * held, otherwise SYSERR
  */
 syscall ipv4SendFrag(struct packet *pkt, struct netaddr *nxthop)
 {
     uint ihl;
-    uchar *data;
+    uint hlen;
     uint dRem = 0;              // The amount of data remaining to be fragmented
     ushort froff;
     ushort lastFlag;
     ushort dLen;
+    int result, sent;
+
+    // Data of the incoming packet, and the pieces of it in a fragment
+    struct netSeg data;
+    const struct netSeg *cur;
+    uint off;
+    struct netSeg seg[IPv4_FRAG_NSEG];
 
     // Incoming packet structures
     struct ipv4Pkt *ip;
@@ -66,31 +83,19 @@ syscall ipv4SendFrag(struct packet *pkt, struct netaddr *nxthop)
     }
 
     ihl = (ip->ver_ihl & IPv4_IHL) * 4;
-    data = ((uchar *)ip) + ihl;
     dRem = net2hs(ip->len) - ihl;
     froff = net2hs(ip->flags_froff) & IPv4_FROFF;
     lastFlag = net2hs(ip->flags_froff) & IPv4_FLAGS;
 
-    // Length of data in this packet will be MTU - header length,
-    //  rounded down to nearest multiple of 8 bytes.
-    dLen = (pkt->nif->mtu - ihl) & ~0x7;
-
-    pkt->len = ihl + dLen;
-    ip->len = hs2net(pkt->len);
-
-    // Set more fragments flag
-    ip->flags_froff = IPv4_FLAG_MF & froff;
-    ip->flags_froff = hs2net(ip->flags_froff);
+    // The data follows the header in the packet's buffer, then its segments
+    data.data = ((uchar *)ip) + ihl;
+    data.len = pkt->len - pkt->seglen - ihl;
+    data.next = pkt->segs;
+    cur = &data;
+    off = 0;
 
-    ip->chksum = 0;
-    ip->chksum = netChksum((uchar *)ip, ihl);
-
-    netSend(pkt, NULL, nxthop, ETHER_TYPE_IPv4);
-    dRem -= dLen;
-    data += dLen;
-    froff += (dLen / 8);
-
-    // Get memory from stack for outgoing fragment
+    // Get memory from stack for outgoing fragment headers, with room for
+    // data that has to be copied after them
     outpkt = netGetbuf();
 
     if (SYSERR == (int)outpkt)
@@ -104,50 +109,145 @@ syscall ipv4SendFrag(struct packet *pkt, struct netaddr *nxthop)
     outip = (struct ipv4Pkt *)outpkt->curr;
     outpkt->nif = pkt->nif;
 
-    memcpy(outip, ip, IPv4_HDR_LEN);
+    // The first fragment carries the options
+    memcpy(outip, ip, ihl);
+    hlen = ihl;
+    result = OK;
 
     // While packet must be fragmented
     while (dRem > 0)
     {
-        if (((dRem + 7) & ~0x7) > pkt->nif->mtu + IPv4_HDR_LEN)
+        // Length of data in all but the last fragment will be MTU - header
+        //  length, rounded down to nearest multiple of 8 bytes.
+        if (dRem > pkt->nif->mtu - hlen)
         {
-            dLen = (pkt->nif->mtu - IPv4_HDR_LEN) & ~0x7;
+            dLen = (pkt->nif->mtu - hlen) & ~0x7;
         }
         else
         {
             dLen = dRem;
         }
-        // Copy data segment
-        memcpy(outip->opts, data, dLen);
 
         // Set more fragments flag
         if (dLen == dRem)
         {
-            outip->flags_froff = lastFlag & froff;
+            outip->flags_froff = (lastFlag & IPv4_FLAG_MF) | froff;
         }
         else
         {
-            outip->flags_froff = IPv4_FLAG_MF & froff;
+            outip->flags_froff = IPv4_FLAG_MF | froff;
         }
         outip->flags_froff = hs2net(outip->flags_froff);
 
         // Update fields
-        outip->len = hs2net(IPv4_HDR_LEN + dLen);
+        outip->len = hs2net(hlen + dLen);
         outip->chksum = 0;
-        outip->chksum = netChksum((uchar *)outip, IPv4_HDR_LEN);
+        outip->chksum = netChksum((uchar *)outip, hlen);
 
-        // Update outgoing packet length
-        outpkt->len = net2hs(outip->len);
+        // Update outgoing packet length; netSend() moved curr back
+        outpkt->curr = (uchar *)outip;
+        outpkt->len = hlen + dLen;
+
+        // Refer to the data, or copy it if it lies in too many pieces
+        if (ipv4FragData(seg, outpkt->curr + hlen, &cur, &off, dLen) > 0)
+        {
+            outpkt->segs = seg;
+            outpkt->seglen = dLen;
+        }
+        else
+        {
+            outpkt->segs = NULL;
+            outpkt->seglen = 0;
+        }
 
-        // Send fragment
-        netSend(outpkt, NULL, nxthop, ETHER_TYPE_IPv4);
+        // Send fragment; once one is lost, the others are of no use
+        sent = netSend(outpkt, NULL, nxthop, ETHER_TYPE_IPv4);
+        if (NET_QUEUED == sent)
+        {
+            result = NET_QUEUED;
+        }
+        else if (OK != sent)
+        {
+            IPv4_TRACE("fragment not sent");
+            result = sent;
+            break;
+        }
+
+        // Options are not copied into later fragments
+        if (hlen != IPv4_HDR_LEN)
+        {
+            outip->ver_ihl = (uchar)(IPv4_VERSION << 4) + IPv4_HDR_LEN / 4;
+            hlen = IPv4_HDR_LEN;
+        }
 
         dRem -= dLen;
-        data += dLen;
         froff += (dLen / 8);
     }
 
     IPv4_TRACE("freeing outpkt");
     netFreebuf(outpkt);
-    return OK;
+    return result;
+}
+
+/*
+ * Describes the next len octets of a packet's data, from off octets into
+ * the piece cur, with segments.  Returns the number of segments, or 0 if
+ * more than IPv4_FRAG_NSEG would be needed, in which case the octets are
+ * copied to dst instead.  Either way cur and off are moved past them.
+ */
+static uint ipv4FragData(struct netSeg *seg, uchar *dst,
+                         const struct netSeg **cur, uint *off, uint len)
+{
+    const struct netSeg *piece;
+    uint pos, n, count, nseg;
+    bool copy;
+
+    copy = FALSE;
+    while (TRUE)
+    {
+        piece = *cur;
+        pos = *off;
+        nseg = 0;
+        for (count = 0; (count < len) && (piece != NULL);)
+        {
+            if (pos >= piece->len)
+            {
+                piece = piece->next;
+                pos = 0;
+                continue;
+            }
+            n = piece->len - pos;
+            if (n > len - count)
+            {
+                n = len - count;
+            }
+            if (copy)
+            {
+                memcpy(dst + count, piece->data + pos, n);
+            }
+            else if (nseg < IPv4_FRAG_NSEG)
+            {
+                seg[nseg].data = piece->data + pos;
+                seg[nseg].len = n;
+                seg[nseg].next = NULL;
+                if (nseg > 0)
+                {
+                    seg[nseg - 1].next = &seg[nseg];
+                }
+            }
+            nseg++;
+            count += n;
+            pos += n;
+        }
+
+        // Too many pieces; go over them again, copying them
+        if (!copy && (nseg > IPv4_FRAG_NSEG))
+        {
+            copy = TRUE;
+            continue;
+        }
+        *cur = piece;
+        *off = pos;
+        return copy ? 0 : nseg;
+    }
 }
@@ -1,41 +1,226 @@
 /**
  * @file netChksum.c
  *
+ * Internet checksum (RFC 1071).  Words are summed as they lie in memory,
+ * so a sum is in network order on either byte order.  Aligned data is
+ * read 32 bits at a time into a 64-bit accumulator, eight words to a loop,
+ * which ARM and MIPS do without a carry test per word; the accumulator is
+ * folded to 16 bits once at the end.  A partial sum can be carried from
+ * one piece of a packet to the next, and a checksum can be updated for a
+ * changed field without summing the rest again (RFC 1624).
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
 #include <network.h>
+#include <string.h>
+
+static uint netChksumFold(unsigned long long);
+static unsigned long long netChksumTail(unsigned long long, const uchar *,
+                                        uint);
 
 /**
  * @ingroup network
+ *
+ * Computes the Internet checksum of a buffer.
+ * @param data buffer to checksum
+ * @param len length of the buffer in octets
+ * @return ones' complement of the ones' complement sum, in network order;
+ *      0 when checking a buffer that includes a correct checksum
  */
 ushort netChksum(void *data, uint len)
 {
-    uint sum;
-    ushort *ptr;
+    return netChksumFinish(netChksumAdd(0, data, len));
+}
 
-    /* Add data to sum */
-    ptr = (ushort *)data;
-    sum = 0;
-    while (len > 1)
+/**
+ * @ingroup network
+ *
+ * Adds a buffer to a partial Internet checksum.  Every piece but the last
+ * one of the data checksummed must have an even length.
+ * @param sum partial sum of the data before, 0 to start
+ * @param data buffer to add
+ * @param len length of the buffer in octets
+ * @return partial sum, at most 0xFFFF
+ */
+uint netChksumAdd(uint sum, const void *data, uint len)
+{
+    const uchar *ptr = data;
+    const uint *word;
+    unsigned long long acc = sum;
+
+    /* Align to 32 bits; data at an odd address is read octet by octet */
+    if (((ulong)ptr & 1) || (len < 4))
+    {
+        return netChksumFold(netChksumTail(acc, ptr, len));
+    }
+    if ((ulong)ptr & 2)
     {
-        sum += *ptr;
-        ptr++;
+        acc += *(const ushort *)ptr;
+        ptr += 2;
         len -= 2;
     }
 
-    /* Add left-over byte, if any */
-    if (len > 0)
+    word = (const uint *)ptr;
+    while (len >= 32)
+    {
+        acc += word[0];
+        acc += word[1];
+        acc += word[2];
+        acc += word[3];
+        acc += word[4];
+        acc += word[5];
+        acc += word[6];
+        acc += word[7];
+        word += 8;
+        len -= 32;
+    }
+    while (len >= 4)
+    {
+        acc += *word++;
+        len -= 4;
+    }
+
+    return netChksumFold(netChksumTail(acc, (const uchar *)word, len));
+}
+
+/**
+ * @ingroup network
+ *
+ * Copies a buffer and adds it to a partial Internet checksum in the same
+ * pass.  Every piece but the last one of the data checksummed must have an
+ * even length.
+ * @param sum partial sum of the data before, 0 to start
+ * @param dst buffer to copy to
+ * @param src buffer to copy and add
+ * @param len length of the buffer in octets
+ * @return partial sum, at most 0xFFFF
+ */
+uint netChksumCopy(uint sum, void *dst, const void *src, uint len)
+{
+    const uchar *sptr = src;
+    uchar *dptr = dst;
+    const uint *sword;
+    uint *dword;
+    unsigned long long acc = sum;
+    uint w;
+
+    /* Buffers that cannot both be aligned are copied, then summed */
+    if (((ulong)sptr & 1) || (((ulong)sptr ^ (ulong)dptr) & 3)
+        || (len < 4))
+    {
+        memcpy(dptr, sptr, len);
+        return netChksumAdd(sum, dptr, len);
+    }
+    if ((ulong)sptr & 2)
+    {
+        *(ushort *)dptr = *(const ushort *)sptr;
+        acc += *(const ushort *)sptr;
+        sptr += 2;
+        dptr += 2;
+        len -= 2;
+    }
+
+    sword = (const uint *)sptr;
+    dword = (uint *)dptr;
+    while (len >= 16)
+    {
+        w = sword[0];
+        dword[0] = w;
+        acc += w;
+        w = sword[1];
+        dword[1] = w;
+        acc += w;
+        w = sword[2];
+        dword[2] = w;
+        acc += w;
+        w = sword[3];
+        dword[3] = w;
+        acc += w;
+        sword += 4;
+        dword += 4;
+        len -= 16;
+    }
+    while (len >= 4)
     {
-        sum += net2hs(*((uchar *)ptr) << 8);
+        w = *sword++;
+        *dword++ = w;
+        acc += w;
+        len -= 4;
     }
 
-    /* Fold 32-bit sum into 16 bits */
-    while (sum >> 16)
+    memcpy(dword, sword, len);
+    return netChksumFold(netChksumTail(acc, (const uchar *)sword, len));
+}
+
+/**
+ * @ingroup network
+ *
+ * Turns a partial Internet checksum into the checksum to send.
+ * @param sum partial sum, or the sum of several
+ * @return ones' complement of the sum, in network order
+ */
+ushort netChksumFinish(uint sum)
+{
+    return ~netChksumFold(sum);
+}
+
+/**
+ * @ingroup network
+ *
+ * Updates an Internet checksum for a 16-bit word of the data that changed,
+ * as in equation 3 of RFC 1624.
+ * @param chksum checksum, as it is in the packet
+ * @param old word as it was, as it is in memory
+ * @param new word as it is now, as it is in memory
+ * @return checksum of the data with the new word
+ */
+ushort netChksumAdjust(ushort chksum, ushort old, ushort new)
+{
+    uint sum;
+
+    sum = (ushort)~chksum + (ushort)~old + new;
+    return ~netChksumFold(sum);
+}
+
+/*
+ * Folds a sum into 16 bits.
+ */
+static uint netChksumFold(unsigned long long acc)
+{
+    uint sum;
+
+    sum = (uint)(acc >> 32) + (uint)acc;
+    if (sum < (uint)acc)
     {
-        sum = (sum >> 16) + (sum & 0xFFFF);
+        sum++;
     }
+    sum = (sum >> 16) + (sum & 0xFFFF);
+    sum = (sum >> 16) + (sum & 0xFFFF);
+    return sum;
+}
 
-    return (~sum);
+/*
+ * Adds octets at any address to a sum, two at a time as they lie in
+ * memory, and a last odd octet as the first of a word.
+ */
+static unsigned long long netChksumTail(unsigned long long acc,
+                                        const uchar *ptr, uint len)
+{
+    ushort w;
+
+    while (len > 1)
+    {
+        memcpy(&w, ptr, 2);
+        acc += w;
+        ptr += 2;
+        len -= 2;
+    }
+    if (len > 0)
+    {
+        w = 0;
+        *(uchar *)&w = *ptr;
+        acc += w;
+    }
+    return acc;
 }
@@ -4,6 +4,7 @@
  */
 /* Embedded Xinu, Copyright (C) 2009, 2013.  All rights reserved. */
 
+#include <device.h>
 #include <interrupt.h>
 #include <network.h>
 #include <route.h>
@@ -25,6 +26,7 @@
 syscall netDown(int descrp)
 {
     struct netif *netptr;
+    struct netRxq *rxq;
     irqmask im;
     uint i;
 
@@ -41,14 +43,37 @@ syscall netDown(int descrp)
 
     NET_TRACE("Stopping netif %u on device %d", netptr - netiftab, descrp);
 
+    /* Stop the driver steering frames to the receive queues */
+    if (netptr->poll)
+    {
+        control(descrp, NET_SET_POLL, FALSE, 0);
+    }
+    if (netptr->steer)
+    {
+        control(descrp, NET_SET_STEER, 0, 0);
+    }
+
     /* Kill receiver threads.  TODO: There is a known bug here: this can kill
      * the receiver threads at inopportune times and leak resources (such as
      * packet buffers allocated with netGetbuf()).  */
-    for (i = 0; i < NET_NTHR; i++)
+    for (i = 0; i < netptr->nthr; i++)
     {
         kill(netptr->recvthr[i]);
     }
 
+    /* Free the packets left on the receive queues */
+    for (i = 0; i < netptr->nthr; i++)
+    {
+        rxq = &netptr->rxq[i];
+        while (rxq->count > 0)
+        {
+            netFreebuf(rxq->pkt[rxq->head]);
+            rxq->head = (rxq->head + 1) % NET_RXQ_LEN;
+            rxq->count--;
+        }
+        semfree(rxq->sem);
+    }
+
     /* Clear all entries in the route table for this network interface.  */
     rtClear(netptr);
 
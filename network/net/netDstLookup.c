@@ -0,0 +1,114 @@
+/**
+ * file netDstLookup.c
+ * 
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <arp.h>
+#include <clock.h>
+#include <ethernet.h>
+#include <interrupt.h>
+#include <network.h>
+#include <route.h>
+#include <string.h>
+
+/**
+ * @ingroup network
+ *
+ * Makes sure a destination cache holds the interface, next hop and
+ * link-level header for IPv4 packets to an address.  A cache filled in for
+ * the same address is used as it is until the route table or a resolved
+ * ARP entry changes or its hardware address expires; only then are the
+ * route and ARP tables looked up again.
+ * @param dc destination cache, all zero before its first use
+ * @param dst IPv4 address of the destination
+ * @return OK if the cache holds the destination, SYSERR if there is no
+ * 	route to it or the next hop's hardware address is not resolved yet;
+ * 	packets must then be sent with ipv4Send(), which resolves it.
+ */
+syscall netDstLookup(struct netDst *dc, const struct netaddr *dst)
+{
+    struct rtEntry *rtptr;
+    struct arpEntry *entry;
+    struct etherPkt *ether;
+    struct netif *netptr;
+    const struct netaddr *nxthop;
+    struct netaddr hwaddr;
+    uint rg, ag, expires;
+    irqmask im;
+
+    /* Use the cache while nothing it was filled in from has changed */
+    im = disable();
+    if ((dc->nif != NULL) && (dc->rtgen == rtgen) && (dc->arpgen == arpgen)
+        && (clktime < dc->expires) && netaddrequal(&dc->dst, dst))
+    {
+        restore(im);
+        return OK;
+    }
+    rg = rtgen;
+    ag = arpgen;
+    restore(im);
+
+    NET_TRACE("Filling destination cache");
+
+    /* Lookup destination in route table; only Ethernet framing is kept */
+    rtptr = rtLookup(dst);
+    if ((NULL == rtptr) || (SYSERR == (int)rtptr) || (NULL == rtptr->nif))
+    {
+        return SYSERR;
+    }
+    netptr = rtptr->nif;
+    if (netptr->linkhdrlen != ETH_HDR_LEN)
+    {
+        return SYSERR;
+    }
+    if (NULL == rtptr->gateway.type)
+    {
+        nxthop = dst;
+    }
+    else
+    {
+        nxthop = &rtptr->gateway;
+    }
+
+    /* Find the next hop's hardware address */
+    im = disable();
+    if (netaddrequal(&netptr->ipbrc, nxthop))
+    {
+        netaddrcpy(&hwaddr, &NETADDR_GLOBAL_ETH_BRC);
+        expires = ~0;
+    }
+    else
+    {
+        entry = arpGetEntry(nxthop);
+        if ((NULL == entry) || (entry->state != ARP_RESOLVED))
+        {
+            restore(im);
+            return SYSERR;
+        }
+        netaddrcpy(&hwaddr, &entry->hwaddr);
+        expires = entry->expires;
+    }
+
+    /* If either table changed meanwhile, what was found may be stale */
+    if ((rg != rtgen) || (ag != arpgen))
+    {
+        restore(im);
+        return SYSERR;
+    }
+
+    dc->nif = netptr;
+    netaddrcpy(&dc->dst, dst);
+    netaddrcpy(&dc->nxthop, nxthop);
+    ether = (struct etherPkt *)dc->linkhdr;
+    memcpy(ether->dst, hwaddr.addr, ETH_ADDR_LEN);
+    memcpy(ether->src, netptr->hwaddr.addr, ETH_ADDR_LEN);
+    ether->type = hs2net(ETHER_TYPE_IPv4);
+    dc->rtgen = rg;
+    dc->arpgen = ag;
+    dc->expires = expires;
+    restore(im);
+
+    return OK;
+}
@@ -6,15 +6,24 @@
 
 #include <stddef.h>
 #include <bufpool.h>
+#include <memory.h>
 #include <network.h>
 
 /**
  * @ingroup network
  *
- * Frees a buffer for storing a packet.
+ * Frees a buffer for storing a packet, from ::netpool or a pool of received
+ * packets or, if netGetbufLen() took it from the heap, to the heap.
  * @return OK if successful, SYSERR if an error occured
  */
 syscall netFreebuf(struct packet *pkt)
 {
+    struct netHeapbuf *hdr;
+
+    hdr = ((struct netHeapbuf *)pkt) - 1;
+    if (NET_HEAPPOOL == hdr->poolid)
+    {
+        return memfree(hdr, hdr->size);
+    }
     return buffree(pkt);
 }
@@ -0,0 +1,52 @@
+/**
+ * @file netGetbufLen.c
+ *
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <memory.h>
+#include <network.h>
+#include <stdlib.h>
+
+/**
+ * @ingroup network
+ *
+ * Provides a buffer for storing a packet of a given length, such as a
+ * datagram to be fragmented or one reassembled from fragments.  A packet
+ * that fits in ::NET_MAX_PKTLEN octets is given a buffer from ::netpool
+ * by netGetbuf(); a larger one is given a buffer from the heap, whose data
+ * is not cleared.  Either is freed with netFreebuf().
+ * @param len number of octets the packet's data must hold
+ * @return pointer to a packet buffer with curr at the end of its data,
+ * 	SYSERR if an error occured
+ */
+struct packet *netGetbufLen(uint len)
+{
+    struct netHeapbuf *hdr;
+    struct packet *pkt;
+    uint size;
+
+    if (len <= NET_MAX_PKTLEN)
+    {
+        return netGetbuf();
+    }
+
+    /* Keep the end of the data aligned as in a pool buffer, whose length
+     * is 2 more than a multiple of 4 */
+    len = ((len + 1) & ~0x03) + 2;
+    size = sizeof(struct netHeapbuf) + sizeof(struct packet) + len;
+    hdr = memget(size);
+    if (SYSERR == (int)hdr)
+    {
+        return (struct packet *)SYSERR;
+    }
+    hdr->size = size;
+    hdr->poolid = NET_HEAPPOOL;
+
+    pkt = (struct packet *)(hdr + 1);
+    bzero(pkt, sizeof(struct packet));
+    pkt->curr = pkt->data + len;
+
+    return pkt;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file     netHash.c
+ *
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <network.h>
+
+/**
+ * @ingroup network
+ *
+ * Hash of the ports and remote address that a transport protocol keys its
+ * table of connections or sockets on.  Folded so that its low bits depend
+ * on all of the key, so a table of a power of two buckets can take them.
+ * @param localpt local port
+ * @param remotept remote port, or 0
+ * @param remoteip remote address, or @c NULL
+ * @return hash of the key
+ */
+uint netHashPorts(ushort localpt, ushort remotept,
+                  const struct netaddr *remoteip)
+{
+    uint hash;
+    int i;
+
+    hash = localpt * 31 + remotept;
+    if ((NULL != remoteip) && (NULL != remoteip->type))
+    {
+        for (i = 0; i < remoteip->len; i++)
+        {
+            hash = hash * 31 + remoteip->addr[i];
+        }
+    }
+    hash ^= hash >> 16;
+    hash ^= hash >> 8;
+    return hash;
+}
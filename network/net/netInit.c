@@ -7,11 +7,13 @@
 #include <arp.h>
 #include <icmp.h>
 #include <bufpool.h>
+#include <ipv4.h>
 #include <network.h>
 #include <route.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <tcp.h>
+#include <thread.h>
 
 #ifndef NNETIF
 #define NNETIF 0
@@ -35,13 +37,15 @@ syscall netInit()
     {
         bzero(&netiftab[i], sizeof(struct netif));
         netiftab[i].state = NET_FREE;
+        netiftab[i].rxpool = SYSERR;
     }
 
-    /* Allocate packet buffer pool */
+    /* Allocate packet buffer pool for sending, keeping some buffers for
+     * netGetbuf().  Each interface gets a pool for receiving in netUp(). */
     netpool = bfpalloc(NET_MAX_PKTLEN + sizeof(struct packet),
                        NET_POOLSIZE);
     NET_TRACE("netpool has been assigned pool ID %d.\r\n", netpool);
-    if (SYSERR == netpool)
+    if ((SYSERR == netpool) || (SYSERR == bfpreserve(netpool, NET_TXRESERVE)))
     {
         return SYSERR;
     }
@@ -63,6 +67,15 @@ syscall netInit()
         return SYSERR;
     }
 
+    /* Drop datagrams whose fragments stop arriving */
+    i = create((void *)ipv4ReasmTimer, NET_THR_STK, NET_THR_PRIO,
+               "ipv4ReasmTimer", 0);
+    if (SYSERR == i)
+    {
+        return SYSERR;
+    }
+    ready(i, RESCHED_NO);
+
     /* Initialize TCP */
 #if NTCP
     i = create((void *)tcpTimer, INITSTK, INITPRIO, "tcpTimer", 0);
@@ -0,0 +1,96 @@
+/**
+ * @file netLinearize.c
+ *
+ * Copies out the frame of a packet whose data is split among segments.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <network.h>
+#include <string.h>
+
+/**
+ * @ingroup network
+ *
+ * Copies part of the frame of a packet, the octets at @c curr followed by
+ * its segments, into one buffer.
+ * @param dst buffer to copy into
+ * @param pkt packet whose frame to copy
+ * @param off offset in the frame of the first octet to copy
+ * @param len number of octets to copy
+ * @return number of octets copied, less than @p len if the frame ends
+ */
+uint netGather(void *dst, const struct packet *pkt, uint off, uint len)
+{
+    const struct netSeg *seg;
+    uchar *ptr = dst;
+    uint n, count;
+
+    /* Octets in the buffer */
+    count = 0;
+    n = pkt->len - pkt->seglen;
+    if (off < n)
+    {
+        n -= off;
+        if (n > len)
+        {
+            n = len;
+        }
+        memcpy(ptr, pkt->curr + off, n);
+        count = n;
+        off = 0;
+    }
+    else
+    {
+        off -= n;
+    }
+
+    /* Octets in the segments */
+    for (seg = pkt->segs; (seg != NULL) && (count < len); seg = seg->next)
+    {
+        if (off >= seg->len)
+        {
+            off -= seg->len;
+            continue;
+        }
+        n = seg->len - off;
+        if (n > len - count)
+        {
+            n = len - count;
+        }
+        memcpy(ptr + count, seg->data + off, n);
+        count += n;
+        off = 0;
+    }
+    return count;
+}
+
+/**
+ * @ingroup network
+ *
+ * Provides a copy of a packet with its whole frame in its buffer, for a
+ * driver that cannot gather segments.
+ * @param pkt packet to copy, which stays the caller's
+ * @return copy of the packet with its frame at @c curr and no segments,
+ * 	to be freed with netFreebuf(); SYSERR if there is no buffer for it
+ */
+struct packet *netLinearize(const struct packet *pkt)
+{
+    struct packet *copy;
+
+    copy = netGetbufLen(pkt->len);
+    if (SYSERR == (int)copy)
+    {
+        return (struct packet *)SYSERR;
+    }
+    copy->nif = pkt->nif;
+    copy->len = pkt->len;
+    copy->curr = copy->data;
+    copy->linkhdr = copy->curr;
+    if (pkt->nethdr != NULL)
+    {
+        copy->nethdr = copy->curr + (pkt->nethdr - pkt->curr);
+    }
+    netGather(copy->curr, pkt, 0, pkt->len);
+    return copy;
+}
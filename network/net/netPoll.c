@@ -0,0 +1,65 @@
+/**
+ * @file netPoll.c
+ *
+ * Polls drivers for received frames, a budget at a time.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <device.h>
+#include <interrupt.h>
+#include <network.h>
+
+/**
+ * @ingroup network
+ *
+ * Has the first receive thread of an interface poll its driver, after the
+ * frames already on its queue.  Called by a driver in the mode set by
+ * ::NET_SET_POLL when it has received a frame and masked its receive
+ * interrupt, followed by netRxqWake().  Interrupts must be disabled.
+ * @param netptr interface the driver steers frames to
+ */
+void netPollSchedule(struct netif *netptr)
+{
+    if (!netptr->pollpend)
+    {
+        netptr->pollpend = TRUE;
+        netptr->nrxintr++;
+        netptr->rxq[0].nwake++;
+    }
+}
+
+/**
+ * @ingroup network
+ *
+ * Polls the driver of an interface for up to ::NET_POLL_BUDGET frames,
+ * which it puts on the receive queues.  If it had that many, it may have
+ * more, and the first receive thread polls it again once it has handled
+ * the frames it was given, so that a busy interface takes its turn with
+ * the threads rather than interrupting them.  Called by the first receive
+ * thread when netRxqTake() gives it the poll netPollSchedule() queued.
+ * @param netptr interface to poll
+ */
+void netPoll(struct netif *netptr)
+{
+    irqmask im;
+    int n;
+
+    n = control(netptr->dev, NET_POLL, NET_POLL_BUDGET, 0);
+    if (SYSERR == n)
+    {
+        return;
+    }
+    netptr->npoll++;
+    if (n >= NET_POLL_BUDGET)
+    {
+        im = disable();
+        if (!netptr->pollpend)
+        {
+            netptr->pollpend = TRUE;
+            netptr->rxq[0].nwake++;
+        }
+        restore(im);
+        netRxqWake(netptr);
+    }
+}
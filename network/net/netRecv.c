@@ -6,8 +6,10 @@
 
 #include <stddef.h>
 #include <arp.h>
+#include <bufpool.h>
 #include <device.h>
 #include <ethernet.h>
+#include <interrupt.h>
 #include <network.h>
 #include <ipv4.h>
 #include <snoop.h>
@@ -15,51 +17,118 @@
 #include <string.h>
 #include <thread.h>
 
+/* Frames dropped for want of a buffer are read here, by any thread */
+static uchar discard[NET_MAX_PKTLEN];
+
 /**
  * @ingroup network
  *
- * Receive thread to handle one incoming packet at a time
+ * Receive thread to handle one incoming packet at a time.  Each thread of
+ * an interface takes the frames steered to its queue.  If the driver does
+ * not steer frames itself, the first thread reads them from the driver,
+ * handles those that are its own and puts the rest on the queues.  If the
+ * driver is polled, the first thread polls it.
  *
  * @param netptr
  *      network interface device to open netRecv on
+ * @param q
+ *      index of the thread among the interface's receive threads
  *
  * @return
  *      This thread never returns.
  */
-thread netRecv(struct netif *netptr)
+thread netRecv(struct netif *netptr, uint q)
 {
     uint maxlen;                            /**< maximum packet length */
     maxlen = netptr->linkhdrlen + netptr->mtu;
     struct packet *pkt;
     struct etherPkt *ether;
     struct netaddr dst;
+    irqmask im;
 
     /* Processing incoming packets */
     while (TRUE)
     {
         int len;
 
-        /* Get a buffer for incoming packet */
-        pkt = netGetbuf();
-        if (SYSERR == (int)pkt)
+        if (netptr->steer || (q != 0))
         {
-            continue;
+            /* Take the next frame steered to this thread, or poll the
+             * driver for more */
+            pkt = netRxqTake(netptr, q);
+            if (NULL == pkt)
+            {
+                netPoll(netptr);
+                continue;
+            }
+            len = pkt->len;
+        }
+        else if (netptr->recvpkt)
+        {
+            /* The driver received the frame straight into a packet buffer
+             * and hands it over without copying.  This thread will wait
+             * until there is one.  A driver that is down fails at once, so
+             * the thread sleeps before trying again rather than keep lower
+             * priority threads from running. */
+            len = control(netptr->dev, NET_RECV_PKT, (long)&pkt, 0);
+            if (SYSERR == len)
+            {
+                sleep(NET_RECV_RETRY);
+                continue;
+            }
+        }
+        else
+        {
+            /* Get a buffer for incoming packet from the interface's pool.
+             * It is not cleared, as the frame and the fields set below are
+             * all that is looked at.  If the pool is used up, the frame is
+             * read and dropped, counted against the pool, rather than left
+             * in the driver to wait for a buffer. */
+            pkt = bufgetnb(netptr->rxpool);
+            if (SYSERR == (int)pkt)
+            {
+                if (SYSERR == read(netptr->dev, discard, maxlen))
+                {
+                    sleep(NET_RECV_RETRY);
+                }
+                continue;
+            }
+
+            /* Read in packet from the underlying network device.
+             * This thread will wait until there is a packet to read.
+             * It is the responsibility of the network driver to tell this
+             * thread to run, signifying that there is a packet to read
+             */
+            len = read(netptr->dev, pkt->data, maxlen);
+            if (SYSERR == len)
+            {
+                netFreebuf(pkt);
+                sleep(NET_RECV_RETRY);
+                continue;
+            }
         }
 
-        /* Read in packet from the underlying network device.
-         * This thread will wait until there is a packet to read.
-         * It is the responsibility of the network driver to tell this
-         * thread to run, signifying that there is a packet to read
-         */
-        len = read(netptr->dev, pkt->data, maxlen);
-        if (ETH_HDR_LEN > len || SYSERR == len)
+        if (ETH_HDR_LEN > len)
         {
             netFreebuf(pkt);
             continue;
         }
 
+        /* Pass frames this thread read for other threads to them */
         pkt->len = len;
+        if (!netptr->steer && (0 == q) && (netRxqSelect(netptr, pkt) != 0))
+        {
+            im = disable();
+            netRxqPut(netptr, pkt);
+            restore(im);
+            netRxqWake(netptr);
+            continue;
+        }
+        netptr->rxq[q].npkt++;
+
         pkt->curr = pkt->data;
+        pkt->segs = NULL;
+        pkt->seglen = 0;
         pkt->nif = netptr;
         netptr->nin++;
 
@@ -0,0 +1,153 @@
+/**
+ * @file netRxq.c
+ *
+ * Steers received frames to the receive threads of a network interface.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <network.h>
+#include <semaphore.h>
+
+/**
+ * @ingroup network
+ *
+ * Chooses the receive thread of an interface to handle a frame.  IPv4
+ * frames are spread over the threads by a hash of their addresses and
+ * protocol, and of their ports if they are TCP or UDP and not fragments,
+ * so every frame of a flow goes to the same thread, and all fragments of a
+ * datagram do too.  ARP and other frames go to the first thread.
+ * @param netptr interface the frame was received on
+ * @param pkt packet with the frame at @c data and @c len set
+ * @return index of the thread, less than @c netptr->nthr
+ */
+uint netRxqSelect(const struct netif *netptr, const struct packet *pkt)
+{
+    const struct etherPkt *ether;
+    const struct ipv4Pkt *ip;
+    const uchar *ports;
+    uint ihl, hash, i;
+
+    ether = (const struct etherPkt *)pkt->data;
+    ip = (const struct ipv4Pkt *)(pkt->data + netptr->linkhdrlen);
+    if ((netptr->nthr <= 1) || (ETHER_TYPE_IPv4 != net2hs(ether->type))
+        || (pkt->len < netptr->linkhdrlen + IPv4_HDR_LEN))
+    {
+        return 0;
+    }
+
+    hash = ip->proto;
+    for (i = 0; i < IPv4_ADDR_LEN; i++)
+    {
+        hash = (hash << 8) ^ (hash >> 24) ^ ip->src[i] ^ (ip->dst[i] << 16);
+    }
+    ihl = (ip->ver_ihl & IPv4_IHL) * 4;
+    if (((IPv4_PROTO_TCP == ip->proto) || (IPv4_PROTO_UDP == ip->proto))
+        && !(net2hs(ip->flags_froff) & (IPv4_FLAG_MF | IPv4_FROFF))
+        && (pkt->len >= netptr->linkhdrlen + ihl + 4))
+    {
+        ports = (const uchar *)ip + ihl;
+        hash ^= (ports[0] << 24) | (ports[1] << 16) | (ports[2] << 8)
+            | ports[3];
+    }
+
+    /* Mix the bits, so that the high ones decide the thread */
+    hash *= 0x9E3779B1;
+    return (hash >> 16) % netptr->nthr;
+}
+
+/**
+ * @ingroup network
+ *
+ * Puts a received frame on the queue of the receive thread netRxqSelect()
+ * chooses for it, to be woken by netRxqWake().  If the queue is full the
+ * packet is freed and counted as dropped.  Interrupts must be disabled.
+ * @param netptr interface the frame was received on
+ * @param pkt packet with the frame at @c data and @c len set
+ * @return index of the queue, SYSERR if the packet was dropped
+ */
+int netRxqPut(struct netif *netptr, struct packet *pkt)
+{
+    struct netRxq *rxq;
+    uint q;
+
+    q = netRxqSelect(netptr, pkt);
+    rxq = &netptr->rxq[q];
+    if (rxq->count >= NET_RXQ_LEN)
+    {
+        rxq->ndrop++;
+        netFreebuf(pkt);
+        return SYSERR;
+    }
+    rxq->pkt[(rxq->head + rxq->count) % NET_RXQ_LEN] = pkt;
+    rxq->count++;
+    rxq->nwake++;
+    if (rxq->count > rxq->maxcount)
+    {
+        rxq->maxcount = rxq->count;
+    }
+    return q;
+}
+
+/**
+ * @ingroup network
+ *
+ * Wakes the receive threads of an interface for the frames put on their
+ * queues since the last call, with one signal per queue.
+ * @param netptr interface the frames were received on
+ */
+void netRxqWake(struct netif *netptr)
+{
+    struct netRxq *rxq;
+    irqmask im;
+    uint q, n;
+
+    for (q = 0; q < netptr->nthr; q++)
+    {
+        rxq = &netptr->rxq[q];
+        im = disable();
+        n = rxq->nwake;
+        rxq->nwake = 0;
+        restore(im);
+        if (n > 0)
+        {
+            rxq->nsignal++;
+            signaln(rxq->sem, n);
+        }
+    }
+}
+
+/**
+ * @ingroup network
+ *
+ * Takes the oldest frame off the queue of a receive thread, waiting for
+ * one if there is none.  The first thread is given the poll queued by
+ * netPollSchedule() once it has taken the frames ahead of it.
+ * @param netptr interface the frame was received on
+ * @param q index of the thread's queue
+ * @return packet with the frame at @c data and @c len set; NULL if the
+ *      thread is to call netPoll()
+ */
+struct packet *netRxqTake(struct netif *netptr, uint q)
+{
+    struct netRxq *rxq;
+    struct packet *pkt;
+    irqmask im;
+
+    rxq = &netptr->rxq[q];
+    wait(rxq->sem);
+    im = disable();
+    if ((0 == rxq->count) && netptr->pollpend)
+    {
+        netptr->pollpend = FALSE;
+        restore(im);
+        return NULL;
+    }
+    pkt = rxq->pkt[rxq->head];
+    rxq->head = (rxq->head + 1) % NET_RXQ_LEN;
+    rxq->count--;
+    restore(im);
+    return pkt;
+}
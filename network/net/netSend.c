@@ -21,8 +21,10 @@
  * @param hwaddr hardware address of the destination, NULL if should lookup
  * @param praddr protocol address of the destination, NULL if hwaddr is known
  * @param type type of the packet to put in link level header
- * @return OK if packet was sent, TIMEOUT if ARP request timed out,
- * 	otherwise SYSERR
+ * @return OK if packet was sent, NET_QUEUED if a copy of it is held until
+ * 	the destination hardware address is resolved, NET_DROPPED if it
+ * 	could not be held, otherwise SYSERR.  Never waits for ARP; the caller
+ * 	keeps ownership of pkt in every case.
  */
 syscall netSend(struct packet *pkt, const struct netaddr *hwaddr,
                 const struct netaddr *praddr, ushort type)
@@ -31,6 +33,7 @@ syscall netSend(struct packet *pkt, const struct netaddr *hwaddr,
     struct etherPkt *ether = NULL;      /**< pointer to Ethernet header   */
     int result;                         /**< result of ARP lookup         */
     struct netaddr addr;
+    struct packet *copy;
 
     /* Setup and error check pointers */
     if (NULL == pkt)
@@ -64,7 +67,7 @@ syscall netSend(struct packet *pkt, const struct netaddr *hwaddr,
     {
         NET_TRACE("Hardware address lookup required");
         hwaddr = &addr;
-        result = arpLookup(netptr, praddr, (struct netaddr*)hwaddr);
+        result = arpLookup(netptr, praddr, &addr, pkt);
         if (result != OK)
         {
             return result;
@@ -74,10 +77,35 @@ syscall netSend(struct packet *pkt, const struct netaddr *hwaddr,
     /* Copy destination hardware address into link-level header */
     memcpy(ether->dst, hwaddr->addr, hwaddr->len);
 
-    /* Write the packet to the underlying device */
-    if (pkt->len != write(netptr->dev, pkt->curr, pkt->len))
+    /* Write the packet to the underlying device, which gathers any
+     * segments it has, or else is given a contiguous copy of it */
+    if (NULL == pkt->segs)
     {
-        return SYSERR;
+        if (pkt->len != write(netptr->dev, pkt->curr, pkt->len))
+        {
+            return SYSERR;
+        }
+    }
+    else if (netptr->sendpkts)
+    {
+        if (1 != control(netptr->dev, NET_SEND_PKTS, (long)&pkt, 1))
+        {
+            return SYSERR;
+        }
+    }
+    else
+    {
+        copy = netLinearize(pkt);
+        if (SYSERR == (int)copy)
+        {
+            return SYSERR;
+        }
+        result = write(netptr->dev, copy->curr, copy->len);
+        netFreebuf(copy);
+        if (result != pkt->len)
+        {
+            return SYSERR;
+        }
     }
 
     /* Snoop packet */
@@ -0,0 +1,100 @@
+/**
+ * file netSendPkts.c
+ * 
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <device.h>
+#include <network.h>
+#include <snoop.h>
+#include <string.h>
+
+/**
+ * @ingroup network
+ *
+ * Prepends the Link-Level header of a destination cache to a burst of
+ * packets and writes them to its interface, in one call if the driver
+ * supports ::NET_SEND_PKTS.
+ * @param pkts packets to send
+ * @param npkt number of packets
+ * @param dc destination cache, filled in by netDstLookup()
+ * @return OK if the packets were sent, otherwise SYSERR.  The caller keeps
+ * 	ownership of the packets.
+ */
+syscall netSendPkts(struct packet **pkts, uint npkt, const struct netDst *dc)
+{
+    struct netif *netptr = NULL;        /**< pointer to network interface */
+    struct packet *pkt, *copy;
+    uint i;
+    int result;
+
+    /* Setup and error check pointers */
+    if ((NULL == pkts) || (NULL == dc))
+    {
+        return SYSERR;
+    }
+    netptr = dc->nif;
+    if ((NULL == netptr) || (netptr->state != NET_ALLOC))
+    {
+        return SYSERR;
+    }
+
+    NET_TRACE("Send %d packets", npkt);
+
+    /* Make space for and copy in Link-Level headers */
+    for (i = 0; i < npkt; i++)
+    {
+        pkt = pkts[i];
+        pkt->nif = netptr;
+        pkt->curr -= ETH_HDR_LEN;
+        pkt->len += ETH_HDR_LEN;
+        memcpy(pkt->curr, dc->linkhdr, ETH_HDR_LEN);
+    }
+
+    /* Write the packets to the underlying device */
+    if (netptr->sendpkts)
+    {
+        if (npkt != control(netptr->dev, NET_SEND_PKTS, (long)pkts, npkt))
+        {
+            return SYSERR;
+        }
+    }
+    else
+    {
+        for (i = 0; i < npkt; i++)
+        {
+            pkt = pkts[i];
+            if (NULL == pkt->segs)
+            {
+                result = write(netptr->dev, pkt->curr, pkt->len);
+            }
+            else
+            {
+                /* The driver cannot gather segments; write a copy */
+                copy = netLinearize(pkt);
+                if (SYSERR == (int)copy)
+                {
+                    return SYSERR;
+                }
+                result = write(netptr->dev, copy->curr, copy->len);
+                netFreebuf(copy);
+            }
+            if (result != pkt->len)
+            {
+                return SYSERR;
+            }
+        }
+    }
+
+    /* Snoop packets */
+    if (netptr->capture != NULL)
+    {
+        for (i = 0; i < npkt; i++)
+        {
+            snoopCapture(netptr->capture, pkts[i]);
+        }
+    }
+
+    return OK;
+}
@@ -3,11 +3,13 @@
  */
 /* Embedded Xinu, Copyright (C) 2009, 2013.  All rights reserved. */
 
+#include <bufpool.h>
 #include <conf.h>
 #include <device.h>
 #include <interrupt.h>
 #include <network.h>
 #include <route.h>
+#include <semaphore.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <thread.h>
@@ -17,7 +19,8 @@ static int netAlloc(void);
 /**
  * @ingroup network
  *
- * Starts a network interface using the specified protocol addresses.
+ * Starts a network interface using the specified protocol addresses, with
+ * ::NET_NTHR receive threads.
  *
  * @param descrp
  *      Index of the underlying network device on which to open the interface.
@@ -34,9 +37,39 @@ static int netAlloc(void);
  */
 syscall netUp(int descrp, const struct netaddr *ip, const struct netaddr *mask,
               const struct netaddr *gateway)
+{
+    return netUpThreads(descrp, ip, mask, gateway, NET_NTHR);
+}
+
+/**
+ * @ingroup network
+ *
+ * Starts a network interface using the specified protocol addresses, with
+ * a number of receive threads.  Received frames are steered to the
+ * threads by flow, as netRxqSelect() describes.
+ *
+ * @param descrp
+ *      Index of the underlying network device on which to open the interface.
+ * @param ip
+ *      Protocol address; cannot be NULL.
+ * @param mask
+ *      Protocol address mask; cannot be NULL.
+ * @param gateway
+ *      Protocol address of the gateway, or NULL if unspecified.  If
+ *      unspecified, it is interpreted as "no gateway".
+ * @param nthr
+ *      Number of receive threads, from 1 to ::NET_NTHR_MAX.
+ *
+ * @return
+ *      OK if the network interface was successfully started; otherwise SYSERR.
+ */
+syscall netUpThreads(int descrp, const struct netaddr *ip,
+                     const struct netaddr *mask,
+                     const struct netaddr *gateway, uint nthr)
 {
     irqmask im;
     int nif;
+    int rxpool;
     struct netif *netptr;
     uint i;
     uint nthreads;
@@ -49,6 +82,12 @@ syscall netUp(int descrp, const struct netaddr *ip, const struct netaddr *mask,
         goto out;
     }
 
+    if (nthr < 1 || nthr > NET_NTHR_MAX)
+    {
+        NET_TRACE("Bad number of receive threads");
+        goto out;
+    }
+
     if (ip->len > NET_MAX_ALEN || mask->len > NET_MAX_ALEN ||
         (NULL != gateway && gateway->len > NET_MAX_ALEN))
     {
@@ -76,10 +115,25 @@ syscall netUp(int descrp, const struct netaddr *ip, const struct netaddr *mask,
     netptr = &netiftab[nif];
     NET_TRACE("Starting netif %d on device %d", nif, descrp);
 
-    /* Initialize the network interface structure */
+    /* Initialize the network interface structure, keeping its pool of
+     * received packets, which is allocated the first time it is started and
+     * kept since buffers from it may outlive the interface. */
+    rxpool = netptr->rxpool;
     bzero(netptr, sizeof(struct netif));
+    if (SYSERR == rxpool)
+    {
+        rxpool = bfpalloc(NET_MAX_PKTLEN + sizeof(struct packet),
+                          NET_RXPOOLSIZE);
+    }
+    netptr->rxpool = rxpool;
+    if (SYSERR == rxpool)
+    {
+        NET_TRACE("Failed to allocate pool of received packets");
+        goto out_restore;
+    }
     netptr->dev = descrp;
     netptr->state = NET_ALLOC;
+    netptr->nthr = nthr;
     netptr->mtu = control(descrp, NET_GET_MTU, 0, 0);
     netptr->linkhdrlen = control(descrp, NET_GET_LINKHDRLEN, 0, 0);
     if (SYSERR == netptr->mtu || SYSERR == netptr->linkhdrlen)
@@ -88,6 +142,16 @@ syscall netUp(int descrp, const struct netaddr *ip, const struct netaddr *mask,
         goto out_free_nif;
     }
 
+    /* Take received packets from the driver by reference if it can */
+    netptr->recvpkt = (OK == control(descrp, NET_RECV_PKT, 0, 0));
+    netptr->sendpkts = (OK == control(descrp, NET_SEND_PKTS, 0, 0));
+    if (netptr->recvpkt
+        && (SYSERR == control(descrp, NET_SET_RXPOOL, rxpool, 0)))
+    {
+        NET_TRACE("Failed to set pool of received packets");
+        goto out_free_nif;
+    }
+
     /* Get NIC hardware address and hardware broadcast address  */
     if ((SYSERR ==
          control(descrp, NET_GET_HWADDR, (long)&netptr->hwaddr, 0))
@@ -141,18 +205,27 @@ syscall netUp(int descrp, const struct netaddr *ip, const struct netaddr *mask,
         rtDefault(&netptr->gateway, netptr);
     }
 
-    /*  Spawn receive threads associated with this interface */
-    for (i = 0; i < NET_NTHR; i++)
+    /*  Spawn receive threads associated with this interface, each with
+     *  its queue of received packets */
+    for (i = 0; i < nthr; i++)
     {
         char thrname[DEVMAXNAME + 30];
         tid_typ tid;
 
+        netptr->rxq[i].sem = semcreate(0);
+        if (SYSERR == (int)netptr->rxq[i].sem)
+        {
+            nthreads = i;
+            goto out_kill_recv_threads;
+        }
         sprintf(thrname, "%srecv%02d", devtab[descrp].name, i);
-        tid = create(netRecv, NET_THR_STK, NET_THR_PRIO, thrname, 1, netptr);
+        tid = create(netRecv, NET_THR_STK, NET_THR_PRIO, thrname, 2, netptr,
+                     i);
         if (SYSERR == tid)
         {
             /* Failed to create all receive threads; kill the ones that have
              * already been spawned.  */
+            semfree(netptr->rxq[i].sem);
             nthreads = i;
             goto out_kill_recv_threads;
         }
@@ -160,6 +233,14 @@ syscall netUp(int descrp, const struct netaddr *ip, const struct netaddr *mask,
         ready(tid, RESCHED_NO);
     }
 
+    /* Have the driver steer received frames to the threads if it can;
+     * otherwise the first thread reads and steers them */
+    netptr->steer = (OK == control(descrp, NET_SET_STEER, (long)netptr, 0));
+
+    /* Poll the driver for frames, a budget at a time, if it can */
+    netptr->poll = netptr->steer
+        && (OK == control(descrp, NET_SET_POLL, TRUE, 0));
+
     retval = OK;
     goto out_restore;
 
@@ -167,6 +248,7 @@ out_kill_recv_threads:
     for (i = 0; i < nthreads; i++)
     {
         kill(netptr->recvthr[i]);
+        semfree(netptr->rxq[i].sem);
     }
 out_free_nif:
     netptr->state = NET_FREE;
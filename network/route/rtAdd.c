@@ -72,5 +72,6 @@ syscall rtAdd(const struct netaddr *dst, const struct netaddr *gate,
     rtptr->masklen = length;
 
     rtptr->state = RT_USED;
+    rtTrieBuild();
     return OK;
 }
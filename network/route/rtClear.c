@@ -36,6 +36,7 @@ syscall rtClear(struct netif *nif)
             rttab[i].nif = NULL;
         }
     }
+    rtTrieBuild();
     restore(im);
     return OK;
 }
@@ -65,6 +65,7 @@ syscall rtDefault(const struct netaddr *gate, struct netif *nif)
     rtptr->masklen = 0;
 
     rtptr->state = RT_USED;
+    rtTrieBuild();
     RT_TRACE("Populated default route");
     return OK;
 }
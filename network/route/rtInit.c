@@ -13,6 +13,7 @@
 
 struct rtEntry rttab[RT_NENTRY];
 mailbox rtqueue;
+uint rtnarpdrop;
 
 /**
  * @ingroup route
@@ -30,6 +31,7 @@ syscall rtInit(void)
         bzero(&rttab[i], sizeof(struct rtEntry));
         rttab[i].state = RT_FREE;
     }
+    rtTrieBuild();
 
     /* Initialize route queue */
     rtqueue = mailboxAlloc(RT_NQUEUE);
@@ -1,56 +1,68 @@
 /**
  * @file rtLookup.c
- * 
+ *
  */
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
 #include <interrupt.h>
+#include <ipv4.h>
 #include <network.h>
 #include <route.h>
 
 /**
  * @ingroup route
  *
- * Looks up an entry in the routing table
+ * Looks up an entry in the routing table.  Recently used destinations are
+ * found in the route cache; others are looked up in the IPv4 trie with
+ * interrupts enabled, and added to the cache.
  * @param addr the IP address that needs routing
  * @return a route table entry, NULL if none matches, SYSERR on error
  */
 struct rtEntry *rtLookup(const struct netaddr *addr)
 {
-    int i;
+    struct rtCache *cache;
     struct rtEntry *rtptr;
-    struct netaddr masked;
+    uint dst, gen;
     irqmask im;
 
-    rtptr = NULL;
-
     RT_TRACE("Addr = %d.%d.%d.%d", addr->addr[0], addr->addr[1],
              addr->addr[2], addr->addr[3]);
 
-    im = disable();
-    for (i = 0; i < RT_NENTRY; i++)
+    /* Only IPv4 routes are kept in the trie */
+    if ((NETADDR_IPv4 != addr->type) || (IPv4_ADDR_LEN != addr->len))
     {
-        if (RT_USED == rttab[i].state)
-        {
-            /* Mask off address */
-            netaddrcpy(&masked, addr);
-            netaddrmask(&masked, &rttab[i].mask);
+        return NULL;
+    }
+    dst = ((uint)addr->addr[0] << 24) | ((uint)addr->addr[1] << 16)
+        | ((uint)addr->addr[2] << 8) | addr->addr[3];
+    cache = &rtcache[(dst ^ (dst >> 7) ^ (dst >> 15)) & (RT_NCACHE - 1)];
 
-            /* Check if match  */
-            if (netaddrequal(&masked, &rttab[i].dst))
-            {
-                RT_TRACE("Matched entry %d", i);
-                /* Remember match if no match so far or match is better */
-                if ((NULL == rtptr)
-                    || (rtptr->masklen < rttab[i].masklen))
-                {
-                    rtptr = &rttab[i];
-                }
-            }
-        }
+    im = disable();
+    if ((cache->gen == rtgen) && (cache->addr == dst))
+    {
+        rtptr = cache->route;
+        restore(im);
+        RT_TRACE("Cached route");
+        return rtptr;
     }
     restore(im);
 
-    return rtptr;
+    /* Walk the trie, again if the route table changed meanwhile */
+    while (TRUE)
+    {
+        gen = rtgen;
+        rtptr = rtTrieLookup(dst);
+
+        im = disable();
+        if (gen == rtgen)
+        {
+            cache->addr = dst;
+            cache->gen = gen;
+            cache->route = rtptr;
+            restore(im);
+            return rtptr;
+        }
+        restore(im);
+    }
 }
@@ -37,6 +37,7 @@ syscall rtRemove(const struct netaddr *dst)
             rttab[i].nif = NULL;
         }
     }
+    rtTrieBuild();
     restore(im);
     return OK;
 }
@@ -23,6 +23,8 @@ syscall rtSend(struct packet *pkt)
     struct netaddr dst;
     struct rtEntry *route;
     struct netaddr *nxthop;
+    ushort *ttlproto, old;
+    int result;
 
     /* Error check pointers */
     if (NULL == pkt)
@@ -57,7 +59,10 @@ syscall rtSend(struct packet *pkt)
         }
     }
 
-    /* Update IP header */
+    /* Update IP header; only the word holding the TTL changes, so the
+     * checksum is adjusted for it rather than summed again (RFC 1624) */
+    ttlproto = (ushort *)&ip->ttl;
+    old = *ttlproto;
     ip->ttl--;
     if (0 == ip->ttl)
     {
@@ -65,8 +70,7 @@ syscall rtSend(struct packet *pkt)
         icmpTimeExceeded(pkt, ICMP_TTL_EXC);
         return SYSERR;
     }
-    ip->chksum = 0;
-    ip->chksum = netChksum((uchar *)ip, IPv4_HDR_LEN);
+    ip->chksum = netChksumAdjust(ip->chksum, old, *ttlproto);
 
     /* Change packet to new network interface */
     pkt->nif = route->nif;
@@ -81,7 +85,18 @@ syscall rtSend(struct packet *pkt)
         nxthop = &route->gateway;
     }
 
-    if (SYSERR == ipv4SendFrag(pkt, nxthop))
+    /* A packet held until the next hop's address is resolved is sent
+     * then, but one that could not be held is lost like one sent to an
+     * unreachable host */
+    result = ipv4SendFrag(pkt, nxthop);
+    if (NET_DROPPED == result)
+    {
+        RT_TRACE("Routed packet: No room to hold for ARP.");
+        rtnarpdrop++;
+        icmpDestUnreach(pkt, ICMP_HST_UNR);
+        return SYSERR;
+    }
+    if (SYSERR == result)
     {
         RT_TRACE("Routed packet: Host unreachable.");
         icmpDestUnreach(pkt, ICMP_HST_UNR);
@@ -0,0 +1,167 @@
+/**
+ * @file rtTrie.c
+ *
+ * Longest-prefix match of IPv4 routes.  The IPv4 entries of the route
+ * table are kept in a path-compressed binary trie, which is rebuilt from
+ * scratch whenever the table changes; routes change rarely, and each
+ * rebuild is at most ::RT_NENTRY insertions of no more than 32 steps.
+ *
+ * A rebuild runs with interrupts disabled and increments ::rtgen.  A lookup
+ * runs with interrupts enabled and only trusts its result if ::rtgen did not
+ * change meanwhile.  Every step of a lookup moves to a node with a longer
+ * prefix, so even a lookup that races a rebuild ends after at most 33 steps.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <network.h>
+#include <route.h>
+#include <stdlib.h>
+
+struct rtNode rttrie[RT_NNODE];
+struct rtCache rtcache[RT_NCACHE];
+volatile uint rtgen;
+
+static uint rtnnode;
+
+/* Netmask of a prefix length from 0 to 32 */
+#define rtmask(len)     ((0 == (len)) ? 0 : ~0U << (32 - (len)))
+
+/* Bit pos of an address, counting from the most significant bit */
+#define rtbit(addr, pos)    (((addr) >> (31 - (pos))) & 1)
+
+static ushort rtTrieNode(uint prefix, ushort len, struct rtEntry *route)
+{
+    struct rtNode *node;
+
+    node = &rttrie[rtnnode];
+    node->prefix = prefix & rtmask(len);
+    node->len = len;
+    node->child[0] = node->child[1] = 0;
+    node->route = route;
+    return rtnnode++;
+}
+
+/* Add a prefix to the trie.  If the prefix is already there the route that
+ * was added first is kept, as rtLookup() always did. */
+static void rtTrieInsert(uint prefix, ushort len, struct rtEntry *route)
+{
+    ushort n, c, m, common;
+    uint diff;
+
+    prefix &= rtmask(len);
+    n = 0;
+    while (rttrie[n].len != len)
+    {
+        c = rttrie[n].child[rtbit(prefix, rttrie[n].len)];
+        if (0 == c)
+        {
+            rttrie[n].child[rtbit(prefix, rttrie[n].len)] =
+                rtTrieNode(prefix, len, route);
+            return;
+        }
+
+        /* Length of the prefix shared with the child */
+        diff = prefix ^ rttrie[c].prefix;
+        common = (0 == diff) ? 32 : __builtin_clz(diff);
+        if (common > len)
+        {
+            common = len;
+        }
+        if (common >= rttrie[c].len)
+        {
+            n = c;
+            continue;
+        }
+
+        /* Split the edge to the child, at the new prefix itself if the child
+         * extends it, otherwise at a branch node where the two differ. */
+        if (common == len)
+        {
+            m = rtTrieNode(prefix, len, route);
+        }
+        else
+        {
+            m = rtTrieNode(prefix, common, NULL);
+            rttrie[m].child[rtbit(prefix, common)] =
+                rtTrieNode(prefix, len, route);
+        }
+        rttrie[m].child[rtbit(rttrie[c].prefix, common)] = c;
+        rttrie[n].child[rtbit(prefix, rttrie[n].len)] = m;
+        return;
+    }
+
+    if (NULL == rttrie[n].route)
+    {
+        rttrie[n].route = route;
+    }
+}
+
+/**
+ * @ingroup route
+ *
+ * Rebuild the IPv4 lookup trie from the route table and invalidate the route
+ * cache.  Must be called after every change to the route table.
+ */
+void rtTrieBuild(void)
+{
+    struct rtEntry *rtptr;
+    uint prefix;
+    int i;
+    irqmask im;
+
+    im = disable();
+    rtgen++;
+    rtnnode = 0;
+    rtTrieNode(0, 0, NULL);
+    for (i = 0; i < RT_NENTRY; i++)
+    {
+        rtptr = &rttab[i];
+        if ((RT_USED != rtptr->state) || (NETADDR_IPv4 != rtptr->dst.type)
+            || (rtptr->masklen > 32))
+        {
+            continue;
+        }
+        prefix = ((uint)rtptr->dst.addr[0] << 24)
+            | ((uint)rtptr->dst.addr[1] << 16)
+            | ((uint)rtptr->dst.addr[2] << 8) | rtptr->dst.addr[3];
+        rtTrieInsert(prefix, rtptr->masklen, rtptr);
+    }
+    bzero(rtcache, sizeof(rtcache));
+    restore(im);
+}
+
+/**
+ * @ingroup route
+ *
+ * Find the route with the longest prefix matching an IPv4 address.  May be
+ * called with interrupts enabled; the caller must check that ::rtgen is the
+ * same before and after, and look up again if it is not.
+ * @param addr IPv4 address in host order
+ * @return route table entry, NULL if none matches
+ */
+struct rtEntry *rtTrieLookup(uint addr)
+{
+    struct rtEntry *best;
+    ushort n, c, len;
+
+    n = 0;
+    best = rttrie[0].route;
+    while ((len = rttrie[n].len) < 32)
+    {
+        c = rttrie[n].child[rtbit(addr, len)];
+        if ((0 == c) || (c >= RT_NNODE) || (rttrie[c].len <= len)
+            || (0 != ((addr ^ rttrie[c].prefix) & rtmask(rttrie[c].len))))
+        {
+            break;
+        }
+        if (rttrie[c].route != NULL)
+        {
+            best = rttrie[c].route;
+        }
+        n = c;
+    }
+    return best;
+}
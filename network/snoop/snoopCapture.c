@@ -4,6 +4,7 @@
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
+#include <bufpool.h>
 #include <snoop.h>
 
 /**
@@ -38,10 +39,12 @@ int snoopCapture(struct snoop *cap, struct packet *pkt)
     /* Increment count of packets matching filter */
     cap->nmatch++;
 
-    /* Try to get a buffer to put packet into */
-    buf = netGetbuf();
+    /* Try to get a buffer to put packet into, without waiting for one or
+     * taking those kept for packets that cannot be dropped */
+    buf = bufgetnb(netpool);
     if (SYSERR == (int)buf)
     {
+        cap->novrn++;
         SNOOP_TRACE("Failed to get buffer");
         return SYSERR;
     }
@@ -55,8 +58,10 @@ int snoopCapture(struct snoop *cap, struct packet *pkt)
     {
         len = cap->caplen;
     }
-    memcpy(buf->data, pkt->curr, len);
+    netGather(buf->data, pkt, 0, len);
     buf->curr = buf->data;
+    buf->segs = NULL;
+    buf->seglen = 0;
 
     /* Queue packet */
     if (mailboxCount(cap->queue) >= SNOOP_QLEN)
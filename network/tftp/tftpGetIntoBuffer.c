@@ -65,7 +65,7 @@ syscall tftpGetIntoBuffer(const char *filename, const struct netaddr *local_ip,
     }
 
     /* Allocate the head of the block list.  */
-    head = memget(TFTP_FILE_DATA_BLOCK_SIZE);
+    head = slabget(TFTP_FILE_DATA_BLOCK_SIZE);
     if (SYSERR == (int)head)
     {
         TFTP_TRACE("Out of memory.");
@@ -124,7 +124,7 @@ syscall tftpGetIntoBuffer(const char *filename, const struct netaddr *local_ip,
             memcpy(&finalbuf[totallen], ptr->data, ptr->bytes_filled);
         }
         totallen += ptr->bytes_filled;
-        memfree(ptr, TFTP_FILE_DATA_BLOCK_SIZE);
+        slabfree(ptr, TFTP_FILE_DATA_BLOCK_SIZE);
     } while (NULL != next);
 
     /* If successful, save the file length in the caller-provided location.  */
@@ -159,7 +159,7 @@ static int tftpCopyIntoBufferCb(const uchar *data, uint len, void *ctx)
         if (tail->bytes_filled == sizeof(tail->data))
         {
             /* Tail block is full; append a new block.  */
-            newtail = memget(TFTP_FILE_DATA_BLOCK_SIZE);
+            newtail = slabget(TFTP_FILE_DATA_BLOCK_SIZE);
             if (SYSERR == (int)newtail)
             {
                 TFTP_TRACE("Out of memory.");
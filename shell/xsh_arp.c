@@ -64,6 +64,8 @@ shellcmd xsh_arp(int nargs, char *args[])
             printf("%s\r\n", pdev->name);
         }
     }
+    printf("\r\n%u packets waited for resolution, %u sent, %u dropped\r\n",
+           arpstats.queued, arpstats.sent, arpstats.dropped);
 
     return OK;
 }
@@ -5,6 +5,8 @@
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
+#include <bufpool.h>
+#include <interrupt.h>
 #include <platform.h>
 #include <mips.h>
 #include <memory.h>
@@ -18,6 +20,8 @@
 #define PRINT_KERNEL  0x02
 #define PRINT_REGION  0x04
 #define PRINT_THREAD  0x08
+#define PRINT_SLAB    0x10
+#define PRINT_POOL    0x20
 
 extern char *maxaddr;
 extern void _start(void);
@@ -26,16 +30,21 @@ static void printMemUsage(void);
 static void printRegAllocList(void);
 static void printRegFreeList(void);
 static void printFreeList(struct memblock *, char *);
+static void printHeapFreeList(void);
+static void printSlabStats(void);
+static void printPoolStats(void);
 
 static void usage(char *command)
 {
-    printf("Usage: %s [-r] [-k] [-q] [-t <TID>]\n\n", command);
+    printf("Usage: %s [-r] [-k] [-s] [-b] [-q] [-t <TID>]\n\n", command);
     printf("Description:\n");
     printf("\tDisplays the current memory usage and prints the\n");
     printf("\tfree list.\n");
     printf("Options:\n");
     printf("\t-r\t\tprint region allocated and free lists\n");
     printf("\t-k\t\tprint kernel free list\n");
+    printf("\t-s\t\tprint slab allocator size classes\n");
+    printf("\t-b\t\tprint buffer pool usage\n");
     printf("\t-q\t\tsuppress current system memory usage screen\n");
     printf("\t-t <TID>\tprint user free list of thread id tid\n");
     printf("\t--help\t\tdisplay this help and exit\n");
@@ -89,6 +98,14 @@ shellcmd xsh_memstat(int nargs, char *args[])
         {
             print |= PRINT_KERNEL;
         }
+        else if (0 == strcmp(args[i], "-s"))
+        {
+            print |= PRINT_SLAB;
+        }
+        else if (0 == strcmp(args[i], "-b"))
+        {
+            print |= PRINT_POOL;
+        }
         else if (0 == strcmp(args[i], "-q"))
         {
             print &= ~(PRINT_DEFAULT);
@@ -108,7 +125,17 @@ shellcmd xsh_memstat(int nargs, char *args[])
 
     if (print & PRINT_KERNEL)
     {
-        printFreeList(&memlist, "kernel");
+        printHeapFreeList();
+    }
+
+    if (print & PRINT_SLAB)
+    {
+        printSlabStats();
+    }
+
+    if (print & PRINT_POOL)
+    {
+        printPoolStats();
     }
 
     if (print & PRINT_THREAD)
@@ -135,8 +162,9 @@ static void printMemUsage(void)
     uint stack = 0;             /* total stack memory             */
     uint kheap = 0;             /* total kernel heap memory       */
     uint kused = 0;             /* total used kernel heap memory  */
-    uint kfree = 0;             /* total free memory              */
-    struct memblock *block;     /* memory block pointer           */
+    uint kfree = 0;             /* free memory that can be allocated */
+    struct memhdr *block;       /* block of the kernel heap       */
+    irqmask im;
 #ifdef UHEAP_SIZE
     uint uheap = 0;             /* total user heap memory         */
     uint uused = 0;             /* total used user heap memory    */
@@ -166,11 +194,19 @@ static void printMemUsage(void)
         }
     }
 
-    /* Calculate amount of free kernel memory */
-    for (block = memlist.next; block != NULL; block = block->next)
+    /* Calculate amount of free kernel memory that can be allocated: each
+     * free block less its header.  (memlist.length also counts the headers
+     * of all blocks, which can never be handed out.) */
+    im = disable();
+    for (block = (struct memhdr *)memheap; block != NULL;
+         block = memislast(block) ? NULL : memnext(block))
     {
-        kfree += block->length;
+        if (block->size & MEM_FREE)
+        {
+            kfree += memsize(block) - MEMHDRSIZE;
+        }
     }
+    restore(im);
 
     /* Caculate amount of kernel heap memory */
     kheap = phys - resrv - code - stack;
@@ -204,7 +240,8 @@ static void printMemUsage(void)
     printf("%10d bytes system area\n", resrv);
     printf("%10d bytes Xinu code\n", code);
     printf("%10d bytes stack space\n", stack);
-    printf("%10d bytes kernel heap space (%d used)\n", kheap, kused);
+    printf("%10d bytes kernel heap space (%d used, %d free to allocate)\n",
+           kheap, kused, kfree);
 #ifdef UHEAP_SIZE
     printf("%10d bytes user heap space (%d used)\n", uheap, uused);
 #endif                          /* UHEAP_SIZE */
@@ -282,3 +319,77 @@ static void printFreeList(struct memblock *base, char *ident)
     }
     printf("\n");
 }
+
+/**
+ * Dump the free blocks of the kernel heap in address order.
+ */
+static void printHeapFreeList(void)
+{
+    struct memhdr *block;
+
+    printf("Free List (kernel):\n");
+    printf("BLOCK START  LENGTH  \n");
+    printf("-----------  --------\n");
+    for (block = (struct memhdr *)memheap; block != NULL;
+         block = memislast(block) ? NULL : memnext(block))
+    {
+        if (block->size & MEM_FREE)
+        {
+            printf("0x%08lX   %8u\n", (ulong)block, memsize(block));
+        }
+    }
+    printf("\n");
+}
+
+/**
+ * Dump the per-size-class counters of the slab allocator.  Waste is the
+ * internal fragmentation of objects in use, i.e. the bytes by which their
+ * size class exceeds what was requested; free is the number of objects
+ * in the class's slabs that are not in use.
+ */
+static void printSlabStats(void)
+{
+    int i;
+    struct slabclass *cls;
+
+    printf("Slab Size Classes:\n");
+    printf(" SIZE  SLABS  IN USE    FREE      HITS    MISSES   WASTE\n");
+    printf("-----  -----  ------  ------  --------  --------  ------\n");
+    for (i = 0; i < NSLABCLASS; i++)
+    {
+        cls = &slabtab[i];
+        printf("%5u  %5u  %6u  %6u  %8u  %8u  %6u\n",
+               cls->size, cls->nslab, cls->inuse,
+               cls->nslab * cls->nobj - cls->inuse, cls->hits,
+               cls->misses, cls->inuse * cls->size - cls->reqbytes);
+    }
+    printf("\n");
+}
+
+/**
+ * Dump the counters of the buffer pools in use.  Hiwat is the most buffers
+ * ever in use at once; waits are bufget() calls that found the pool empty;
+ * drops are bufgetnb() calls that found no buffer beyond those reserved.
+ */
+static void printPoolStats(void)
+{
+    int i;
+    struct bfpentry *bfpptr;
+
+    printf("Buffer Pools:\n");
+    printf("ID  BUFSIZE   NBUF  IN USE   HIWAT  RESERVE     WAITS     DROPS\n");
+    printf("--  -------  -----  ------  ------  -------  --------  --------\n");
+    for (i = 0; i < NPOOL; i++)
+    {
+        bfpptr = &bfptab[i];
+        if (BFPUSED != bfpptr->state)
+        {
+            continue;
+        }
+        printf("%2d  %7u  %5u  %6u  %6u  %7u  %8u  %8u\n", i,
+               bfpptr->bufsize - sizeof(struct poolbuf), bfpptr->nbuf,
+               bfpptr->nused, bfpptr->hiwat, bfpptr->reserve,
+               bfpptr->nwait, bfpptr->ndrop);
+    }
+    printf("\n");
+}
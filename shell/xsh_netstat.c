@@ -5,12 +5,14 @@
 /* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
 
 #include <stddef.h>
+#include <bufpool.h>
 #include <stdio.h>
 #include <string.h>
 #include <network.h>
 
 #if NETHER
 static void netStat(struct netif *);
+static void poolStat(const char *, int);
 
 /**
  * @ingroup shell
@@ -30,7 +32,9 @@ shellcmd xsh_netstat(int nargs, char *args[])
     {
         printf("Usage: %s\n\n", args[0]);
         printf("Description:\n");
-        printf("\tDisplays Network Information\n");
+        printf("\tDisplays Network Information, including the use of the\n");
+        printf("\tpools of packets received and sent and the packets each\n");
+        printf("\treceive thread has handled and has queued\n");
         printf("Options:\n");
         printf("\t--help\tdisplay this help and exit\n");
         return OK;
@@ -61,6 +65,8 @@ shellcmd xsh_netstat(int nargs, char *args[])
     i = 0;
     netStat(NULL);
 #endif
+    printf("Packets sent:\n");
+    poolStat("Tx Pool", netpool);
 
     return OK;
 }
@@ -68,6 +74,8 @@ shellcmd xsh_netstat(int nargs, char *args[])
 static void netStat(struct netif *netptr)
 {
     device *pdev;
+    struct netRxq *rxq;
+    uint i;
     char strA[20];
     char strB[20];
 
@@ -96,7 +104,37 @@ static void netStat(struct netif *netptr)
            netptr->linkhdrlen);
     printf("\t");
     printf("Num Rcv: %-15d   Num Proc: %d\n", netptr->nin, netptr->nproc);
+    poolStat("Rx Pool", netptr->rxpool);
+    if (netptr->poll)
+    {
+        printf("\t");
+        printf("Rx Polled: %u interrupts, %u polls (budget %u)\n",
+               netptr->nrxintr, netptr->npoll, NET_POLL_BUDGET);
+    }
+    for (i = 0; i < netptr->nthr; i++)
+    {
+        rxq = &netptr->rxq[i];
+        printf("\t");
+        printf("Rx Thread %u: %u pkts, %u wakeups, queue %u/%u (max %u), "
+               "%u drops\n", i, rxq->npkt, rxq->nsignal, rxq->count,
+               NET_RXQ_LEN, rxq->maxcount, rxq->ndrop);
+    }
 
     return;
 }
+
+static void poolStat(const char *name, int poolid)
+{
+    struct bfpentry *bfpptr;
+
+    if (isbadpool(poolid))
+    {
+        return;
+    }
+    bfpptr = &bfptab[poolid];
+    printf("\t");
+    printf("%s: %u/%u in use, %u most, %u reserved, %u waits, %u drops\n",
+           name, bfpptr->nused, bfpptr->nbuf, bfpptr->hiwat, bfpptr->reserve,
+           bfpptr->nwait, bfpptr->ndrop);
+}
 #endif /* NETHER */
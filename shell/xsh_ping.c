@@ -48,6 +48,7 @@ shellcmd xsh_ping(int nargs, char *args[])
     uint count = 10;
     uint num_recv = 0;
     int echoq;
+    int result;
     ulong min_rtt = ULONG_MAX, max_rtt = 0, total_rtt = 0;
     ulong startsec, startticks;
     ulong endsec, endticks;
@@ -143,7 +144,8 @@ shellcmd xsh_ping(int nargs, char *args[])
         ulong sendsec, sendticks;
 
         // Send ping packet
-        if (OK != icmpEchoRequest(&target, gettid(), i))
+        result = icmpEchoRequest(&target, gettid(), i);
+        if ((OK != result) && (NET_QUEUED != result))
         {
             printf("...Failed to reach %s\n", target_str);
             echoQueueDealloc(echoq);
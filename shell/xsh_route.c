@@ -157,6 +157,7 @@ shellcmd xsh_route(int nargs, char *args[])
             printf("%s\r\n", pdev->name);
         }
     }
+    printf("Routed packets dropped waiting for ARP: %u\r\n", rtnarpdrop);
 
     return 0;
 }
@@ -15,6 +15,7 @@
 #include <ipv4.h>
 #include <network.h>
 #include <ether.h>
+#include <tcp.h>
 
 #if NETHER
 static int argErr(char *command, char *arg)
@@ -34,8 +35,9 @@ static int argErr(char *command, char *arg)
  */
 shellcmd xsh_telnetserver(int nargs, char *args[])
 {
-    int descrp, port, i, spawntelnet;
+    int descrp, port, i, spawntelnet, listener;
     struct thrent *thrptr;
+    struct netif *interface;
     char thrname[TNMLEN];
 
     bzero(thrname, TNMLEN);
@@ -75,6 +77,12 @@ shellcmd xsh_telnetserver(int nargs, char *args[])
         }
 
 #if NTELNET
+        /* Stop listening, resetting connections not yet served */
+        if (telnetlistener != SYSERR)
+        {
+            close(telnetlistener);
+            telnetlistener = SYSERR;
+        }
         semfree(telnettab[0].killswitch);
         telnettab[0].killswitch = semcreate(0);
 #endif                          /* NTELNET */
@@ -131,15 +139,37 @@ shellcmd xsh_telnetserver(int nargs, char *args[])
         return SHELL_ERROR;
     }
 
-    /* spawn three servers */
 #if NTELNET
+    /* listen on the port, for the servers to accept connections from */
+    interface = netLookup(descrp);
+    if (NULL == interface)
+    {
+        fprintf(stderr, "%s: no network interface on device\n", args[0]);
+        return SHELL_ERROR;
+    }
+    listener = tcpAlloc();
+    if (SYSERR == (short)listener)
+    {
+        fprintf(stderr, "%s: failed to allocate TCP device\n", args[0]);
+        return SHELL_ERROR;
+    }
+    if (SYSERR == open(listener, &(interface->ip), NULL, port, NULL,
+                       TCP_LISTENER))
+    {
+        close(listener);
+        fprintf(stderr, "%s: failed to open TCP device\n", args[0]);
+        return SHELL_ERROR;
+    }
+    telnetlistener = listener;
+
+    /* spawn a server for each telnet device */
     for (i = 0; i < NTELNET; i++)
     {
         spawntelnet = telnetAlloc();
         sprintf(thrname, "telnetServ_%d", (spawntelnet - TELNET0));
         TELNET_TRACE("Spawning %s on %d", thrname, spawntelnet - TELNET0);
         ready(create((void *)telnetServer, INITSTK, INITPRIO, thrname,
-                     4, descrp, port, spawntelnet, "SHELL2"),
+                     3, listener, spawntelnet, "SHELL2"),
               RESCHED_YES);
     }
 #endif
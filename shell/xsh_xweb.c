@@ -68,6 +68,13 @@ shellcmd xsh_xweb(int nargs, char *args[])
             }
         }
 
+        /* Stop listening, resetting connections not yet served */
+        if (httplistener != SYSERR)
+        {
+            close(httplistener);
+            httplistener = SYSERR;
+        }
+
         /* Signal to kill any spawned threads */
         for (i = 0; i < NHTTP; i++)
         {
@@ -65,6 +65,11 @@ int bfpalloc(uint bufsize, uint nbuf)
 
     bfpptr->nbuf = nbuf;
     bfpptr->bufsize = bufsize;
+    bfpptr->reserve = 0;
+    bfpptr->nused = 0;
+    bfpptr->hiwat = 0;
+    bfpptr->nwait = 0;
+    bfpptr->ndrop = 0;
     bufptr = (struct poolbuf *)memget(nbuf * bufsize);
     if ((void *)SYSERR == bufptr)
     {
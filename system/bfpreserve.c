@@ -0,0 +1,41 @@
+/**
+ * @file bfpreserve.c
+ *
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <interrupt.h>
+#include <bufpool.h>
+
+/**
+ * @ingroup memory_mgmt
+ *
+ * Sets how many buffers of a buffer pool are reserved for bufget().
+ * bufgetnb() and bufgetn() do not take a buffer while no more than this
+ * many are free, so that callers that can drop what they would have put in
+ * it leave the last buffers for those that cannot.
+ *
+ * @param poolid
+ *      Identifier of the buffer pool, as returned by bfpalloc().
+ * @param nbuf
+ *      Number of buffers to reserve, less than the number in the pool.
+ *
+ * @return
+ *      ::OK if the reservation was set; otherwise ::SYSERR.
+ */
+syscall bfpreserve(int poolid, uint nbuf)
+{
+    irqmask im;
+
+    im = disable();
+    if (isbadpool(poolid) || (nbuf >= bfptab[poolid].nbuf))
+    {
+        restore(im);
+        return SYSERR;
+    }
+    bfptab[poolid].reserve = nbuf;
+    restore(im);
+
+    return OK;
+}
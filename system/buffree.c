@@ -45,8 +45,67 @@ syscall buffree(void *buffer)
     im = disable();
     bufptr->next = bfpptr->next;
     bfpptr->next = bufptr;
+    bfpptr->nused--;
     restore(im);
     signaln(bfpptr->freebuf, 1);
 
     return OK;
 }
+
+/**
+ * @ingroup memory_mgmt
+ *
+ * Return several buffers to their buffer pools, waking the threads waiting
+ * for them once per run of buffers from the same pool.
+ *
+ * @param buffers
+ *      Addresses of the buffers to free, as returned by bufget(), bufgetnb()
+ *      or bufgetn().
+ * @param nbuf
+ *      Number of buffers.
+ *
+ * @return
+ *      ::OK if every buffer was successfully freed; otherwise ::SYSERR, in
+ *      which case the buffers after the first bad one are not freed.
+ */
+syscall buffreen(void **buffers, uint nbuf)
+{
+    struct bfpentry *bfpptr;
+    struct poolbuf *bufptr;
+    irqmask im;
+    uint i, run;
+    int poolid;
+
+    im = disable();
+    poolid = SYSERR;
+    run = 0;
+    for (i = 0; i < nbuf; i++)
+    {
+        bufptr = ((struct poolbuf *)buffers[i]) - 1;
+        if (isbadpool(bufptr->poolid) || (bufptr->next != bufptr))
+        {
+            break;
+        }
+
+        /* Wake waiters for the run of buffers before this one */
+        if ((bufptr->poolid != poolid) && (run > 0))
+        {
+            signaln(bfptab[poolid].freebuf, run);
+            run = 0;
+        }
+        poolid = bufptr->poolid;
+
+        bfpptr = &bfptab[poolid];
+        bufptr->next = bfpptr->next;
+        bfpptr->next = bufptr;
+        bfpptr->nused--;
+        run++;
+    }
+    if (run > 0)
+    {
+        signaln(bfptab[poolid].freebuf, run);
+    }
+    restore(im);
+
+    return (i == nbuf) ? OK : SYSERR;
+}
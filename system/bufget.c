@@ -38,9 +38,17 @@ void *bufget(int poolid)
     bfpptr = &bfptab[poolid];
 
     im = disable();
+    if (semcount(bfpptr->freebuf) <= 0)
+    {
+        bfpptr->nwait++;
+    }
     wait(bfpptr->freebuf);
     bufptr = bfpptr->next;
     bfpptr->next = bufptr->next;
+    if (++bfpptr->nused > bfpptr->hiwat)
+    {
+        bfpptr->hiwat = bfpptr->nused;
+    }
     restore(im);
 
     bufptr->next = bufptr;
@@ -0,0 +1,103 @@
+/**
+ * @file bufgetnb.c
+ *
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <semaphore.h>
+#include <interrupt.h>
+#include <bufpool.h>
+
+/**
+ * @ingroup memory_mgmt
+ *
+ * Allocate a buffer from a buffer pool without waiting.  The buffers the
+ * pool reserves, as set with bfpreserve(), are left for bufget(), so that
+ * traffic that can be dropped does not take the last of them.  A request
+ * that finds no buffer is counted in the pool's drops.  The returned buffer
+ * must be freed with buffree() when the calling code is finished with it.
+ *
+ * @param poolid
+ *      Identifier of the buffer pool, as returned by bfpalloc().
+ *
+ * @return
+ *      If @p poolid does not specify a valid buffer pool, or no more than
+ *      the reserved buffers are free, returns ::SYSERR; otherwise returns a
+ *      pointer to the resulting buffer.
+ */
+void *bufgetnb(int poolid)
+{
+    void *buffer;
+    irqmask im;
+
+    if (1 == bufgetn(poolid, &buffer, 1))
+    {
+        return buffer;
+    }
+
+    if (!isbadpool(poolid))
+    {
+        im = disable();
+        bfptab[poolid].ndrop++;
+        restore(im);
+    }
+    return (void *)SYSERR;
+}
+
+/**
+ * @ingroup memory_mgmt
+ *
+ * Allocate up to a number of buffers from a buffer pool without waiting,
+ * as bufgetnb() does, under one disabling of interrupts.  Getting fewer
+ * buffers than asked for is not counted as a drop, since callers such as
+ * one filling a burst carry on with what they got.
+ *
+ * @param poolid
+ *      Identifier of the buffer pool, as returned by bfpalloc().
+ * @param buffers
+ *      Array in which to store pointers to the buffers allocated.
+ * @param nbuf
+ *      Number of buffers wanted.
+ *
+ * @return
+ *      Number of buffers allocated, at the start of @p buffers; 0 if
+ *      @p poolid does not specify a valid buffer pool.
+ */
+uint bufgetn(int poolid, void **buffers, uint nbuf)
+{
+    struct bfpentry *bfpptr;
+    struct poolbuf *bufptr;
+    irqmask im;
+    uint i;
+
+    if (isbadpool(poolid))
+    {
+        return 0;
+    }
+
+    bfpptr = &bfptab[poolid];
+
+    im = disable();
+    for (i = 0; i < nbuf; i++)
+    {
+        /* A count above the reserve means wait() returns at once */
+        if (semcount(bfpptr->freebuf) <= (int)bfpptr->reserve)
+        {
+            break;
+        }
+        wait(bfpptr->freebuf);
+        bufptr = bfpptr->next;
+        bfpptr->next = bufptr->next;
+        bufptr->next = bufptr;
+        buffers[i] = bufptr + 1;    /* +1 to skip past accounting structure */
+        bfpptr->nused++;
+    }
+    if (bfpptr->nused > bfpptr->hiwat)
+    {
+        bfpptr->hiwat = bfpptr->nused;
+    }
+    restore(im);
+
+    return i;
+}
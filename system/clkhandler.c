@@ -14,6 +14,137 @@
 void wakeup(void);
 int resched(void);
 
+/** @ingroup timer
+ * Number of timer interrupts that have occurred since boot.  */
+ulong clkintrs;
+
+/** @ingroup timer
+ * Number of timer interrupts that arrived while the null thread was idle.  */
+ulong clkidlewakes;
+
+#if TICKLESS
+
+/** @ingroup timer
+ * TRUE while the timer is not simply ticking every ::CLKTICKS_PER_SEC, in
+ * which case resched() must re-evaluate the deadline.  */
+bool clkoneshot;
+
+/** @ingroup timer
+ * Value of clkcount() at the last tick accounted for in ::clkticks.  */
+ulong clklast;
+
+static ulong clknext;           /* clkcount() at programmed deadline     */
+
+/* Return TRUE if the thread that resched() would pick next has to share
+ * the processor with another ready thread of the same priority.  */
+static bool clkcontended(void)
+{
+    struct thrent *thrptr = &thrtab[thrcurrent];
+    int level;
+    tid_typ first;
+
+    level = rdyhighest();
+    if (EMPTY == level)
+    {
+        return FALSE;
+    }
+    first = firstid(rdyqueue(level));
+
+    if (THRCURR == thrptr->state)
+    {
+        /* current thread either keeps running alone or ties the head */
+        if (thrptr->prio > quetab[first].key)
+        {
+            return FALSE;
+        }
+        if (thrptr->prio == quetab[first].key)
+        {
+            return TRUE;
+        }
+    }
+
+    /* the head of the level runs; is anyone else on that level? */
+    return (quetab[first].next < NTHREAD);
+}
+
+/**
+ * @ingroup timer
+ *
+ * Bring ::clkticks, ::clktime and the timing wheel up to date with the
+ * free-running counter.  Any number of ticks may have passed since the last
+ * timer interrupt; they are all accounted at once.  Expired sleepers are
+ * left on ::tmrwakeq for wakeup().  Interrupts must be disabled.
+ */
+void clkcatchup(void)
+{
+    ulong cpt = platform.clkfreq / CLKTICKS_PER_SEC;
+    ulong ticks;
+
+    ticks = (clkcount() - clklast) / cpt;
+    if (0 == ticks)
+    {
+        return;
+    }
+    clklast += ticks * cpt;
+
+    clkticks += ticks;
+    if (clkticks >= CLKTICKS_PER_SEC)
+    {
+        clktime += clkticks / CLKTICKS_PER_SEC;
+        clkticks %= CLKTICKS_PER_SEC;
+    }
+
+    tmradvance(ticks);
+}
+
+/**
+ * @ingroup timer
+ *
+ * Program the next timer interrupt.  If another thread is competing for the
+ * processor the next tick is needed for preemption; otherwise the interrupt
+ * is deferred until the timing wheel has work, up to ::CLKTICKS_MAXIDLE.
+ * Deadlines stay on the tick grid so that clkcatchup() loses no time.
+ * Interrupts must be disabled.
+ */
+void clkdeadline(void)
+{
+    ulong cpt = platform.clkfreq / CLKTICKS_PER_SEC;
+    ulong ticks, next;
+    long cycles;
+
+    ticks = 1;
+    if (!clkcontended())
+    {
+        ticks = tmrnext();
+        if (ticks > CLKTICKS_MAXIDLE)
+        {
+            ticks = CLKTICKS_MAXIDLE;
+        }
+        else if (0 == ticks)
+        {
+            ticks = 1;
+        }
+    }
+
+    next = clklast + ticks * cpt;
+    clkoneshot = (ticks > 1);
+    if (next == clknext)
+    {
+        return;
+    }
+    clknext = next;
+
+    /* A deadline already passed (or about to) fires as soon as possible. */
+    cycles = (long)(next - clkcount());
+    if (cycles < (long)(cpt >> 3))
+    {
+        cycles = cpt >> 3;
+    }
+    clkset(cycles);
+}
+
+#endif                          /* TICKLESS */
+
 /**
  * @ingroup timer
  *
@@ -21,9 +152,35 @@ int resched(void);
  * timer interrupt to occur at some point in the future, then updates ::clktime
  * and ::clkticks, then wakes sleeping threads if there are any, otherwise
  * reschedules the processor.
+ *
+ * In dynamic tick mode the interrupt may arrive many ticks after the previous
+ * one; the elapsed ticks are accounted all at once and the next deadline is
+ * left for resched() to choose once it knows which thread runs next.
  */
 interrupt clkhandler(void)
 {
+    clkintrs++;
+    if (NULLTHREAD == thrcurrent)
+    {
+        clkidlewakes++;
+    }
+
+#if TICKLESS
+    clkcatchup();
+
+    /* The one-shot has expired; make resched() arm the next one. */
+    clkoneshot = TRUE;
+    clknext = clklast;
+
+    if (nonempty(tmrwakeq))
+    {
+        wakeup();
+    }
+    else
+    {
+        resched();
+    }
+#else
     clkupdate(platform.clkfreq / CLKTICKS_PER_SEC);
 
     /* Another clock tick passes. */
@@ -36,9 +193,10 @@ interrupt clkhandler(void)
         clkticks = 0;
     }
 
-    /* If sleepq is not empty, decrement first key.   */
-    /* If key reaches zero, call wakeup.              */
-    if (nonempty(sleepq) && (--firstkey(sleepq) <= 0))
+    /* Advance the timing wheel.  If any timed     */
+    /* wait has ended, call wakeup.                */
+    tmradvance(1);
+    if (nonempty(tmrwakeq))
     {
         wakeup();
     }
@@ -46,6 +204,7 @@ interrupt clkhandler(void)
     {
         resched();
     }
+#endif                          /* TICKLESS */
 }
 
 #endif /* RTCLOCK */
@@ -27,9 +27,6 @@ volatile ulong clkticks;
  * Number of seconds that have elapsed since the system booted.  */
 volatile ulong clktime;
 
-/** Queue of sleeping processes.  */
-qid_typ sleepq;
-
 /* TODO: Get rid of ugly x86 ifdef.  */
 #ifdef _XINU_PLATFORM_X86_
 extern void clockIRQ(void);
@@ -41,11 +38,11 @@ ulong time_intr_freq = 0;     /** frequency of XINU clock interrupt   */
 /**
  * @ingroup timer
  *
- * Initialize the clock and sleep queue.  This function is called at startup.
+ * Initialize the clock and timing wheel.  This function is called at startup.
  */
 void clkinit(void)
 {
-    sleepq = queinit();         /* initialize sleep queue       */
+    tmrinit();                  /* initialize timing wheel      */
 
     clkticks = 0;
 
@@ -67,8 +64,14 @@ void clkinit(void)
     /* register clock interrupt */
     interruptVector[IRQ_TIMER] = clkhandler;
     enable_irq(IRQ_TIMER);
+#if TICKLESS
+    clklast = clkcount();
+    clkoneshot = TRUE;
+    clkdeadline();
+#else
     clkupdate(platform.clkfreq / CLKTICKS_PER_SEC);
 #endif
+#endif
 }
 
 #endif                          /* RTCLOCK */
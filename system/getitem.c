@@ -65,11 +65,20 @@ tid_typ getlast(qid_typ q)
 tid_typ getitem(tid_typ tid)
 {
     tid_typ prev, next;
+    int level;
 
     next = quetab[tid].next;
     prev = quetab[tid].prev;
     quetab[prev].next = next;
     quetab[next].prev = prev;
+
+    /* a ready list level that just emptied drops out of the bitmap */
+    if ((next == prev + 1) && isrdyqueue(prev))
+    {
+        level = (prev - readylist) >> 1;
+        rdymap[level >> 5] &= ~(1 << (level & 0x1f));
+    }
+
     quetab[tid].next = EMPTY;
     quetab[tid].prev = EMPTY;
     return tid;
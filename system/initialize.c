@@ -96,7 +96,6 @@ static int sysinit(void)
 {
     int i;
     struct thrent *thrptr;      /* thread control block pointer  */
-    struct memblock *pmblock;   /* memory block pointer          */
 
     /* Initialize system variables */
     /* Count this NULLTHREAD as the first thread in the system. */
@@ -105,10 +104,7 @@ static int sysinit(void)
     /* Initialize free memory list */
     memheap = roundmb(memheap);
     platform.maxaddr = truncmb(platform.maxaddr);
-    memlist.next = pmblock = (struct memblock *)memheap;
-    memlist.length = (uint)(platform.maxaddr - memheap);
-    pmblock->next = NULL;
-    pmblock->length = (uint)(platform.maxaddr - memheap);
+    meminit();
 
     /* Initialize thread table */
     for (i = 0; i < NTHREAD; i++)
@@ -148,7 +144,7 @@ static int sysinit(void)
     }
 
     /* initialize thread ready list */
-    readylist = queinit();
+    readylist = rdyinit();
 
 #if SB_BUS
     backplaneInit(NULL);
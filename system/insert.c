@@ -11,7 +11,8 @@
 /**
  * @ingroup threads
  *
- * Insert a thread into a queue in descending key order.
+ * Insert a thread into a queue in descending key order.  Insertions into
+ * the readylist are passed to rdyinsert(), which uses the key as priority.
  * @param tid    thread ID to insert
  * @param q      target queue
  * @param key    sorting key
@@ -27,6 +28,11 @@ int insert(tid_typ tid, qid_typ q, int key)
         return SYSERR;
     }
 
+    if (q == readylist)
+    {
+        return rdyinsert(tid, key);
+    }
+
     next = quetab[quehead(q)].next;
     while (quetab[next].key >= key)
     {
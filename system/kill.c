@@ -48,6 +48,7 @@ syscall kill(tid_typ tid)
     switch (thrptr->state)
     {
     case THRSLEEP:
+    case THRTMOUT:
         unsleep(tid);
         thrptr->state = THRFREE;
         break;
@@ -11,7 +11,9 @@
 /**
  * @ingroup memory_mgmt
  *
- * Frees a block of heap-allocated memory.
+ * Frees a block of heap-allocated memory.  The boundary tags of the
+ * neighbouring blocks tell whether they can be merged with it, so this
+ * takes constant time.
  *
  * @param memptr
  *      Pointer to memory block allocated with memget().
@@ -22,73 +24,73 @@
  * @return
  *      ::OK on success; ::SYSERR on failure.  This function can only fail
  *      because of memory corruption or specifying an invalid memory block.
+ *      Only whole blocks returned by memget() can be freed.
  */
 syscall memfree(void *memptr, uint nbytes)
 {
-    register struct memblock *block, *next, *prev;
+    struct memhdr *block, *next;
+    uint size;
     irqmask im;
-    ulong top;
 
     /* make sure block is in heap */
     if ((0 == nbytes)
-        || ((ulong)memptr < (ulong)memheap)
-        || ((ulong)memptr > (ulong)platform.maxaddr))
+        || ((ulong)memptr < (ulong)memheap + MEMHDRSIZE)
+        || ((ulong)memptr > (ulong)platform.maxaddr)
+        || ((ulong)memptr & (MEMHDRSIZE - 1)))
     {
         return SYSERR;
     }
 
-    block = (struct memblock *)memptr;
+    block = (struct memhdr *)((ulong)memptr - MEMHDRSIZE);
     nbytes = (ulong)roundmb(nbytes);
 
     im = disable();
 
-    prev = &memlist;
-    next = memlist.next;
-    while ((next != NULL) && (next < block))
+    /* make sure this is an allocated block of the length given */
+    size = memsize(block) - MEMHDRSIZE;
+    if (block->size & MEM_SLACK)
     {
-        prev = next;
-        next = next->next;
+        size -= MEMHDRSIZE;
     }
-
-    /* find top of previous memblock */
-    if (prev == &memlist)
-    {
-        top = NULL;
-    }
-    else
-    {
-        top = (ulong)prev + prev->length;
-    }
-
-    /* make sure block is not overlapping on prev or next blocks */
-    if ((top > (ulong)block)
-        || ((next != NULL) && ((ulong)block + nbytes) > (ulong)next))
+    if ((block->size & MEM_FREE) || (size != nbytes))
     {
         restore(im);
         return SYSERR;
     }
 
     memlist.length += nbytes;
+    block->size &= ~MEM_SLACK;
 
-    /* coalesce with previous block if adjacent */
-    if (top == (ulong)block)
+    /* coalesce with previous block if free */
+    if (block->size & MEM_PREVFREE)
     {
-        prev->length += nbytes;
-        block = prev;
+        size = memsize(block);
+        block = block->prevphys;
+        memunlink(block);
+        block->size += size;
     }
-    else
+
+    /* coalesce with next block if free */
+    if (!memislast(block))
     {
-        block->next = next;
-        block->length = nbytes;
-        prev->next = block;
+        next = memnext(block);
+        if (next->size & MEM_FREE)
+        {
+            memunlink(next);
+            block->size += memsize(next);
+        }
     }
 
-    /* coalesce with next block if adjacent */
-    if (((ulong)block + block->length) == (ulong)next)
+    if (memislast(block))
+    {
+        memctl.last = block;
+    }
+    else
     {
-        block->length += next->length;
-        block->next = next->next;
+        memnext(block)->prevphys = block;
     }
+
+    memlink(block);
     restore(im);
     return OK;
 }
@@ -7,10 +7,43 @@
 #include <interrupt.h>
 #include <memory.h>
 
+/* Allocate the first need bytes of a free block and give any usable
+ * remainder back to the free lists. */
+static void *memtake(struct memhdr *block, uint need)
+{
+    struct memhdr *rest;
+    uint size;
+
+    memunlink(block);
+    size = memsize(block);
+    if (size - need >= MEMMINBLK)
+    {
+        rest = (struct memhdr *)((ulong)block + need);
+        rest->prevphys = block;
+        rest->size = size - need;
+        block->size = need | (block->size & MEM_FLAGS);
+        if (memislast(rest))
+        {
+            memctl.last = rest;
+        }
+        else
+        {
+            memnext(rest)->prevphys = rest;
+        }
+        memlink(rest);
+    }
+    else if (size != need)
+    {
+        block->size |= MEM_SLACK;
+    }
+    return (void *)((ulong)block + MEMHDRSIZE);
+}
+
 /**
  * @ingroup memory_mgmt
  *
- * Allocate heap memory.
+ * Allocate heap memory.  Takes constant time regardless of how fragmented
+ * the heap is.
  *
  * @param nbytes
  *      Number of bytes requested.
@@ -23,10 +56,11 @@
  */
 void *memget(uint nbytes)
 {
-    register struct memblock *prev, *curr, *leftover;
+    struct memhdr *block;
+    void *memptr;
     irqmask im;
 
-    if (0 == nbytes)
+    if ((0 == nbytes) || (nbytes > (uint)~0 - 2 * MEMMINBLK))
     {
         return (void *)SYSERR;
     }
@@ -36,33 +70,92 @@ void *memget(uint nbytes)
 
     im = disable();
 
-    prev = &memlist;
-    curr = memlist.next;
-    while (curr != NULL)
+    block = memfind(nbytes + MEMHDRSIZE);
+    if (NULL == block)
     {
-        if (curr->length == nbytes)
-        {
-            prev->next = curr->next;
-            memlist.length -= nbytes;
+        restore(im);
+        return (void *)SYSERR;
+    }
+    memptr = memtake(block, nbytes + MEMHDRSIZE);
+    memlist.length -= nbytes;
+
+    restore(im);
+    return memptr;
+}
+
+/**
+ * @ingroup memory_mgmt
+ *
+ * Allocate heap memory at an address that is a multiple of @p align.  The
+ * block is freed with memfree() like any other.
+ *
+ * @param nbytes
+ *      Number of bytes requested.
+ * @param align
+ *      Required alignment, a power of two.
+ *
+ * @return
+ *      ::SYSERR if @p nbytes was 0 or there is no memory to satisfy the
+ *      request; otherwise returns a pointer to the allocated memory region.
+ */
+void *memgetalign(uint nbytes, uint align)
+{
+    struct memhdr *block, *lead;
+    ulong memptr, gap;
+    void *result;
+    irqmask im;
+
+    if (align <= MEMHDRSIZE)
+    {
+        return memget(nbytes);
+    }
+    if ((0 == nbytes) || (nbytes > (uint)~0 - 2 * MEMMINBLK - 2 * align))
+    {
+        return (void *)SYSERR;
+    }
+
+    nbytes = (ulong)roundmb(nbytes);
+
+    im = disable();
+
+    /* room for the block plus a free block in front to align it */
+    block = memfind(nbytes + MEMHDRSIZE + MEMMINBLK + align);
+    if (NULL == block)
+    {
+        restore(im);
+        return (void *)SYSERR;
+    }
 
-            restore(im);
-            return (void *)(curr);
+    memptr = (ulong)block + MEMHDRSIZE;
+    gap = ((memptr + align - 1) & ~((ulong)align - 1)) - memptr;
+    if ((gap > 0) && (gap < MEMMINBLK))
+    {
+        gap += align;
+    }
+    if (gap > 0)
+    {
+        /* split off the unaligned front as a free block of its own */
+        memunlink(block);
+        lead = block;
+        block = (struct memhdr *)((ulong)lead + gap);
+        block->prevphys = lead;
+        block->size = memsize(lead) - gap;
+        lead->size = gap | (lead->size & MEM_FLAGS);
+        if (memislast(block))
+        {
+            memctl.last = block;
         }
-        else if (curr->length > nbytes)
+        else
         {
-            /* split block into two */
-            leftover = (struct memblock *)((ulong)curr + nbytes);
-            prev->next = leftover;
-            leftover->next = curr->next;
-            leftover->length = curr->length - nbytes;
-            memlist.length -= nbytes;
-
-            restore(im);
-            return (void *)(curr);
+            memnext(block)->prevphys = block;
         }
-        prev = curr;
-        curr = curr->next;
+        memlink(lead);
+        memlink(block);
     }
+
+    result = memtake(block, nbytes + MEMHDRSIZE);
+    memlist.length -= nbytes;
+
     restore(im);
-    return (void *)SYSERR;
+    return result;
 }
@@ -0,0 +1,187 @@
+/**
+ * @file meminit.c
+ *
+ * Free lists of the kernel heap.  A free block of size s lives on list
+ * (fl, sl), where fl selects the power of two below s and sl one of
+ * ::MEM_NSL equal slices above it; blocks smaller than 128 bytes use
+ * first level 0 with slices of 8 bytes.  No two free blocks are ever
+ * physically adjacent.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <platform.h>
+#include <memory.h>
+
+/** @ingroup memory_mgmt
+ * Free list heads and bitmaps of the kernel heap.  */
+struct memctl memctl;
+
+/* Index of the most significant set bit of a nonzero word. */
+#define fls(x)  (31 - __builtin_clz(x))
+
+/* Free list that holds blocks of the given size. */
+static void memmap(uint size, int *fl, int *sl)
+{
+    int f;
+
+    if (size < (1 << MEM_FLSHIFT))
+    {
+        *fl = 0;
+        *sl = size >> 3;
+    }
+    else
+    {
+        f = fls(size);
+        *fl = f - MEM_FLSHIFT + 1;
+        *sl = (size >> (f - MEM_SLBITS)) & (MEM_NSL - 1);
+    }
+}
+
+/**
+ * @ingroup memory_mgmt
+ *
+ * Initialize the kernel heap as one free block spanning ::memheap to
+ * platform::maxaddr, both 8-byte aligned.  ::memlist.length starts at the
+ * size of the heap and only changes by the sizes passed to memget() and
+ * memfree(), so it equals the bytes of free blocks plus the headers and
+ * slack of allocated ones.
+ */
+void meminit(void)
+{
+    struct memhdr *block;
+    int i, j;
+
+    memctl.flmap = 0;
+    for (i = 0; i < MEM_NFL; i++)
+    {
+        memctl.slmap[i] = 0;
+        for (j = 0; j < MEM_NSL; j++)
+        {
+            memctl.free[i][j] = NULL;
+        }
+    }
+
+    memctl.top = (ulong)platform.maxaddr;
+    block = (struct memhdr *)memheap;
+    block->prevphys = NULL;
+    block->size = memctl.top - (ulong)memheap;
+    memctl.last = block;
+    memlink(block);
+
+    memlist.next = NULL;
+    memlist.length = memsize(block);
+}
+
+/**
+ * @ingroup memory_mgmt
+ *
+ * Put a block on the free list for its size and mark it free.  Interrupts
+ * must be disabled.
+ * @param block  block to insert, with its size already set
+ */
+void memlink(struct memhdr *block)
+{
+    int fl, sl;
+
+    memmap(memsize(block), &fl, &sl);
+    block->prevfree = NULL;
+    block->nextfree = memctl.free[fl][sl];
+    if (block->nextfree != NULL)
+    {
+        block->nextfree->prevfree = block;
+    }
+    memctl.free[fl][sl] = block;
+    memctl.slmap[fl] |= 1 << sl;
+    memctl.flmap |= 1 << fl;
+
+    block->size |= MEM_FREE;
+    if (!memislast(block))
+    {
+        memnext(block)->size |= MEM_PREVFREE;
+    }
+}
+
+/**
+ * @ingroup memory_mgmt
+ *
+ * Take a free block off its free list and mark it allocated.  Interrupts
+ * must be disabled.
+ * @param block  free block to remove
+ */
+void memunlink(struct memhdr *block)
+{
+    int fl, sl;
+
+    memmap(memsize(block), &fl, &sl);
+    if (block->prevfree != NULL)
+    {
+        block->prevfree->nextfree = block->nextfree;
+    }
+    else
+    {
+        memctl.free[fl][sl] = block->nextfree;
+        if (NULL == block->nextfree)
+        {
+            memctl.slmap[fl] &= ~(1 << sl);
+            if (0 == memctl.slmap[fl])
+            {
+                memctl.flmap &= ~(1 << fl);
+            }
+        }
+    }
+    if (block->nextfree != NULL)
+    {
+        block->nextfree->prevfree = block->prevfree;
+    }
+
+    block->size &= ~MEM_FREE;
+    if (!memislast(block))
+    {
+        memnext(block)->size &= ~MEM_PREVFREE;
+    }
+}
+
+/**
+ * @ingroup memory_mgmt
+ *
+ * Find a free block of at least @p size bytes without searching any list.
+ * The size is rounded up to the next list boundary first, so that any
+ * block on the chosen list is large enough.  Interrupts must be disabled.
+ * @param size  block size needed, including header
+ * @return a free block, or NULL if none is large enough
+ */
+struct memhdr *memfind(uint size)
+{
+    uint round, map;
+    int fl, sl;
+
+    if (size >= (1 << MEM_FLSHIFT))
+    {
+        round = size + (1 << (fls(size) - MEM_SLBITS)) - 1;
+        if (round < size)
+        {
+            return NULL;
+        }
+        size = round;
+    }
+    memmap(size, &fl, &sl);
+
+    map = memctl.slmap[fl] & (~0U << sl);
+    if (0 == map)
+    {
+        if (fl + 1 >= MEM_NFL)
+        {
+            return NULL;
+        }
+        map = memctl.flmap & (~0U << (fl + 1));
+        if (0 == map)
+        {
+            return NULL;
+        }
+        fl = __builtin_ctz(map);
+        map = memctl.slmap[fl];
+    }
+    sl = __builtin_ctz(map);
+    return memctl.free[fl][sl];
+}
@@ -14,7 +14,8 @@
  * Although Embedded Xinu could make use of the periodic timer mode that is
  * available on the SP804 to eliminate the need to call clkupdate() every timer
  * interrupt, this driver uses the oneshot timer mode to be consistent with
- * other platforms which don't have periodic timers.
+ * other platforms which don't have periodic timers.  The oneshot mode is also
+ * what clkset() needs for dynamic tick (::TICKLESS) operation.
  */
 /* Embedded Xinu, Copyright (C) 2014.  All rights reserved. */
 
@@ -62,6 +63,13 @@ ulong clkcount(void)
 
 /* clkupdate() interface is documented in clock.h  */
 void clkupdate(ulong cycles)
+{
+    /* The oneshot timer always counts from now.  */
+    clkset(cycles);
+}
+
+/* clkset() interface is documented in clock.h  */
+void clkset(ulong cycles)
 {
     /* Clear the timer IRQ if pending.  */
     regs->timers[0].IntClr = 0;
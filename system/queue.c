@@ -40,7 +40,8 @@ tid_typ enqueue(tid_typ tid, qid_typ q)
 /**
  * @ingroup threads
  *
- * Remove and return the first thread on a list
+ * Remove and return the first thread on a list.  For the readylist this is
+ * the highest priority ready thread.
  * @param  q  target queue
  * @return thread id of removed thread, or EMPTY
  */
@@ -52,6 +53,10 @@ tid_typ dequeue(qid_typ q)
     {
         return SYSERR;
     }
+    if (q == readylist)
+    {
+        return rdydequeue();
+    }
     if (isempty(q))
     {
         return EMPTY;
@@ -0,0 +1,113 @@
+/**
+ * @file readylist.c
+ *
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <thread.h>
+#include <queue.h>
+
+uint rdymap[RDYMAPLEN];         /**< bitmap of non-empty ready levels */
+
+/* Find index of the highest set bit in a nonzero word. */
+static inline uint highest_set_bit(uint word)
+{
+    return 31 - __builtin_clz(word);
+}
+
+/**
+ * @ingroup threads
+ *
+ * Initialize the ready list as one FIFO queue per priority level.  The
+ * queues are allocated back to back so a level can be found from the
+ * readylist head by arithmetic alone.
+ * @return queue ID of the lowest priority level, or SYSERR
+ */
+qid_typ rdyinit(void)
+{
+    qid_typ q, first;
+    int i;
+
+    first = queinit();
+    for (i = 1; i < NPRIO; i++)
+    {
+        q = queinit();
+        if (SYSERR == q)
+        {
+            return SYSERR;
+        }
+    }
+    for (i = 0; i < RDYMAPLEN; i++)
+    {
+        rdymap[i] = 0;
+    }
+    return first;
+}
+
+/**
+ * @ingroup threads
+ *
+ * Insert a thread at the tail of its priority level in the ready list.
+ * Threads of equal priority are therefore served round-robin, as they
+ * were with the sorted list.  Priorities outside [0, NPRIO) share the
+ * lowest or highest level.
+ * @param tid   thread ID to insert
+ * @param prio  priority of the thread
+ * @return OK
+ */
+int rdyinsert(tid_typ tid, int prio)
+{
+    int level;
+
+    if (isbadtid(tid))
+    {
+        return SYSERR;
+    }
+
+    level = rdylevel(prio);
+    enqueue(tid, rdyqueue(level));
+    quetab[tid].key = prio;
+    rdymap[level >> 5] |= 1 << (level & 0x1f);
+    return OK;
+}
+
+/**
+ * @ingroup threads
+ *
+ * Find the highest priority level that has a ready thread.
+ * @return ready list level, or EMPTY if no thread is ready
+ */
+int rdyhighest(void)
+{
+    int i;
+
+    for (i = RDYMAPLEN - 1; i >= 0; i--)
+    {
+        if (0 != rdymap[i])
+        {
+            return (i << 5) + highest_set_bit(rdymap[i]);
+        }
+    }
+    return EMPTY;
+}
+
+/**
+ * @ingroup threads
+ *
+ * Remove and return the highest priority ready thread.
+ * @return thread id of removed thread, or EMPTY
+ */
+tid_typ rdydequeue(void)
+{
+    int level;
+
+    level = rdyhighest();
+    if (EMPTY == level)
+    {
+        return EMPTY;
+    }
+
+    /* getitem() clears the level's bitmap bit if it becomes empty */
+    return getfirst(rdyqueue(level));
+}
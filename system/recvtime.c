@@ -31,7 +31,10 @@ message recvtime(int maxwait)
     if (FALSE == thrptr->hasmsg)
     {
 #if RTCLOCK
-        if (SYSERR == insertd(thrcurrent, sleepq, maxwait))
+#if TICKLESS
+        clkcatchup();
+#endif
+        if (SYSERR == tmrinsert(thrcurrent, maxwait))
         {
             restore(im);
             return SYSERR;
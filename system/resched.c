@@ -24,6 +24,7 @@ int resdefer;                   /* >0 if rescheduling deferred */
 int resched(void)
 {
     uchar asid;                 /* address space identifier */
+    int level;                  /* highest non-empty ready level */
     struct thrent *throld;      /* old thread entry */
     struct thrent *thrnew;      /* new thread entry */
 
@@ -37,19 +38,30 @@ int resched(void)
 
     throld->intmask = disable();
 
+#if TICKLESS
+    /* Preemption may be needed sooner than the programmed deadline.  A
+     * deferred call is made again once rescheduling is allowed. */
+    if (clkoneshot)
+    {
+        clkdeadline();
+    }
+#endif
+
     if (THRCURR == throld->state)
     {
-        if (nonempty(readylist) && (throld->prio > firstkey(readylist)))
+        level = rdyhighest();
+        if ((EMPTY == level)
+            || (throld->prio > firstkey(rdyqueue(level))))
         {
             restore(throld->intmask);
             return OK;
         }
         throld->state = THRREADY;
-        insert(thrcurrent, readylist, throld->prio);
+        rdyinsert(thrcurrent, throld->prio);
     }
 
     /* get highest priority thread from ready list */
-    thrcurrent = dequeue(readylist);
+    thrcurrent = rdydequeue();
     thrnew = &thrtab[thrcurrent];
     thrnew->state = THRCURR;
 
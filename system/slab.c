@@ -0,0 +1,259 @@
+/**
+ * @file slab.c
+ *
+ * Size-class slab allocator.  Small requests are rounded up to one of
+ * ::NSLABCLASS power-of-two sizes from ::SLAB_MINOBJ to ::SLAB_MAXOBJ bytes.
+ * Each class hands out objects from slabs obtained with memgetalign(); a
+ * slab is aligned to its own size so that freeing an object finds its slab without
+ * searching.  Slabs with free objects are kept on a per-class list, and one
+ * completely free slab per class is kept in reserve so that a class which
+ * repeatedly allocates and frees a single object does not go back to the
+ * heap each time.  Larger requests are passed straight to memget().
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <interrupt.h>
+#include <platform.h>
+#include <memory.h>
+
+#define SLABHDR         ((ulong)roundmb(sizeof(struct slab)))
+#define SLABSIZE(sz)    ((4 * (sz) > SLAB_MINSIZE) ? 4 * (sz) : SLAB_MINSIZE)
+#define SLABCLASS(sz)   { (sz), SLABSIZE(sz), \
+                          (SLABSIZE(sz) - SLABHDR) / (sz) }
+
+/** @ingroup memory_mgmt
+ * Table of slab size classes, smallest first.  */
+struct slabclass slabtab[NSLABCLASS] = {
+    SLABCLASS(16), SLABCLASS(32), SLABCLASS(64), SLABCLASS(128),
+    SLABCLASS(256), SLABCLASS(512), SLABCLASS(1024), SLABCLASS(2048),
+    SLABCLASS(4096)
+};
+
+/* Size class that serves a request of 1 to SLAB_MAXOBJ bytes. */
+static struct slabclass *slabclassof(uint nbytes)
+{
+    if (nbytes <= SLAB_MINOBJ)
+    {
+        return &slabtab[0];
+    }
+    return &slabtab[32 - __builtin_clz(nbytes - 1) - 4];
+}
+
+/* Unlink a slab from the list of slabs with free objects. */
+static void slabunlink(struct slabclass *cls, struct slab *slab)
+{
+    if (NULL == slab->prev)
+    {
+        cls->partial = slab->next;
+    }
+    else
+    {
+        slab->prev->next = slab->next;
+    }
+    if (slab->next != NULL)
+    {
+        slab->next->prev = slab->prev;
+    }
+}
+
+/* Put a slab at the head of the list of slabs with free objects. */
+static void slablink(struct slabclass *cls, struct slab *slab)
+{
+    slab->prev = NULL;
+    slab->next = cls->partial;
+    if (slab->next != NULL)
+    {
+        slab->next->prev = slab;
+    }
+    cls->partial = slab;
+}
+
+/* Carve a new, completely free slab out of the heap. */
+static struct slab *slabgrow(struct slabclass *cls)
+{
+    struct slab *slab;
+    void **obj;
+    uint i;
+
+    slab = memgetalign(cls->slabsize, cls->slabsize);
+    if (SYSERR == (int)slab)
+    {
+        return NULL;
+    }
+
+    slab->inuse = 0;
+    slab->free = (void *)((ulong)slab + SLABHDR);
+    obj = slab->free;
+    for (i = 1; i < cls->nobj; i++)
+    {
+        *obj = (void *)((ulong)obj + cls->size);
+        obj = *obj;
+    }
+    *obj = NULL;
+
+    cls->nslab++;
+    return slab;
+}
+
+/**
+ * @ingroup memory_mgmt
+ *
+ * Allocate a small kernel object.  Requests of up to ::SLAB_MAXOBJ bytes are
+ * served from the slab of the matching size class; anything larger is
+ * passed to memget().
+ *
+ * @param nbytes
+ *      Number of bytes requested.
+ *
+ * @return
+ *      ::SYSERR if @p nbytes was 0 or there is no memory to satisfy the
+ *      request; otherwise returns a pointer to the allocated memory region.
+ *      The returned pointer is guaranteed to be 8-byte aligned.  Free the
+ *      block with slabfree() when done with it.
+ */
+void *slabget(uint nbytes)
+{
+    struct slabclass *cls;
+    struct slab *slab;
+    void **obj;
+    irqmask im;
+
+    if (0 == nbytes)
+    {
+        return (void *)SYSERR;
+    }
+    if (nbytes > SLAB_MAXOBJ)
+    {
+        return memget(nbytes);
+    }
+
+    cls = slabclassof(nbytes);
+
+    im = disable();
+
+    slab = cls->partial;
+    if (NULL == slab)
+    {
+        /* reuse the reserve slab if there is one, else grow the class */
+        if (cls->spare != NULL)
+        {
+            slab = cls->spare;
+            cls->spare = NULL;
+            cls->hits++;
+        }
+        else
+        {
+            slab = slabgrow(cls);
+            if (NULL == slab)
+            {
+                restore(im);
+                return (void *)SYSERR;
+            }
+            cls->misses++;
+        }
+        slablink(cls, slab);
+    }
+    else
+    {
+        cls->hits++;
+    }
+
+    obj = slab->free;
+    slab->free = *obj;
+    slab->inuse++;
+    if (NULL == slab->free)
+    {
+        slabunlink(cls, slab);
+    }
+
+    cls->inuse++;
+    cls->reqbytes += nbytes;
+
+    restore(im);
+    return (void *)obj;
+}
+
+/**
+ * @ingroup memory_mgmt
+ *
+ * Frees a block allocated with slabget().
+ *
+ * @param memptr
+ *      Pointer to memory block allocated with slabget().
+ *
+ * @param nbytes
+ *      Length of memory block, in bytes.  (Same value passed to slabget().)
+ *
+ * @return
+ *      ::OK on success; ::SYSERR on failure.  This function can only fail
+ *      because of memory corruption or specifying an invalid memory block.
+ */
+syscall slabfree(void *memptr, uint nbytes)
+{
+    struct slabclass *cls;
+    struct slab *slab;
+    ulong offset;
+    irqmask im;
+
+    /* make sure block is in heap */
+    if ((0 == nbytes)
+        || ((ulong)memptr < (ulong)memheap)
+        || ((ulong)memptr > (ulong)platform.maxaddr))
+    {
+        return SYSERR;
+    }
+    if (nbytes > SLAB_MAXOBJ)
+    {
+        return memfree(memptr, nbytes);
+    }
+
+    cls = slabclassof(nbytes);
+    slab = (struct slab *)((ulong)memptr & ~((ulong)cls->slabsize - 1));
+
+    /* make sure block is an object boundary of a live slab */
+    offset = (ulong)memptr - (ulong)slab - SLABHDR;
+    if (((ulong)memptr < (ulong)slab + SLABHDR)
+        || (0 != offset % cls->size) || (offset / cls->size >= cls->nobj))
+    {
+        return SYSERR;
+    }
+
+    im = disable();
+
+    if (0 == slab->inuse)
+    {
+        restore(im);
+        return SYSERR;
+    }
+
+    if (NULL == slab->free)
+    {
+        slablink(cls, slab);
+    }
+    *(void **)memptr = slab->free;
+    slab->free = memptr;
+    slab->inuse--;
+
+    cls->inuse--;
+    cls->reqbytes -= nbytes;
+    cls->frees++;
+
+    /* keep one free slab in reserve, return any other to the heap */
+    if (0 == slab->inuse)
+    {
+        slabunlink(cls, slab);
+        if (NULL == cls->spare)
+        {
+            cls->spare = slab;
+        }
+        else
+        {
+            cls->nslab--;
+            memfree(slab, cls->slabsize);
+        }
+    }
+
+    restore(im);
+    return OK;
+}
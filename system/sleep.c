@@ -35,7 +35,11 @@ syscall sleep(uint ms)
     im = disable();
     if (ticks > 0)
     {
-        if (SYSERR == insertd(thrcurrent, sleepq, ticks))
+#if TICKLESS
+        /* the wheel must count from now, not the last interrupt */
+        clkcatchup();
+#endif
+        if (SYSERR == tmrinsert(thrcurrent, ticks))
         {
             restore(im);
             return SYSERR;
@@ -20,14 +20,16 @@
  * @return
  *      ::SYSERR if @p nbytes was 0 or there is no memory to satisfy the
  *      request; otherwise returns a pointer to the <b>topmost (highest address)
- *      word</b> of the allocated memory region.  The intention is that this is
+ *      word</b> of the allocated memory region.  While the top of the heap is
+ *      free, stacks are carved from it downwards.  The intention is that this is
  *      the base of a stack growing down.  Free the stack with stkfree() when
  *      done with it.
  */
 void *stkget(uint nbytes)
 {
     irqmask im;
-    struct memblock *prev, *next, *fits, *fitsprev;
+    struct memhdr *last, *top;
+    uint need;
 
     if (0 == nbytes)
     {
@@ -36,45 +38,33 @@ void *stkget(uint nbytes)
 
     /* round to multiple of memblock size   */
     nbytes = (uint)roundmb(nbytes);
+    need = nbytes + MEMHDRSIZE;
 
     im = disable();
 
-    prev = &memlist;
-    next = memlist.next;
-    fits = NULL;
-    fitsprev = NULL;
-
-    /* scan list for highest block that fits */
-    while (next != NULL)
+    /* take the top portion of the heap if it is free */
+    last = memctl.last;
+    if ((last->size & MEM_FREE) && (memsize(last) >= need + MEMMINBLK))
     {
-        if (next->length >= nbytes)
-        {
-            fits = next;
-            fitsprev = prev;
-        }
-        prev = next;
-        next = next->next;
-    }
+        memunlink(last);
+        top = (struct memhdr *)((ulong)last + memsize(last) - need);
+        top->prevphys = last;
+        top->size = need;
+        last->size -= need;
+        memctl.last = top;
+        memlink(last);
 
-    if (NULL == fits)
-    {
-        /* no block big enough */
+        memlist.length -= nbytes;
         restore(im);
-        return (void *)SYSERR;
+        return (void *)((ulong)top + need - sizeof(int));
     }
+    restore(im);
 
-    if (nbytes == fits->length)
+    /* otherwise any block will do */
+    top = memget(nbytes);
+    if (SYSERR == (int)top)
     {
-        fitsprev->next = fits->next;
-    }
-    else
-    {
-        /* take top portion */
-        fits->length -= nbytes;
-        fits = (struct memblock *)((ulong)fits + fits->length);
+        return (void *)SYSERR;
     }
-
-    memlist.length -= nbytes;
-    restore(im);
-    return (void *)((ulong)fits + nbytes - sizeof(int));
+    return (void *)((ulong)top + nbytes - sizeof(int));
 }
@@ -0,0 +1,295 @@
+/**
+ * @file tmrwheel.c
+ *
+ * Hierarchical timing wheel for timed waits (sleep() and recvtime()).
+ *
+ * Level 0 has one slot per tick for the next ::TMRSLOTS ticks; each slot
+ * of level n spans ::TMRSLOTS times as many ticks as a slot of level n-1.
+ * A thread waits in the slot of the lowest level that can hold its
+ * expiry.  Whenever level 0 wraps around, the current slot of the next
+ * level is cascaded, i.e. its threads are redistributed to lower levels.
+ * Slots are ordinary quetab queues, so insertion and cancellation are
+ * O(1), and every thread due in a tick is moved to ::tmrwakeq at once.
+ * The key of a waiting thread is its absolute expiry time in ticks.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <thread.h>
+#include <queue.h>
+#include <clock.h>
+
+#if RTCLOCK
+
+#define TMRMASK      (TMRSLOTS - 1)
+#define TMRMAPLEN    (TMRSLOTS / 32)
+#define TMRMAXDELTA  ((1UL << (TMRSLOTBITS * TMRLEVELS)) - 1)
+
+#define tmrslot(l, i)  (tmrwheel + 2 * ((l) * TMRSLOTS + (i)))
+#define istmrslot(q)   ((uint)((q) - tmrwheel) < 2 * NTMRSLOT)
+
+/** @ingroup timer
+ * Number of ticks the timing wheel has processed.  */
+ulong tmrnow;
+
+/** @ingroup timer
+ * Queue ID of the first timing wheel slot.  */
+qid_typ tmrwheel;
+
+/** @ingroup timer
+ * Threads whose timed wait has expired, waiting for wakeup().  */
+qid_typ tmrwakeq;
+
+static uint tmrmap[TMRLEVELS][TMRMAPLEN];  /* non-empty slot bitmaps */
+
+/* Find index of the lowest set bit in a nonzero word. */
+static inline uint lowest_set_bit(uint word)
+{
+    return __builtin_ctz(word);
+}
+
+/* Move every thread of queue src to the tail of queue dst. */
+static void tmrsplice(qid_typ src, qid_typ dst)
+{
+    tid_typ first, last, prev;
+
+    if (isempty(src))
+    {
+        return;
+    }
+    first = quetab[quehead(src)].next;
+    last = quetab[quetail(src)].prev;
+    prev = quetab[quetail(dst)].prev;
+
+    quetab[prev].next = first;
+    quetab[first].prev = prev;
+    quetab[last].next = quetail(dst);
+    quetab[quetail(dst)].prev = last;
+
+    quetab[quehead(src)].next = quetail(src);
+    quetab[quetail(src)].prev = quehead(src);
+}
+
+/* Put a thread whose key holds its expiry into the right slot. */
+static void tmrplace(tid_typ tid)
+{
+    ulong expires = quetab[tid].key;
+    long delta = (long)(expires - tmrnow);
+    int level, slot;
+
+    if (delta <= 0)
+    {
+        enqueue(tid, tmrwakeq);
+        return;
+    }
+    if ((ulong)delta > TMRMAXDELTA)
+    {
+        /* park at the far end of the wheel; re-placed on cascade */
+        expires = tmrnow + TMRMAXDELTA;
+        delta = TMRMAXDELTA;
+    }
+
+    for (level = 0; (ulong)delta >> (TMRSLOTBITS * (level + 1)); level++)
+        ;
+    slot = (expires >> (TMRSLOTBITS * level)) & TMRMASK;
+
+    enqueue(tid, tmrslot(level, slot));
+    tmrmap[level][slot >> 5] |= 1 << (slot & 0x1f);
+}
+
+/* Redistribute the threads of one slot to lower levels. */
+static void tmrcascade(int level, int slot)
+{
+    qid_typ q = tmrslot(level, slot);
+    tid_typ tid;
+
+    tmrmap[level][slot >> 5] &= ~(1 << (slot & 0x1f));
+    while (nonempty(q))
+    {
+        tid = getfirst(q);
+        tmrplace(tid);
+    }
+}
+
+/*
+ * Distance from slot 'from' to the next non-empty slot after it on one
+ * level, from 1 (the next slot) to TMRSLOTS (slot 'from' itself, one full
+ * turn later), or 0 if the level is empty.
+ */
+static int tmrscan(const uint *map, int from)
+{
+    int slot, found, i;
+    uint word;
+
+    slot = (from + 1) & TMRMASK;
+    for (i = 0; i <= TMRMAPLEN; i++)
+    {
+        word = map[slot >> 5] & (~0U << (slot & 0x1f));
+        if (word)
+        {
+            found = (slot & ~0x1f) + lowest_set_bit(word);
+            return ((found - from - 1) & TMRMASK) + 1;
+        }
+        slot = ((slot | 0x1f) + 1) & TMRMASK;
+    }
+    return 0;
+}
+
+/**
+ * @ingroup timer
+ *
+ * Initialize the timing wheel.  The slot queues are allocated back to back
+ * so a slot can be found from ::tmrwheel by arithmetic alone.
+ */
+void tmrinit(void)
+{
+    int i;
+
+    tmrwakeq = queinit();
+    tmrwheel = queinit();
+    for (i = 1; i < NTMRSLOT; i++)
+    {
+        queinit();
+    }
+    tmrnow = 0;
+}
+
+/**
+ * @ingroup timer
+ *
+ * Start a timed wait.  The thread is woken by the clock after the given
+ * number of ticks; a wait of zero ticks ends at the next tick.  Interrupts
+ * must be disabled.
+ * @param tid    thread ID to insert
+ * @param ticks  ticks to wait
+ * @return OK, or SYSERR on a bad thread ID
+ */
+int tmrinsert(tid_typ tid, int ticks)
+{
+    if (isbadtid(tid) || (ticks < 0))
+    {
+        return SYSERR;
+    }
+
+    quetab[tid].key = tmrnow + ((ticks > 0) ? ticks : 1);
+    tmrplace(tid);
+    return OK;
+}
+
+/**
+ * @ingroup timer
+ *
+ * Cancel a timed wait.  Interrupts must be disabled.
+ * @param tid  thread ID to remove
+ */
+void tmrremove(tid_typ tid)
+{
+    tid_typ prev, next;
+    int slot;
+
+    prev = quetab[tid].prev;
+    next = quetab[tid].next;
+    getitem(tid);
+
+    /* a wheel slot that just emptied drops out of its bitmap */
+    if ((next == prev + 1) && istmrslot(prev))
+    {
+        slot = (prev - tmrwheel) >> 1;
+        tmrmap[slot / TMRSLOTS][(slot & TMRMASK) >> 5] &=
+            ~(1 << (slot & 0x1f));
+    }
+}
+
+/* Ticks until the next slot of level 0 expires or the next non-empty slot
+ * of a higher level must be cascaded; ~0 if the wheel is empty. */
+static ulong tmrscanall(void)
+{
+    ulong best, when, base;
+    int level, shift, k;
+
+    best = ~0UL;
+    for (level = 0; level < TMRLEVELS; level++)
+    {
+        shift = TMRSLOTBITS * level;
+        base = tmrnow >> shift;
+        k = tmrscan(tmrmap[level], base & TMRMASK);
+        if (k)
+        {
+            when = ((base + k) << shift) - tmrnow;
+            if (when < best)
+            {
+                best = when;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * @ingroup timer
+ *
+ * Ticks from now until the timing wheel next has work to do.  Used to
+ * program the next timer interrupt in dynamic tick mode.
+ * @return number of ticks, 0 if ::tmrwakeq is already non-empty, or ~0 if
+ *         no thread is waiting
+ */
+ulong tmrnext(void)
+{
+    if (nonempty(tmrwakeq))
+    {
+        return 0;
+    }
+    return tmrscanall();
+}
+
+/**
+ * @ingroup timer
+ *
+ * Advance the timing wheel.  Every thread whose wait ends in the elapsed
+ * ticks is moved to ::tmrwakeq for wakeup().  Ticks in which the wheel has
+ * nothing to do are skipped without visiting their slots.  Interrupts must
+ * be disabled.
+ * @param ticks  number of ticks that have elapsed
+ */
+void tmradvance(ulong ticks)
+{
+    ulong skip;
+    int level, slot;
+
+    while (ticks > 0)
+    {
+        if (ticks > 1)
+        {
+            skip = tmrscanall();
+            if (skip > ticks)
+            {
+                tmrnow += ticks;
+                return;
+            }
+            tmrnow += skip - 1;
+            ticks -= skip - 1;
+        }
+
+        /* process one tick */
+        tmrnow++;
+        ticks--;
+        slot = tmrnow & TMRMASK;
+        if (0 == slot)
+        {
+            for (level = 1; level < TMRLEVELS; level++)
+            {
+                slot = (tmrnow >> (TMRSLOTBITS * level)) & TMRMASK;
+                tmrcascade(level, slot);
+                if (slot != 0)
+                {
+                    break;
+                }
+            }
+            slot = 0;
+        }
+        tmrmap[0][slot >> 5] &= ~(1 << (slot & 0x1f));
+        tmrsplice(tmrslot(0, slot), tmrwakeq);
+    }
+}
+
+#endif                          /* RTCLOCK */
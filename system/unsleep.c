@@ -22,7 +22,6 @@ syscall unsleep(tid_typ tid)
 {
     register struct thrent *thrptr;
     irqmask im;
-    tid_typ next = 0;
 
     im = disable();
 
@@ -39,13 +38,7 @@ syscall unsleep(tid_typ tid)
         return SYSERR;
     }
 
-    next = quetab[tid].next;
-    if (next < NTHREAD)
-    {
-        quetab[next].key += quetab[tid].key;
-    }
-
-    getitem(tid);
+    tmrremove(tid);
     restore(im);
     return OK;
 }
@@ -14,13 +14,14 @@
 /**
  * @ingroup threads
  *
- * Wakeup and ready all threads that have no more time to sleep
+ * Wakeup and ready all threads that have no more time to sleep.  The
+ * timing wheel has already moved them all to ::tmrwakeq.
  */
 void wakeup(void)
 {
-    while (nonempty(sleepq) && (firstkey(sleepq) <= 0))
+    while (nonempty(tmrwakeq))
     {
-        ready(dequeue(sleepq), RESCHED_NO);
+        ready(dequeue(tmrwakeq), RESCHED_NO);
     }
 
     resched();
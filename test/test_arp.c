@@ -6,6 +6,7 @@
 
 #include <stddef.h>
 #include <arp.h>
+#include <bufpool.h>
 #include <clock.h>
 #include <ethloop.h>
 #include <interrupt.h>
@@ -13,6 +14,8 @@
 #include <network.h>
 #include <snoop.h>
 #include <pcap.h>
+#include <semaphore.h>
+#include <string.h>
 #include <testsuite.h>
 #include <thread.h>
 
@@ -25,29 +28,49 @@
 extern int _binary_data_testarp_pcap_start;
 #define MAX_WAIT 10
 
-static thread notifyTest(void)
+/* Fill a packet with an Ethernet frame from the interface, lacking only
+ * the destination, as netSend() hands it to arpLookup(). */
+static void frameFill(struct packet *pkt, struct netif *netptr, uint len)
 {
-    while (ARP_MSG_RESOLVED != receive());
-    return OK;
+    struct etherPkt *ether;
+
+    pkt->nif = netptr;
+    pkt->len = len;
+    pkt->curr = pkt->data + NET_MAX_PKTLEN - len;
+    memset(pkt->curr, 0x5A, len);
+    ether = (struct etherPkt *)pkt->curr;
+    memset(ether->dst, 0, ETH_ADDR_LEN);
+    memcpy(ether->src, netptr->hwaddr.addr, ETH_ADDR_LEN);
+    ether->type = hs2net(ETHER_TYPE_IPv4);
 }
 
-static thread freeTest(void)
-{
-    while (TIMEOUT != receive());
-    return OK;
-}
+/* Data of a datagram that takes several fragments to send */
+static uchar fragdata[4 * NET_MAX_PKTLEN];
 
-static thread lookupTest(uchar *request, int rqlen, uchar *reply,
-                         int rplen)
+/* Fill a packet with an IPv4 datagram to dst carrying fragdata in a
+ * segment, as ipv4Send() hands it to ipv4SendFrag(). */
+static void datagramFill(struct packet *pkt, struct netif *netptr,
+                         struct netSeg *seg, const struct netaddr *dst)
 {
-    uchar buf[ELOOP_BUFSIZE];
-    control(ELOOP, ELOOP_CTRL_GETHOLD, (int)buf, ELOOP_BUFSIZE);
-    if (memcmp(buf, request, rqlen) != 0)
-    {
-        return SYSERR;
-    }
-    write(ELOOP, reply, rplen);
-    return OK;
+    struct ipv4Pkt *ip;
+
+    pkt->nif = netptr;
+    pkt->len = IPv4_HDR_LEN + sizeof(fragdata);
+    pkt->curr = pkt->data + NET_MAX_PKTLEN - IPv4_HDR_LEN;
+    seg->data = fragdata;
+    seg->len = sizeof(fragdata);
+    seg->next = NULL;
+    pkt->segs = seg;
+    pkt->seglen = sizeof(fragdata);
+    ip = (struct ipv4Pkt *)pkt->curr;
+    memset(ip, 0, IPv4_HDR_LEN);
+    ip->ver_ihl = (uchar)(IPv4_VERSION << 4) + IPv4_HDR_LEN / 4;
+    ip->len = hs2net(pkt->len);
+    ip->ttl = IPv4_TTL;
+    ip->proto = IPv4_PROTO_UDP;
+    memcpy(ip->src, netptr->ip.addr, IPv4_ADDR_LEN);
+    memcpy(ip->dst, dst->addr, IPv4_ADDR_LEN);
+    ip->chksum = netChksum(ip, IPv4_HDR_LEN);
 }
 
 #endif /* NETHER */
@@ -69,18 +92,18 @@ thread test_arp(bool verbose)
     struct pcap_file_header pcap;
     struct pcap_pkthdr phdr;
     struct packet *pkt;
+    struct netSeg seg;
     struct netif *netptr;
     struct ethloop *pelp;
     uchar *data;
-    uchar *request;
     struct arpPkt *arp;
     struct arpEntry *entry;
     uchar buf[ELOOP_BUFSIZE];
     int nproc;
     int nout;
     int wait;
-    tid_typ tids[ARP_NTHRWAIT];
-    tid_typ tid;
+    int nfree;
+    uint count;
     irqmask im;
 
     ip.type = NETADDR_IPv4;
@@ -222,51 +245,6 @@ thread test_arp(bool verbose)
     failif(((NULL == entry) || (entry != &arptab[1])
             || (0 == (entry->state & ARP_USED))), "");
 
-    /* Test arpNotify */
-    testPrint(verbose, "Notify waiting threads (bad params)");
-    failif((SYSERR != arpNotify(NULL, TIMEOUT)), "");
-
-    /* Test arpNotify */
-    testPrint(verbose, "Notify waiting threads");
-    entry = &arptab[0];
-    entry->state = ARP_UNRESOLVED;
-    for (i = 0; i < ARP_NTHRWAIT; i++)
-    {
-        tid =
-            create((void *)notifyTest, INITSTK, INITPRIO, "notifyTest",
-                   0);
-        tids[i] = tid;
-        entry->waiting[i] = tid;
-        entry->count++;
-        ready(tid, RESCHED_NO);
-    }
-    recvclr();
-    arpNotify(entry, ARP_MSG_RESOLVED);
-    nout = FALSE;
-    nproc = 0;
-    tid = recvtime(100);
-    while ((tid != TIMEOUT) && (nproc < ARP_NTHRWAIT))
-    {
-        for (i = 0; i < ARP_NTHRWAIT; i++)
-        {
-            if (tid == tids[i])
-            {
-                tids[i] = NULL;
-            }
-        }
-        nproc++;
-        tid = recvtime(100);
-    }
-    for (i = 0; i < ARP_NTHRWAIT; i++)
-    {
-        if (tids[i] != NULL)
-        {
-            kill(tids[i]);
-            nout = TRUE;
-        }
-    }
-    failif(nout || (entry->count != 0), "");
-
     /* Test arpFree */
     testPrint(verbose, "Free entry (bad params)");
     failif((SYSERR != arpFree(NULL)), "");
@@ -282,46 +260,16 @@ thread test_arp(bool verbose)
     testPrint(verbose, "Free unresolved entry");
     entry = &arptab[0];
     entry->state = ARP_UNRESOLVED;
-    for (i = 0; i < ARP_NTHRWAIT; i++)
-    {
-        tid = create((void *)freeTest, INITSTK, INITPRIO, "freeTest", 0);
-        tids[i] = tid;
-        entry->waiting[i] = tid;
-        entry->count++;
-        ready(tid, RESCHED_NO);
-    }
-    recvclr();
-    if (SYSERR == arpFree(entry))
-    {
-        failif(TRUE, "Returned SYSERR");
-    }
-    else
+    nfree = semcount(bfptab[netpool].freebuf);
+    count = arpstats.dropped;
+    for (i = 0; i < ARP_NPENDING; i++)
     {
-        nout = FALSE;
-        nproc = 0;
-        tid = recvtime(100);
-        while ((tid != TIMEOUT) && (nproc < ARP_NTHRWAIT))
-        {
-            for (i = 0; i < ARP_NTHRWAIT; i++)
-            {
-                if (tid == tids[i])
-                {
-                    tids[i] = NULL;
-                }
-            }
-            nproc++;
-            tid = recvtime(100);
-        }
-        for (i = 0; i < ARP_NTHRWAIT; i++)
-        {
-            if (tids[i] != NULL)
-            {
-                kill(tids[i]);
-                nout = TRUE;
-            }
-        }
-        failif(nout || (entry->count != 0), "");
+        entry->pending[i] = netGetbuf();
+        entry->npending++;
     }
+    failif(((SYSERR == arpFree(entry)) || (entry->npending != 0)
+            || (semcount(bfptab[netpool].freebuf) != nfree)
+            || (arpstats.dropped != count + ARP_NPENDING)), "");
 
     /* Test arpGetEntry */
     testPrint(verbose, "Get entry");
@@ -344,6 +292,7 @@ thread test_arp(bool verbose)
         netaddrcpy(&entry->hwaddr, &hwaddr);
         netaddrcpy(&entry->praddr, &praddr);
         entry->expires = clktime + ARP_TTL_RESOLVED;
+        arpHashInsert(entry);
     }
     for (i = 1; i < nout; i++)
     {
@@ -419,7 +368,7 @@ thread test_arp(bool verbose)
         }
         else if ((FALSE == netaddrequal(&praddr, &entry->praddr))
                  || (FALSE == netaddrequal(&hwaddr, &entry->hwaddr))
-                 || (entry->nif != netptr) || (entry->count != 0))
+                 || (entry->nif != netptr) || (entry->npending != 0))
         {
             failif(TRUE, "Entry incorrect");
         }
@@ -481,7 +430,7 @@ thread test_arp(bool verbose)
         }
         else if ((FALSE == netaddrequal(&praddr, &entry->praddr))
                  || (FALSE == netaddrequal(&hwaddr, &entry->hwaddr))
-                 || (entry->nif != netptr) || (entry->count != 0))
+                 || (entry->nif != netptr) || (entry->npending != 0))
         {
             failif(TRUE, "Entry incorrect");
         }
@@ -700,7 +649,7 @@ thread test_arp(bool verbose)
 
     /* Test arpLookup */
     testPrint(verbose, "Lookup address (bad params)");
-    failif((SYSERR != arpLookup(NULL, NULL, NULL)), "");
+    failif((SYSERR != arpLookup(NULL, NULL, NULL, NULL)), "");
 
     /* Test arpLookup */
     testPrint(verbose, "Lookup existing resolved address");
@@ -716,10 +665,12 @@ thread test_arp(bool verbose)
     netaddrcpy(&entry->hwaddr, &hwaddr);
     netaddrcpy(&entry->praddr, &praddr);
     entry->expires = clktime + ARP_TTL_UNRESOLVED;
-    i = arpLookup(netptr, &praddr, &addrbuf);
-    if ((SYSERR == i) || (TIMEOUT == i))
+    arpHashInsert(entry);
+    frameFill(pkt, netptr, ETH_HDR_LEN + 64);
+    i = arpLookup(netptr, &praddr, &addrbuf, pkt);
+    if (OK != i)
     {
-        failif(TRUE, "Returned SYSERR or TIMEOUT");
+        failif(TRUE, "Did not return OK");
     }
     else
     {
@@ -728,56 +679,35 @@ thread test_arp(bool verbose)
     }
 
     /* Test arpLookup */
-    testPrint(verbose, "Lookup existing unresolved address");
+    testPrint(verbose, "Lookup unresolved address, hold packet");
     entry = &arptab[1];
     entry->state = ARP_UNRESOLVED;
     entry->nif = netptr;
     praddr.addr[3] = 2;
     hwaddr.addr[5] = 0xBB;
-    netaddrcpy(&entry->hwaddr, &hwaddr);
     netaddrcpy(&entry->praddr, &praddr);
     entry->expires = clktime + ARP_TTL_UNRESOLVED;
+    entry->rqsttime = clktime - ARP_RQST_INTERVAL;
+    arpHashInsert(entry);
+    count = arpstats.queued;
     control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, NULL);
-    request = data;
-    wait = phdr.caplen;
-    /* Get 11th packet */
-    data += phdr.caplen;
-    memcpy(&phdr, data, sizeof(phdr));
-    data += sizeof(phdr);
-    if (PCAP_MAGIC != pcap.magic)
-    {
-        phdr.caplen = endswap(phdr.caplen);
-    }
-    tid =
-        ready(create
-              ((void *)lookupTest, INITSTK, INITPRIO, "lookupTest", 4,
-               request, wait, data, phdr.caplen), RESCHED_NO);
-    i = arpLookup(netptr, &praddr, &addrbuf);
-    if ((SYSERR == i) || (TIMEOUT == i))
+    i = arpLookup(netptr, &praddr, &addrbuf, pkt);
+    if ((NET_QUEUED != i) || (entry->npending != 1)
+        || (arpstats.queued != count + 1))
     {
-        kill(tid);
-        failif(TRUE, "Returned SYSERR or TIMEOUT");
+        control(ELOOP, ELOOP_CTRL_CLRFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+        failif(TRUE, "Packet not held");
     }
     else
     {
-        failif((FALSE == netaddrequal(&addrbuf, &hwaddr)),
-               "Wrong address");
+        /* Request sent is the 10th packet again */
+        control(ELOOP, ELOOP_CTRL_GETHOLD, (int)buf, ELOOP_BUFSIZE);
+        failif((memcmp(buf, data, phdr.caplen) != 0), "Wrong request");
     }
 
-    /* Test arpLookup */
-    testPrint(verbose, "Lookup max threads wait for resolve");
-    entry->state = ARP_UNRESOLVED;
-    entry->count = ARP_NTHRWAIT;
-    failif((arpLookup(netptr, &praddr, &addrbuf) != SYSERR), "");
-
-    /* Test arpLookup */
-    testPrint(verbose, "Lookup non-existing unresolved addr");
-    praddr.addr[3] = 3;
-    hwaddr.addr[5] = 0xCC;
-    control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, NULL);
-    request = data;
-    wait = phdr.caplen;
-    /* Get 12th packet */
+    /* Test arpRecv sending held packets */
+    testPrint(verbose, "Send held packet on reply");
+    /* Get 11th packet */
     data += phdr.caplen;
     memcpy(&phdr, data, sizeof(phdr));
     data += sizeof(phdr);
@@ -785,38 +715,82 @@ thread test_arp(bool verbose)
     {
         phdr.caplen = endswap(phdr.caplen);
     }
-    request = data;
-    wait = phdr.caplen;
-    /* Get 13th packet */
-    data += phdr.caplen;
-    memcpy(&phdr, data, sizeof(phdr));
-    data += sizeof(phdr);
-    if (PCAP_MAGIC != pcap.magic)
+    count = arpstats.sent;
+    im = disable();
+    write(ELOOP, data, phdr.caplen);
+    control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+    restore(im);
+    wait = 0;
+    while ((wait < MAX_WAIT) && (arpstats.sent == count))
     {
-        phdr.caplen = endswap(phdr.caplen);
+        wait++;
+        sleep(100);
     }
-    tid =
-        ready(create
-              ((void *)lookupTest, INITSTK, INITPRIO, "lookupTest", 4,
-               request, wait, data, phdr.caplen), RESCHED_NO);
-    i = arpLookup(netptr, &praddr, &addrbuf);
-    if ((SYSERR == i) || (TIMEOUT == i))
+    if (MAX_WAIT == wait)
     {
-        kill(tid);
-        failif(TRUE, "Returned SYSERR or TIMEOUT");
+        control(ELOOP, ELOOP_CTRL_CLRFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+        failif(TRUE, "Wait time expired");
     }
     else
     {
-        failif((FALSE == netaddrequal(&addrbuf, &hwaddr)),
-               "Wrong address");
+        control(ELOOP, ELOOP_CTRL_GETHOLD, (int)buf, ELOOP_BUFSIZE);
+        memcpy(pkt->curr, hwaddr.addr, ETH_ADDR_LEN);
+        failif((ARP_RESOLVED != entry->state) || (entry->npending != 0)
+               || (memcmp(buf, pkt->curr, pkt->len) != 0),
+               "Wrong packet sent");
     }
 
     /* Test arpLookup */
-    testPrint(verbose, "Lookup timeout");
+    testPrint(verbose, "Lookup new address, hold packets");
     praddr.addr[3] = 4;
-    hwaddr.addr[5] = 0xDD;
     control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_DROPALL, NULL);
-    failif((SYSERR != arpLookup(netptr, &praddr, &addrbuf)), "");
+    nfree = semcount(bfptab[netpool].freebuf);
+    for (i = 0; i < ARP_NPENDING; i++)
+    {
+        if (NET_QUEUED != arpLookup(netptr, &praddr, &addrbuf, pkt))
+        {
+            break;
+        }
+    }
+    entry = arpGetEntry(&praddr);
+    failif((i != ARP_NPENDING) || (NULL == entry)
+           || (ARP_UNRESOLVED != entry->state)
+           || (entry->npending != ARP_NPENDING), "");
+
+    /* Test arpLookup */
+    testPrint(verbose, "Lookup address with full queue");
+    count = arpstats.dropped;
+    failif((NET_DROPPED != arpLookup(netptr, &praddr, &addrbuf, pkt))
+           || (arpstats.dropped != count + 1), "");
+
+    /* Test arpFree */
+    testPrint(verbose, "Expire entry, drop held packets");
+    if (entry != NULL)
+    {
+        entry->expires = clktime - 1;
+    }
+    failif((arpGetEntry(&praddr) != NULL)
+           || (semcount(bfptab[netpool].freebuf) != nfree), "");
+
+    /* Test ipv4SendFrag */
+    testPrint(verbose, "Fragment to new address, drop what cannot be held");
+    praddr.addr[3] = 5;
+    datagramFill(pkt, netptr, &seg, &praddr);
+    count = arpstats.dropped;
+    i = ipv4SendFrag(pkt, &praddr);
+    entry = arpGetEntry(&praddr);
+    failif((NET_DROPPED != i) || (NULL == entry)
+           || (entry->npending != ARP_NPENDING)
+           || (arpstats.dropped != count + 1), "");
+    if (entry != NULL)
+    {
+        entry->expires = clktime - 1;
+    }
+    failif((arpGetEntry(&praddr) != NULL)
+           || (semcount(bfptab[netpool].freebuf) != nfree), "");
+    pkt->segs = NULL;
+    pkt->seglen = 0;
+    control(ELOOP, ELOOP_CTRL_CLRFLAG, ELOOP_FLAG_DROPALL, NULL);
 
     /* Stop loopback ethernet and network interface */
     testPrint(verbose, "Test case cleanup");
@@ -1,18 +1,21 @@
 #include <stddef.h>
 #include <memory.h>
 #include <bufpool.h>
+#include <semaphore.h>
 #include <stdio.h>
 #include <string.h>
 #include <testsuite.h>
 
 #define TBUFSIZE  32
 #define TBUFNUM   32
+#define TBUFRESERVE 4
 
 thread test_bufpool(bool verbose)
 {
 #if NPOOL
     bool passed = TRUE;
     int id, i;
+    uint n;
     void *pbuf;
     void *chain[TBUFNUM];
     irqmask im;
@@ -119,6 +122,41 @@ thread test_bufpool(bool verbose)
         }
     }
 
+    /* Allocate without waiting, leaving reserved buffers for bufget() */
+    testPrint(verbose, "Non-blocking and batch allocation");
+    if ((OK != bfpreserve(id, TBUFRESERVE))
+        || (SYSERR != bfpreserve(id, TBUFNUM)))
+    {
+        passed = FALSE;
+        testFail(verbose, "\nbfpreserve() does not check reservation");
+    }
+    else if (((n = bufgetn(id, chain, TBUFNUM)) != TBUFNUM - TBUFRESERVE)
+             || (SYSERR != (ulong)bufgetnb(id))
+             || (SYSERR == (ulong)(chain[n] = bufget(id))))
+    {
+        passed = FALSE;
+        testFail(verbose, "\nreserved buffers not left for bufget()");
+        buffreen(chain, n);
+    }
+    else if ((bfptab[id].nused != n + 1) || (bfptab[id].hiwat != n + 1)
+             || (bfptab[id].ndrop != 1) || (bfptab[id].nwait != 0))
+    {
+        passed = FALSE;
+        testFail(verbose, "\npool counters are wrong");
+        buffreen(chain, n + 1);
+    }
+    else if ((OK != buffreen(chain, n + 1)) || (bfptab[id].nused != 0)
+             || (semcount(bfptab[id].freebuf) != TBUFNUM)
+             || (SYSERR != buffreen(chain, 1)))
+    {
+        passed = FALSE;
+        testFail(verbose, "\nbuffreen() does not return buffers");
+    }
+    else
+    {
+        testPass(verbose, "");
+    }
+
     /* Release pool */
     testPrint(verbose, "Free buffer pool");
     im = disable();
@@ -0,0 +1,194 @@
+/**
+ * @file     test_chksum.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <clock.h>
+#include <interrupt.h>
+#include <network.h>
+#include <stdio.h>
+#include <string.h>
+#include <testsuite.h>
+
+#define CHK_BUFLEN  (4096 + 8)  /* largest size plus room to misalign */
+#define CHK_ROUNDS  16          /* calls timed per measurement        */
+#define CHK_CHECK   100         /* lengths checked against the loop   */
+
+static uchar chk_src[CHK_BUFLEN];
+static uchar chk_dst[CHK_BUFLEN];
+
+/* The 16-bit loop netChksum() used to be, for checking results and as a
+ * baseline.  Words at odd addresses are copied out a word at a time. */
+static ushort chkLoop(void *data, uint len)
+{
+    uint sum = 0;
+    ushort *ptr = data;
+    ushort w;
+
+    while (len > 1)
+    {
+        if ((ulong)ptr & 1)
+        {
+            memcpy(&w, ptr, 2);
+        }
+        else
+        {
+            w = *ptr;
+        }
+        sum += w;
+        ptr++;
+        len -= 2;
+    }
+    if (len > 0)
+    {
+        sum += net2hs(*((uchar *)ptr) << 8);
+    }
+    sum = (sum >> 16) + (sum & 0xFFFF);
+    sum += (sum >> 16);
+    return ~sum;
+}
+
+/* Compare netChksum(), sums carried over split buffers, netChksumCopy()
+ * and netChksumAdjust() with the loop for every short length and a few
+ * alignments.  Returns the number of wrong results. */
+static int chkCheck(void)
+{
+    uchar *s, *d;
+    uint n, so, dof, i, cut, sum;
+    ushort ref, old, w;
+    int errors = 0;
+
+    for (i = 0; i < CHK_BUFLEN; i++)
+    {
+        chk_src[i] = (i * 131 + (i >> 3)) & 0xFF;
+    }
+    for (so = 0; so < 4; so++)
+    {
+        for (dof = 0; dof < 4; dof++)
+        {
+            for (n = 0; n < CHK_CHECK; n++)
+            {
+                s = chk_src + so + n;
+                d = chk_dst + dof;
+                ref = chkLoop(s, n);
+                if (netChksum(s, n) != ref)
+                {
+                    errors++;
+                }
+
+                cut = (n / 3) & ~1;
+                sum = netChksumAdd(0, s, cut);
+                sum = netChksumAdd(sum, s + cut, n - cut);
+                if (netChksumFinish(sum) != ref)
+                {
+                    errors++;
+                }
+
+                memset(chk_dst, 0x5a, n + 8);
+                sum = netChksumCopy(0, d, s, n);
+                if ((netChksumFinish(sum) != ref) || (0 != memcmp(d, s, n))
+                    || (0x5a != d[n]))
+                {
+                    errors++;
+                }
+
+                if (n >= 2)
+                {
+                    memcpy(&old, d, 2);
+                    d[0]--;
+                    d[1] ^= n;
+                    memcpy(&w, d, 2);
+                    if (netChksumAdjust(ref, old, w) != chkLoop(d, n))
+                    {
+                        errors++;
+                    }
+                }
+            }
+        }
+    }
+    return errors;
+}
+
+/* Cycles taken by one call of a function, best of CHK_ROUNDS. */
+static ulong chkTime(int which, uchar *d, uchar *s, uint n)
+{
+    ulong start, t, best;
+    irqmask im;
+    int i;
+
+    best = (ulong)-1;
+    im = disable();
+    for (i = 0; i < CHK_ROUNDS; i++)
+    {
+        start = clkcount();
+        switch (which)
+        {
+        case 0:
+            chkLoop(s, n);
+            break;
+        case 1:
+            netChksum(s, n);
+            break;
+        case 2:
+            memcpy(d, s, n);
+            netChksum(d, n);
+            break;
+        case 3:
+            netChksumFinish(netChksumCopy(0, d, s, n));
+            break;
+        }
+        t = clkcount() - start;
+        if (t < best)
+        {
+            best = t;
+        }
+    }
+    restore(im);
+    return (best > 0) ? best : 1;
+}
+
+/**
+ * Internet checksum throughput.  Checks netChksum(), partial sums,
+ * netChksumCopy() and netChksumAdjust() against the 16-bit loop that
+ * netChksum() used to be, then reports cycles/KB over a range of sizes for
+ * the loop, netChksum(), a memcpy() followed by netChksum(), and
+ * netChksumCopy(), which copies and sums in one pass as the TCP and UDP
+ * send paths now do.
+ */
+thread test_chksum(bool verbose)
+{
+    static const uint sizes[] = { 20, 64, 256, 1460, 4096 };
+    bool passed = TRUE;
+    uint i, k, n;
+    ulong cycles[4];
+    char msg[100];
+
+    testPrint(verbose, "Results match 16-bit loop");
+    failif(0 != chkCheck(), "");
+
+    testPrint(verbose, "\ncycles/KB, aligned:");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        n = sizes[i];
+        for (k = 0; k < 4; k++)
+        {
+            cycles[k] = chkTime(k, chk_dst, chk_src, n) * 1024 / n;
+        }
+        sprintf(msg, "\n%5u: loop %u netChksum %u memcpy+sum %u "
+                "netChksumCopy %u", n, (uint)cycles[0], (uint)cycles[1],
+                (uint)cycles[2], (uint)cycles[3]);
+        testPrint(verbose, msg);
+    }
+    testPrint(verbose, "\n");
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+    return OK;
+}
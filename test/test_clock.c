@@ -0,0 +1,65 @@
+#include <stddef.h>
+#include <thread.h>
+#include <clock.h>
+#include <platform.h>
+#include <stdio.h>
+#include <testsuite.h>
+
+#define CLOCK_SLEEP_MS  1000    /* length of the idle period measured   */
+
+/**
+ * Timer interrupt benchmark.  Sleeps through an idle period and reports
+ * how many timer interrupts were taken and how many of them woke the null
+ * thread.  With a fixed tick both are about one per millisecond; with
+ * ::TICKLESS the idle period should cost only a handful.  Also checks that
+ * ::clktime and ::clkticks agree with the free-running counter afterwards.
+ */
+thread test_clock(bool verbose)
+{
+#if RTCLOCK
+    bool passed = TRUE;
+    ulong intrs, idle, cycles, ms, hwms;
+    ulong sec, ticks;
+    char msg[80];
+
+    /* Start on a fresh tick so the sleep is not cut short. */
+    sleep(1);
+
+    intrs = clkintrs;
+    idle = clkidlewakes;
+    sec = clktime;
+    ticks = clkticks;
+    cycles = clkcount();
+
+    sleep(CLOCK_SLEEP_MS);
+
+    cycles = clkcount() - cycles;
+    ms = (clktime - sec) * CLKTICKS_PER_SEC + clkticks - ticks;
+    hwms = cycles / (platform.clkfreq / CLKTICKS_PER_SEC);
+    intrs = clkintrs - intrs;
+    idle = clkidlewakes - idle;
+
+    sprintf(msg, "%u interrupts, %u idle wakeups in %u ms\n",
+            (uint)intrs, (uint)idle, (uint)ms);
+    testPrint(verbose, msg);
+
+    testPrint(verbose, "Sleep lasts as long as requested");
+    failif(ms < CLOCK_SLEEP_MS || ms > CLOCK_SLEEP_MS + 10,
+           "sleep ended early or late");
+
+    testPrint(verbose, "Tick count matches hardware counter");
+    failif(ms + 2 < hwms || hwms + 2 < ms, "clktime/clkticks drifted");
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else
+    testSkip(TRUE, "");
+#endif                          /* RTCLOCK */
+    return OK;
+}
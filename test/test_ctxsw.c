@@ -0,0 +1,95 @@
+#include <stddef.h>
+#include <thread.h>
+#include <queue.h>
+#include <clock.h>
+#include <stdio.h>
+#include <testsuite.h>
+
+#define CTXSW_ROUNDS  100       /* yields made by each spinning thread  */
+#define CTXSW_STK     1024      /* stack size of a spinning thread      */
+
+static void ctxswSpinner(int rounds, int *count)
+{
+    while (rounds-- > 0)
+    {
+        (*count)++;
+        yield();
+    }
+}
+
+/**
+ * Context switch microbenchmark.  A number of threads of equal priority
+ * take turns yielding to each other, so every switch puts the current
+ * thread back at the tail of its ready list level and takes the next one
+ * off the head.  With a sorted ready list the cost per switch grows with
+ * the number of threads at that priority; with the per-level ready list
+ * it should stay flat.
+ */
+thread test_ctxsw(bool verbose)
+{
+#if RTCLOCK
+    static const int nthr[] = { 1, 4, 16, 48 };
+    bool passed = TRUE;
+    int count, created, i, j, prio;
+    tid_typ tid;
+    ulong start, cycles;
+    irqmask im;
+    char msg[80];
+
+    prio = getprio(gettid()) + 1;
+
+    for (i = 0; i < sizeof(nthr) / sizeof(nthr[0]); i++)
+    {
+        count = 0;
+        created = 0;
+
+        /* Ready every spinner before any of them gets to run. */
+        im = disable();
+        for (j = 0; j < nthr[i]; j++)
+        {
+            tid = create((void *)ctxswSpinner, CTXSW_STK, prio,
+                         "ctxsw", 2, CTXSW_ROUNDS, &count);
+            if (SYSERR == tid)
+            {
+                break;
+            }
+            ready(tid, RESCHED_NO);
+            created++;
+        }
+
+        /* The spinners preempt us here and we return when all are done. */
+        start = clkcount();
+        resched();
+        cycles = clkcount() - start;
+        restore(im);
+
+        while (recvclr() != NOMSG)
+            ;
+
+        /* With no spinners there is no rate to report. */
+        if (0 == created)
+        {
+            failif(TRUE, "could not create any spinning threads");
+            break;
+        }
+
+        sprintf(msg, "%2d threads: %u cycles/switch\n", created,
+                (uint)(cycles / (created * CTXSW_ROUNDS)));
+        testPrint(verbose, msg);
+        failif(created != nthr[i] || count != created * CTXSW_ROUNDS,
+               "spinning threads did not all run to completion");
+    }
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else
+    testSkip(TRUE, "");
+#endif                          /* RTCLOCK */
+    return OK;
+}
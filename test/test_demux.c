@@ -0,0 +1,376 @@
+/**
+ * @file     test_demux.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <clock.h>
+#include <conf.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <memory.h>
+#include <network.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <tcp.h>
+#include <testsuite.h>
+#include <udp.h>
+
+#if defined(UDP0) || defined(TCP0)
+
+#define DEMUX_NSOCK   32        /* sockets open during the benchmark     */
+#define DEMUX_ROUNDS  8         /* passes timed, best one is reported    */
+#define DEMUX_LOCALPT 40000     /* local port of socket 0                */
+#define DEMUX_REMPT   50000     /* remote port of socket 0               */
+
+/* Only the connection details at the front of each TCB are used; a whole
+ * TCB is too large to keep many of them around just for this. */
+#define DEMUX_TCBHEAD offsetof(struct tcb, rcvnxt)
+
+/* Addresses of socket i.  The local address is from TEST-NET-1, so no
+ * interface has it and no real socket is bound to it. */
+static void demuxAddrs(struct netaddr *local, struct netaddr *remote,
+                       int i)
+{
+    local->type = NETADDR_IPv4;
+    local->len = IPv4_ADDR_LEN;
+    local->addr[0] = 192;
+    local->addr[1] = 0;
+    local->addr[2] = 2;
+    local->addr[3] = 1;
+    remote->type = NETADDR_IPv4;
+    remote->len = IPv4_ADDR_LEN;
+    remote->addr[0] = 10;
+    remote->addr[1] = 0;
+    remote->addr[2] = 0;
+    remote->addr[3] = 1 + i;
+}
+
+static void demuxReport(bool verbose, const char *proto, ulong scan,
+                        ulong hash)
+{
+    char msg[80];
+
+    sprintf(msg, "%s, %d sockets: scan %u, hash %u cycles/lookup\n",
+            proto, DEMUX_NSOCK, (uint)scan, (uint)hash);
+    testPrint(verbose, msg);
+}
+
+#endif /* UDP0 || TCP0 */
+
+#ifdef UDP0
+/* The linear scan that udpDemux() used to be, over a given table. */
+static struct udp *udpScan(struct udp *tab, int n, ushort dstpt,
+                           ushort srcpt, const struct netaddr *dstip,
+                           const struct netaddr *srcip)
+{
+    struct udp *udpptr = NULL;
+    int i;
+    int match = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        if ((UDP_FREE == tab[i].state)
+            || !netaddrequal(&tab[i].localip, dstip))
+        {
+            continue;
+        }
+        if ((tab[i].localpt == dstpt) && (tab[i].remotept == srcpt)
+            && netaddrequal(&tab[i].remoteip, srcip))
+        {
+            return &tab[i];
+        }
+        if ((match < 2) && (tab[i].localpt == dstpt)
+            && (tab[i].remotept == srcpt) && (NULL == tab[i].remoteip.type))
+        {
+            udpptr = &tab[i];
+            match = 2;
+        }
+        if ((match < 1) && (tab[i].localpt == dstpt)
+            && (0 == tab[i].remotept) && (NULL == tab[i].remoteip.type))
+        {
+            udpptr = &tab[i];
+            match = 1;
+        }
+    }
+    return udpptr;
+}
+
+/* Time one lookup per socket plus one that matches nothing, with either
+ * demux.  Returns cycles per lookup and counts wrong answers in *errors.
+ * Interrupts must be disabled. */
+static ulong udpTime(struct udp *tab, bool hash, int *errors)
+{
+    struct netaddr local, remote;
+    struct udp *udpptr;
+    ulong start, t, best;
+    int r, i;
+
+    best = (ulong)-1;
+    for (r = 0; r < DEMUX_ROUNDS; r++)
+    {
+        t = 0;
+        for (i = 0; i <= DEMUX_NSOCK; i++)
+        {
+            demuxAddrs(&local, &remote, i);
+            start = clkcount();
+            if (hash)
+            {
+                udpptr = udpDemux(DEMUX_LOCALPT + i, DEMUX_REMPT + i,
+                                  &local, &remote);
+            }
+            else
+            {
+                udpptr = udpScan(tab, DEMUX_NSOCK, DEMUX_LOCALPT + i,
+                                 DEMUX_REMPT + i, &local, &remote);
+            }
+            t += clkcount() - start;
+            if (udpptr != ((i < DEMUX_NSOCK) ? &tab[i] : NULL))
+            {
+                (*errors)++;
+            }
+        }
+        if (t < best)
+        {
+            best = t;
+        }
+    }
+    return best / (DEMUX_NSOCK + 1);
+}
+
+/* Benchmark UDP demux over a private table of sockets, half connected and
+ * half only bound to a local port, which are put into the real hash table
+ * for the duration.  Returns the number of wrong lookups. */
+static int udpBench(ulong *scan, ulong *hash)
+{
+    struct udp *tab;
+    struct netaddr local, remote;
+    int i, errors;
+    irqmask im;
+
+    *scan = *hash = 0;
+    tab = memget(DEMUX_NSOCK * sizeof(struct udp));
+    if (SYSERR == (int)tab)
+    {
+        return 1;
+    }
+    bzero(tab, DEMUX_NSOCK * sizeof(struct udp));
+    for (i = 0; i < DEMUX_NSOCK; i++)
+    {
+        demuxAddrs(&local, &remote, i);
+        tab[i].state = UDP_OPEN;
+        tab[i].localpt = DEMUX_LOCALPT + i;
+        netaddrcpy(&tab[i].localip, &local);
+        if (0 == (i & 1))
+        {
+            tab[i].remotept = DEMUX_REMPT + i;
+            netaddrcpy(&tab[i].remoteip, &remote);
+        }
+    }
+
+    errors = 0;
+    im = disable();
+    for (i = 0; i < DEMUX_NSOCK; i++)
+    {
+        udpHashInsert(&tab[i]);
+    }
+    *scan = udpTime(tab, FALSE, &errors);
+    *hash = udpTime(tab, TRUE, &errors);
+    for (i = 0; i < DEMUX_NSOCK; i++)
+    {
+        udpHashRemove(&tab[i]);
+    }
+    restore(im);
+
+    memfree(tab, DEMUX_NSOCK * sizeof(struct udp));
+    return errors;
+}
+#endif /* UDP0 */
+
+#ifdef TCP0
+/* The mutex-taking scan that tcpDemux() used to be, over a given table. */
+static struct tcb *tcpScan(struct tcb **tab, int n, ushort dstpt,
+                           ushort srcpt, struct netaddr *dstip,
+                           struct netaddr *srcip)
+{
+    struct tcb *tcbptr = NULL;
+    int i;
+    int level = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        wait(tab[i]->mutex);
+        if ((tab[i]->state != TCP_CLOSED)
+            && (tab[i]->localpt == dstpt)
+            && netaddrequal(&tab[i]->localip, dstip))
+        {
+            if ((level < 3) && (tab[i]->remotept == srcpt)
+                && netaddrequal(&tab[i]->remoteip, srcip))
+            {
+                tcbptr = tab[i];
+                level = 3;
+            }
+            if ((level < 2) && (tab[i]->remotept == srcpt)
+                && (NULL == tab[i]->remoteip.type))
+            {
+                tcbptr = tab[i];
+                level = 2;
+            }
+            if ((level < 1) && (0 == tab[i]->remotept)
+                && (NULL == tab[i]->remoteip.type))
+            {
+                tcbptr = tab[i];
+                level = 1;
+            }
+        }
+        signal(tab[i]->mutex);
+    }
+    return tcbptr;
+}
+
+/* As udpTime(), for TCBs. */
+static ulong tcpTime(struct tcb **tab, bool hash, int *errors)
+{
+    struct netaddr local, remote;
+    struct tcb *tcbptr;
+    ulong start, t, best;
+    int r, i;
+
+    best = (ulong)-1;
+    for (r = 0; r < DEMUX_ROUNDS; r++)
+    {
+        t = 0;
+        for (i = 0; i <= DEMUX_NSOCK; i++)
+        {
+            demuxAddrs(&local, &remote, i);
+            start = clkcount();
+            if (hash)
+            {
+                tcbptr = tcpDemux(DEMUX_LOCALPT + i, DEMUX_REMPT + i,
+                                  &local, &remote);
+            }
+            else
+            {
+                tcbptr = tcpScan(tab, DEMUX_NSOCK, DEMUX_LOCALPT + i,
+                                 DEMUX_REMPT + i, &local, &remote);
+            }
+            t += clkcount() - start;
+            if (tcbptr != ((i < DEMUX_NSOCK) ? tab[i] : NULL))
+            {
+                (*errors)++;
+            }
+        }
+        if (t < best)
+        {
+            best = t;
+        }
+    }
+    return best / (DEMUX_NSOCK + 1);
+}
+
+/* As udpBench(), for TCBs in the established and listening states. */
+static int tcpBench(ulong *scan, ulong *hash)
+{
+    struct tcb *tab[DEMUX_NSOCK];
+    struct netaddr local, remote;
+    semaphore mutex;
+    int i, n, errors;
+    irqmask im;
+
+    *scan = *hash = 0;
+    mutex = semcreate(1);
+    if (SYSERR == (int)mutex)
+    {
+        return 1;
+    }
+    errors = 0;
+    for (n = 0; n < DEMUX_NSOCK; n++)
+    {
+        tab[n] = memget(DEMUX_TCBHEAD);
+        if (SYSERR == (int)tab[n])
+        {
+            errors++;
+            break;
+        }
+        demuxAddrs(&local, &remote, n);
+        bzero(tab[n], DEMUX_TCBHEAD);
+        tab[n]->mutex = mutex;
+        tab[n]->localpt = DEMUX_LOCALPT + n;
+        netaddrcpy(&tab[n]->localip, &local);
+        if (0 == (n & 1))
+        {
+            tab[n]->state = TCP_ESTAB;
+            tab[n]->remotept = DEMUX_REMPT + n;
+            netaddrcpy(&tab[n]->remoteip, &remote);
+        }
+        else
+        {
+            tab[n]->state = TCP_LISTEN;
+        }
+    }
+
+    if (n == DEMUX_NSOCK)
+    {
+        im = disable();
+        for (i = 0; i < n; i++)
+        {
+            tcpHashInsert(tab[i]);
+        }
+        *scan = tcpTime(tab, FALSE, &errors);
+        *hash = tcpTime(tab, TRUE, &errors);
+        for (i = 0; i < n; i++)
+        {
+            tcpHashRemove(tab[i]);
+        }
+        restore(im);
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        memfree(tab[i], DEMUX_TCBHEAD);
+    }
+    semfree(mutex);
+    return errors;
+}
+#endif /* TCP0 */
+
+/**
+ * Socket demultiplexing benchmark.  Sets up many UDP sockets and TCP
+ * connections, some fully connected and some only bound or listening on a
+ * local port, and times finding the socket for a packet to each of them
+ * and for one that matches none.  The linear scans that udpDemux() and
+ * tcpDemux() used to be are timed alongside; their cost grows with the
+ * number of sockets, while the hash lookups should not.
+ */
+thread test_demux(bool verbose)
+{
+#if defined(UDP0) || defined(TCP0)
+    bool passed = TRUE;
+    ulong scan, hash;
+
+#ifdef UDP0
+    testPrint(verbose, "UDP hash and scan find the same sockets");
+    failif(0 != udpBench(&scan, &hash), "");
+    demuxReport(verbose, "UDP", scan, hash);
+#endif /* UDP0 */
+
+#ifdef TCP0
+    testPrint(verbose, "TCP hash and scan find the same sockets");
+    failif(0 != tcpBench(&scan, &hash), "");
+    demuxReport(verbose, "TCP", scan, hash);
+#endif /* TCP0 */
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else /* UDP0 || TCP0 */
+    testSkip(TRUE, "");
+#endif /* !(UDP0 || TCP0) */
+    return OK;
+}
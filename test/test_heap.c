@@ -0,0 +1,211 @@
+#include <stddef.h>
+#include <memory.h>
+#include <clock.h>
+#include <interrupt.h>
+#include <stdio.h>
+#include <testsuite.h>
+
+#define HEAP_NFRAG    256       /* blocks allocated before punching holes */
+#define HEAP_FRAG     48        /* size of each of those blocks          */
+#define HEAP_BIG      1024      /* request that fits in none of the holes */
+#define HEAP_ROUNDS   64        /* allocate/free pairs timed             */
+#define HEAP_ARENA    (HEAP_NFRAG * HEAP_FRAG + 4 * HEAP_BIG)
+
+/* The first-fit list allocator that memget() used to be, over a private
+ * arena, as a baseline. */
+static void *ffget(struct memblock *list, uint nbytes)
+{
+    struct memblock *prev, *curr, *leftover;
+
+    nbytes = (ulong)roundmb(nbytes);
+    prev = list;
+    curr = list->next;
+    while (curr != NULL)
+    {
+        if (curr->length == nbytes)
+        {
+            prev->next = curr->next;
+            list->length -= nbytes;
+            return (void *)curr;
+        }
+        else if (curr->length > nbytes)
+        {
+            leftover = (struct memblock *)((ulong)curr + nbytes);
+            prev->next = leftover;
+            leftover->next = curr->next;
+            leftover->length = curr->length - nbytes;
+            list->length -= nbytes;
+            return (void *)curr;
+        }
+        prev = curr;
+        curr = curr->next;
+    }
+    return (void *)SYSERR;
+}
+
+static void fffree(struct memblock *list, void *memptr, uint nbytes)
+{
+    struct memblock *block, *next, *prev;
+
+    block = (struct memblock *)memptr;
+    nbytes = (ulong)roundmb(nbytes);
+    prev = list;
+    next = list->next;
+    while ((next != NULL) && (next < block))
+    {
+        prev = next;
+        next = next->next;
+    }
+    list->length += nbytes;
+    if ((prev != list) && ((ulong)prev + prev->length == (ulong)block))
+    {
+        prev->length += nbytes;
+        block = prev;
+    }
+    else
+    {
+        block->next = next;
+        block->length = nbytes;
+        prev->next = block;
+    }
+    if (((ulong)block + block->length) == (ulong)next)
+    {
+        block->length += next->length;
+        block->next = next->next;
+    }
+}
+
+/* Worst-case cycles of a request that skips every hole, on either
+ * allocator.  Interrupts must be disabled. */
+static void heapWorst(struct memblock *list, ulong *get, ulong *put)
+{
+    ulong start, t;
+    void *p;
+    int i;
+
+    *get = *put = 0;
+    for (i = 0; i < HEAP_ROUNDS; i++)
+    {
+        start = clkcount();
+        p = list ? ffget(list, HEAP_BIG) : memget(HEAP_BIG);
+        t = clkcount() - start;
+        if (t > *get)
+        {
+            *get = t;
+        }
+        if (SYSERR == (int)p)
+        {
+            *get = *put = 0;
+            return;
+        }
+
+        start = clkcount();
+        if (list)
+        {
+            fffree(list, p, HEAP_BIG);
+        }
+        else
+        {
+            memfree(p, HEAP_BIG);
+        }
+        t = clkcount() - start;
+        if (t > *put)
+        {
+            *put = t;
+        }
+    }
+}
+
+/**
+ * Heap latency benchmark.  Fragments the heap on purpose by allocating
+ * many small blocks and freeing every other one, then measures the worst
+ * case cost of allocating and freeing a block that fits in none of the
+ * holes.  The first-fit list allocator walks every hole on both calls;
+ * the TLSF heap should not notice the holes at all.
+ */
+thread test_heap(bool verbose)
+{
+    bool passed = TRUE;
+    struct memblock arena;
+    void *frags[HEAP_NFRAG];
+    void *base;
+    ulong ffget_worst, fffree_worst, get_worst, free_worst;
+    uint before;
+    int i, n;
+    irqmask im;
+    char msg[80];
+
+    before = memlist.length;
+
+    /* Fragment a private arena run by the old first-fit allocator. */
+    testPrint(verbose, "First-fit list, fragmented");
+    base = memget(HEAP_ARENA);
+    failif(SYSERR == (int)base, "no memory for arena");
+    if (SYSERR == (int)base)
+    {
+        return OK;
+    }
+    arena.next = (struct memblock *)base;
+    arena.length = HEAP_ARENA;
+    arena.next->next = NULL;
+    arena.next->length = HEAP_ARENA;
+    for (i = 0; i < HEAP_NFRAG; i++)
+    {
+        frags[i] = ffget(&arena, HEAP_FRAG);
+    }
+    for (i = 0; i < HEAP_NFRAG; i += 2)
+    {
+        fffree(&arena, frags[i], HEAP_FRAG);
+    }
+
+    im = disable();
+    heapWorst(&arena, &ffget_worst, &fffree_worst);
+    restore(im);
+    memfree(base, HEAP_ARENA);
+
+    /* Fragment the real heap the same way. */
+    testPrint(verbose, "TLSF heap, fragmented");
+    n = 0;
+    for (i = 0; i < HEAP_NFRAG; i++)
+    {
+        frags[i] = memget(HEAP_FRAG);
+        if (SYSERR == (int)frags[i])
+        {
+            break;
+        }
+        n++;
+    }
+    for (i = 0; i < n; i += 2)
+    {
+        memfree(frags[i], HEAP_FRAG);
+    }
+
+    im = disable();
+    heapWorst(NULL, &get_worst, &free_worst);
+    restore(im);
+
+    for (i = 1; i < n; i += 2)
+    {
+        memfree(frags[i], HEAP_FRAG);
+    }
+    failif((n != HEAP_NFRAG) || (0 == get_worst), "memget() failed");
+
+    sprintf(msg, "\nfirst-fit worst %u get, %u free; "
+            "TLSF worst %u get, %u free (cycles)\n",
+            (uint)ffget_worst, (uint)fffree_worst, (uint)get_worst,
+            (uint)free_worst);
+    testPrint(verbose, msg);
+
+    testPrint(verbose, "Heap accounting restored");
+    failif(memlist.length != before, "memlist.length changed");
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+    return OK;
+}
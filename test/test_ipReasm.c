@@ -0,0 +1,297 @@
+/**
+ * @file     test_ipReasm.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <bufpool.h>
+#include <clock.h>
+#include <device.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <memory.h>
+#include <network.h>
+#include <stdio.h>
+#include <string.h>
+#include <testsuite.h>
+#include <thread.h>
+#include <udp.h>
+
+#if defined(ELOOP) && NUDP && NNETIF
+
+#define REASM_LEN     4000      /* data in the datagrams put together    */
+#define REASM_PORT    5003      /* port the loopback datagrams go to     */
+#define REASM_BYTES   (1024 * 1024)     /* octets sent each way timed    */
+#define REASM_SMALL   1024      /* data in a small datagram              */
+
+static uchar reasmdata[REASM_LEN];
+
+/* Fragment of a datagram from src to dst holding data [start, end) of
+ * reasmdata, with more to come if mf.  Returns NULL if no buffer. */
+static struct packet *reasmFrag(const struct netaddr *src,
+                                const struct netaddr *dst, ushort id,
+                                uint start, uint end, bool mf)
+{
+    struct packet *pkt;
+    struct ipv4Pkt *ip;
+
+    pkt = netGetbuf();
+    if (SYSERR == (int)pkt)
+    {
+        return NULL;
+    }
+    pkt->linkhdr = pkt->data;
+    pkt->nethdr = pkt->linkhdr + ETH_HDR_LEN;
+    pkt->curr = pkt->nethdr;
+    pkt->len = ETH_HDR_LEN + IPv4_HDR_LEN + end - start;
+
+    ip = (struct ipv4Pkt *)pkt->nethdr;
+    ip->ver_ihl = (uchar)(IPv4_VERSION << 4) + IPv4_HDR_LEN / 4;
+    ip->len = hs2net(IPv4_HDR_LEN + end - start);
+    ip->id = hs2net(id);
+    ip->flags_froff = hs2net((mf ? IPv4_FLAG_MF : 0) | (start / 8));
+    ip->ttl = IPv4_TTL;
+    ip->proto = IPv4_PROTO_UDP;
+    memcpy(ip->src, src->addr, IPv4_ADDR_LEN);
+    memcpy(ip->dst, dst->addr, IPv4_ADDR_LEN);
+    ip->chksum = netChksum(ip, IPv4_HDR_LEN);
+    memcpy(ip->opts, reasmdata + start, end - start);
+    return pkt;
+}
+
+/* Hand n fragments, given as start, end and more-to-come triples, to
+ * ipv4Reasm().  Returns TRUE if the last, and only the last, completed the
+ * datagram, and the datagram is reasmdata with a valid header. */
+static bool reasmRun(const struct netaddr *src, const struct netaddr *dst,
+                     ushort id, const uint *frags, int n)
+{
+    struct packet *pkt, *done;
+    struct ipv4Pkt *ip;
+    bool ok = TRUE;
+    int i;
+
+    done = NULL;
+    for (i = 0; i < n; i++)
+    {
+        pkt = reasmFrag(src, dst, id, frags[3 * i], frags[3 * i + 1],
+                        frags[3 * i + 2]);
+        if (NULL == pkt)
+        {
+            return FALSE;
+        }
+        pkt = ipv4Reasm(pkt);
+        if ((pkt != NULL) && (i != n - 1))
+        {
+            ok = FALSE;
+            netFreebuf(pkt);
+        }
+        else if (pkt != NULL)
+        {
+            done = pkt;
+        }
+    }
+    if (NULL == done)
+    {
+        return FALSE;
+    }
+
+    ip = (struct ipv4Pkt *)done->nethdr;
+    if ((done->curr != done->nethdr)
+        || (net2hs(ip->len) != IPv4_HDR_LEN + REASM_LEN)
+        || (0 != ip->flags_froff) || (0 != netChksum(ip, IPv4_HDR_LEN))
+        || (done->len != ETH_HDR_LEN + IPv4_HDR_LEN + REASM_LEN)
+        || (0 != memcmp(ip->opts, reasmdata, REASM_LEN)))
+    {
+        ok = FALSE;
+    }
+    netFreebuf(done);
+    return ok;
+}
+
+/* Make every datagram held time out, and let the reassembly timer drop
+ * them.  Returns the number of fragments still held. */
+static uint reasmFlush(void)
+{
+    irqmask im;
+    int i;
+
+    im = disable();
+    for (i = 0; i < IPv4_REASM_NENTRY; i++)
+    {
+        if (IPv4_REASM_USED == ipv4reasmtab[i].state)
+        {
+            ipv4reasmtab[i].expires = clktime - 1;
+        }
+    }
+    restore(im);
+    ipv4ReasmExpire();
+    return ipv4reasmnbuf;
+}
+
+#endif /* ELOOP && NUDP && NNETIF */
+
+/**
+ * IPv4 fragment reassembly test and benchmark.  Hands fragments straight
+ * to ipv4Reasm() in order, in reverse, with duplicates, with overlaps and
+ * with one covering another, and checks the datagram put together; checks
+ * that truncated fragments are dropped, that no more fragments than the
+ * limit are held, and that datagrams that time out are dropped.  Then
+ * sends 64 KB UDP datagrams to itself over the loopback interface, and
+ * reports cycles per KB against the same data in small datagrams.
+ */
+thread test_ipReasm(bool verbose)
+{
+#if defined(ELOOP) && NUDP && NNETIF
+    static const uint inorder[] = {
+        0, 1480, 1, 1480, 2960, 1, 2960, REASM_LEN, 0
+    };
+    static const uint reverse[] = {
+        2960, REASM_LEN, 0, 1480, 2960, 1, 0, 1480, 1
+    };
+    static const uint overlap[] = {
+        1600, 2400, 1, 0, 800, 1, 1600, 2400, 1, 400, 2000, 1,
+        2400, REASM_LEN, 0
+    };
+    static const uint cover[] = {
+        800, 1600, 1, 1600, 2000, 1, 0, 2400, 1, 2000, REASM_LEN, 0
+    };
+    struct netaddr ip, far;
+    struct netif *netptr;
+    struct packet *pkt;
+    uchar *out, *in;
+    ulong big, small;
+    uint nbuf, held;
+    int freebuf, i, j;
+    ushort dev;
+    bool passed = TRUE;
+    char msg[100];
+
+    /* Fragments go to the address the loopback interface is given */
+    ip.type = NETADDR_IPv4;
+    ip.len = IPv4_ADDR_LEN;
+    ip.addr[0] = 192;
+    ip.addr[1] = 168;
+    ip.addr[2] = 1;
+    ip.addr[3] = 6;
+    far.type = NETADDR_IPv4;
+    far.len = IPv4_ADDR_LEN;
+    far.addr[0] = 10;
+    far.addr[1] = 99;
+    far.addr[2] = 0;
+    far.addr[3] = 1;
+    for (i = 0; i < REASM_LEN; i++)
+    {
+        reasmdata[i] = (i * 7) ^ (i >> 8);
+    }
+    held = ipv4reasmnbuf;
+    freebuf = semcount(bfptab[netpool].freebuf);
+
+    testPrint(verbose, "Fragments in order");
+    failif(!reasmRun(&far, &ip, 1, inorder, 3), "");
+
+    testPrint(verbose, "Fragments in reverse");
+    failif(!reasmRun(&far, &ip, 2, reverse, 3), "");
+
+    testPrint(verbose, "Duplicate and overlapping fragments");
+    failif(!reasmRun(&far, &ip, 3, overlap, 5), "");
+
+    testPrint(verbose, "Fragment covering another");
+    failif(!reasmRun(&far, &ip, 4, cover, 4), "");
+    failif((ipv4reasmnbuf != held)
+           || (semcount(bfptab[netpool].freebuf) != freebuf), "");
+
+    testPrint(verbose, "Truncated fragment");
+    pkt = reasmFrag(&far, &ip, 5, 0, 1480, TRUE);
+    if (pkt != NULL)
+    {
+        /* The header claims more than the packet holds */
+        pkt->len -= 8;
+        failif(NULL != ipv4Reasm(pkt), "");
+    }
+    failif((ipv4reasmnbuf != held)
+           || (semcount(bfptab[netpool].freebuf) != freebuf), "");
+
+    testPrint(verbose, "Fragments held are bounded");
+    nbuf = 0;
+    for (i = 0; i < 2 * IPv4_REASM_NENTRY; i++)
+    {
+        for (j = 0; j < IPv4_REASM_NFRAG; j++)
+        {
+            /* 8 octets out of every 16, never complete */
+            pkt = reasmFrag(&far, &ip, 100 + i, 16 * j + 8, 16 * j + 16,
+                            TRUE);
+            if (pkt != NULL)
+            {
+                ipv4Reasm(pkt);
+            }
+            if (ipv4reasmnbuf > nbuf)
+            {
+                nbuf = ipv4reasmnbuf;
+            }
+        }
+    }
+    failif(nbuf > IPv4_REASM_NBUF, "");
+
+    testPrint(verbose, "Datagrams time out");
+    failif(0 != reasmFlush(), "");
+    failif(semcount(bfptab[netpool].freebuf) != freebuf, "");
+
+    testPrint(verbose, "64 KB datagrams over loopback");
+    netptr = testNetUp(&ip);
+    out = memget(UDP_MAX_DATALEN);
+    in = memget(UDP_MAX_DATALEN);
+    dev = (ushort)SYSERR;
+    if ((netptr != NULL) && (SYSERR != (int)out) && (SYSERR != (int)in))
+    {
+        dev = testNetUdpOpen(&ip, REASM_PORT);
+    }
+    if ((ushort)SYSERR == dev)
+    {
+        failif(TRUE, "no loopback interface, UDP device or memory");
+    }
+    else
+    {
+        for (i = 0; i < UDP_MAX_DATALEN; i++)
+        {
+            out[i] = i ^ (i >> 9);
+        }
+        big = testNetUdpLoop(dev, out, in, UDP_MAX_DATALEN, REASM_BYTES);
+        small = testNetUdpLoop(dev, out, in, REASM_SMALL, REASM_BYTES);
+        close(dev);
+        failif((0 == big) || (0 == small), "");
+        if ((big != 0) && (small != 0))
+        {
+            sprintf(msg, "\n%u KB each way: %u cycles/KB in %u octet "
+                    "datagrams, %u in %u octet datagrams\n",
+                    REASM_BYTES / 1024, (uint)(big / (REASM_BYTES / 1024)),
+                    UDP_MAX_DATALEN, (uint)(small / (REASM_BYTES / 1024)),
+                    REASM_SMALL);
+            testPrint(verbose, msg);
+        }
+    }
+    if (SYSERR != (int)out)
+    {
+        memfree(out, UDP_MAX_DATALEN);
+    }
+    if (SYSERR != (int)in)
+    {
+        memfree(in, UDP_MAX_DATALEN);
+    }
+    if (netptr != NULL)
+    {
+        testNetDown();
+    }
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else /* ELOOP && NUDP && NNETIF */
+    testSkip(TRUE, "");
+#endif /* !(ELOOP && NUDP && NNETIF) */
+    return OK;
+}
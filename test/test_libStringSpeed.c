@@ -0,0 +1,226 @@
+#include <stddef.h>
+#include <string.h>
+#include <clock.h>
+#include <interrupt.h>
+#include <stdio.h>
+#include <testsuite.h>
+
+#define SPEED_BUFLEN  (4096 + 8)    /* largest size plus room to misalign */
+#define SPEED_ROUNDS  16            /* calls timed per measurement        */
+#define SPEED_CHECK   80            /* lengths checked against byte loops */
+
+static uchar speed_src[SPEED_BUFLEN];
+static uchar speed_dst[SPEED_BUFLEN];
+
+/* Byte-at-a-time versions, as libxc used to have, for checking results
+ * and as a baseline. */
+static void bytecpy(uchar *dest, const uchar *src, uint n)
+{
+    uint i;
+
+    for (i = 0; i < n; i++)
+    {
+        dest[i] = src[i];
+    }
+}
+
+static int bytecmp(const uchar *p1, const uchar *p2, uint n)
+{
+    uint i;
+
+    for (i = 0; i < n; i++)
+    {
+        if (p1[i] != p2[i])
+        {
+            return (int)p1[i] - (int)p2[i];
+        }
+    }
+    return 0;
+}
+
+static int sign(int x)
+{
+    return (x > 0) - (x < 0);
+}
+
+/* Compare each function with the byte loops for every short length and
+ * every pair of alignments.  Returns the number of wrong results. */
+static int speedCheck(void)
+{
+    uchar *s, *d;
+    uint n, so, dof, i;
+    int errors = 0;
+
+    for (so = 0; so < 4; so++)
+    {
+        for (dof = 0; dof < 4; dof++)
+        {
+            for (n = 0; n < SPEED_CHECK; n++)
+            {
+                s = speed_src + so;
+                d = speed_dst + dof;
+                for (i = 0; i < n + 8; i++)
+                {
+                    s[i] = 'a' + (i * 7 + so) % 23;
+                }
+                s[n] = '\0';
+                memset(speed_dst, 0x5a, n + 8);
+
+                memcpy(d, s, n);
+                if ((0 != bytecmp(d, s, n)) || (0x5a != d[n]))
+                {
+                    errors++;
+                }
+                memset(d, so, n);
+                for (i = 0; i < n; i++)
+                {
+                    if (d[i] != so)
+                    {
+                        errors++;
+                        break;
+                    }
+                }
+                if (0x5a != d[n])
+                {
+                    errors++;
+                }
+
+                bytecpy(d, s, n + 1);
+                if ((0 != memcmp(d, s, n)) || (strlen((char *)s) != n))
+                {
+                    errors++;
+                }
+                if (n > 0)
+                {
+                    d[n - 1]++;
+                    if (sign(memcmp(d, s, n)) != sign(bytecmp(d, s, n)))
+                    {
+                        errors++;
+                    }
+                    d[n / 2] = '#';
+                    if ((memchr(d, '#', n) != &d[n / 2])
+                        || (strchr((char *)d, '#') != (char *)&d[n / 2]))
+                    {
+                        errors++;
+                    }
+                }
+                if ((memchr(s, '#', n) != NULL)
+                    || (strchr((char *)s, '#') != NULL)
+                    || (strchr((char *)s, '\0') != (char *)&s[n]))
+                {
+                    errors++;
+                }
+            }
+        }
+    }
+    return errors;
+}
+
+/* Cycles taken by one call of a function, best of SPEED_ROUNDS. */
+static ulong speedTime(int which, uchar *d, uchar *s, uint n)
+{
+    ulong start, t, best;
+    irqmask im;
+    int i;
+
+    best = (ulong)-1;
+    im = disable();
+    for (i = 0; i < SPEED_ROUNDS; i++)
+    {
+        start = clkcount();
+        switch (which)
+        {
+        case 0:
+            bytecpy(d, s, n);
+            break;
+        case 1:
+            memcpy(d, s, n);
+            break;
+        case 2:
+            memset(d, i, n);
+            break;
+        case 3:
+            memcmp(d, s, n);
+            break;
+        case 4:
+            strlen((char *)s);
+            break;
+        }
+        t = clkcount() - start;
+        if (t < best)
+        {
+            best = t;
+        }
+    }
+    restore(im);
+    return (best > 0) ? best : 1;
+}
+
+/* Throughput in hundredths of a byte per cycle. */
+static uint speedRate(uint n, ulong cycles)
+{
+    return (ulong)n * 100 / cycles;
+}
+
+/**
+ * Throughput of the libxc memory and string functions.  Checks them
+ * against plain byte loops first, then reports bytes/cycle of memcpy,
+ * memset, memcmp and strlen over a range of sizes, with source and
+ * destination both aligned, both misaligned by the same amount, and
+ * misaligned relative to each other.  A byte-at-a-time copy is timed
+ * alongside as a baseline.
+ */
+thread test_libStringSpeed(bool verbose)
+{
+    static const uint sizes[] = { 16, 64, 256, 1514, 4096 };
+    static const uint soff[] = { 0, 1, 1 };
+    static const uint doff[] = { 0, 1, 2 };
+    static const char *const align[] = {
+        "aligned", "both +1", "src+1/dst+2"
+    };
+    bool passed = TRUE;
+    uchar *s, *d;
+    uint i, j, k, n;
+    uint rate[5];
+    char msg[100];
+
+    testPrint(verbose, "Results match byte-at-a-time loops");
+    failif(0 != speedCheck(), "");
+
+    for (j = 0; j < sizeof(soff) / sizeof(soff[0]); j++)
+    {
+        sprintf(msg, "\nbytes/cycle, %s:", align[j]);
+        testPrint(verbose, msg);
+        for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        {
+            n = sizes[i];
+            s = speed_src + soff[j];
+            d = speed_dst + doff[j];
+            memset(s, 'x', n);
+            s[n - 1] = '\0';
+            memcpy(d, s, n);
+
+            for (k = 0; k < 5; k++)
+            {
+                rate[k] = speedRate(n, speedTime(k, d, s, n));
+            }
+            sprintf(msg, "\n%5u: loop %u.%02u memcpy %u.%02u memset %u.%02u "
+                    "memcmp %u.%02u strlen %u.%02u", n,
+                    rate[0] / 100, rate[0] % 100, rate[1] / 100, rate[1] % 100,
+                    rate[2] / 100, rate[2] % 100, rate[3] / 100, rate[3] % 100,
+                    rate[4] / 100, rate[4] % 100);
+            testPrint(verbose, msg);
+        }
+    }
+    testPrint(verbose, "\n");
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+    return OK;
+}
@@ -101,17 +101,26 @@ thread test_memory(bool verbose)
 }
 
 /**
- * Computes size of free list by add length of each hop, and
- * compares this sum with the value maintained in memlist->length
+ * Walks the kernel heap block by block, and compares the free space plus
+ * the overhead of allocated blocks with the value maintained in
+ * memlist->length
  */
 static bool list_check(void)
 {
-    struct memblock *mptr;
-    int free = 0;
+    struct memhdr *block;
+    uint free = 0;
 
-    for (mptr = memlist.next; mptr != NULL; mptr = mptr->next)
+    for (block = (struct memhdr *)memheap; block != NULL;
+         block = memislast(block) ? NULL : memnext(block))
     {
-        free += mptr->length;
+        if (block->size & MEM_FREE)
+        {
+            free += memsize(block);
+        }
+        else
+        {
+            free += (block->size & MEM_SLACK) ? 2 * MEMHDRSIZE : MEMHDRSIZE;
+        }
     }
 
     if (memlist.length == free)
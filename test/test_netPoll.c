@@ -0,0 +1,252 @@
+/**
+ * @file     test_netPoll.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <bufpool.h>
+#include <clock.h>
+#include <device.h>
+#include <ethloop.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <network.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <testsuite.h>
+#include <thread.h>
+
+#if defined(ELOOP) && NNETIF
+
+#define POLL_NTHR     2         /* receive threads of the test interface  */
+#define POLL_NPKT     64        /* frames written, one flow each          */
+#define POLL_WAIT     1000      /* ms to wait for the frames to be taken  */
+
+#define POLL_FRAMELEN (ETH_HDR_LEN + IPv4_HDR_LEN + 8)
+
+static uchar pollframes[POLL_NPKT][POLL_FRAMELEN];
+
+/* Counts of an interface before and after writing the frames */
+struct pollCount
+{
+    uint npkt[NET_NTHR_MAX];
+    uint nsignal;
+    uint nrxintr;
+    uint npoll;
+};
+
+/* Fill in frame i, a UDP datagram of its own flow to a hardware address
+ * that is not the loopback device's, so the receive threads drop it. */
+static void pollFrame(uchar *frame, uint i)
+{
+    struct etherPkt *ether;
+    struct ipv4Pkt *ip;
+    uchar *ports;
+
+    bzero(frame, POLL_FRAMELEN);
+    ether = (struct etherPkt *)frame;
+    memset(ether->dst, 0xEE, ETH_ADDR_LEN);
+    ether->type = hs2net(ETHER_TYPE_IPv4);
+    ip = (struct ipv4Pkt *)ether->data;
+    ip->ver_ihl = (uchar)(IPv4_VERSION << 4) + IPv4_HDR_LEN / 4;
+    ip->len = hs2net(IPv4_HDR_LEN + 8);
+    ip->ttl = IPv4_TTL;
+    ip->proto = IPv4_PROTO_UDP;
+    ip->src[0] = 10;
+    ip->src[3] = i;
+    ip->dst[0] = 192;
+    ip->dst[1] = 168;
+    ip->dst[2] = 1;
+    ip->dst[3] = 6;
+    ports = ip->opts;
+    ports[0] = 4000 >> 8;
+    ports[1] = 4000 & 0xFF;
+    ports[3] = 80;
+}
+
+/* Writes the frames one at a time, at a priority above the receive
+ * threads, as a NIC interrupts whatever thread is running. */
+static thread pollWriter(void)
+{
+    uint i;
+
+    for (i = 0; i < POLL_NPKT; i++)
+    {
+        write(ELOOP, pollframes[i], POLL_FRAMELEN);
+    }
+    return OK;
+}
+
+/* Store the counts of an interface in @p count */
+static void pollCounts(const struct netif *netptr, struct pollCount *count)
+{
+    uint i;
+
+    count->nsignal = 0;
+    for (i = 0; i < netptr->nthr; i++)
+    {
+        count->npkt[i] = netptr->rxq[i].npkt;
+        count->nsignal += netptr->rxq[i].nsignal;
+    }
+    count->nrxintr = netptr->nrxintr;
+    count->npoll = netptr->npoll;
+}
+
+/* Write the frames from pollWriter() and wait for the receive threads to
+ * take them.  Stores the cycles taken and the counts of the interface
+ * since the frames were written in @p diff.  Returns TRUE if each thread
+ * took the frames meant for it. */
+static bool pollLoop(struct netif *netptr, ulong *cycles,
+                     struct pollCount *diff)
+{
+    uint expect[NET_NTHR_MAX];
+    struct pollCount before, after;
+    struct packet *pkt;
+    ulong start;
+    uint i, done;
+    int ms;
+
+    pkt = netGetbuf();
+    if (SYSERR == (int)pkt)
+    {
+        return FALSE;
+    }
+    for (i = 0; i < netptr->nthr; i++)
+    {
+        expect[i] = 0;
+    }
+    for (i = 0; i < POLL_NPKT; i++)
+    {
+        pollFrame(pollframes[i], i);
+        memcpy(pkt->data, pollframes[i], POLL_FRAMELEN);
+        pkt->len = POLL_FRAMELEN;
+        expect[netRxqSelect(netptr, pkt)]++;
+    }
+    netFreebuf(pkt);
+
+    netptr->rxq[0].maxcount = 0;
+    pollCounts(netptr, &before);
+    start = clkcount();
+    ready(create(pollWriter, INITSTK, NET_THR_PRIO + 1, "pollwriter", 0),
+          RESCHED_YES);
+
+    done = 0;
+    for (ms = 0; (ms < POLL_WAIT) && (done < netptr->nthr); ms++)
+    {
+        for (done = 0; done < netptr->nthr; done++)
+        {
+            if (netptr->rxq[done].npkt - before.npkt[done] != expect[done])
+            {
+                break;
+            }
+        }
+        if (done < netptr->nthr)
+        {
+            sleep(1);
+        }
+    }
+    *cycles = clkcount() - start;
+
+    pollCounts(netptr, &after);
+    diff->nsignal = after.nsignal - before.nsignal;
+    diff->nrxintr = after.nrxintr - before.nrxintr;
+    diff->npoll = after.npoll - before.npoll;
+    return (done == netptr->nthr);
+}
+
+#endif /* ELOOP && NNETIF */
+
+/**
+ * Budgeted receive polling test and benchmark.  Writes frames to a
+ * loopback interface from a thread above the receive threads, as a NIC
+ * interrupts them, and checks that with the driver polled the frames
+ * reach their threads after one receive interrupt, taken at most
+ * ::NET_POLL_BUDGET a poll.  Then does the same with frames steered as
+ * they are written, and reports the cycles per frame and the receive
+ * thread wakeups of each.
+ */
+thread test_netPoll(bool verbose)
+{
+#if defined(ELOOP) && NNETIF
+    struct netaddr ip, mask;
+    struct netif *netptr;
+    struct pollCount poll, intr;
+    ulong pcycles, icycles;
+    int i;
+    bool passed = TRUE;
+    char msg[120];
+
+    ip.type = NETADDR_IPv4;
+    ip.len = IPv4_ADDR_LEN;
+    ip.addr[0] = 192;
+    ip.addr[1] = 168;
+    ip.addr[2] = 1;
+    ip.addr[3] = 6;
+    mask.type = NETADDR_IPv4;
+    mask.len = IPv4_ADDR_LEN;
+    mask.addr[0] = 255;
+    mask.addr[1] = 255;
+    mask.addr[2] = 255;
+    mask.addr[3] = 0;
+    bzero(&poll, sizeof(poll));
+    bzero(&intr, sizeof(intr));
+    pcycles = 0;
+    icycles = 0;
+    netptr = NULL;
+    if ((SYSERR != open(ELOOP))
+        && (SYSERR != netUpThreads(ELOOP, &ip, &mask, NULL, POLL_NTHR)))
+    {
+        for (i = 0; i < NNETIF; i++)
+        {
+            if ((NET_ALLOC == netiftab[i].state)
+                && (ELOOP == netiftab[i].dev))
+            {
+                netptr = &netiftab[i];
+                break;
+            }
+        }
+    }
+    if (NULL == netptr)
+    {
+        failif(TRUE, "no loopback interface");
+    }
+    else
+    {
+        testPrint(verbose, "Polled frames reach their threads");
+        failif(!netptr->poll || !pollLoop(netptr, &pcycles, &poll), "");
+
+        testPrint(verbose, "One interrupt, polled within budget");
+        failif((poll.nrxintr != 1)
+               || (poll.npoll < POLL_NPKT / NET_POLL_BUDGET)
+               || (netptr->rxq[0].maxcount > NET_POLL_BUDGET), "");
+
+        testPrint(verbose, "Steered frames reach their threads");
+        failif(SYSERR == control(ELOOP, NET_SET_POLL, FALSE, 0), "");
+        netptr->poll = FALSE;
+        failif(!pollLoop(netptr, &icycles, &intr) || (intr.npoll != 0), "");
+
+        testPrint(verbose, "Polling wakes the threads less");
+        failif(poll.nsignal >= intr.nsignal, "");
+        sprintf(msg, "\n%u frames: polled %u cycles/frame, %u wakeups; "
+                "steered %u cycles/frame, %u wakeups\n", POLL_NPKT,
+                (uint)(pcycles / POLL_NPKT), poll.nsignal,
+                (uint)(icycles / POLL_NPKT), intr.nsignal);
+        testPrint(verbose, msg);
+        netDown(ELOOP);
+    }
+    close(ELOOP);
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else /* ELOOP && NNETIF */
+    testSkip(TRUE, "");
+#endif /* !(ELOOP && NNETIF) */
+    return OK;
+}
@@ -0,0 +1,230 @@
+/**
+ * @file     test_netSeg.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <bufpool.h>
+#include <clock.h>
+#include <device.h>
+#include <ethloop.h>
+#include <ipv4.h>
+#include <memory.h>
+#include <network.h>
+#include <stdio.h>
+#include <string.h>
+#include <testsuite.h>
+#include <thread.h>
+#include <udp.h>
+
+#if defined(ELOOP) && NUDP && NNETIF
+
+#define SEG_HEAD      40        /* octets of a test frame in its buffer   */
+#define SEG_NSEG      3         /* segments of a test frame               */
+#define SEG_PORT      5004      /* port the loopback datagrams go to      */
+#define SEG_BYTES     (1024 * 1024)     /* octets sent each way timed     */
+
+static uchar segframe[ELOOP_MTU + ETH_HDR_LEN];
+static uchar segcopy[ELOOP_MTU + ETH_HDR_LEN + 1];
+
+/* Set up a packet whose frame is segframe: SEG_HEAD octets in its buffer,
+ * then SEG_NSEG segments of uneven length over the rest of len. */
+static void segBuild(struct packet *pkt, struct netSeg *seg, uint len)
+{
+    uint i, off, n;
+
+    memcpy(pkt->curr, segframe, SEG_HEAD);
+    off = SEG_HEAD;
+    for (i = 0; i < SEG_NSEG; i++)
+    {
+        n = (i == SEG_NSEG - 1) ? len - off : (len - off) / 3 + i;
+        seg[i].data = segframe + off;
+        seg[i].len = n;
+        seg[i].next = (i == SEG_NSEG - 1) ? NULL : &seg[i + 1];
+        off += n;
+    }
+    pkt->len = len;
+    pkt->segs = seg;
+    pkt->seglen = len - SEG_HEAD;
+}
+
+/* Check netGather() over every offset that starts in or near each piece,
+ * and netLinearize().  Returns TRUE if all copies match the frame. */
+static bool segGather(uint len)
+{
+    struct netSeg seg[SEG_NSEG];
+    struct packet *pkt, *copy;
+    uint off, n;
+    bool ok = TRUE;
+
+    pkt = netGetbuf();
+    if (SYSERR == (int)pkt)
+    {
+        return FALSE;
+    }
+    pkt->curr = pkt->data;
+    segBuild(pkt, seg, len);
+
+    for (off = 0; off < len; off += 7)
+    {
+        n = (off * 5) % (len - off) + 1;
+        memset(segcopy, 0, sizeof(segcopy));
+        if ((netGather(segcopy, pkt, off, n) != n)
+            || (0 != memcmp(segcopy, segframe + off, n))
+            || (0 != segcopy[n]))
+        {
+            ok = FALSE;
+        }
+    }
+    if (netGather(segcopy, pkt, len - 1, 10) != 1)
+    {
+        ok = FALSE;
+    }
+
+    copy = netLinearize(pkt);
+    if ((SYSERR == (int)copy) || (copy->len != len) || (copy->segs != NULL)
+        || (0 != memcmp(copy->curr, segframe, len)))
+    {
+        ok = FALSE;
+    }
+    if (SYSERR != (int)copy)
+    {
+        netFreebuf(copy);
+    }
+    netFreebuf(pkt);
+    return ok;
+}
+
+/* Write a frame with segments to the loopback device with NET_SEND_PKTS,
+ * and read it back.  Returns TRUE if it came back whole. */
+static bool segLoop(uint len)
+{
+    struct netSeg seg[SEG_NSEG];
+    struct packet *pkt;
+    bool ok;
+
+    pkt = netGetbuf();
+    if (SYSERR == (int)pkt)
+    {
+        return FALSE;
+    }
+    pkt->curr = pkt->data;
+    segBuild(pkt, seg, len);
+    ok = (1 == control(ELOOP, NET_SEND_PKTS, (long)&pkt, 1));
+    netFreebuf(pkt);
+
+    memset(segcopy, 0, sizeof(segcopy));
+    return ok && (len == read(ELOOP, segcopy, len))
+        && (0 == memcmp(segcopy, segframe, len));
+}
+
+#endif /* ELOOP && NUDP && NNETIF */
+
+/**
+ * Scatter-gather send test and benchmark.  Checks netGather() and
+ * netLinearize() on packets whose frames are split among segments, and
+ * that the loopback driver gathers them.  Then sends 64 KB UDP datagrams,
+ * whose fragments refer to the caller's data, to itself over the loopback
+ * interface, and reports cycles per KB with the driver gathering them and
+ * with each fragment copied by netLinearize() first, as for a driver that
+ * cannot gather.
+ */
+thread test_netSeg(bool verbose)
+{
+#if defined(ELOOP) && NUDP && NNETIF
+    struct netaddr ip;
+    struct netif *netptr;
+    uchar *out, *in;
+    ulong gather, linear;
+    int freebuf, i;
+    ushort dev;
+    bool sendpkts;
+    bool passed = TRUE;
+    char msg[100];
+
+    for (i = 0; i < sizeof(segframe); i++)
+    {
+        segframe[i] = (i * 11) ^ (i >> 8);
+    }
+    freebuf = semcount(bfptab[netpool].freebuf);
+
+    testPrint(verbose, "Gather and linearize");
+    failif(!segGather(ETH_HDR_LEN + 64) || !segGather(sizeof(segframe)),
+           "");
+    failif(semcount(bfptab[netpool].freebuf) != freebuf, "");
+
+    testPrint(verbose, "Loopback driver gathers");
+    if (SYSERR == open(ELOOP))
+    {
+        failif(TRUE, "");
+    }
+    else
+    {
+        failif(!segLoop(ETH_HDR_LEN + 64) || !segLoop(sizeof(segframe)),
+               "");
+        close(ELOOP);
+    }
+
+    testPrint(verbose, "64 KB datagrams over loopback");
+    netptr = testNetUp(&ip);
+    out = memget(UDP_MAX_DATALEN);
+    in = memget(UDP_MAX_DATALEN);
+    dev = (ushort)SYSERR;
+    if ((netptr != NULL) && (SYSERR != (int)out) && (SYSERR != (int)in))
+    {
+        dev = testNetUdpOpen(&ip, SEG_PORT);
+    }
+    if ((ushort)SYSERR == dev)
+    {
+        failif(TRUE, "no loopback interface, UDP device or memory");
+    }
+    else
+    {
+        for (i = 0; i < UDP_MAX_DATALEN; i++)
+        {
+            out[i] = i ^ (i >> 9);
+        }
+        gather = testNetUdpLoop(dev, out, in, UDP_MAX_DATALEN, SEG_BYTES);
+
+        /* As for a driver that cannot gather */
+        sendpkts = netptr->sendpkts;
+        netptr->sendpkts = FALSE;
+        linear = testNetUdpLoop(dev, out, in, UDP_MAX_DATALEN, SEG_BYTES);
+        netptr->sendpkts = sendpkts;
+        close(dev);
+        failif((0 == gather) || (0 == linear), "");
+        if ((gather != 0) && (linear != 0))
+        {
+            sprintf(msg, "\n%u KB each way: %u cycles/KB gathered, "
+                    "%u linearized\n", SEG_BYTES / 1024,
+                    (uint)(gather / (SEG_BYTES / 1024)),
+                    (uint)(linear / (SEG_BYTES / 1024)));
+            testPrint(verbose, msg);
+        }
+    }
+    if (SYSERR != (int)out)
+    {
+        memfree(out, UDP_MAX_DATALEN);
+    }
+    if (SYSERR != (int)in)
+    {
+        memfree(in, UDP_MAX_DATALEN);
+    }
+    if (netptr != NULL)
+    {
+        testNetDown();
+    }
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else /* ELOOP && NUDP && NNETIF */
+    testSkip(TRUE, "");
+#endif /* !(ELOOP && NUDP && NNETIF) */
+    return OK;
+}
@@ -0,0 +1,313 @@
+/**
+ * @file     test_netSteer.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <bufpool.h>
+#include <device.h>
+#include <ethloop.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <network.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <testsuite.h>
+#include <thread.h>
+
+#if defined(ELOOP) && NNETIF
+
+#define STEER_NTHR    4         /* receive threads of the test interface  */
+#define STEER_NFLOW   32        /* flows spread over the threads          */
+#define STEER_NPKT    5         /* frames written of each flow            */
+#define STEER_WAIT    1000      /* ms to wait for the frames to be taken  */
+
+static struct netif steerif;
+
+/* Fill in a frame to steerif from src:port to 192.168.1.6:80 with protocol
+ * proto, and the fragment offset and flags given. */
+static void steerFrame(struct packet *pkt, uchar src, ushort port,
+                       uchar proto, ushort froff)
+{
+    struct etherPkt *ether;
+    struct ipv4Pkt *ip;
+    uchar *ports;
+
+    bzero(pkt->data, ETH_HDR_LEN + IPv4_HDR_LEN + 8);
+    ether = (struct etherPkt *)pkt->data;
+    memset(ether->dst, 0xEE, ETH_ADDR_LEN);
+    ether->type = hs2net(ETHER_TYPE_IPv4);
+    ip = (struct ipv4Pkt *)ether->data;
+    ip->ver_ihl = (uchar)(IPv4_VERSION << 4) + IPv4_HDR_LEN / 4;
+    ip->len = hs2net(IPv4_HDR_LEN + 8);
+    ip->flags_froff = hs2net(froff);
+    ip->ttl = IPv4_TTL;
+    ip->proto = proto;
+    ip->src[0] = 10;
+    ip->src[3] = src;
+    ip->dst[0] = 192;
+    ip->dst[1] = 168;
+    ip->dst[2] = 1;
+    ip->dst[3] = 6;
+    ports = ip->opts;
+    ports[0] = port >> 8;
+    ports[1] = port & 0xFF;
+    ports[3] = 80;
+    pkt->len = ETH_HDR_LEN + IPv4_HDR_LEN + 8;
+}
+
+/* Check that netRxqSelect() keeps flows and datagrams together, sends ARP
+ * to the first thread, and spreads flows over the threads.  Returns TRUE
+ * if it does. */
+static bool steerSelect(struct packet *pkt)
+{
+    struct etherPkt *ether;
+    uint q, used, i, n;
+    bool ok = TRUE;
+
+    steerif.nthr = STEER_NTHR;
+    steerif.linkhdrlen = ETH_HDR_LEN;
+
+    used = 0;
+    for (i = 0; i < STEER_NFLOW; i++)
+    {
+        steerFrame(pkt, 1, 1000 + i, IPv4_PROTO_TCP, 0);
+        q = netRxqSelect(&steerif, pkt);
+        pkt->data[pkt->len - 1] = i;
+        if ((q >= STEER_NTHR) || (netRxqSelect(&steerif, pkt) != q))
+        {
+            ok = FALSE;
+        }
+        used |= 1 << q;
+    }
+    for (n = 0; used != 0; used &= used - 1)
+    {
+        n++;
+    }
+    if (n < STEER_NTHR - 1)
+    {
+        ok = FALSE;
+    }
+
+    /* Fragments of a datagram go to one thread, whatever their offset */
+    steerFrame(pkt, 2, 1000, IPv4_PROTO_UDP, IPv4_FLAG_MF);
+    q = netRxqSelect(&steerif, pkt);
+    steerFrame(pkt, 2, 0xFFFF, IPv4_PROTO_UDP, 185);
+    if (netRxqSelect(&steerif, pkt) != q)
+    {
+        ok = FALSE;
+    }
+
+    /* ARP goes to the first thread, as does everything with one thread */
+    ether = (struct etherPkt *)pkt->data;
+    ether->type = hs2net(ETHER_TYPE_ARP);
+    if (netRxqSelect(&steerif, pkt) != 0)
+    {
+        ok = FALSE;
+    }
+    steerFrame(pkt, 3, 1000, IPv4_PROTO_UDP, 0);
+    steerif.nthr = 1;
+    if (netRxqSelect(&steerif, pkt) != 0)
+    {
+        ok = FALSE;
+    }
+    steerif.nthr = STEER_NTHR;
+    return ok;
+}
+
+/* Fill one queue of steerif past its length, then take the frames back.
+ * Returns TRUE if the queue kept them in order, counted them and dropped
+ * the one that did not fit. */
+static bool steerQueue(void)
+{
+    struct packet *pkt, *sent[NET_RXQ_LEN];
+    struct netRxq *rxq;
+    uint q, i, n;
+    int result;
+    irqmask im;
+    bool ok = TRUE;
+
+    for (i = 0; i < STEER_NTHR; i++)
+    {
+        bzero(&steerif.rxq[i], sizeof(struct netRxq));
+        steerif.rxq[i].sem = semcreate(0);
+    }
+
+    n = 0;
+    q = 0;
+    im = disable();
+    for (i = 0; i <= NET_RXQ_LEN; i++)
+    {
+        pkt = bufgetnb(netpool);
+        if (SYSERR == (int)pkt)
+        {
+            break;
+        }
+        steerFrame(pkt, 4, 2000, IPv4_PROTO_UDP, 0);
+        result = netRxqPut(&steerif, pkt);
+        if (SYSERR == result)
+        {
+            break;
+        }
+        q = result;
+        sent[n++] = pkt;
+    }
+    restore(im);
+    netRxqWake(&steerif);
+
+    rxq = &steerif.rxq[q];
+    if ((n != NET_RXQ_LEN) || (rxq->count != n) || (rxq->maxcount != n)
+        || (rxq->ndrop != 1) || (semcount(rxq->sem) != n))
+    {
+        ok = FALSE;
+    }
+    for (i = 0; i < n; i++)
+    {
+        pkt = netRxqTake(&steerif, q);
+        if (pkt != sent[i])
+        {
+            ok = FALSE;
+        }
+        netFreebuf(pkt);
+    }
+    for (i = 0; i < STEER_NTHR; i++)
+    {
+        semfree(steerif.rxq[i].sem);
+    }
+    return ok;
+}
+
+/* Write STEER_NPKT frames of each of STEER_NFLOW flows to the loopback
+ * interface, whose threads drop them as they are not to its hardware
+ * address.  Returns TRUE if each thread took the frames meant for it. */
+static bool steerLoop(struct netif *netptr)
+{
+    uint expect[NET_NTHR_MAX], before[NET_NTHR_MAX];
+    uchar frame[ETH_HDR_LEN + IPv4_HDR_LEN + 8];
+    struct packet *pkt;
+    uint i, j, done;
+    int ms;
+
+    pkt = netGetbuf();
+    if (SYSERR == (int)pkt)
+    {
+        return FALSE;
+    }
+    for (i = 0; i < netptr->nthr; i++)
+    {
+        expect[i] = 0;
+        before[i] = netptr->rxq[i].npkt;
+    }
+    for (i = 0; i < STEER_NFLOW; i++)
+    {
+        steerFrame(pkt, 5 + i, 3000, IPv4_PROTO_UDP, 0);
+        expect[netRxqSelect(netptr, pkt)] += STEER_NPKT;
+        memcpy(frame, pkt->data, pkt->len);
+        for (j = 0; j < STEER_NPKT; j++)
+        {
+            write(ELOOP, frame, pkt->len);
+        }
+    }
+    netFreebuf(pkt);
+
+    done = 0;
+    for (ms = 0; (ms < STEER_WAIT) && (done < netptr->nthr); ms++)
+    {
+        sleep(1);
+        for (done = 0; done < netptr->nthr; done++)
+        {
+            if (netptr->rxq[done].npkt - before[done] != expect[done])
+            {
+                break;
+            }
+        }
+    }
+    return (done == netptr->nthr);
+}
+
+#endif /* ELOOP && NNETIF */
+
+/**
+ * Receive flow steering.  Checks that netRxqSelect() sends each flow, and
+ * each fragmented datagram, to one receive thread and spreads flows over
+ * the threads, that receive queues hold and drop frames as they should,
+ * and that frames written to a loopback interface with STEER_NTHR receive
+ * threads are taken by the thread their flow is steered to.
+ */
+thread test_netSteer(bool verbose)
+{
+#if defined(ELOOP) && NNETIF
+    struct netaddr ip, mask;
+    struct netif *netptr;
+    struct packet *pkt;
+    int freebuf, i;
+    bool passed = TRUE;
+
+    freebuf = semcount(bfptab[netpool].freebuf);
+
+    testPrint(verbose, "Flows keep to one thread");
+    pkt = netGetbuf();
+    failif((SYSERR == (int)pkt) || !steerSelect(pkt), "");
+    if (SYSERR != (int)pkt)
+    {
+        netFreebuf(pkt);
+    }
+
+    testPrint(verbose, "Receive queue holds and drops frames");
+    failif(!steerQueue(), "");
+    failif(semcount(bfptab[netpool].freebuf) != freebuf, "");
+
+    testPrint(verbose, "Loopback frames reach their threads");
+    ip.type = NETADDR_IPv4;
+    ip.len = IPv4_ADDR_LEN;
+    ip.addr[0] = 192;
+    ip.addr[1] = 168;
+    ip.addr[2] = 1;
+    ip.addr[3] = 6;
+    mask.type = NETADDR_IPv4;
+    mask.len = IPv4_ADDR_LEN;
+    mask.addr[0] = 255;
+    mask.addr[1] = 255;
+    mask.addr[2] = 255;
+    mask.addr[3] = 0;
+    netptr = NULL;
+    if ((SYSERR != open(ELOOP))
+        && (SYSERR != netUpThreads(ELOOP, &ip, &mask, NULL, STEER_NTHR)))
+    {
+        for (i = 0; i < NNETIF; i++)
+        {
+            if ((NET_ALLOC == netiftab[i].state)
+                && (ELOOP == netiftab[i].dev))
+            {
+                netptr = &netiftab[i];
+                break;
+            }
+        }
+    }
+    if (NULL == netptr)
+    {
+        failif(TRUE, "no loopback interface");
+    }
+    else
+    {
+        failif((netptr->nthr != STEER_NTHR) || !netptr->steer
+               || !steerLoop(netptr), "");
+        netDown(ELOOP);
+    }
+    close(ELOOP);
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else /* ELOOP && NNETIF */
+    testSkip(TRUE, "");
+#endif /* !(ELOOP && NNETIF) */
+    return OK;
+}
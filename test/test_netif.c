@@ -125,13 +125,14 @@ thread test_netif(bool verbose)
         }
     }
 
-    /* Kill receiver threads */
+    /* Kill receiver threads, and have frames queued for read() again */
     netptr = &netiftab[i];
-    for (i = 0; i < NET_NTHR; i++)
+    for (i = 0; i < netptr->nthr; i++)
     {
         kill(netptr->recvthr[i]);
         netptr->recvthr[i] = BADTID;
     }
+    control(ELOOP, NET_SET_STEER, 0, 0);
 
     testPrint(verbose, "Get packet buffer");
     pkt = netGetbuf();
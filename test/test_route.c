@@ -0,0 +1,391 @@
+/**
+ * @file     test_route.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <arp.h>
+#include <bufpool.h>
+#include <clock.h>
+#include <device.h>
+#include <ethloop.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <network.h>
+#include <route.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <testsuite.h>
+#include <thread.h>
+
+#if defined(ELOOP) && NNETIF
+
+#define RTB_NROUTE   20         /* routes added on top of the interface's */
+#define RTB_NDST     64         /* distinct destinations looked up        */
+#define RTB_NPKT     (4 * RT_NQUEUE)   /* packets forwarded               */
+#define RTB_DATALEN  64         /* payload of each forwarded packet       */
+#define RTB_NSEND    64         /* packets timed sent to one destination  */
+
+static void rtbAddr(struct netaddr *addr, uchar a, uchar b, uchar c, uchar d)
+{
+    addr->type = NETADDR_IPv4;
+    addr->len = IPv4_ADDR_LEN;
+    addr->addr[0] = a;
+    addr->addr[1] = b;
+    addr->addr[2] = c;
+    addr->addr[3] = d;
+}
+
+/* The scan over the whole route table that rtLookup() used to be. */
+static struct rtEntry *rtbScan(const struct netaddr *addr)
+{
+    struct rtEntry *rtptr = NULL;
+    struct netaddr masked;
+    int i;
+
+    for (i = 0; i < RT_NENTRY; i++)
+    {
+        if (RT_USED == rttab[i].state)
+        {
+            netaddrcpy(&masked, addr);
+            netaddrmask(&masked, &rttab[i].mask);
+            if (netaddrequal(&masked, &rttab[i].dst)
+                && ((NULL == rtptr) || (rtptr->masklen < rttab[i].masklen)))
+            {
+                rtptr = &rttab[i];
+            }
+        }
+    }
+    return rtptr;
+}
+
+/* Destination i, spread over the routes added and some that only match
+ * the interface or default routes. */
+static void rtbDst(struct netaddr *dst, int i)
+{
+    rtbAddr(dst, 10, i % (RTB_NROUTE + 4), i, 5);
+}
+
+/* Cycles per lookup of every destination: 0 with the old scan, 1 with the
+ * trie, 2 with rtLookup() of a destination that is in the route cache.
+ * Counts lookups that disagree with the scan in *errors. */
+static ulong rtbTime(int how, int *errors)
+{
+    struct netaddr dst;
+    struct rtEntry *rtptr;
+    ulong start, t;
+    uint addr;
+    int i;
+    irqmask im;
+
+    t = 0;
+    for (i = 0; i < RTB_NDST; i++)
+    {
+        rtbDst(&dst, (2 == how) ? 0 : i);
+        addr = ((uint)dst.addr[0] << 24) | ((uint)dst.addr[1] << 16)
+            | ((uint)dst.addr[2] << 8) | dst.addr[3];
+        im = disable();
+        start = clkcount();
+        switch (how)
+        {
+        case 0:
+            rtptr = rtbScan(&dst);
+            break;
+        case 1:
+            rtptr = rtTrieLookup(addr);
+            break;
+        default:
+            rtptr = rtLookup(&dst);
+            break;
+        }
+        t += clkcount() - start;
+        restore(im);
+        if (rtptr != rtbScan(&dst))
+        {
+            (*errors)++;
+        }
+    }
+    return t / RTB_NDST;
+}
+
+/* Put a resolved ARP entry for the gateway in place, so that packets
+ * sent to it need no ARP request. */
+static struct arpEntry *rtbArp(struct netif *netptr,
+                               const struct netaddr *gate)
+{
+    struct arpEntry *entry;
+    irqmask im;
+
+    im = disable();
+    entry = arpAlloc();
+    if (SYSERR != (int)entry)
+    {
+        entry->state = ARP_RESOLVED;
+        entry->nif = netptr;
+        netaddrcpy(&entry->praddr, gate);
+        netaddrcpy(&entry->hwaddr, &netptr->hwaddr);
+        entry->expires = clktime + ARP_TTL_RESOLVED;
+        arpHashInsert(entry);
+    }
+    restore(im);
+    return entry;
+}
+
+/* Push RTB_NPKT packets through rtRecv(), rtDaemon() and rtSend(), out of
+ * the loopback interface with an ARP entry already in place for the
+ * gateway.  Returns cycles per packet, 0 on failure. */
+static ulong rtbForward(struct netif *netptr, const struct netaddr *gate)
+{
+    struct packet *pkt[RT_NQUEUE];
+    struct ipv4Pkt *ip;
+    struct arpEntry *entry;
+    struct netaddr dst;
+    semaphore freebuf;
+    ulong start, t;
+    int before, n, i, j, wait;
+    irqmask im;
+
+    entry = rtbArp(netptr, gate);
+    if (SYSERR == (int)entry)
+    {
+        return 0;
+    }
+
+    control(netptr->dev, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_DROPALL, 0);
+    freebuf = bfptab[netpool].freebuf;
+    before = semcount(freebuf);
+
+    t = 0;
+    for (n = 0; n < RTB_NPKT; n += RT_NQUEUE)
+    {
+        for (i = 0; i < RT_NQUEUE; i++)
+        {
+            pkt[i] = netGetbuf();
+            pkt[i]->nethdr = pkt[i]->curr = pkt[i]->data + ETH_HDR_LEN;
+            pkt[i]->len = IPv4_HDR_LEN + RTB_DATALEN;
+            ip = (struct ipv4Pkt *)pkt[i]->nethdr;
+            ip->ver_ihl = (IPv4_VERSION << 4) | (IPv4_HDR_LEN / 4);
+            ip->len = hs2net(pkt[i]->len);
+            ip->ttl = IPv4_TTL;
+            ip->proto = IPv4_PROTO_UDP;
+            rtbDst(&dst, n + i);
+            memcpy(ip->dst, dst.addr, IPv4_ADDR_LEN);
+            rtbAddr(&dst, 172, 16, 0, 1);
+            memcpy(ip->src, dst.addr, IPv4_ADDR_LEN);
+            ip->chksum = netChksum((uchar *)ip, IPv4_HDR_LEN);
+        }
+
+        /* The daemon has the same priority as the test, so it forwards
+         * each packet as soon as it is queued. */
+        start = clkcount();
+        for (i = 0; i < RT_NQUEUE; i++)
+        {
+            rtRecv(pkt[i]);
+        }
+        for (wait = 0; (semcount(freebuf) < before) && (wait < 100); wait++)
+        {
+            yield();
+        }
+        t += clkcount() - start;
+
+        if (semcount(freebuf) < before)
+        {
+            for (j = 0; (semcount(freebuf) < before) && (j < 10); j++)
+            {
+                sleep(10);
+            }
+            t = 0;
+            break;
+        }
+    }
+
+    control(netptr->dev, ELOOP_CTRL_CLRFLAG, ELOOP_FLAG_DROPALL, 0);
+    im = disable();
+    arpFree(entry);
+    restore(im);
+    return t / RTB_NPKT;
+}
+
+/* Cycles per packet to send RTB_NSEND small UDP packets from src to dst
+ * with ipv4Send(), or with ipv4SendDst() if given a destination cache.
+ * Returns 0 if one could not be sent. */
+static ulong rtbSend(struct netaddr *src, struct netaddr *dst,
+                     struct netDst *dc)
+{
+    struct packet *pkt;
+    ulong start, t;
+    int i, result;
+    irqmask im;
+
+    t = 0;
+    for (i = 0; i < RTB_NSEND; i++)
+    {
+        pkt = netGetbuf();
+        if (SYSERR == (int)pkt)
+        {
+            return 0;
+        }
+        pkt->curr -= RTB_DATALEN;
+        pkt->len = RTB_DATALEN;
+
+        im = disable();
+        start = clkcount();
+        if (NULL == dc)
+        {
+            result = ipv4Send(pkt, src, dst, IPv4_PROTO_UDP);
+        }
+        else
+        {
+            result = ipv4SendDst(pkt, src, dst, IPv4_PROTO_UDP, dc);
+        }
+        t += clkcount() - start;
+        restore(im);
+
+        netFreebuf(pkt);
+        if (result != OK)
+        {
+            return 0;
+        }
+    }
+    return t / RTB_NSEND;
+}
+
+#endif /* ELOOP && NNETIF */
+
+/**
+ * Routing benchmark.  Brings up the loopback interface, adds a number of
+ * routes, and compares the old scan over the route table with the trie
+ * and with the route cache in cycles per lookup.  Then forwards packets
+ * through the route daemon and out of the loopback interface, and compares
+ * sending packets with a lookup of the route and the gateway's hardware
+ * address each time and with a destination cache, which a route change
+ * or a dropped ARP entry must invalidate.
+ */
+thread test_route(bool verbose)
+{
+#if defined(ELOOP) && NNETIF
+    struct netaddr ip, mask, gate, dst, rmask, net;
+    struct netif *netptr;
+    struct arpEntry *entry;
+    struct netDst dc;
+    ulong scan, trie, cached, fwd, plain, direct;
+    int i, nroute, nused, errors;
+    uint gen;
+    bool ok;
+    bool passed = TRUE;
+    char msg[100];
+    irqmask im;
+
+    rtbAddr(&ip, 192, 168, 1, 6);
+    rtbAddr(&mask, 255, 255, 255, 0);
+    rtbAddr(&gate, 192, 168, 1, 1);
+    rtbAddr(&rmask, 255, 255, 0, 0);
+
+    testPrint(verbose, "Initialization");
+    netptr = NULL;
+    if ((SYSERR != open(ELOOP))
+        && (SYSERR != netUp(ELOOP, &ip, &mask, &gate)))
+    {
+        for (i = 0; i < NNETIF; i++)
+        {
+            if (ELOOP == netiftab[i].dev)
+            {
+                netptr = &netiftab[i];
+                break;
+            }
+        }
+    }
+    failif(NULL == netptr, "loopback interface not up");
+    if (NULL == netptr)
+    {
+        close(ELOOP);
+        return OK;
+    }
+
+    for (nroute = 0; nroute < RTB_NROUTE; nroute++)
+    {
+        rtbAddr(&dst, 10, nroute, 0, 0);
+        if (OK != rtAdd(&dst, &gate, &rmask, netptr))
+        {
+            break;
+        }
+    }
+
+    testPrint(verbose, "Lookups agree with route table scan");
+    errors = 0;
+    scan = rtbTime(0, &errors);
+    trie = rtbTime(1, &errors);
+    rtbTime(2, &errors);
+    cached = rtbTime(2, &errors);
+    failif(0 != errors, "");
+    nused = 0;
+    for (i = 0; i < RT_NENTRY; i++)
+    {
+        if (RT_USED == rttab[i].state)
+        {
+            nused++;
+        }
+    }
+    sprintf(msg, "\n%d routes: scan %u, trie %u, cached %u cycles/lookup\n",
+            nused, (uint)scan, (uint)trie, (uint)cached);
+    testPrint(verbose, msg);
+
+    testPrint(verbose, "Forward packets");
+    fwd = rtbForward(netptr, &gate);
+    failif(0 == fwd, "");
+    sprintf(msg, "\n%d packets: %u cycles/packet\n", RTB_NPKT, (uint)fwd);
+    testPrint(verbose, msg);
+
+    testPrint(verbose, "Destination cache");
+    entry = rtbArp(netptr, &gate);
+    control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_DROPALL, 0);
+    bzero(&dc, sizeof(dc));
+    rtbDst(&dst, 1);
+    ok = (SYSERR != (int)entry) && (OK == netDstLookup(&dc, &dst))
+        && (netptr == dc.nif) && netaddrequal(&gate, &dc.nxthop);
+    plain = rtbSend(&ip, &dst, NULL);
+    direct = rtbSend(&ip, &dst, &dc);
+    ok = ok && (plain != 0) && (direct != 0);
+
+    /* The route to dst goes, and the default route takes over */
+    gen = dc.rtgen;
+    rtbAddr(&net, 10, 1, 0, 0);
+    rtRemove(&net);
+    ok = ok && (OK == netDstLookup(&dc, &dst)) && (dc.rtgen != gen);
+
+    /* Without the gateway's hardware address nothing is cached */
+    if (SYSERR != (int)entry)
+    {
+        im = disable();
+        arpFree(entry);
+        restore(im);
+    }
+    ok = ok && (SYSERR == netDstLookup(&dc, &dst));
+    control(ELOOP, ELOOP_CTRL_CLRFLAG, ELOOP_FLAG_DROPALL, 0);
+    failif(!ok, "");
+    sprintf(msg, "\n%d packets: %u cycles/packet, %u with a destination "
+            "cache\n", RTB_NSEND, (uint)plain, (uint)direct);
+    testPrint(verbose, msg);
+
+    for (i = 0; i < nroute; i++)
+    {
+        rtbAddr(&dst, 10, i, 0, 0);
+        rtRemove(&dst);
+    }
+    netDown(ELOOP);
+    close(ELOOP);
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else /* ELOOP && NNETIF */
+    testSkip(TRUE, "");
+#endif /* !(ELOOP && NNETIF) */
+    return OK;
+}
@@ -0,0 +1,161 @@
+#include <stddef.h>
+#include <memory.h>
+#include <clock.h>
+#include <interrupt.h>
+#include <stdio.h>
+#include <testsuite.h>
+
+#define SLAB_NOBJ     40        /* objects allocated per size           */
+#define SLAB_NFRAG    200       /* heap blocks used to fragment memlist */
+#define SLAB_ROUNDS   200       /* allocate/free pairs timed            */
+
+/* Objects handed out by all size classes. */
+static uint slabInuse(void)
+{
+    uint i, inuse = 0;
+
+    for (i = 0; i < NSLABCLASS; i++)
+    {
+        inuse += slabtab[i].inuse;
+    }
+    return inuse;
+}
+
+/* Allocate and free a batch of objects of one size, checking alignment,
+ * overlap and the in-use counters. */
+static bool slabBatch(uint nbytes)
+{
+    uchar *objs[SLAB_NOBJ];
+    uint inuse, i, j;
+    bool ok = TRUE;
+
+    inuse = slabInuse();
+    for (i = 0; i < SLAB_NOBJ; i++)
+    {
+        objs[i] = slabget(nbytes);
+        if ((SYSERR == (int)objs[i]) || ((ulong)objs[i] & 0x7))
+        {
+            ok = FALSE;
+            break;
+        }
+        for (j = 0; j < nbytes; j++)
+        {
+            objs[i][j] = i;
+        }
+    }
+
+    /* every object must still hold its own pattern */
+    while (i-- > 0)
+    {
+        for (j = 0; j < nbytes; j++)
+        {
+            if (objs[i][j] != (uchar)i)
+            {
+                ok = FALSE;
+            }
+        }
+        if (SYSERR == slabfree(objs[i], nbytes))
+        {
+            ok = FALSE;
+        }
+    }
+
+    if (slabInuse() != inuse)
+    {
+        ok = FALSE;
+    }
+    return ok;
+}
+
+/**
+ * Slab allocator test and benchmark.  Exercises every size class, checks
+ * that bogus frees are refused, then fragments the kernel heap and
+ * compares the cost of small allocations from slabs against first-fit
+ * memget().
+ */
+thread test_slab(bool verbose)
+{
+    static const uint sizes[] = { 1, 8, 16, 17, 100, 256, 1000, 2048,
+        4096, 4097, 10000
+    };
+    bool passed = TRUE;
+    void *frag[SLAB_NFRAG];
+    void *p;
+    uint i, nfrag;
+    ulong start, first, slab;
+    irqmask im;
+    char msg[80];
+
+    testPrint(verbose, "Allocate and free each size class");
+    sprintf(msg, "slabget() or slabfree() failed");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        if (!slabBatch(sizes[i]))
+        {
+            sprintf(msg, "failed for %u bytes", sizes[i]);
+            break;
+        }
+    }
+    failif(i < sizeof(sizes) / sizeof(sizes[0]), msg);
+
+    testPrint(verbose, "Refuse bad frees");
+    p = slabget(64);
+    failif((SYSERR == (int)p)
+           || (SYSERR != slabfree((uchar *)p + 8, 64))
+           || (OK != slabfree(p, 64)),
+           "bad slabfree() accepted");
+
+    /* Leave holes all over the kernel free list. */
+    nfrag = 0;
+    for (i = 0; i < SLAB_NFRAG; i++)
+    {
+        frag[nfrag] = memget(24 + (i % 7) * 40);
+        if (SYSERR == (int)frag[nfrag])
+        {
+            break;
+        }
+        nfrag++;
+    }
+    for (i = 0; i < nfrag; i += 2)
+    {
+        memfree(frag[i], 24 + (i % 7) * 40);
+    }
+
+    im = disable();
+    start = clkcount();
+    for (i = 0; i < SLAB_ROUNDS; i++)
+    {
+        p = memget(300);
+        memfree(p, 300);
+    }
+    first = clkcount() - start;
+
+    start = clkcount();
+    for (i = 0; i < SLAB_ROUNDS; i++)
+    {
+        p = slabget(300);
+        slabfree(p, 300);
+    }
+    slab = clkcount() - start;
+    restore(im);
+
+    for (i = 1; i < nfrag; i += 2)
+    {
+        memfree(frag[i], 24 + (i % 7) * 40);
+    }
+
+    sprintf(msg, "\nfirst-fit %u, slab %u cycles/pair\n",
+            (uint)(first / SLAB_ROUNDS), (uint)(slab / SLAB_ROUNDS));
+    testPrint(verbose, msg);
+    failif(nfrag < SLAB_NFRAG, "could not fragment heap");
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+    return OK;
+}
@@ -0,0 +1,293 @@
+/**
+ * @file     test_tcpAccept.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <clock.h>
+#include <device.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <network.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <tcp.h>
+#include <testsuite.h>
+#include <thread.h>
+
+#if defined(ELOOP) && defined(TCP0) && (NTCP > 2) && NNETIF
+
+#define STORM_PORT    5002      /* port the listener listens on          */
+#define STORM_NCONN   ((NTCP - 1) / 2)  /* clients started at once, each */
+                                        /* taking two TCBs               */
+#define STORM_ROUNDS  20        /* bursts timed against the listener     */
+#define STORM_WAIT    (5 * CLKTICKS_PER_SEC)    /* give up after this    */
+#define STORM_SETTLE  100       /* ms for a burst's handshakes to finish */
+
+/* Milliseconds since boot */
+static ulong stormNow(void)
+{
+    return clktime * 1000 + (clkticks * 1000) / CLKTICKS_PER_SEC;
+}
+
+static int stormdev[STORM_NCONN];   /* client's device, SYSERR if refused */
+static int stormdone;               /* clients done connecting            */
+
+/* Client i: connect to the port and record the TCP device if the
+ * connection was made. */
+static thread stormClient(struct netaddr *ip, int i)
+{
+    int dev;
+    irqmask im;
+
+    dev = (short)tcpAlloc();
+    if (dev != SYSERR)
+    {
+        open(dev, ip, ip, NULL, STORM_PORT, TCP_ACTIVE);
+        /* A refused connection's TCB is already freed */
+        if (TCP_ESTAB != tcptab[devtab[dev].minor].state)
+        {
+            dev = SYSERR;
+        }
+    }
+    stormdev[i] = dev;
+    im = disable();
+    stormdone++;
+    restore(im);
+    return OK;
+}
+
+/* Server that waits for one connection with a passive open, as servers
+ * did before listeners, and stays until killed. */
+static thread stormPassive(struct netaddr *ip, ushort dev)
+{
+    open(dev, ip, NULL, STORM_PORT, NULL, TCP_PASSIVE);
+    receive();
+    return OK;
+}
+
+/* Delete a TCB without the closing handshake, as both ends are ours. */
+static void stormDrop(ushort dev)
+{
+    struct tcb *tcbptr;
+
+    tcbptr = &tcptab[devtab[dev].minor];
+    wait(tcbptr->mutex);
+    if (TCP_CLOSED == tcbptr->state)
+    {
+        tcbptr->devstate = TCP_FREE;
+        signal(tcbptr->mutex);
+    }
+    else
+    {
+        tcpFree(tcbptr);
+    }
+}
+
+/* Start n clients connecting at once. */
+static void stormStart(struct netaddr *ip, int n)
+{
+    int i;
+
+    stormdone = 0;
+    for (i = 0; i < n; i++)
+    {
+        ready(create((void *)stormClient, INITSTK, getprio(gettid()),
+                     "stormClient", 2, ip, i), RESCHED_NO);
+    }
+}
+
+/* Wait for n clients to finish connecting, giving up after STORM_WAIT.
+ * Puts the devices of those that connected in devs and returns how many
+ * there are. */
+static int stormCollect(int n, ushort *devs)
+{
+    int i, nconn, ms;
+
+    for (ms = 0; (stormdone < n) && (ms < STORM_WAIT); ms++)
+    {
+        sleep(1);
+    }
+    nconn = 0;
+    for (i = 0; i < stormdone; i++)
+    {
+        if (stormdev[i] != SYSERR)
+        {
+            devs[nconn++] = stormdev[i];
+        }
+    }
+    return nconn;
+}
+
+/* Accept n connections from a listener, as they are established, giving
+ * up after STORM_WAIT.  Puts the devices in devs and returns how many. */
+static int stormAccept(ushort listener, int n, ushort *devs)
+{
+    struct tcb *tcbptr;
+    int nacc, ms;
+
+    tcbptr = &tcptab[devtab[listener].minor];
+    nacc = 0;
+    for (ms = 0; (nacc < n) && (ms < STORM_WAIT); ms += 10)
+    {
+        while ((nacc < n) && (semcount(tcbptr->openclose) > 0))
+        {
+            devs[nacc++] = control(listener, TCP_CTRL_ACCEPT, 0, 0);
+        }
+        if (nacc < n)
+        {
+            sleep(10);
+        }
+    }
+    return nacc;
+}
+
+#endif /* ELOOP && TCP0 && NTCP > 2 && NNETIF */
+
+/**
+ * TCP connect storm benchmark.  Starts as many clients at once as there
+ * are TCBs for over the loopback interface: first against a server with a
+ * passive open, which takes one connection and refuses the rest, then
+ * against a listener, reporting connections per second over a number of
+ * bursts.  Then checks that a listener with a backlog of one takes every
+ * connection of a burst as the earlier ones are accepted, and that
+ * closing a listener resets connections that were not accepted.
+ */
+thread test_tcpAccept(bool verbose)
+{
+#if defined(ELOOP) && defined(TCP0) && (NTCP > 2) && NNETIF
+    struct netaddr ip;
+    struct netif *netptr;
+    struct tcb *lstptr;
+    ushort clients[STORM_NCONN], accepted[STORM_NCONN];
+    ushort listener, passive;
+    ulong start, cycles, ms;
+    int nconn, nacc, r, i;
+    bool ok, full;
+    tid_typ server;
+    bool passed = TRUE;
+    char msg[100];
+
+    for (i = 0; i < NTCP; i++)
+    {
+        if ((TCP_CLOSED != tcptab[i].state)
+            || (TCP_FREE != tcptab[i].devstate))
+        {
+            testSkip(TRUE, "TCP devices in use");
+            return OK;
+        }
+    }
+
+    testPrint(verbose, "Initialization");
+    netptr = testNetUp(&ip);
+    failif(NULL == netptr, "loopback interface not up");
+    if (NULL == netptr)
+    {
+        return OK;
+    }
+
+    testPrint(verbose, "Burst against a passive open");
+    passive = tcpAlloc();
+    server = create((void *)stormPassive, INITSTK, getprio(gettid()),
+                    "stormPassive", 2, &ip, passive);
+    ready(server, RESCHED_YES);
+    stormStart(&ip, STORM_NCONN);
+    nconn = stormCollect(STORM_NCONN, clients);
+    kill(server);
+    for (i = 0; i < nconn; i++)
+    {
+        stormDrop(clients[i]);
+    }
+    stormDrop(passive);
+    sprintf(msg, "\n%d of %d connections made\n", nconn, STORM_NCONN);
+    testPrint(verbose, msg);
+
+    testPrint(verbose, "Bursts against a listener");
+    listener = tcpAlloc();
+    lstptr = &tcptab[devtab[listener].minor];
+    ok = (SYSERR != open(listener, &ip, NULL, STORM_PORT, NULL,
+                         TCP_LISTENER));
+    cycles = 0;
+    ms = stormNow();
+    for (r = 0; ok && (r < STORM_ROUNDS); r++)
+    {
+        start = clkcount();
+        stormStart(&ip, STORM_NCONN);
+        nconn = stormCollect(STORM_NCONN, clients);
+        nacc = stormAccept(listener, nconn, accepted);
+        cycles += clkcount() - start;
+        ok = (STORM_NCONN == nconn) && (nconn == nacc);
+        for (i = 0; i < nconn; i++)
+        {
+            stormDrop(clients[i]);
+        }
+        for (i = 0; i < nacc; i++)
+        {
+            stormDrop(accepted[i]);
+        }
+    }
+    ms = stormNow() - ms;
+    failif(!ok, "");
+    if (ok)
+    {
+        sprintf(msg, "\n%d connections: %u cycles and %u us each, "
+                "%u/s\n", STORM_ROUNDS * STORM_NCONN,
+                (uint)(cycles / (STORM_ROUNDS * STORM_NCONN)),
+                (uint)(ms * 1000 / (STORM_ROUNDS * STORM_NCONN)),
+                (uint)(STORM_ROUNDS * STORM_NCONN * 1000 / (ms + 1)));
+        testPrint(verbose, msg);
+    }
+
+    testPrint(verbose, "Burst against a backlog of one");
+    control(listener, TCP_CTRL_BACKLOG, 1, 0);
+    ms = stormNow();
+    stormStart(&ip, STORM_NCONN);
+    sleep(STORM_SETTLE);
+    full = (lstptr->nchild > 1);
+    nacc = stormAccept(listener, STORM_NCONN, accepted);
+    nconn = stormCollect(STORM_NCONN, clients);
+    ms = stormNow() - ms;
+    failif(full || (nacc != STORM_NCONN) || (nconn != STORM_NCONN), "");
+    for (i = 0; i < nconn; i++)
+    {
+        stormDrop(clients[i]);
+    }
+    for (i = 0; i < nacc; i++)
+    {
+        stormDrop(accepted[i]);
+    }
+    control(listener, TCP_CTRL_BACKLOG, 0, 0);
+    sprintf(msg, "\n%d connections in %u ms\n", nconn, (uint)ms);
+    testPrint(verbose, msg);
+
+    testPrint(verbose, "Close resets unaccepted connections");
+    stormStart(&ip, STORM_NCONN);
+    nconn = stormCollect(STORM_NCONN, clients);
+    sleep(STORM_SETTLE);
+    ok = (lstptr->nchild == nconn) && (SYSERR != close(listener));
+    sleep(STORM_SETTLE);
+    for (i = 0; i < NTCP; i++)
+    {
+        if (TCP_CLOSED != tcptab[i].state)
+        {
+            ok = FALSE;
+            stormDrop(TCP0 + i);
+        }
+    }
+    failif(!ok || (nconn != STORM_NCONN), "");
+
+    testNetDown();
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else /* ELOOP && TCP0 && NTCP > 2 && NNETIF */
+    testSkip(TRUE, "");
+#endif /* !(ELOOP && TCP0 && NTCP > 2 && NNETIF) */
+    return OK;
+}
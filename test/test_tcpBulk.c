@@ -0,0 +1,463 @@
+/**
+ * @file     test_tcpBulk.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <clock.h>
+#include <device.h>
+#include <ethloop.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <network.h>
+#include <stdio.h>
+#include <string.h>
+#include <tcp.h>
+#include <testsuite.h>
+#include <thread.h>
+
+#if defined(ELOOP) && defined(TCP0) && (NTCP > 1) && NNETIF
+
+#define BULK_PORT     5001      /* port the receiving end listens on     */
+#define BULK_CHUNK    1024      /* octets per read() and write()         */
+#define BULK_LEN      (256 * 1024)  /* octets sent without loss          */
+#define BULK_LOSSLEN  (64 * 1024)   /* octets sent with segments dropped */
+#define BULK_NLOSS    4         /* segments dropped in that transfer     */
+#define BULK_WAIT     (30 * CLKTICKS_PER_SEC)   /* give up after this    */
+#define BULK_ROUNDS   16        /* ring copies timed, best one reported  */
+#define BULK_SMALLBUF 4096      /* buffers set for the last transfer     */
+#define BULK_SMALLLEN (16 * 1024)   /* octets sent through them          */
+#define BULK_NRATE    3         /* random loss rates tried               */
+#define BULK_TINY     16        /* octets per write() of a chatty sender */
+#define BULK_NSEG     32        /* full size segments timed sent at once */
+
+/* Random loss rates, in packets per 1000 */
+static const uint bulkrate[BULK_NRATE] = { 10, 20, 50 };
+
+static uchar bulkbuf[TCP_IBLEN];
+static uchar bulkring[TCP_IBLEN];
+static uint bulkrcvbuf;         /* receiving end's input buffer size     */
+static ulong bulkms;            /* milliseconds the last transfer took   */
+static uint bulkpkts;           /* packets the last transfer took        */
+static struct tcb bulktcb;      /* connection segments are timed sent on */
+
+/* Milliseconds since boot */
+static ulong bulkNow(void)
+{
+    return clktime * 1000 + (clkticks * 1000) / CLKTICKS_PER_SEC;
+}
+
+/* Octet at a given position of the stream sent. */
+static uchar bulkByte(uint pos)
+{
+    return (uchar)(pos * 7 + (pos >> 10));
+}
+
+/* Receiving end: accept one connection on TCP1, read len octets, check
+ * them, and send the parent OK or SYSERR. */
+static thread bulkServer(struct netaddr *ip, uint len, tid_typ parent)
+{
+    uchar buf[BULK_CHUNK];
+    uint count, i;
+    int result;
+
+    result = OK;
+    if (SYSERR == open(TCP1, ip, NULL, BULK_PORT, NULL, TCP_PASSIVE))
+    {
+        send(parent, SYSERR);
+        return SYSERR;
+    }
+    for (count = 0; count < len; count += BULK_CHUNK)
+    {
+        if (read(TCP1, buf, BULK_CHUNK) != BULK_CHUNK)
+        {
+            result = SYSERR;
+            break;
+        }
+        for (i = 0; i < BULK_CHUNK; i++)
+        {
+            if (buf[i] != bulkByte(count + i))
+            {
+                result = SYSERR;
+            }
+        }
+    }
+    bulkrcvbuf = control(TCP1, TCP_CTRL_GETRCVBUF, 0, 0);
+    send(parent, result);
+    close(TCP1);
+    return OK;
+}
+
+/* Tear down both ends of a transfer that went wrong, without the closing
+ * handshake that close() waits for. */
+static void bulkAbort(tid_typ server)
+{
+    struct tcb *tcbptr;
+    int i;
+
+    kill(server);
+    for (i = 0; i < 2; i++)
+    {
+        tcbptr = &tcptab[i];
+        wait(tcbptr->mutex);
+        if (TCP_CLOSED == tcbptr->state)
+        {
+            tcbptr->devstate = TCP_FREE;
+            signal(tcbptr->mutex);
+        }
+        else
+        {
+            tcpFree(tcbptr);
+        }
+    }
+}
+
+/* Send len octets from TCP0 to TCP1 over the loopback interface, chunk
+ * octets per write(), dropping nloss of the packets written to it along
+ * the way, and loss in 1000 of them at random.  Returns cycles per KB, or
+ * 0 if the transfer failed. */
+static ulong bulkSend(struct netaddr *ip, uint len, uint chunk, int nloss,
+                      uint loss)
+{
+    uchar buf[BULK_CHUNK];
+    ulong start, t, ms;
+    uint count, i, nout;
+    int result;
+    tid_typ server;
+
+    recvclr();
+    bulkrcvbuf = 0;
+    server = create((void *)bulkServer, INITSTK, getprio(gettid()),
+                    "bulkServer", 3, ip, len, gettid());
+    ready(server, RESCHED_YES);
+    if (SYSERR == open(TCP0, ip, ip, NULL, BULK_PORT, TCP_ACTIVE))
+    {
+        bulkAbort(server);
+        return 0;
+    }
+
+    control(ELOOP, ELOOP_CTRL_SETLOSS, loss, 0);
+    nout = elooptab[devtab[ELOOP].minor].nout;
+    ms = bulkNow();
+    start = clkcount();
+    for (count = 0; count < len; count += chunk)
+    {
+        if ((nloss > 0) && (count % (len / nloss) == len / (2 * nloss)))
+        {
+            control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_DROPNXT, NULL);
+        }
+        for (i = 0; i < chunk; i++)
+        {
+            buf[i] = bulkByte(count + i);
+        }
+        if (write(TCP0, buf, chunk) != chunk)
+        {
+            break;
+        }
+    }
+    result = recvtime(BULK_WAIT);
+    t = clkcount() - start;
+    bulkms = bulkNow() - ms;
+    bulkpkts = elooptab[devtab[ELOOP].minor].nout - nout;
+    control(ELOOP, ELOOP_CTRL_SETLOSS, 0, 0);
+
+    if ((count < len) || (result != OK))
+    {
+        bulkAbort(server);
+        return 0;
+    }
+    close(TCP0);
+    return t / (len / 1024);
+}
+
+/* Cycles to copy a full buffer into a ring starting half way round, octet
+ * by octet with a modulo as the TCP device used to, or with tcpRingPut(). */
+static ulong bulkRingTime(bool bulk)
+{
+    ulong start, t, best;
+    uint r, i;
+    irqmask im;
+
+    best = (ulong)-1;
+    im = disable();
+    for (r = 0; r < BULK_ROUNDS; r++)
+    {
+        start = clkcount();
+        if (bulk)
+        {
+            tcpRingPut(bulkring, TCP_IBLEN, TCP_IBLEN / 2, bulkbuf,
+                       TCP_IBLEN);
+        }
+        else
+        {
+            for (i = 0; i < TCP_IBLEN; i++)
+            {
+                bulkring[(TCP_IBLEN / 2 + i) % TCP_IBLEN] = bulkbuf[i];
+            }
+        }
+        t = clkcount() - start;
+        if (t < best)
+        {
+            best = t;
+        }
+    }
+    restore(im);
+    return best / (TCP_IBLEN / 1024);
+}
+
+/* Cycles per KB to build and write BULK_NSEG full size segments of a
+ * connection to ip, with the loopback device dropping them, one at a time
+ * with tcpSend() or in bursts with tcpSendBurst().  The connection is not
+ * in the TCB table, so nothing answers.  Returns 0 if the segments could
+ * not be sent in bursts. */
+static ulong bulkSegTime(struct netaddr *ip, bool burst)
+{
+    struct tcb *tcbptr;
+    ulong start, t, best;
+    uint r, i;
+    irqmask im;
+
+    tcbptr = &bulktcb;
+    memset(tcbptr, 0, sizeof(struct tcb));
+    tcbptr->state = TCP_ESTAB;
+    netaddrcpy(&tcbptr->localip, ip);
+    netaddrcpy(&tcbptr->remoteip, ip);
+    tcbptr->localpt = BULK_PORT + 1;
+    tcbptr->remotept = BULK_PORT;
+    tcbptr->out = bulkring;
+    tcbptr->obsize = TCP_IBLEN;
+    tcbptr->ibsize = TCP_IBLEN;
+    tcbptr->sndmss = TCP_INIT_MSS - TCP_HDR_LEN;
+    tcbptr->rcvmss = tcbptr->sndmss;
+
+    best = (ulong)-1;
+    for (r = 0; r < BULK_ROUNDS; r++)
+    {
+        im = disable();
+        start = clkcount();
+        if (burst)
+        {
+            if (BULK_NSEG != tcpSendBurst(tcbptr, tcbptr->sndnxt, 0,
+                                          BULK_NSEG))
+            {
+                restore(im);
+                return 0;
+            }
+        }
+        else
+        {
+            for (i = 0; i < BULK_NSEG; i++)
+            {
+                tcpSend(tcbptr, TCP_CTRL_ACK,
+                        tcbptr->sndnxt + i * tcbptr->sndmss, tcbptr->rcvnxt,
+                        (i * tcbptr->sndmss) % tcbptr->obsize,
+                        tcbptr->sndmss);
+            }
+        }
+        t = clkcount() - start;
+        restore(im);
+        if (t < best)
+        {
+            best = t;
+        }
+    }
+    return best / (BULK_NSEG * tcbptr->sndmss / 1024);
+}
+
+/* Retransmits, with tcpSendHole(), the hole at the end of a connection to
+ * ip whose FIN has been sent, and checks that the segment written carries
+ * the data of the hole and the FIN, and not an octet past the data.  The
+ * connection is not in the TCB table.  Returns TRUE if it does. */
+static bool bulkHoleFin(struct netaddr *ip)
+{
+    struct ethloop *elpptr;
+    struct tcb *tcbptr;
+    struct ipv4Pkt *ipv4;
+    struct tcpPkt *tcp;
+    uchar frame[ELOOP_BUFSIZE];
+    uint ihl, datalen;
+
+    tcbptr = &bulktcb;
+    memset(tcbptr, 0, sizeof(struct tcb));
+    tcbptr->state = TCP_FINWT1;
+    netaddrcpy(&tcbptr->localip, ip);
+    netaddrcpy(&tcbptr->remoteip, ip);
+    tcbptr->localpt = BULK_PORT + 1;
+    tcbptr->remotept = BULK_PORT;
+    tcbptr->out = bulkring;
+    tcbptr->obsize = TCP_IBLEN;
+    tcbptr->ibsize = TCP_IBLEN;
+    tcbptr->sndmss = TCP_INIT_MSS - TCP_HDR_LEN;
+    tcbptr->rcvmss = tcbptr->sndmss;
+    tcbptr->rxttime = TCP_RXT_MAXTIME;
+
+    /* BULK_TINY octets of data and the FIN, none of it acknowledged */
+    tcbptr->snduna = 1000;
+    tcbptr->sndhole = tcbptr->snduna;
+    tcbptr->sndfin = seqadd(tcbptr->snduna, BULK_TINY);
+    tcbptr->sndnxt = seqadd(tcbptr->sndfin, 1);
+    tcbptr->sndflg = TCP_FLG_FIN;
+    tcbptr->ocount = BULK_TINY;
+
+    elpptr = &elooptab[devtab[ELOOP].minor];
+    control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+    tcpSendHole(tcbptr);
+    tcpTimerPurge(tcbptr, TCP_EVT_RXT);
+    if (semcount(elpptr->hsem) < 1)
+    {
+        control(ELOOP, ELOOP_CTRL_CLRFLAG, ELOOP_FLAG_HOLDNXT, NULL);
+        return FALSE;
+    }
+    control(ELOOP, ELOOP_CTRL_GETHOLD, (long)frame, ELOOP_BUFSIZE);
+
+    ipv4 = (struct ipv4Pkt *)(frame + ETH_HDR_LEN);
+    ihl = (ipv4->ver_ihl & IPv4_IHL) * 4;
+    tcp = (struct tcpPkt *)((uchar *)ipv4 + ihl);
+    datalen = tcpSeglen(tcp, net2hs(ipv4->len) - ihl);
+    return (IPv4_PROTO_TCP == ipv4->proto)
+        && (net2hl(tcp->seqnum) == tcbptr->snduna)
+        && (tcp->control & TCP_CTRL_FIN) && (BULK_TINY == datalen);
+}
+
+#endif /* ELOOP && TCP0 && NTCP > 1 && NNETIF */
+
+/**
+ * TCP bulk transfer benchmark.  Times copying a buffer's worth of data
+ * into a ring octet by octet, as the TCP device used to, and with
+ * tcpRingPut(), and sending a run of full size segments one at a time and
+ * in bursts built from a header template, and checks the retransmission
+ * of a hole that ends at the FIN.  Then opens a connection
+ * between two TCP devices over the loopback interface, sends a stream
+ * through it and checks what arrives, reporting cycles per KB and how far
+ * the receiving end's input buffer grew; sends another with some segments dropped, so the receiver has to
+ * put data that arrived out of order back together; reports goodput with
+ * packets lost at random at several rates, which fast retransmit and SACK
+ * recover from; counts the packets saved by delayed ACKs and by Nagle's
+ * algorithm on a sender that writes a few octets at a time; and sends a
+ * last one through small buffers set with control().
+ */
+thread test_tcpBulk(bool verbose)
+{
+#if defined(ELOOP) && defined(TCP0) && (NTCP > 1) && NNETIF
+    struct netaddr ip;
+    struct netif *netptr;
+    ulong loop, ring, bulk;
+    uint quick, nodelay;
+    bool passed = TRUE;
+    char msg[100];
+    int i;
+
+    if ((TCP_CLOSED != tcptab[0].state) || (TCP_CLOSED != tcptab[1].state))
+    {
+        testSkip(TRUE, "TCP0 or TCP1 in use");
+        return OK;
+    }
+
+    testPrint(verbose, "Ring copies");
+    memset(bulkbuf, 0xA5, sizeof(bulkbuf));
+    loop = bulkRingTime(FALSE);
+    ring = bulkRingTime(TRUE);
+    sprintf(msg, "\nring copy: octet loop %u, tcpRingPut %u cycles/KB\n",
+            (uint)loop, (uint)ring);
+    testPrint(verbose, msg);
+
+    testPrint(verbose, "Initialization");
+    netptr = testNetUp(&ip);
+    failif(NULL == netptr, "loopback interface not up");
+    if (NULL == netptr)
+    {
+        return OK;
+    }
+
+    testPrint(verbose, "Segment transmission");
+    control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_DROPALL, NULL);
+    loop = bulkSegTime(&ip, FALSE);
+    bulk = bulkSegTime(&ip, TRUE);
+    control(ELOOP, ELOOP_CTRL_CLRFLAG, ELOOP_FLAG_DROPALL, NULL);
+    failif(0 == bulk, "");
+    sprintf(msg, "\n%u segments: tcpSend %u, tcpSendBurst %u cycles/KB\n",
+            BULK_NSEG, (uint)loop, (uint)bulk);
+    testPrint(verbose, msg);
+
+    testPrint(verbose, "Retransmit hole ending at FIN");
+    failif(!bulkHoleFin(&ip), "");
+
+    testPrint(verbose, "Bulk transfer");
+    bulk = bulkSend(&ip, BULK_LEN, BULK_CHUNK, 0, 0);
+    failif(0 == bulk, "");
+    sprintf(msg, "\n%u KB: %u cycles/KB, input buffer %u KB\n",
+            BULK_LEN / 1024, (uint)bulk, bulkrcvbuf / 1024);
+    testPrint(verbose, msg);
+
+    testPrint(verbose, "Bulk transfer with lost segments");
+    failif(0 == bulkSend(&ip, BULK_LOSSLEN, BULK_CHUNK, BULK_NLOSS, 0), "");
+
+    for (i = 0; i < BULK_NRATE; i++)
+    {
+        sprintf(msg, "Bulk transfer at %u.%u%% loss", bulkrate[i] / 10,
+                bulkrate[i] % 10);
+        testPrint(verbose, msg);
+        bulk = bulkSend(&ip, BULK_LOSSLEN, BULK_CHUNK, 0,
+                        bulkrate[i]);
+        failif(0 == bulk, "");
+        if (bulk != 0)
+        {
+            sprintf(msg, "\n%u KB in %u ms: %u KB/s, %u packets lost\n",
+                    BULK_LOSSLEN / 1024, (uint)bulkms,
+                    (uint)((BULK_LOSSLEN / 1024) * 1000 / (bulkms + 1)),
+                    elooptab[devtab[ELOOP].minor].nlost);
+            testPrint(verbose, msg);
+        }
+    }
+
+    testPrint(verbose, "Delayed ACKs");
+    control(TCP1, TCP_CTRL_QUICKACK, TRUE, 0);
+    failif(0 == bulkSend(&ip, BULK_LOSSLEN, BULK_CHUNK, 0, 0), "");
+    quick = bulkpkts;
+    control(TCP1, TCP_CTRL_QUICKACK, FALSE, 0);
+    failif((0 == bulkSend(&ip, BULK_LOSSLEN, BULK_CHUNK, 0, 0))
+           || (bulkpkts > quick), "");
+    sprintf(msg, "\n%u KB: %u packets, %u with every segment ACKed\n",
+            BULK_LOSSLEN / 1024, bulkpkts, quick);
+    testPrint(verbose, msg);
+
+    testPrint(verbose, "Nagle coalescing");
+    control(TCP0, TCP_CTRL_NODELAY, TRUE, 0);
+    failif(0 == bulkSend(&ip, BULK_SMALLLEN, BULK_TINY, 0, 0), "");
+    nodelay = bulkpkts;
+    control(TCP0, TCP_CTRL_NODELAY, FALSE, 0);
+    failif((0 == bulkSend(&ip, BULK_SMALLLEN, BULK_TINY, 0, 0))
+           || (bulkpkts > nodelay), "");
+    sprintf(msg, "\n%u KB in %u octet writes: %u packets, %u without Nagle\n",
+            BULK_SMALLLEN / 1024, BULK_TINY, bulkpkts, nodelay);
+    testPrint(verbose, msg);
+
+    testPrint(verbose, "Buffer sizes out of range");
+    failif((SYSERR != control(TCP1, TCP_CTRL_SETRCVBUF, TCP_BUFMIN - 1, 0))
+           || (SYSERR != control(TCP0, TCP_CTRL_SETSNDBUF, TCP_BUFMAX + 1,
+                                 0)), "");
+
+    testPrint(verbose, "Bulk transfer through small buffers");
+    control(TCP0, TCP_CTRL_SETSNDBUF, BULK_SMALLBUF, 0);
+    control(TCP1, TCP_CTRL_SETRCVBUF, BULK_SMALLBUF, 0);
+    failif((BULK_SMALLBUF != control(TCP1, TCP_CTRL_GETRCVBUF, 0, 0))
+           || (0 == bulkSend(&ip, BULK_SMALLLEN, BULK_CHUNK, 0, 0))
+           || (BULK_SMALLBUF != bulkrcvbuf), "");
+    control(TCP0, TCP_CTRL_SETSNDBUF, 0, 0);
+    control(TCP1, TCP_CTRL_SETRCVBUF, 0, 0);
+
+    testNetDown();
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else /* ELOOP && TCP0 && NTCP > 1 && NNETIF */
+    testSkip(TRUE, "");
+#endif /* !(ELOOP && TCP0 && NTCP > 1 && NNETIF) */
+    return OK;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file     test_tcpTimer.c
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <clock.h>
+#include <interrupt.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <tcp.h>
+#include <testsuite.h>
+#include <thread.h>
+
+#if NTCP
+
+#define TCPT_NCONN    32        /* connections timed, beyond NTCP        */
+#define TCPT_FAR      60000     /* ms away, so events timed never fire   */
+#define TCPT_MAXWAIT  40        /* longest event that is let fire, in ms */
+#define TCPT_IDLE     1000      /* ms the timer thread is watched idle   */
+
+static struct tcb tcpttab[TCPT_NCONN];
+
+/* The list all events used to be kept in, sorted by time as a delta
+ * queue, and its insertion, for comparison. */
+struct tcptDelta
+{
+    int remain;
+    struct tcptDelta *next;
+};
+static struct tcptDelta tcptdelta[TCPT_NCONN * TCP_NTIMERS + 1];
+
+static void tcptDeltaInsert(struct tcptDelta *evtptr, int time)
+{
+    struct tcptDelta *prev, *next;
+
+    prev = &tcptdelta[0];
+    next = prev->next;
+    while ((next != NULL) && (next->remain <= time))
+    {
+        time -= next->remain;
+        prev = next;
+        next = next->next;
+    }
+    evtptr->next = next;
+    prev->next = evtptr;
+    evtptr->remain = time;
+    if (next != NULL)
+    {
+        next->remain -= time;
+    }
+}
+
+/* Events of TCBs in tcptab that are scheduled */
+static int tcptScheduled(void)
+{
+    int i, j, n;
+
+    n = 0;
+    for (i = 0; i < NTCP; i++)
+    {
+        for (j = 0; j < TCP_NTIMERS; j++)
+        {
+            if (tcptab[i].timers[j].prev != NULL)
+            {
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+#endif /* NTCP */
+
+/**
+ * TCP timer wheel test and benchmark.  Counts how often the TCP timer
+ * thread wakes up while no event is scheduled; times scheduling and
+ * cancelling the events of a few dozen connections at once, against
+ * insertion into a delta queue, which is what the events used to be kept
+ * in; and checks that delayed ACK events of those connections fire neither
+ * early nor much late.
+ */
+thread test_tcpTimer(bool verbose)
+{
+#if NTCP
+    bool passed = TRUE;
+    ulong wakes, start, sched, purge, delta;
+    int nevent, i, j, n, time;
+    bool early;
+    irqmask im;
+    char msg[100];
+
+    testPrint(verbose, "Idle wakeups");
+    n = tcptScheduled();
+    wakes = tcptimerwakes;
+    sleep(TCPT_IDLE);
+    wakes = tcptimerwakes - wakes;
+    if ((0 == n) && (0 == tcptScheduled()))
+    {
+        failif(wakes > 1, "");
+        sprintf(msg, "\n%u wakeups in %d ms\n", (uint)wakes, TCPT_IDLE);
+        testPrint(verbose, msg);
+    }
+    else
+    {
+        testSkip(verbose, "TCP events scheduled");
+    }
+
+    testPrint(verbose, "Timer operations");
+    for (i = 0; i < TCPT_NCONN; i++)
+    {
+        tcpttab[i].mutex = semcreate(1);
+    }
+    nevent = TCPT_NCONN * TCP_NTIMERS;
+    im = disable();
+    start = clkcount();
+    for (i = 0; i < TCPT_NCONN; i++)
+    {
+        for (j = 1; j <= TCP_NTIMERS; j++)
+        {
+            tcpTimerSched(TCPT_FAR + (i * 37 + j * 101) % 1000,
+                          &tcpttab[i], j);
+        }
+    }
+    sched = clkcount() - start;
+    start = clkcount();
+    for (i = 0; i < TCPT_NCONN; i++)
+    {
+        for (j = 1; j <= TCP_NTIMERS; j++)
+        {
+            tcpTimerPurge(&tcpttab[i], j);
+        }
+    }
+    purge = clkcount() - start;
+    tcptdelta[0].next = NULL;
+    start = clkcount();
+    for (i = 0; i < nevent; i++)
+    {
+        tcptDeltaInsert(&tcptdelta[i + 1], TCPT_FAR + (i * 37) % 1000);
+    }
+    delta = clkcount() - start;
+    restore(im);
+    sprintf(msg, "\n%d events: schedule %u, cancel %u, "
+            "delta queue %u cycles/event\n", nevent, (uint)(sched / nevent),
+            (uint)(purge / nevent), (uint)(delta / nevent));
+    testPrint(verbose, msg);
+
+    testPrint(verbose, "Events fire on time");
+    for (i = 0; i < TCPT_NCONN; i++)
+    {
+        tcpTimerSched(i % TCPT_MAXWAIT + 1, &tcpttab[i], TCP_EVT_DELACK);
+    }
+    sleep(TCPT_MAXWAIT / 2);
+    early = FALSE;
+    for (i = 0; i < TCPT_NCONN; i++)
+    {
+        time = i % TCPT_MAXWAIT + 1;
+        if ((time > TCPT_MAXWAIT / 2 + 1)
+            && (0 == tcpTimerRemain(&tcpttab[i], TCP_EVT_DELACK)))
+        {
+            early = TRUE;
+        }
+    }
+    sleep(TCPT_MAXWAIT / 2 + 2);
+    n = 0;
+    for (i = 0; i < TCPT_NCONN; i++)
+    {
+        if (tcpTimerRemain(&tcpttab[i], TCP_EVT_DELACK) > 0)
+        {
+            n++;
+        }
+    }
+    failif(early || (n > 0), "");
+
+    for (i = 0; i < TCPT_NCONN; i++)
+    {
+        tcpTimerPurge(&tcpttab[i], NULL);
+        semfree(tcpttab[i].mutex);
+    }
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else /* NTCP */
+    testSkip(TRUE, "");
+#endif /* !NTCP */
+    return OK;
+}
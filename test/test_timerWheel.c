@@ -0,0 +1,208 @@
+#include <stddef.h>
+#include <thread.h>
+#include <queue.h>
+#include <clock.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <testsuite.h>
+
+#define TMRW_TIMERS    48       /* dummy threads for the insert benchmark */
+#define TMRW_SLEEPERS  32       /* threads making timed waits            */
+#define TMRW_ROUNDS    8        /* timed waits made by each sleeper      */
+#define TMRW_MAXWAIT   40       /* longest single wait, in ticks         */
+#define TMRW_STK       1024     /* stack size of a sleeping thread       */
+
+/* Milliseconds since boot, from the clock's own bookkeeping. */
+static ulong tmrwNow(void)
+{
+    ulong sec, ticks;
+    irqmask im;
+
+    im = disable();
+#if TICKLESS
+    clkcatchup();
+#endif
+    sec = clktime;
+    ticks = clkticks;
+    restore(im);
+    return sec * 1000 + (ticks * 1000) / CLKTICKS_PER_SEC;
+}
+
+/* Make a series of timed waits and report the worst lateness, or -1 if a
+ * wait ended early.  Odd rounds wait for a message that never comes. */
+static void tmrwSleeper(tid_typ parent, int seed)
+{
+    ulong start, late, worst;
+    int i, ms;
+
+    worst = 0;
+    for (i = 0; i < TMRW_ROUNDS; i++)
+    {
+        ms = (seed * 7 + i * 13) % TMRW_MAXWAIT + 1;
+        start = tmrwNow();
+        if (i & 1)
+        {
+            if (TIMEOUT != recvtime(ms * CLKTICKS_PER_SEC / 1000))
+            {
+                send(parent, -1);
+                return;
+            }
+        }
+        else
+        {
+            sleep(ms);
+        }
+        late = tmrwNow() - start;
+        if (late < (ulong)ms)
+        {
+            send(parent, -1);
+            return;
+        }
+        late -= ms;
+        if (late > worst)
+        {
+            worst = late;
+        }
+    }
+    send(parent, worst);
+}
+
+/**
+ * Timing wheel test and benchmark.  First compares the cost of starting a
+ * timed wait on the timing wheel with sorted insertion into a delta queue,
+ * the structure the sleep queue used to be, with a few dozen waits
+ * outstanding.  Then starts many threads that sleep and time out for
+ * assorted intervals at once and checks that none of them wakes early or
+ * more than a couple of ticks late.
+ */
+thread test_timerWheel(bool verbose)
+{
+#if RTCLOCK
+    bool passed = TRUE;
+    tid_typ tids[TMRW_TIMERS];
+    int delays[TMRW_TIMERS];
+    int created, i, n;
+    bool early;
+    tid_typ tid;
+    semaphore s;
+    qid_typ q;
+    ulong start, wheel, delta;
+    message worst, msg;
+    irqmask im;
+    char str[80];
+
+    /* Create some valid threads IDs to stuff in the queues.  */
+    /* These threads had better not ever run. */
+    s = semcreate(0);
+    created = 0;
+    for (i = 0; i < TMRW_TIMERS; i++)
+    {
+        tids[i] = create((void *)NULL, INITSTK, 0, "TMRWHEEL", 0);
+        if (SYSERR == tids[i])
+        {
+            break;
+        }
+        delays[i] = rand() % 10000 + 1;
+        created++;
+    }
+
+    testPrint(verbose, "Insert cost");
+    failif(isbadsem(s) || created != TMRW_TIMERS,
+           "could not create semaphore or threads");
+
+    if (!isbadsem(s))
+    {
+        q = semtab[s].queue;
+        im = disable();
+
+        start = clkcount();
+        for (i = 0; i < created; i++)
+        {
+            tmrinsert(tids[i], delays[i]);
+        }
+        wheel = clkcount() - start;
+        for (i = 0; i < created; i++)
+        {
+            tmrremove(tids[i]);
+        }
+
+        start = clkcount();
+        for (i = 0; i < created; i++)
+        {
+            insertd(tids[i], q, delays[i]);
+        }
+        delta = clkcount() - start;
+        while (EMPTY != dequeue(q))
+            ;
+
+        restore(im);
+        semfree(s);
+
+        if (created > 0)
+        {
+            sprintf(str, "\n%d waits: wheel %u, delta queue %u cycles/insert\n",
+                    created, (uint)(wheel / created),
+                    (uint)(delta / created));
+            testPrint(verbose, str);
+        }
+    }
+
+    for (i = 0; i < created; i++)
+    {
+        kill(tids[i]);
+    }
+
+    /* Many threads sleeping and timing out at once. */
+    testPrint(verbose, "Timed wait accuracy");
+    while (recvclr() != NOMSG)
+        ;
+    n = 0;
+    for (i = 0; i < TMRW_SLEEPERS; i++)
+    {
+        tid = create((void *)tmrwSleeper, TMRW_STK, getprio(gettid()) + 1,
+                     "TMRSLEEP", 2, gettid(), i);
+        if (SYSERR == tid)
+        {
+            break;
+        }
+        ready(tid, RESCHED_NO);
+        n++;
+    }
+
+    /* The sleepers run while we wait for their reports. */
+    early = FALSE;
+    worst = 0;
+    for (i = 0; i < n; i++)
+    {
+        msg = receive();
+        if (msg < 0)
+        {
+            early = TRUE;
+        }
+        else if (msg > worst)
+        {
+            worst = msg;
+        }
+    }
+
+    sprintf(str, "\n%d timed waits, worst lateness %d ms\n",
+            n * TMRW_ROUNDS, (int)worst);
+    testPrint(verbose, str);
+    failif(n != TMRW_SLEEPERS, "could not start sleeping threads");
+    failif(early, "a timed wait ended early");
+    failif(worst > 2, "a timed wait ended late");
+
+    if (passed)
+    {
+        testPass(TRUE, "");
+    }
+    else
+    {
+        testFail(TRUE, "");
+    }
+#else
+    testSkip(TRUE, "");
+#endif                          /* RTCLOCK */
+    return OK;
+}
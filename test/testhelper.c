@@ -37,6 +37,22 @@ struct testcase testtab[] = {
     {"IP", test_ip},
     {"User Memory", test_umemory},
     {"Simple TLB", test_tlb},
+    {"Context Switch", test_ctxsw},
+    {"Clock Interrupts", test_clock},
+    {"Timing Wheel", test_timerWheel},
+    {"Slab Allocator", test_slab},
+    {"Heap Latency", test_heap},
+    {"String Speed", test_libStringSpeed},
+    {"Socket Demux", test_demux},
+    {"Route Lookup", test_route},
+    {"TCP Bulk Transfer", test_tcpBulk},
+    {"TCP Timer Wheel", test_tcpTimer},
+    {"TCP Connect Storm", test_tcpAccept},
+    {"Checksum Throughput", test_chksum},
+    {"IPv4 Reassembly", test_ipReasm},
+    {"Scatter-Gather Send", test_netSeg},
+    {"Receive Flow Steering", test_netSteer},
+    {"Receive Polling", test_netPoll},
 };
 
 int ntests = sizeof(testtab) / sizeof(struct testcase);
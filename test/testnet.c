@@ -0,0 +1,184 @@
+/**
+ * @file     testnet.c
+ *
+ * Loopback network shared by the tests that send packets to themselves.
+ */
+/* Embedded Xinu, Copyright (C) 2009.  All rights reserved. */
+
+#include <stddef.h>
+#include <arp.h>
+#include <clock.h>
+#include <device.h>
+#include <interrupt.h>
+#include <ipv4.h>
+#include <network.h>
+#include <string.h>
+#include <testsuite.h>
+#include <thread.h>
+#include <udp.h>
+
+#if defined(ELOOP) && NNETIF
+static struct arpEntry *testarp;        /* static entry for our address  */
+#endif
+
+/**
+ * Bring the loopback interface up at 192.168.1.6/24, with a static ARP
+ * entry for that address, since packets to our own address need no ARP
+ * request.
+ * @param ip filled in with the address of the interface
+ * @return the interface, or NULL if it could not be brought up
+ */
+struct netif *testNetUp(struct netaddr *ip)
+{
+#if defined(ELOOP) && NNETIF
+    struct netaddr mask;
+    struct netif *netptr;
+    irqmask im;
+    int i;
+
+    ip->type = NETADDR_IPv4;
+    ip->len = IPv4_ADDR_LEN;
+    ip->addr[0] = 192;
+    ip->addr[1] = 168;
+    ip->addr[2] = 1;
+    ip->addr[3] = 6;
+    mask.type = NETADDR_IPv4;
+    mask.len = IPv4_ADDR_LEN;
+    mask.addr[0] = 255;
+    mask.addr[1] = 255;
+    mask.addr[2] = 255;
+    mask.addr[3] = 0;
+
+    if (SYSERR == open(ELOOP))
+    {
+        return NULL;
+    }
+    netptr = NULL;
+    if (SYSERR != netUp(ELOOP, ip, &mask, NULL))
+    {
+        for (i = 0; i < NNETIF; i++)
+        {
+            if ((NET_ALLOC == netiftab[i].state)
+                && (ELOOP == netiftab[i].dev))
+            {
+                netptr = &netiftab[i];
+                break;
+            }
+        }
+    }
+    if (NULL == netptr)
+    {
+        close(ELOOP);
+        return NULL;
+    }
+
+    im = disable();
+    testarp = arpAlloc();
+    if (SYSERR != (int)testarp)
+    {
+        testarp->state = ARP_RESOLVED;
+        testarp->nif = netptr;
+        netaddrcpy(&testarp->praddr, ip);
+        netaddrcpy(&testarp->hwaddr, &netptr->hwaddr);
+        testarp->expires = clktime + ARP_TTL_RESOLVED;
+        arpHashInsert(testarp);
+    }
+    restore(im);
+    return netptr;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * Take down the loopback interface brought up by testNetUp(), and its
+ * static ARP entry.
+ */
+void testNetDown(void)
+{
+#if defined(ELOOP) && NNETIF
+    irqmask im;
+
+    im = disable();
+    if (SYSERR != (int)testarp)
+    {
+        arpFree(testarp);
+    }
+    restore(im);
+    netDown(ELOOP);
+    close(ELOOP);
+#endif
+}
+
+/**
+ * Open a non-blocking UDP device between a port of our own address and
+ * itself.
+ * @param ip our address
+ * @param port port to send from and to
+ * @return the device, or SYSERR if none could be opened
+ */
+ushort testNetUdpOpen(const struct netaddr *ip, ushort port)
+{
+#if NUDP
+    ushort dev;
+
+    dev = udpAlloc();
+    if ((ushort)SYSERR == dev)
+    {
+        return (ushort)SYSERR;
+    }
+    if (SYSERR == open(dev, ip, ip, port, port))
+    {
+        return (ushort)SYSERR;
+    }
+    control(dev, UDP_CTRL_SETFLAG, UDP_FLAG_NOBLOCK, 0);
+    return dev;
+#else
+    return (ushort)SYSERR;
+#endif
+}
+
+/**
+ * Send datagrams of len octets to ourselves over a UDP device opened by
+ * testNetUdpOpen() until total octets have gone each way, reading each
+ * back before sending the next.
+ * @param dev UDP device
+ * @param out data to send, whose first octet is overwritten
+ * @param in buffer for the data read back
+ * @param len length of each datagram
+ * @param total octets to send
+ * @return the cycles taken, 0 if a datagram went missing or came back wrong
+ */
+ulong testNetUdpLoop(ushort dev, uchar *out, uchar *in, uint len,
+                     uint total)
+{
+    ulong start, cycles;
+    uint sent;
+    int n, ms;
+
+    cycles = 0;
+    for (sent = 0; sent < total; sent += len)
+    {
+        out[0] = sent / len;
+        start = clkcount();
+        if (len != write(dev, out, len))
+        {
+            return 0;
+        }
+        n = 0;
+        for (ms = 0; (0 == n) && (ms < TESTNET_WAIT); ms++)
+        {
+            n = read(dev, in, len);
+            if (0 == n)
+            {
+                sleep(1);
+            }
+        }
+        cycles += clkcount() - start;
+        if ((n != len) || (0 != memcmp(in, out, len)))
+        {
+            return 0;
+        }
+    }
+    return (cycles > 0) ? cycles : 1;
+}